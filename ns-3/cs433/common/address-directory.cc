@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/address-directory.h"
+
+#include <algorithm>
+
+using namespace ns3;
+
+AddressDirectory::AddressDirectory ()
+{
+}
+
+AddressDirectory::AddressDirectory (const std::map<uint32_t, Ipv4Address> &nodeAddressMap,
+                                    const std::map<Ipv4Address, uint32_t> &addressNodeMap)
+{
+  uint32_t nodeCount = nodeAddressMap.empty () ? 0 : nodeAddressMap.rbegin ()->first + 1;
+  m_mainAddresses.assign (nodeCount, Ipv4Address::GetAny ());
+  for (std::map<uint32_t, Ipv4Address>::const_iterator iter = nodeAddressMap.begin ();
+       iter != nodeAddressMap.end (); iter++)
+    {
+      m_mainAddresses[iter->first] = iter->second;
+    }
+
+  // Ipv4Address orders by its 32-bit value, so the map is already sorted
+  m_addresses.reserve (addressNodeMap.size ());
+  m_addressNodes.reserve (addressNodeMap.size ());
+  for (std::map<Ipv4Address, uint32_t>::const_iterator iter = addressNodeMap.begin ();
+       iter != addressNodeMap.end (); iter++)
+    {
+      m_addresses.push_back (iter->first.Get ());
+      m_addressNodes.push_back (iter->second);
+    }
+}
+
+AddressDirectory::~AddressDirectory ()
+{
+}
+
+uint32_t
+AddressDirectory::GetNodeCount () const
+{
+  return m_mainAddresses.size ();
+}
+
+Ipv4Address
+AddressDirectory::GetMainAddress (uint32_t nodeNumber) const
+{
+  if (nodeNumber < m_mainAddresses.size ())
+    {
+      return m_mainAddresses[nodeNumber];
+    }
+  return Ipv4Address::GetAny ();
+}
+
+uint32_t
+AddressDirectory::GetNodeNumber (Ipv4Address address) const
+{
+  std::vector<uint32_t>::const_iterator iter =
+    std::lower_bound (m_addresses.begin (), m_addresses.end (), address.Get ());
+  if (iter != m_addresses.end () && *iter == address.Get ())
+    {
+      return m_addressNodes[iter - m_addresses.begin ()];
+    }
+  return NODE_UNKNOWN;
+}
+
+uint32_t
+AddressDirectory::GetNAddresses () const
+{
+  return m_addresses.size ();
+}
+
+Ipv4Address
+AddressDirectory::GetAddress (uint32_t index) const
+{
+  return Ipv4Address (m_addresses[index]);
+}
+
+uint32_t
+AddressDirectory::GetAddressNode (uint32_t index) const
+{
+  return m_addressNodes[index];
+}
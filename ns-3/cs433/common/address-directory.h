@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ADDRESS_DIRECTORY_H
+#define ADDRESS_DIRECTORY_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/ipv4-address.h"
+
+#include <vector>
+#include <map>
+#include <limits>
+
+#define NODE_UNKNOWN std::numeric_limits<uint32_t>::max()
+
+using namespace ns3;
+
+/**
+ * \brief Read-only mapping between Inet topology node numbers and IP addresses.
+ *
+ * simulator-main builds one directory for the whole topology and hands the
+ * same instance to every protocol and application, instead of a copy of both
+ * maps per node. Main addresses are kept in an array indexed by node number,
+ * interface addresses in a sorted array searched by bisection.
+ */
+class AddressDirectory : public SimpleRefCount<AddressDirectory>
+{
+  public:
+    AddressDirectory ();
+    AddressDirectory (const std::map<uint32_t, Ipv4Address> &nodeAddressMap,
+                      const std::map<Ipv4Address, uint32_t> &addressNodeMap);
+    ~AddressDirectory ();
+
+    /**
+     * \returns One past the highest node number in the directory.
+     */
+    uint32_t GetNodeCount () const;
+    /**
+     * \returns Main address of the node, Ipv4Address::GetAny () if unknown.
+     */
+    Ipv4Address GetMainAddress (uint32_t nodeNumber) const;
+    /**
+     * \returns Node owning the address, NODE_UNKNOWN if none does.
+     */
+    uint32_t GetNodeNumber (Ipv4Address address) const;
+
+    // Iteration over all interface addresses, in address order
+    uint32_t GetNAddresses () const;
+    Ipv4Address GetAddress (uint32_t index) const;
+    uint32_t GetAddressNode (uint32_t index) const;
+
+  private:
+    std::vector<Ipv4Address> m_mainAddresses;
+    std::vector<uint32_t> m_addresses;
+    std::vector<uint32_t> m_addressNodes;
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include <map>
 
 #include "ns3/comm-log.h"
+#include "ns3/address-directory.h"
 
 using namespace ns3; 
 
@@ -39,6 +40,7 @@ class CommApplication : public Application, public CommLog
    virtual void ProcessCommand (std::vector<std::string> tokens) = 0;
    virtual void SetNodeAddressMap (std::map<uint32_t, Ipv4Address> nodeAddressMap) = 0;
    virtual void SetAddressNodeMap (std::map<Ipv4Address, uint32_t> addressNodeMap) = 0;
+   virtual void SetAddressDirectory (Ptr<AddressDirectory> addressDirectory) = 0;
   private:
     virtual Ipv4Address ResolveNodeIpAddress (uint32_t nodeNumber) = 0;
     virtual std::string ReverseLookup (Ipv4Address ipv4Address) = 0; 
@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Prints a binary log written by simulator-main --binary-log=<file> as the
+ * text the comm-log macros would have printed on std::cout.
+ *
+ *   comm-log-decode <file>|-
+ */
+
+#include "ns3/comm-log-sink.h"
+
+#include <iostream>
+#include <fstream>
+#include <string.h>
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      std::cerr << "usage: comm-log-decode <file>|-" << std::endl;
+      return 1;
+    }
+  std::ifstream file;
+  std::istream *input = &std::cin;
+  if (strcmp (argv[1], "-") != 0)
+    {
+      file.open (argv[1], std::ios::in | std::ios::binary);
+      if (!file)
+        {
+          std::cerr << "Unable to open " << argv[1] << std::endl;
+          return 1;
+        }
+      input = &file;
+    }
+  if (!CommLogSink::Decode (*input, std::cout))
+    {
+      std::cerr << "Malformed or truncated log" << std::endl;
+      return 1;
+    }
+  return 0;
+}
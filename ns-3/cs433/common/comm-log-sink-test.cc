@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/comm-log.h"
+#include "ns3/comm-log-sink.h"
+
+#include <stdio.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \brief Logs through every comm-log macro, as a routing protocol module does.
+ */
+class LoggingModule : public CommLog
+{
+public:
+  void Log (uint32_t round, std::string longText)
+  {
+    TRAFFIC_LOG ("packet " << round << " from 10.0.0." << round);
+    ERROR_LOG ("no route to node " << round);
+    DEBUG_LOG ("round " << round << ": " << longText);
+    STATUS_LOG ("");
+    if (round % 2 == 0)
+      PRINT_LOG ("even round " << round << "\t" << 0.25 * round);
+    else
+      PRINT_LOG ("odd round " << round);
+  }
+  void Rename (std::string nodeId, std::string moduleName)
+  {
+    SetNodeId (nodeId);
+    SetModuleName (moduleName);
+  }
+};
+
+/**
+ * \brief Logs the same run once into CommLogSink and once on std::cout and
+ * checks that Decode () gives back the text output byte for byte.
+ */
+class CommLogSinkDecodeTestCase : public TestCase
+{
+public:
+  CommLogSinkDecodeTestCase (uint32_t bufferSize, bool async);
+  virtual ~CommLogSinkDecodeTestCase (void);
+
+protected:
+  virtual bool DoRun (void);
+
+private:
+  void LogRun (void);
+
+  uint32_t m_bufferSize;
+  bool m_async;
+};
+
+CommLogSinkDecodeTestCase::CommLogSinkDecodeTestCase (uint32_t bufferSize, bool async)
+  : TestCase ("comm-log-sink decode matches the text log"),
+    m_bufferSize (bufferSize),
+    m_async (async)
+{
+}
+
+CommLogSinkDecodeTestCase::~CommLogSinkDecodeTestCase (void)
+{
+  return;
+}
+
+void
+CommLogSinkDecodeTestCase::LogRun (void)
+{
+  // several times the ring buffer, so one message is written in several blocks
+  std::string longText;
+  while (longText.size () < 5 * m_bufferSize)
+    {
+      longText += "0123456789abcdefghijklmnopqrstuvwxyz ";
+    }
+
+  LoggingModule first;
+  first.SetTrafficVerbose (true);
+  first.SetDebugVerbose (true);
+  first.Rename ("3", "LS");
+  LoggingModule second;
+  second.SetTrafficVerbose (true);
+  second.SetDebugVerbose (true);
+  second.Rename ("12", "DV");
+  for (uint32_t round = 0; round < 6; round++)
+    {
+      Simulator::Schedule (MicroSeconds (round * 2500 + 300), &LoggingModule::Log, &first, round, longText);
+      Simulator::Schedule (MilliSeconds (round * 1000 + 7), &LoggingModule::Log, &second, round, "short");
+    }
+  // a node and module seen for the first time while running, and one seen before
+  Simulator::Schedule (MilliSeconds (4), &LoggingModule::Rename, &first, "node-with-a-longer-id", "APP");
+  Simulator::Schedule (MilliSeconds (2500), &LoggingModule::Rename, &second, "3", "LS");
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+bool
+CommLogSinkDecodeTestCase::DoRun (void)
+{
+  std::ostringstream text;
+  std::streambuf *saved = std::cout.rdbuf (text.rdbuf ());
+  LogRun ();
+  std::cout.rdbuf (saved);
+
+  std::string fileName = GetTempDir () + "/comm-log-sink-test.bin";
+  // strings interned before Open () must be written out by it
+  CommLogSink::Intern ("interned before the sink was opened");
+  bool opened = CommLogSink::Open (fileName, m_bufferSize, m_async);
+  NS_TEST_ASSERT_MSG_EQ (opened, true, "could not create " << fileName);
+  std::ostringstream leaked;
+  saved = std::cout.rdbuf (leaked.rdbuf ());
+  LogRun ();
+  std::cout.rdbuf (saved);
+  NS_TEST_ASSERT_MSG_EQ (CommLogSink::GetDroppedRecords (), 0, "records dropped");
+  CommLogSink::Close ();
+  NS_TEST_ASSERT_MSG_EQ (leaked.str (), "", "records printed while the sink was open");
+
+  std::ifstream input (fileName.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_ASSERT_MSG_EQ (CommLogSink::Decode (input, decoded), true, "malformed log");
+  input.close ();
+  remove (fileName.c_str ());
+  NS_TEST_ASSERT_MSG_GT (text.str ().size (), 10 * m_bufferSize, "too little logged");
+  NS_TEST_ASSERT_MSG_EQ ((decoded.str () == text.str ()), true, "decoded log differs from the text log");
+  return GetErrorStatus ();
+}
+
+/**
+ * \brief A log cut off in a record header or in the text must be reported.
+ */
+class CommLogSinkTruncatedTestCase : public TestCase
+{
+public:
+  CommLogSinkTruncatedTestCase ();
+  virtual ~CommLogSinkTruncatedTestCase (void);
+
+protected:
+  virtual bool DoRun (void);
+};
+
+CommLogSinkTruncatedTestCase::CommLogSinkTruncatedTestCase ()
+  : TestCase ("comm-log-sink decode rejects truncated logs")
+{
+}
+
+CommLogSinkTruncatedTestCase::~CommLogSinkTruncatedTestCase (void)
+{
+  return;
+}
+
+bool
+CommLogSinkTruncatedTestCase::DoRun (void)
+{
+  std::string fileName = GetTempDir () + "/comm-log-sink-test.bin";
+  bool opened = CommLogSink::Open (fileName);
+  NS_TEST_ASSERT_MSG_EQ (opened, true, "could not create " << fileName);
+  LoggingModule module;
+  module.Rename ("1", "LS");
+  module.Log (1, "truncated");
+  CommLogSink::Close ();
+  Simulator::Destroy ();
+
+  std::ifstream input (fileName.c_str (), std::ios::in | std::ios::binary);
+  std::string log ((std::istreambuf_iterator<char> (input)), std::istreambuf_iterator<char> ());
+  input.close ();
+  remove (fileName.c_str ());
+
+  std::ostringstream decoded;
+  std::istringstream whole (log);
+  NS_TEST_ASSERT_MSG_EQ (CommLogSink::Decode (whole, decoded), true, "malformed log");
+  // into the last text, then into the last header
+  std::istringstream inText (log.substr (0, log.size () - 2));
+  NS_TEST_ASSERT_MSG_EQ (CommLogSink::Decode (inText, decoded), false, "truncated text accepted");
+  std::string lastText = "odd round 1";
+  std::istringstream inHeader (log.substr (0, log.size () - lastText.size () - 2));
+  NS_TEST_ASSERT_MSG_EQ (CommLogSink::Decode (inHeader, decoded), false, "truncated header accepted");
+  std::istringstream notALog ("CS433TXT");
+  NS_TEST_ASSERT_MSG_EQ (CommLogSink::Decode (notALog, decoded), false, "wrong magic accepted");
+  return GetErrorStatus ();
+}
+
+class CommLogSinkTestSuite : public TestSuite
+{
+public:
+  CommLogSinkTestSuite ();
+};
+
+CommLogSinkTestSuite::CommLogSinkTestSuite ()
+  : TestSuite ("cs433-comm-log-sink", UNIT)
+{
+  AddTestCase (new CommLogSinkDecodeTestCase (1024, false));
+  // smaller than one message, the ring wraps and spills over
+  AddTestCase (new CommLogSinkDecodeTestCase (64, false));
+  AddTestCase (new CommLogSinkDecodeTestCase (4096, true));
+  AddTestCase (new CommLogSinkTruncatedTestCase ());
+}
+
+static CommLogSinkTestSuite commLogSinkTestSuite;
+
+int
+main (int argc, char *argv[])
+{
+  commLogSinkTestSuite.SetVerbose (true);
+  // the log files go into the current directory
+  commLogSinkTestSuite.SetTempDir (".");
+  bool failed = commLogSinkTestSuite.Run ();
+  std::cout << (failed ? "FAIL: " : "PASS: ") << commLogSinkTestSuite.GetName () << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,377 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/comm-log-sink.h"
+#include "ns3/simulator.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+const uint32_t CommLogSink::HEADER_SIZE;
+const uint32_t CommLogSink::DEFAULT_BUFFER_SIZE;
+
+static const char LOG_MAGIC[8] = {'C', 'S', '4', '3', '3', 'L', 'O', 'G'};
+static const uint32_t LOG_VERSION = 1;
+
+namespace {
+
+// Collects the message text without an allocation once the capacity is there
+class TextBuffer : public std::streambuf
+{
+  public:
+    std::string text;
+
+  protected:
+    virtual int overflow (int c)
+    {
+      if (!traits_type::eq_int_type (c, traits_type::eof ()))
+        {
+          text.push_back (traits_type::to_char_type (c));
+        }
+      return c;
+    }
+    virtual std::streamsize xsputn (const char *s, std::streamsize n)
+    {
+      text.append (s, n);
+      return n;
+    }
+};
+
+struct SinkState
+{
+  SinkState ()
+    : head (0),
+      tail (0),
+      stream (&textBuffer),
+      exitHandlerInstalled (false)
+  {}
+
+  std::filebuf file;
+  // Ring buffer, head and tail count bytes ever written and ever flushed
+  std::vector<char> ring;
+  // Set in asynchronous mode, it replaces the ring buffer
+  Ptr<AsyncLogWriter> writer;
+  std::string record;
+  uint64_t head;
+  uint64_t tail;
+  std::map<std::string, uint32_t> stringIds;
+  std::vector<std::string> strings;
+  TextBuffer textBuffer;
+  std::ostream stream;
+  bool exitHandlerInstalled;
+};
+
+SinkState &
+GetState ()
+{
+  static SinkState state;
+  return state;
+}
+
+void
+WriteBlock (SinkState &state, const char *data, size_t size)
+{
+  if (size > 0 && state.file.sputn (data, size) != (std::streamsize) size)
+    {
+      std::cerr << "CommLogSink: write to the log file failed" << std::endl;
+    }
+}
+
+void
+Append (SinkState &state, const char *data, uint32_t size)
+{
+  uint64_t capacity = state.ring.size ();
+  if (size > capacity - (state.head - state.tail))
+    {
+      CommLogSink::Flush ();
+      if (size > capacity)
+        {
+          WriteBlock (state, data, size);
+          return;
+        }
+    }
+  uint32_t start = state.head % capacity;
+  uint32_t first = std::min<uint64_t> (size, capacity - start);
+  memcpy (&state.ring[start], data, first);
+  memcpy (&state.ring[0], data + first, size - first);
+  state.head += size;
+}
+
+void
+PutLittleEndian (char *out, uint64_t value, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; i++)
+    {
+      out[i] = (char) (value >> (8 * i));
+    }
+}
+
+uint64_t
+GetLittleEndian (const char *in, uint32_t bytes)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < bytes; i++)
+    {
+      value |= ((uint64_t) (uint8_t) in[i]) << (8 * i);
+    }
+  return value;
+}
+
+void
+AppendRecord (SinkState &state, uint8_t type, uint32_t node, uint32_t module, int64_t time, const std::string &text)
+{
+  // type (1), reserved (3), node (4), module (4), time (8), length (4)
+  char header[CommLogSink::HEADER_SIZE];
+  PutLittleEndian (header, type, 1);
+  PutLittleEndian (header + 1, 0, 3);
+  PutLittleEndian (header + 4, node, 4);
+  PutLittleEndian (header + 8, module, 4);
+  PutLittleEndian (header + 12, time, 8);
+  PutLittleEndian (header + 20, text.size (), 4);
+  if (state.writer == 0)
+    {
+      Append (state, header, CommLogSink::HEADER_SIZE);
+      Append (state, text.data (), text.size ());
+      return;
+    }
+
+  // The writer thread takes a record in one piece
+  state.record.assign (header, CommLogSink::HEADER_SIZE);
+  state.record.append (text);
+  if (!state.writer->Write (state.record.data (), state.record.size ()) && type == CommLogSink::STRING_RECORD)
+    {
+      // Without its strings the rest of the log can not be decoded
+      state.writer->Flush ();
+      state.writer->Write (state.record.data (), state.record.size ());
+    }
+}
+
+void
+CloseAtExit ()
+{
+  CommLogSink::Close ();
+}
+
+} // anonymous namespace
+
+bool
+CommLogSink::Open (std::string fileName, uint32_t bufferSize, bool async, AsyncLogWriter::FullPolicy policy)
+{
+  SinkState &state = GetState ();
+  Close ();
+  // The ring buffer already batches the writes
+  state.file.pubsetbuf (0, 0);
+  if (state.file.open (fileName.c_str (), std::ios::out | std::ios::binary | std::ios::trunc) == 0)
+    {
+      return false;
+    }
+  state.ring.assign (std::max<uint32_t> (bufferSize, HEADER_SIZE), 0);
+  state.head = 0;
+  state.tail = 0;
+  if (!state.exitHandlerInstalled)
+    {
+      atexit (&CloseAtExit);
+      state.exitHandlerInstalled = true;
+    }
+
+  char version[4];
+  PutLittleEndian (version, LOG_VERSION, 4);
+  Append (state, LOG_MAGIC, sizeof (LOG_MAGIC));
+  Append (state, version, sizeof (version));
+  if (async)
+    {
+      Flush ();
+      std::vector<char> ().swap (state.ring);
+      state.writer = Create<AsyncLogWriter> (&state.file, bufferSize, policy);
+    }
+  // Strings interned before the file was opened
+  for (uint32_t id = 0; id < state.strings.size (); id++)
+    {
+      AppendRecord (state, STRING_RECORD, id, 0, 0, state.strings[id]);
+    }
+  return true;
+}
+
+void
+CommLogSink::Close ()
+{
+  SinkState &state = GetState ();
+  if (!state.file.is_open ())
+    {
+      return;
+    }
+  Flush ();
+  if (state.writer != 0)
+    {
+      state.writer->Stop ();
+      state.writer = 0;
+    }
+  state.file.close ();
+  std::vector<char> ().swap (state.ring);
+}
+
+uint64_t
+CommLogSink::GetDroppedRecords ()
+{
+  SinkState &state = GetState ();
+  return state.writer == 0 ? 0 : state.writer->GetDroppedRecords ();
+}
+
+bool
+CommLogSink::IsOpen ()
+{
+  return GetState ().file.is_open ();
+}
+
+void
+CommLogSink::Flush ()
+{
+  SinkState &state = GetState ();
+  if (state.writer != 0)
+    {
+      state.writer->Flush ();
+      return;
+    }
+  if (!state.file.is_open () || state.head == state.tail)
+    {
+      return;
+    }
+  // At most two blocks, the second one if the data wraps around
+  uint64_t capacity = state.ring.size ();
+  uint32_t start = state.tail % capacity;
+  uint64_t size = state.head - state.tail;
+  uint32_t first = std::min<uint64_t> (size, capacity - start);
+  WriteBlock (state, &state.ring[start], first);
+  WriteBlock (state, &state.ring[0], size - first);
+  state.tail = state.head;
+  state.file.pubsync ();
+}
+
+uint32_t
+CommLogSink::Intern (const std::string &text)
+{
+  SinkState &state = GetState ();
+  std::map<std::string, uint32_t>::iterator it = state.stringIds.find (text);
+  if (it != state.stringIds.end ())
+    {
+      return it->second;
+    }
+  uint32_t id = state.strings.size ();
+  state.stringIds.insert (std::make_pair (text, id));
+  state.strings.push_back (text);
+  if (state.file.is_open ())
+    {
+      AppendRecord (state, STRING_RECORD, id, 0, 0, text);
+    }
+  return id;
+}
+
+std::ostream &
+CommLogSink::GetStream ()
+{
+  SinkState &state = GetState ();
+  state.textBuffer.text.clear ();
+  return state.stream;
+}
+
+void
+CommLogSink::Commit (RecordType type, uint32_t node, uint32_t module)
+{
+  SinkState &state = GetState ();
+  if (!state.file.is_open ())
+    {
+      return;
+    }
+  AppendRecord (state, type, node, module, Simulator::Now ().GetMilliSeconds (), state.textBuffer.text);
+}
+
+bool
+CommLogSink::Decode (std::istream &input, std::ostream &output)
+{
+  char magic[sizeof (LOG_MAGIC) + 4];
+  if (!input.read (magic, sizeof (magic)) || memcmp (magic, LOG_MAGIC, sizeof (LOG_MAGIC)) != 0
+      || GetLittleEndian (magic + sizeof (LOG_MAGIC), 4) != LOG_VERSION)
+    {
+      return false;
+    }
+
+  std::vector<std::string> strings;
+  std::string text;
+  char header[HEADER_SIZE];
+  while (input.read (header, HEADER_SIZE))
+    {
+      uint8_t type = GetLittleEndian (header, 1);
+      uint32_t node = GetLittleEndian (header + 4, 4);
+      uint32_t module = GetLittleEndian (header + 8, 4);
+      int64_t time = GetLittleEndian (header + 12, 8);
+      uint32_t length = GetLittleEndian (header + 20, 4);
+      text.resize (length);
+      if (length > 0 && !input.read (&text[0], length))
+        {
+          return false;
+        }
+
+      if (type == STRING_RECORD)
+        {
+          if (node >= strings.size ())
+            {
+              strings.resize (node + 1);
+            }
+          strings[node] = text;
+          continue;
+        }
+      if (type == PRINT_RECORD)
+        {
+          output << text << "\n";
+          continue;
+        }
+
+      const char *label;
+      switch (type)
+        {
+          case TRAFFIC_RECORD:
+            label = "TRAFFIC";
+            break;
+          case ERROR_RECORD:
+            label = "ERROR";
+            break;
+          case DEBUG_RECORD:
+            label = "DEBUG";
+            break;
+          case STATUS_RECORD:
+            label = "STATUS";
+            break;
+          default:
+            return false;
+        }
+      if (node >= strings.size () || module >= strings.size ())
+        {
+          return false;
+        }
+      output << "\n*" << label << "* Node: " << strings[node]
+             << ", Module: " << strings[module]
+             << ", Time: " << time
+             << (type == TRAFFIC_RECORD ? " ms, Message:: " : " ms, Message: ") << text << "\n";
+    }
+  // Anything left over is a truncated header
+  return input.gcount () == 0;
+}
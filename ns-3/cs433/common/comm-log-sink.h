@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMM_LOG_SINK_H
+#define COMM_LOG_SINK_H
+
+#include "ns3/async-log-writer.h"
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+
+/**
+ * \brief Binary, buffered alternative to printing the comm-log macros on std::cout.
+ *
+ * Once opened, every log macro appends one record to a per-run ring buffer
+ * that is written to the log file in large blocks. A record is a fixed size
+ * header (record type, node, module, time in ms, text length, all little
+ * endian) followed by the message text. Node ids and module names are
+ * interned, a STRING_RECORD announces each of them once. Decode () turns a
+ * log file back into the text std::cout would have shown, see the
+ * comm-log-decode program.
+ *
+ * In asynchronous mode the records go through an AsyncLogWriter instead of
+ * the ring buffer, and a background thread writes them to the file.
+ */
+class CommLogSink
+{
+  public:
+    enum RecordType
+    {
+      TRAFFIC_RECORD = 0,
+      ERROR_RECORD = 1,
+      DEBUG_RECORD = 2,
+      STATUS_RECORD = 3,
+      PRINT_RECORD = 4,
+      // Defines the interned string with the id in the node field
+      STRING_RECORD = 5
+    };
+
+    static const uint32_t HEADER_SIZE = 24;
+    static const uint32_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    /**
+     * \brief Start logging into the given file instead of std::cout.
+     *
+     * The sink is closed and flushed at exit at the latest.
+     *
+     * \param async write the file from a background thread.
+     * \param policy what the background thread does with records that do not fit.
+     * \returns false if the file can not be created.
+     */
+    static bool Open (std::string fileName, uint32_t bufferSize = DEFAULT_BUFFER_SIZE, bool async = false,
+                      ns3::AsyncLogWriter::FullPolicy policy = ns3::AsyncLogWriter::BLOCK);
+    static void Close ();
+    static bool IsOpen ();
+    /**
+     * \returns the number of records dropped because the asynchronous writer was full.
+     */
+    static uint64_t GetDroppedRecords ();
+    /**
+     * \brief Write out everything buffered so far.
+     */
+    static void Flush ();
+
+    /**
+     * \returns the id of the string in records, the same for equal strings.
+     */
+    static uint32_t Intern (const std::string &text);
+    /**
+     * \returns an empty stream for the text of the next record.
+     */
+    static std::ostream &GetStream ();
+    /**
+     * \brief Append a record with the text put into GetStream () since, stamped with the current time.
+     */
+    static void Commit (RecordType type, uint32_t node, uint32_t module);
+
+    /**
+     * \brief Print a log file in the format of the text log.
+     *
+     * \returns false if the input is not a log file or ends in the middle of a record.
+     */
+    static bool Decode (std::istream &input, std::ostream &output);
+};
+
+#endif
@@ -23,6 +23,8 @@ CommLog::CommLog ()
 {
   g_nodeId = "Unknown";
   g_moduleName = "Unknown";
+  g_nodeKey = CommLogSink::Intern (g_nodeId);
+  g_moduleKey = g_nodeKey;
   g_errorVerbose = true;
   g_statusVerbose = true;
   g_trafficVerbose = false;
@@ -60,6 +62,7 @@ void
 CommLog::SetNodeId (std::string nodeId)
 {
   g_nodeId = nodeId;
+  g_nodeKey = CommLogSink::Intern (g_nodeId);
 }
 
 
@@ -67,4 +70,5 @@ void
 CommLog::SetModuleName (std::string moduleName)
 {
   g_moduleName = moduleName;
+  g_moduleKey = CommLogSink::Intern (g_moduleName);
 }
@@ -21,48 +21,68 @@
 #include <string>
 #include "ns3/ptr.h"
 #include "ns3/test-result.h"
+#include "ns3/comm-log-sink.h"
 
 using namespace ns3;
 
+// With CommLogSink open the records go to its binary log instead of std::cout
+#define COMM_LOG_RECORD(type, label, separator, msg)                  \
+  do                                                                  \
+    {                                                                 \
+      if (CommLogSink::IsOpen ())                                     \
+        {                                                             \
+          CommLogSink::GetStream () << msg;                           \
+          CommLogSink::Commit (type, g_nodeKey, g_moduleKey);         \
+        }                                                             \
+      else                                                            \
+        {                                                             \
+          std::cout << "\n*" label "* Node: " << g_nodeId             \
+                    << ", Module: " << g_moduleName                   \
+                    << ", Time: " << Simulator::Now().GetMilliSeconds() \
+                    << " ms, Message" separator " " << msg << "\n";   \
+        }                                                             \
+    }                                                                 \
+  while (0)
+
 #define TRAFFIC_LOG(msg)                                              \
   if (g_trafficVerbose)                                               \
     {                                                                 \
-      std::cout << "\n*TRAFFIC* Node: " << g_nodeId                   \
-                << ", Module: " << g_moduleName                      \
-                << ", Time: " << Simulator::Now().GetMilliSeconds()  \
-                << " ms, Message:: " << msg << "\n";                   \
+      COMM_LOG_RECORD (CommLogSink::TRAFFIC_RECORD, "TRAFFIC", "::", msg); \
       checkTrafficTrace(g_nodeId, g_moduleName);                      \
     }                                                                 \
 
-#define ERROR_LOG(msg)                                         \
-  if (g_errorVerbose)                                               \
-    {                                                               \
-      std::cout << "\n*ERROR* Node: " << g_nodeId                   \
-                << ", Module: " << g_moduleName                      \
-                << ", Time: " << Simulator::Now().GetMilliSeconds()  \
-                << " ms, Message: " << msg << "\n";                   \
-    }                                                               \
+#define ERROR_LOG(msg)                                                \
+  if (g_errorVerbose)                                                 \
+    {                                                                 \
+      COMM_LOG_RECORD (CommLogSink::ERROR_RECORD, "ERROR", ":", msg); \
+    }                                                                 \
+
+#define DEBUG_LOG(msg)                                                \
+  if (g_debugVerbose)                                                 \
+    {                                                                 \
+      COMM_LOG_RECORD (CommLogSink::DEBUG_RECORD, "DEBUG", ":", msg); \
+    }                                                                 \
 
-#define DEBUG_LOG(msg)                                         \
-  if (g_debugVerbose)                                               \
-    {                                                               \
-      std::cout << "\n*DEBUG* Node: " << g_nodeId                   \
-                << ", Module: " << g_moduleName                      \
-                << ", Time: " << Simulator::Now().GetMilliSeconds()  \
-                << " ms, Message: " << msg << "\n";                   \
-    }  
-\
-#define STATUS_LOG(msg)                                         \
-  if (g_statusVerbose)                                               \
-    {                                                               \
-      std::cout << "\n*STATUS* Node: " << g_nodeId                   \
-                << ", Module: " << g_moduleName                      \
-                << ", Time: " << Simulator::Now().GetMilliSeconds()  \
-                << " ms, Message: " << msg << "\n";                   \
-    }       
+#define STATUS_LOG(msg)                                               \
+  if (g_statusVerbose)                                                \
+    {                                                                 \
+      COMM_LOG_RECORD (CommLogSink::STATUS_RECORD, "STATUS", ":", msg); \
+    }                                                                 \
 
-#define PRINT_LOG(msg)                                         \
-      std::cout << msg << "\n";                   
+#define PRINT_LOG(msg)                                                \
+  do                                                                  \
+    {                                                                 \
+      if (CommLogSink::IsOpen ())                                     \
+        {                                                             \
+          CommLogSink::GetStream () << msg;                           \
+          CommLogSink::Commit (CommLogSink::PRINT_RECORD, g_nodeKey, g_moduleKey); \
+        }                                                             \
+      else                                                            \
+        {                                                             \
+          std::cout << msg << "\n";                                   \
+        }                                                             \
+    }                                                                 \
+  while (0)
 
 class CommLog 
 {
@@ -81,6 +101,8 @@ class CommLog
     std::string g_moduleName;
     std::string g_nodeId;
     bool g_trafficVerbose, g_errorVerbose, g_debugVerbose, g_statusVerbose;
+    // Interned g_nodeId and g_moduleName for CommLogSink records
+    uint32_t g_nodeKey, g_moduleKey;
 };
 
 #endif
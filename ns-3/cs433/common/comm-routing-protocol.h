@@ -20,6 +20,7 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/comm-log.h"
+#include "ns3/address-directory.h"
 
 #include <vector>
 #include <map>
@@ -52,6 +53,7 @@ class CommRoutingProtocol : public Ipv4RoutingProtocol, public CommLog
     virtual void SetMainInterface (uint32_t mainInterface) = 0;
     virtual void SetNodeAddressMap (std::map<uint32_t, Ipv4Address> nodeAddressMap) = 0;
     virtual void SetAddressNodeMap (std::map<Ipv4Address, uint32_t> addressNodeMap) = 0;
+    virtual void SetAddressDirectory (Ptr<AddressDirectory> addressDirectory) = 0;
 
   private:
     virtual Ipv4Address ResolveNodeIpAddress (uint32_t nodeNumber) = 0;
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/forwarding-table.h"
+#include "ns3/net-device.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * \brief Fills a forwarding table with the interface addresses simulator-main
+ * gives out, one 10.0.x.0/24 subnet per link, and checks the lookups stay
+ * short.
+ */
+class ForwardingTableTestCase : public TestCase
+{
+public:
+  ForwardingTableTestCase (uint32_t nLinks);
+  virtual ~ForwardingTableTestCase (void);
+
+protected:
+  virtual bool DoRun (void);
+
+private:
+  uint32_t m_nLinks;
+};
+
+ForwardingTableTestCase::ForwardingTableTestCase (uint32_t nLinks)
+  : TestCase ("forwarding table probes"),
+    m_nLinks (nLinks)
+{
+}
+
+ForwardingTableTestCase::~ForwardingTableTestCase (void)
+{
+  return;
+}
+
+bool
+ForwardingTableTestCase::DoRun (void)
+{
+  std::vector<Ipv4Address> addresses;
+  for (uint32_t link = 0; link < m_nLinks; link++)
+    {
+      // Ipv4AddressHelper moves on to 10.1.0.0 after 10.0.255.0
+      addresses.push_back (Ipv4Address (0x0a000000 + (link << 8) + 1));
+      addresses.push_back (Ipv4Address (0x0a000000 + (link << 8) + 2));
+    }
+
+  ForwardingTable table;
+  table.Reset (addresses.size ());
+  for (uint32_t k = 0; k < addresses.size (); k++)
+    {
+      Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+      route->SetDestination (addresses[k]);
+      table.Insert (addresses[k], route);
+    }
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), addresses.size (), "entries missing");
+  for (uint32_t k = 0; k < addresses.size (); k++)
+    {
+      Ptr<Ipv4Route> route = table.Lookup (addresses[k]);
+      NS_TEST_ASSERT_MSG_EQ ((route != 0), true, "no route to " << addresses[k]);
+      NS_TEST_ASSERT_MSG_EQ (route->GetDestination (), addresses[k], "wrong route to " << addresses[k]);
+    }
+  NS_TEST_ASSERT_MSG_EQ ((table.Lookup (Ipv4Address ("10.0.0.3")) == 0), true, "route to unknown address");
+  NS_TEST_ASSERT_MSG_LT (table.GetLongestProbe (), 5, "addresses of " << m_nLinks << " links cluster");
+  return GetErrorStatus ();
+}
+
+class ForwardingTableTestSuite : public TestSuite
+{
+public:
+  ForwardingTableTestSuite ();
+};
+
+ForwardingTableTestSuite::ForwardingTableTestSuite ()
+  : TestSuite ("cs433-forwarding-table", UNIT)
+{
+  AddTestCase (new ForwardingTableTestCase (21));
+  AddTestCase (new ForwardingTableTestCase (200));
+  AddTestCase (new ForwardingTableTestCase (4000));
+}
+
+static ForwardingTableTestSuite forwardingTableTestSuite;
+
+int
+main (int argc, char *argv[])
+{
+  forwardingTableTestSuite.SetVerbose (true);
+  bool failed = forwardingTableTestSuite.Run ();
+  std::cout << (failed ? "FAIL: " : "PASS: ") << forwardingTableTestSuite.GetName () << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/forwarding-table.h"
+#include "ns3/net-device.h"
+
+using namespace ns3;
+
+ForwardingTable::ForwardingTable ()
+  : m_mask (0),
+    m_shift (0),
+    m_size (0)
+{
+  Reset (0);
+}
+
+void
+ForwardingTable::Reset (uint32_t expectedEntries)
+{
+  // Keep the load factor at or below one half
+  uint32_t capacity = 8;
+  uint32_t bits = 3;
+  while (capacity < 2 * expectedEntries)
+    {
+      capacity <<= 1;
+      bits++;
+    }
+  m_keys.assign (capacity, 0);
+  m_routes.assign (capacity, Ptr<Ipv4Route> ());
+  m_mask = capacity - 1;
+  m_shift = 32 - bits;
+  m_size = 0;
+}
+
+uint32_t
+ForwardingTable::Slot (uint32_t key) const
+{
+  // Fibonacci hashing: the high bits of the product depend on every bit of
+  // the key, the low ones only on the low bits of the key, which are the
+  // same host number in every 10.0.x.0/24 link subnet
+  return (key * 2654435769U) >> m_shift;
+}
+
+void
+ForwardingTable::Grow ()
+{
+  std::vector<uint32_t> keys;
+  std::vector<Ptr<Ipv4Route> > routes;
+  keys.swap (m_keys);
+  routes.swap (m_routes);
+  Reset (keys.size ());
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      if (keys[i] != 0)
+        {
+          Insert (Ipv4Address (keys[i]), routes[i]);
+        }
+    }
+}
+
+void
+ForwardingTable::Insert (Ipv4Address destination, Ptr<Ipv4Route> route)
+{
+  uint32_t key = destination.Get ();
+  if (key == 0)
+    {
+      return;
+    }
+  if (2 * (m_size + 1) > m_keys.size ())
+    {
+      Grow ();
+    }
+  uint32_t slot = Slot (key);
+  while (m_keys[slot] != 0 && m_keys[slot] != key)
+    {
+      slot = (slot + 1) & m_mask;
+    }
+  if (m_keys[slot] == 0)
+    {
+      m_keys[slot] = key;
+      m_size++;
+    }
+  m_routes[slot] = route;
+}
+
+Ptr<Ipv4Route>
+ForwardingTable::Lookup (Ipv4Address destination) const
+{
+  uint32_t key = destination.Get ();
+  uint32_t slot = Slot (key);
+  while (m_keys[slot] != 0)
+    {
+      if (m_keys[slot] == key)
+        {
+          return m_routes[slot];
+        }
+      slot = (slot + 1) & m_mask;
+    }
+  return 0;
+}
+
+uint32_t
+ForwardingTable::GetLongestProbe () const
+{
+  uint32_t longest = 0;
+  for (uint32_t slot = 0; slot < m_keys.size (); slot++)
+    {
+      if (m_keys[slot] != 0)
+        {
+          uint32_t probe = ((slot - Slot (m_keys[slot])) & m_mask) + 1;
+          if (probe > longest)
+            {
+              longest = probe;
+            }
+        }
+    }
+  return longest;
+}
+
+uint32_t
+ForwardingTable::GetSize () const
+{
+  return m_size;
+}
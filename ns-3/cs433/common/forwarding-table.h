@@ -0,0 +1,67 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FORWARDING_TABLE_H
+#define FORWARDING_TABLE_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ptr.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief Compiled forwarding table mapping a destination address to a ready-made route.
+ *
+ * Open addressing hash table with linear probing on the 32-bit address. It is
+ * rebuilt from the routing table after the routes changed, so that forwarding
+ * a packet costs a single probe instead of node number lookups and an
+ * interface scan. 0.0.0.0 marks an empty slot and can not be used as a key.
+ */
+class ForwardingTable
+{
+  public:
+    ForwardingTable ();
+
+    /**
+     * \brief Drop all entries and make room for at least the given number of them.
+     */
+    void Reset (uint32_t expectedEntries);
+    void Insert (Ipv4Address destination, Ptr<Ipv4Route> route);
+    /**
+     * \returns the route to the destination, or 0 if there is none.
+     */
+    Ptr<Ipv4Route> Lookup (Ipv4Address destination) const;
+    uint32_t GetSize () const;
+    /**
+     * \returns the largest number of slots a successful lookup has to probe.
+     */
+    uint32_t GetLongestProbe () const;
+
+  private:
+    uint32_t Slot (uint32_t key) const;
+    void Grow ();
+
+    std::vector<uint32_t> m_keys;
+    std::vector<Ptr<Ipv4Route> > m_routes;
+    uint32_t m_mask;
+    uint32_t m_shift;
+    uint32_t m_size;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/ls-message.h"
+#include "ns3/header-template.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * \brief Sends a hello from a HeaderTemplate and reads an LSA through an
+ * LSMessageView, and checks both against the LSMessage they stand for.
+ */
+class LSMessageFastPathTestCase : public TestCase
+{
+public:
+  LSMessageFastPathTestCase ();
+  virtual ~LSMessageFastPathTestCase (void);
+
+protected:
+  virtual bool DoRun (void);
+};
+
+LSMessageFastPathTestCase::LSMessageFastPathTestCase ()
+  : TestCase ("LS hello template and table view")
+{
+}
+
+LSMessageFastPathTestCase::~LSMessageFastPathTestCase (void)
+{
+  return;
+}
+
+bool
+LSMessageFastPathTestCase::DoRun (void)
+{
+  Ipv4Address originator ("10.0.0.1");
+
+  LSMessage hello (LSMessage::HELLO_REQ, 7, 1, originator);
+  hello.SetHelloReq (Ipv4Address ("10.0.0.2"), "hello");
+  HeaderTemplate helloTemplate (hello);
+  helloTemplate.SetU32 (LSMessage::SEQUENCE_NUMBER_OFFSET, 0x01020304);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (helloTemplate);
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), hello.GetSerializedSize (), "hello size mismatch");
+  LSMessage helloReceived;
+  packet->RemoveHeader (helloReceived);
+  NS_TEST_ASSERT_MSG_EQ (helloReceived.GetMessageType (), LSMessage::HELLO_REQ, "hello type mismatch");
+  NS_TEST_ASSERT_MSG_EQ (helloReceived.GetSequenceNumber (), 0x01020304, "hello sequence number not patched");
+  NS_TEST_ASSERT_MSG_EQ (helloReceived.GetOriginatorAddress (), originator, "hello originator mismatch");
+  NS_TEST_ASSERT_MSG_EQ (helloReceived.GetHelloReq ().helloMessage, "hello", "hello payload mismatch");
+
+  LSMessage::nbrCostsVec neighbors;
+  neighbors.push_back (std::make_pair (Ipv4Address ("10.0.0.9"), 1));
+  neighbors.push_back (std::make_pair (Ipv4Address ("10.0.1.3"), 0x7fffffff));
+  neighbors.push_back (std::make_pair (Ipv4Address ("10.0.2.5"), 12));
+  LSMessage lsa (LSMessage::LS_TABLE_MSG, 42, 16, originator);
+  lsa.SetLSTableMsg (neighbors);
+  packet = Create<Packet> ();
+  packet->AddHeader (lsa);
+  LSMessageView view;
+  uint32_t viewSize = packet->PeekHeader (view);
+  NS_TEST_ASSERT_MSG_EQ (viewSize, lsa.GetSerializedSize (), "LSA view size mismatch");
+  NS_TEST_ASSERT_MSG_EQ (view.GetMessageType (), LSMessage::LS_TABLE_MSG, "LSA view type mismatch");
+  NS_TEST_ASSERT_MSG_EQ (view.GetSequenceNumber (), 42, "LSA view sequence number mismatch");
+  NS_TEST_ASSERT_MSG_EQ (view.GetTTL (), 16, "LSA view TTL mismatch");
+  NS_TEST_ASSERT_MSG_EQ (view.GetOriginatorAddress (), originator, "LSA view originator mismatch");
+  NS_TEST_ASSERT_MSG_EQ (view.GetNNeighbors (), neighbors.size (), "LSA view neighbor count mismatch");
+  for (uint32_t k = 0; k < neighbors.size (); k++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (view.GetNeighborAddress (k), neighbors[k].first, "LSA view address mismatch");
+      NS_TEST_ASSERT_MSG_EQ (view.GetNeighborCost (k), neighbors[k].second, "LSA view cost mismatch");
+    }
+
+  // forwarded with a lower TTL, the neighbors copied from the first packet
+  view.SetTTL (15);
+  Ptr<Packet> forward = Create<Packet> ();
+  forward->AddHeader (view);
+  LSMessage lsaReceived;
+  uint32_t lsaSize = forward->RemoveHeader (lsaReceived);
+  NS_TEST_ASSERT_MSG_EQ (lsaSize, lsa.GetSerializedSize (), "forwarded LSA size mismatch");
+  NS_TEST_ASSERT_MSG_EQ (lsaReceived.GetTTL (), 15, "forwarded LSA TTL mismatch");
+  NS_TEST_ASSERT_MSG_EQ (lsaReceived.GetSequenceNumber (), 42, "forwarded LSA sequence number mismatch");
+  LSMessage::nbrCostsVec received = lsaReceived.GetLSTableMsg ().neighborCosts;
+  NS_TEST_ASSERT_MSG_EQ (received.size (), neighbors.size (), "forwarded LSA neighbor count mismatch");
+  for (uint32_t k = 0; k < received.size (); k++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (received[k].first, neighbors[k].first, "forwarded LSA address mismatch");
+      NS_TEST_ASSERT_MSG_EQ (received[k].second, neighbors[k].second, "forwarded LSA cost mismatch");
+    }
+  return GetErrorStatus ();
+}
+
+class HeaderTemplateTestSuite : public TestSuite
+{
+public:
+  HeaderTemplateTestSuite ();
+};
+
+HeaderTemplateTestSuite::HeaderTemplateTestSuite ()
+  : TestSuite ("cs433-header-template", UNIT)
+{
+  AddTestCase (new LSMessageFastPathTestCase ());
+}
+
+static HeaderTemplateTestSuite headerTemplateTestSuite;
+
+int
+main (int argc, char *argv[])
+{
+  headerTemplateTestSuite.SetVerbose (true);
+  bool failed = headerTemplateTestSuite.Run ();
+  std::cout << (failed ? "FAIL: " : "PASS: ") << headerTemplateTestSuite.GetName () << std::endl;
+  return failed ? 1 : 0;
+}
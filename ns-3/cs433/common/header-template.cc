@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/header-template.h"
+#include "ns3/assert.h"
+
+using namespace ns3;
+
+HeaderTemplate::HeaderTemplate ()
+{
+}
+
+HeaderTemplate::HeaderTemplate (const Header &header)
+  : m_tid (header.GetInstanceTypeId ()),
+    m_image (header.GetSerializedSize ())
+{
+  Buffer buffer;
+  buffer.AddAtStart (m_image.size ());
+  header.Serialize (buffer.Begin ());
+  if (!m_image.empty ())
+    {
+      buffer.Begin ().Read (&m_image[0], m_image.size ());
+    }
+}
+
+HeaderTemplate::~HeaderTemplate ()
+{
+}
+
+bool
+HeaderTemplate::IsEmpty (void) const
+{
+  return m_image.empty ();
+}
+
+void
+HeaderTemplate::SetU32 (uint32_t offset, uint32_t value)
+{
+  NS_ASSERT (offset + 4 <= m_image.size ());
+  m_image[offset] = value >> 24;
+  m_image[offset + 1] = value >> 16;
+  m_image[offset + 2] = value >> 8;
+  m_image[offset + 3] = value;
+}
+
+TypeId
+HeaderTemplate::GetInstanceTypeId (void) const
+{
+  return m_tid;
+}
+
+Header *
+HeaderTemplate::CreateHeader (void) const
+{
+  Callback<ObjectBase *> constructor = m_tid.GetConstructor ();
+  NS_ASSERT (!constructor.IsNull ());
+  Header *header = dynamic_cast<Header *> (constructor ());
+  NS_ASSERT (header != 0);
+  return header;
+}
+
+void
+HeaderTemplate::Print (std::ostream &os) const
+{
+  if (m_image.empty ())
+    {
+      return;
+    }
+  Buffer buffer;
+  buffer.AddAtStart (m_image.size ());
+  buffer.Begin ().Write (&m_image[0], m_image.size ());
+  Header *header = CreateHeader ();
+  header->Deserialize (buffer.Begin ());
+  header->Print (os);
+  delete header;
+}
+
+uint32_t
+HeaderTemplate::GetSerializedSize (void) const
+{
+  return m_image.size ();
+}
+
+void
+HeaderTemplate::Serialize (Buffer::Iterator start) const
+{
+  if (!m_image.empty ())
+    {
+      start.Write (&m_image[0], m_image.size ());
+    }
+}
+
+uint32_t
+HeaderTemplate::Deserialize (Buffer::Iterator start)
+{
+  // the type of the header is kept, only its contents change
+  Header *header = CreateHeader ();
+  uint32_t size = header->Deserialize (start);
+  delete header;
+  m_image.resize (size);
+  if (size > 0)
+    {
+      start.Read (&m_image[0], size);
+    }
+  return size;
+}
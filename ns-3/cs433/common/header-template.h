@@ -0,0 +1,72 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HEADER_TEMPLATE_H
+#define HEADER_TEMPLATE_H
+
+#include "ns3/header.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief A header serialized once, for the messages which are sent over
+ * and over and only differ by a field or two, such as the hellos.
+ *
+ * AddHeader copies the serialized image into the packet as is, instead
+ * of sizing and serializing the header again. The packets record the
+ * type of the original header, so that RemoveHeader with that type and
+ * the packet printer work unchanged.
+ */
+class HeaderTemplate : public Header
+{
+  public:
+    HeaderTemplate ();
+    /**
+     * \param header the header to serialize into the template
+     */
+    HeaderTemplate (const Header &header);
+    virtual ~HeaderTemplate ();
+
+    /**
+     * \returns true until a header was serialized into the template
+     */
+    bool IsEmpty (void) const;
+    /**
+     * \brief Overwrite a 32 bit field of the serialized header.
+     * \param offset offset of the field from the start of the header
+     * \param value value of the field, written in network order
+     */
+    void SetU32 (uint32_t offset, uint32_t value);
+
+    /**
+     * \returns the type of the header the template was made of
+     */
+    virtual TypeId GetInstanceTypeId (void) const;
+    virtual void Print (std::ostream &os) const;
+    virtual uint32_t GetSerializedSize (void) const;
+    virtual void Serialize (Buffer::Iterator start) const;
+    virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  private:
+    Header *CreateHeader (void) const;
+
+    TypeId m_tid;
+    std::vector<uint8_t> m_image;
+};
+
+#endif
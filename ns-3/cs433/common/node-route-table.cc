@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/node-route-table.h"
+
+#include <algorithm>
+
+using namespace ns3;
+
+void
+NodeRouteTable::Resize (uint32_t nodeCount)
+{
+  cost.resize (nodeCount, ROUTE_UNREACHABLE);
+  nextHop.resize (nodeCount, NODE_UNKNOWN);
+  nextHopAddr.resize (nodeCount);
+  interfaceAddr.resize (nodeCount);
+}
+
+uint32_t
+NodeRouteTable::GetNodeCount () const
+{
+  return cost.size ();
+}
+
+void
+NodeRouteTable::Clear ()
+{
+  std::fill (cost.begin (), cost.end (), ROUTE_UNREACHABLE);
+  std::fill (nextHop.begin (), nextHop.end (), NODE_UNKNOWN);
+}
+
+bool
+NodeRouteTable::HasRoute (uint32_t node) const
+{
+  return node < cost.size () && cost[node] != ROUTE_UNREACHABLE;
+}
+
+void
+NodeRouteTable::SetRoute (uint32_t node, uint32_t routeCost, uint32_t nextHopNode,
+                          Ipv4Address nextHopAddress, Ipv4Address interfaceAddress)
+{
+  cost[node] = routeCost;
+  nextHop[node] = nextHopNode;
+  nextHopAddr[node] = nextHopAddress;
+  interfaceAddr[node] = interfaceAddress;
+}
+
+void
+NodeRouteTable::RemoveRoute (uint32_t node)
+{
+  cost[node] = ROUTE_UNREACHABLE;
+  nextHop[node] = NODE_UNKNOWN;
+}
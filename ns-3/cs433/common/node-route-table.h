@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NODE_ROUTE_TABLE_H
+#define NODE_ROUTE_TABLE_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/address-directory.h"
+
+#include <vector>
+#include <limits>
+
+#define ROUTE_UNREACHABLE std::numeric_limits<uint32_t>::max()
+
+using namespace ns3;
+
+/**
+ * \brief Routing table indexed by Inet topology node number.
+ *
+ * Every column is a separate array, so SPF and Bellman-Ford passes only walk
+ * the data they actually read. Node numbers are turned into strings only when
+ * the table is dumped.
+ */
+struct NodeRouteTable
+{
+  void Resize (uint32_t nodeCount);
+  uint32_t GetNodeCount () const;
+  /**
+   * \brief Mark every destination unreachable without releasing storage.
+   */
+  void Clear ();
+
+  bool HasRoute (uint32_t node) const;
+  void SetRoute (uint32_t node, uint32_t routeCost, uint32_t nextHopNode,
+                 Ipv4Address nextHopAddress, Ipv4Address interfaceAddress);
+  void RemoveRoute (uint32_t node);
+
+  std::vector<uint32_t> cost;           // ROUTE_UNREACHABLE if there is no route
+  std::vector<uint32_t> nextHop;        // node number of the first hop
+  std::vector<Ipv4Address> nextHopAddr;
+  std::vector<Ipv4Address> interfaceAddr;
+};
+
+#endif
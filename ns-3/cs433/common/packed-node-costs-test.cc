@@ -0,0 +1,306 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/packed-node-costs.h"
+#include "ns3/ls-message.h"
+#include "ns3/dv-message.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace ns3;
+
+typedef std::vector<std::pair<uint32_t, uint32_t> > nodeCostsVec;
+
+/**
+ * \brief Serializes a PackedNodeCosts against a reference encoding and
+ * deserializes the reference back.
+ */
+class PackedNodeCostsTestCase : public TestCase
+{
+public:
+  PackedNodeCostsTestCase (std::string name, nodeCostsVec nodeCosts,
+      uint8_t * buffer, uint32_t size);
+  virtual ~PackedNodeCostsTestCase (void);
+
+protected:
+  virtual bool DoRun (void);
+
+private:
+  bool TestSerialize (void);
+  bool TestDeserialize (void);
+
+  PackedNodeCosts m_refCosts;
+  Buffer m_refBuffer;
+};
+
+PackedNodeCostsTestCase::PackedNodeCostsTestCase (std::string name, nodeCostsVec nodeCosts,
+    uint8_t * buffer, uint32_t size)
+  : TestCase (name)
+{
+  m_refCosts.nodeCosts = nodeCosts;
+
+  m_refBuffer.AddAtStart (size);
+  m_refBuffer.Begin ().Write (buffer, size);
+}
+
+PackedNodeCostsTestCase::~PackedNodeCostsTestCase (void)
+{
+  return;
+}
+
+bool
+PackedNodeCostsTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (TestSerialize (), false,
+      "serialization failed");
+  NS_TEST_ASSERT_MSG_EQ (TestDeserialize (), false,
+      "deserialization failed");
+  return GetErrorStatus ();
+}
+
+bool
+PackedNodeCostsTestCase::TestSerialize (void)
+{
+  Buffer newBuffer;
+  newBuffer.AddAtStart (m_refCosts.GetSerializedSize ());
+  Buffer::Iterator i = newBuffer.Begin ();
+  m_refCosts.Serialize (i);
+
+  NS_TEST_ASSERT_MSG_EQ (newBuffer.GetSize (), m_refBuffer.GetSize (),
+      "serialization failed, buffers have different sizes");
+
+  int memrv = memcmp (newBuffer.PeekData (), m_refBuffer.PeekData (),
+      newBuffer.GetSize ());
+
+  NS_TEST_ASSERT_MSG_EQ (memrv, 0,
+      "serialization failed, buffers differ");
+
+  return GetErrorStatus ();
+}
+
+bool
+PackedNodeCostsTestCase::TestDeserialize (void)
+{
+  PackedNodeCosts newCosts;
+  Buffer::Iterator i = m_refBuffer.Begin ();
+  uint32_t numbytes = newCosts.Deserialize (i);
+
+  NS_TEST_ASSERT_MSG_EQ (numbytes, m_refBuffer.GetSize (),
+      "deserialization failed, did not use all bytes");
+
+  NS_TEST_ASSERT_MSG_EQ (newCosts.nodeCosts.size (), m_refCosts.nodeCosts.size (),
+      "deserialization failed, entry counts do not match");
+  for (uint32_t k = 0; k < newCosts.nodeCosts.size (); k++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (newCosts.nodeCosts[k].first, m_refCosts.nodeCosts[k].first,
+          "deserialization failed, node numbers do not match");
+      NS_TEST_ASSERT_MSG_EQ (newCosts.nodeCosts[k].second, m_refCosts.nodeCosts[k].second,
+          "deserialization failed, costs do not match");
+    }
+
+  return GetErrorStatus ();
+}
+
+/**
+ * \brief Round trips the packed table messages through a packet and checks
+ * they are smaller than the address based ones.
+ */
+class PackedTableMessageTestCase : public TestCase
+{
+public:
+  PackedTableMessageTestCase ();
+  virtual ~PackedTableMessageTestCase (void);
+
+protected:
+  virtual bool DoRun (void);
+
+private:
+  bool CheckNodeCosts (nodeCostsVec got, nodeCostsVec expected);
+};
+
+PackedTableMessageTestCase::PackedTableMessageTestCase ()
+  : TestCase ("LS and DV packed table messages")
+{
+}
+
+PackedTableMessageTestCase::~PackedTableMessageTestCase (void)
+{
+  return;
+}
+
+bool
+PackedTableMessageTestCase::CheckNodeCosts (nodeCostsVec got, nodeCostsVec expected)
+{
+  NS_TEST_ASSERT_MSG_EQ (got.size (), expected.size (), "entry counts do not match");
+  for (uint32_t k = 0; k < got.size (); k++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (got[k].first, expected[k].first, "node numbers do not match");
+      NS_TEST_ASSERT_MSG_EQ (got[k].second, expected[k].second, "costs do not match");
+    }
+  return GetErrorStatus ();
+}
+
+bool
+PackedTableMessageTestCase::DoRun (void)
+{
+  Ipv4Address originator ("10.0.0.1");
+
+  // LSA of a node with unit-cost links, handed over unsorted
+  nodeCostsVec lsa;
+  lsa.push_back (std::make_pair (12, 1));
+  lsa.push_back (std::make_pair (3, 1));
+  lsa.push_back (std::make_pair (7, 1));
+  lsa.push_back (std::make_pair (4, 1));
+  nodeCostsVec sortedLsa = lsa;
+  std::sort (sortedLsa.begin (), sortedLsa.end ());
+
+  LSMessage lsMessage (LSMessage::LS_TABLE_PACKED_MSG, 42, 16, originator);
+  lsMessage.SetLSTablePackedMsg (lsa);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (lsMessage);
+
+  LSMessage lsReceived;
+  uint32_t lsSize = packet->RemoveHeader (lsReceived);
+  NS_TEST_ASSERT_MSG_EQ (lsSize, lsMessage.GetSerializedSize (), "LS header size mismatch");
+  NS_TEST_ASSERT_MSG_EQ (lsReceived.GetMessageType (), LSMessage::LS_TABLE_PACKED_MSG, "LS message type mismatch");
+  NS_TEST_ASSERT_MSG_EQ (lsReceived.GetSequenceNumber (), 42, "LS sequence number mismatch");
+  NS_TEST_ASSERT_MSG_EQ (lsReceived.GetTTL (), 16, "LS TTL mismatch");
+  NS_TEST_ASSERT_MSG_EQ (lsReceived.GetOriginatorAddress (), originator, "LS originator mismatch");
+  NS_TEST_ASSERT_MSG_EQ (lsReceived.GetLSTablePackedMsg ().GetFormat (), PackedNodeCosts::UNIT_BITMAP, "LS unit-cost LSA not sent as bitmap");
+  NS_TEST_ASSERT_MSG_EQ (CheckNodeCosts (lsReceived.GetLSTablePackedMsg ().nodeCosts, sortedLsa), false, "LS payload mismatch");
+
+  LSMessage::nbrCostsVec lsaAddrs;
+  for (uint32_t k = 0; k < lsa.size (); k++)
+    {
+      lsaAddrs.push_back (std::make_pair (Ipv4Address (0x0a000000 + lsa[k].first), lsa[k].second));
+    }
+  LSMessage lsUnpacked (LSMessage::LS_TABLE_MSG, 42, 16, originator);
+  lsUnpacked.SetLSTableMsg (lsaAddrs);
+  NS_TEST_ASSERT_MSG_LT (lsMessage.GetSerializedSize (), lsUnpacked.GetSerializedSize (), "packed LSA is not smaller");
+
+  // Distance vector update with poisoned and multi-byte costs
+  nodeCostsVec dv;
+  dv.push_back (std::make_pair (0, 2));
+  dv.push_back (std::make_pair (5, 0x7fffffff));
+  dv.push_back (std::make_pair (300, 16));
+
+  DVMessage dvMessage (DVMessage::DV_UPDATE_PACKED_MSG, 7, 1, originator);
+  dvMessage.SetDVTablePackedMsg (dv);
+  packet = Create<Packet> ();
+  packet->AddHeader (dvMessage);
+
+  DVMessage dvReceived;
+  uint32_t dvSize = packet->RemoveHeader (dvReceived);
+  NS_TEST_ASSERT_MSG_EQ (dvSize, dvMessage.GetSerializedSize (), "DV header size mismatch");
+  NS_TEST_ASSERT_MSG_EQ (dvReceived.GetMessageType (), DVMessage::DV_UPDATE_PACKED_MSG, "DV message type mismatch");
+  NS_TEST_ASSERT_MSG_EQ (dvReceived.GetSequenceNumber (), 7, "DV sequence number mismatch");
+  NS_TEST_ASSERT_MSG_EQ (dvReceived.GetDVTablePackedMsg ().GetFormat (), PackedNodeCosts::DELTA, "DV update not sent as deltas");
+  NS_TEST_ASSERT_MSG_EQ (CheckNodeCosts (dvReceived.GetDVTablePackedMsg ().nodeCosts, dv), false, "DV payload mismatch");
+
+  // the address based table must consume all its bytes too
+  DVMessage::nbrCostsVec dvAddrs;
+  for (uint32_t k = 0; k < dv.size (); k++)
+    {
+      dvAddrs.push_back (std::make_pair (Ipv4Address (0x0a000000 + dv[k].first), dv[k].second));
+    }
+  DVMessage dvUnpacked (DVMessage::DV_TABLE_MSG, 8, 1, originator);
+  dvUnpacked.SetDVTableMsg (dvAddrs);
+  packet = Create<Packet> ();
+  packet->AddHeader (dvUnpacked);
+  DVMessage dvUnpackedReceived;
+  uint32_t dvUnpackedSize = packet->RemoveHeader (dvUnpackedReceived);
+  NS_TEST_ASSERT_MSG_EQ (dvUnpackedSize, dvUnpacked.GetSerializedSize (), "DV table header size mismatch");
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 0, "DV table bytes left in the packet");
+  NS_TEST_ASSERT_MSG_EQ (dvUnpackedReceived.GetDVTableMsg ().neighborCosts.size (), dvAddrs.size (), "DV table entry count mismatch");
+
+  return GetErrorStatus ();
+}
+
+class PackedNodeCostsTestSuite : public TestSuite
+{
+public:
+  PackedNodeCostsTestSuite ();
+};
+
+PackedNodeCostsTestSuite::PackedNodeCostsTestSuite ()
+  : TestSuite ("cs433-packed-node-costs", UNIT)
+{
+  /* Test 1: empty list, delta format with count 0 */
+  {
+    nodeCostsVec nodeCosts;
+    uint8_t buffer[] = {0x00, 0x00};
+    AddTestCase (new PackedNodeCostsTestCase ("empty", nodeCosts, buffer, sizeof(buffer)));
+  }
+
+  /* Test 2: node gaps and a cost other than 1
+   *   2:1, 3:1, 40:7 -> count 3, (2,1) (1,1) (37,7)
+   */
+  {
+    nodeCostsVec nodeCosts;
+    nodeCosts.push_back (std::make_pair (2, 1));
+    nodeCosts.push_back (std::make_pair (3, 1));
+    nodeCosts.push_back (std::make_pair (40, 7));
+    uint8_t buffer[] = {0x00, 0x03, 0x02, 0x01, 0x01, 0x01, 0x25, 0x07};
+    AddTestCase (new PackedNodeCostsTestCase ("delta", nodeCosts, buffer, sizeof(buffer)));
+  }
+
+  /* Test 3: dense unit-cost adjacency goes out as a bitmap
+   *   1, 3, 4, 9 -> first 1, 2 bytes, bits 0 2 3 | 8
+   */
+  {
+    nodeCostsVec nodeCosts;
+    nodeCosts.push_back (std::make_pair (1, 1));
+    nodeCosts.push_back (std::make_pair (3, 1));
+    nodeCosts.push_back (std::make_pair (4, 1));
+    nodeCosts.push_back (std::make_pair (9, 1));
+    uint8_t buffer[] = {0x01, 0x01, 0x02, 0x0d, 0x01};
+    AddTestCase (new PackedNodeCostsTestCase ("unit bitmap", nodeCosts, buffer, sizeof(buffer)));
+  }
+
+  /* Test 4: sparse unit-cost adjacency stays in deltas, 1000 takes two bytes */
+  {
+    nodeCostsVec nodeCosts;
+    nodeCosts.push_back (std::make_pair (0, 1));
+    nodeCosts.push_back (std::make_pair (1000, 1));
+    uint8_t buffer[] = {0x00, 0x02, 0x00, 0x01, 0xe8, 0x07, 0x01};
+    AddTestCase (new PackedNodeCostsTestCase ("sparse unit", nodeCosts, buffer, sizeof(buffer)));
+  }
+
+  /* Test 5: infinite cost takes the full five varint bytes */
+  {
+    nodeCostsVec nodeCosts;
+    nodeCosts.push_back (std::make_pair (5, 0x7fffffff));
+    uint8_t buffer[] = {0x00, 0x01, 0x05, 0xff, 0xff, 0xff, 0xff, 0x07};
+    AddTestCase (new PackedNodeCostsTestCase ("infinite cost", nodeCosts, buffer, sizeof(buffer)));
+  }
+
+  AddTestCase (new PackedTableMessageTestCase ());
+}
+
+static PackedNodeCostsTestSuite packedNodeCostsTestSuite;
+
+int
+main (int argc, char *argv[])
+{
+  packedNodeCostsTestSuite.SetVerbose (true);
+  bool failed = packedNodeCostsTestSuite.Run ();
+  std::cout << (failed ? "FAIL: " : "PASS: ") << packedNodeCostsTestSuite.GetName () << std::endl;
+  return failed ? 1 : 0;
+}
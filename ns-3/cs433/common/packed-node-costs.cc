@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/packed-node-costs.h"
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+using namespace ns3;
+
+uint32_t
+PackedNodeCosts::GetVarintSize (uint32_t value)
+{
+  uint32_t size = 1;
+  while (value >= 0x80)
+    {
+      value >>= 7;
+      size++;
+    }
+  return size;
+}
+
+void
+PackedNodeCosts::WriteVarint (Buffer::Iterator &start, uint32_t value)
+{
+  while (value >= 0x80)
+    {
+      start.WriteU8 ((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+  start.WriteU8 (value);
+}
+
+uint32_t
+PackedNodeCosts::ReadVarint (Buffer::Iterator &start)
+{
+  uint32_t value = 0;
+  // A 32-bit value takes at most five groups
+  for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+      uint8_t byte = start.ReadU8 ();
+      value |= (uint32_t) (byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        {
+          break;
+        }
+    }
+  return value;
+}
+
+void
+PackedNodeCosts::Sort ()
+{
+  std::sort (nodeCosts.begin (), nodeCosts.end ());
+}
+
+uint32_t
+PackedNodeCosts::GetDeltaSize (void) const
+{
+  uint32_t size = GetVarintSize (nodeCosts.size ());
+  uint32_t previous = 0;
+  for (unsigned i = 0; i < nodeCosts.size (); i++)
+    {
+      size += GetVarintSize (nodeCosts[i].first - previous) + GetVarintSize (nodeCosts[i].second);
+      previous = nodeCosts[i].first;
+    }
+  return size;
+}
+
+uint32_t
+PackedNodeCosts::GetBitmapSize (void) const
+{
+  uint32_t first = nodeCosts.front ().first;
+  uint32_t bytes = (nodeCosts.back ().first - first) / 8 + 1;
+  return GetVarintSize (first) + GetVarintSize (bytes) + bytes;
+}
+
+PackedNodeCosts::Format
+PackedNodeCosts::GetFormat (void) const
+{
+  if (nodeCosts.empty ())
+    {
+      return DELTA;
+    }
+  // The bitmap only holds strictly increasing unit-cost entries
+  for (unsigned i = 0; i < nodeCosts.size (); i++)
+    {
+      if (nodeCosts[i].second != 1 || (i > 0 && nodeCosts[i].first <= nodeCosts[i - 1].first))
+        {
+          return DELTA;
+        }
+    }
+  return GetBitmapSize () < GetDeltaSize () ? UNIT_BITMAP : DELTA;
+}
+
+uint32_t
+PackedNodeCosts::GetSerializedSize (void) const
+{
+  if (GetFormat () == UNIT_BITMAP)
+    {
+      return sizeof (uint8_t) + GetBitmapSize ();
+    }
+  return sizeof (uint8_t) + GetDeltaSize ();
+}
+
+void
+PackedNodeCosts::Print (std::ostream &os) const
+{
+  os << "PackedNodeCosts:: " << (GetFormat () == UNIT_BITMAP ? "bitmap" : "delta") << " Nodes: ";
+  for (unsigned i = 0; i < nodeCosts.size (); i++)
+    {
+      os << nodeCosts[i].first << ":" << nodeCosts[i].second << ", ";
+    }
+  os << "\n";
+}
+
+void
+PackedNodeCosts::Serialize (Buffer::Iterator &start) const
+{
+  Format format = GetFormat ();
+  start.WriteU8 (format);
+  if (format == UNIT_BITMAP)
+    {
+      uint32_t first = nodeCosts.front ().first;
+      uint32_t bytes = (nodeCosts.back ().first - first) / 8 + 1;
+      WriteVarint (start, first);
+      WriteVarint (start, bytes);
+      std::vector<uint8_t> bitmap (bytes, 0);
+      for (unsigned i = 0; i < nodeCosts.size (); i++)
+        {
+          uint32_t bit = nodeCosts[i].first - first;
+          bitmap[bit / 8] |= 1 << (bit % 8);
+        }
+      start.Write (&bitmap[0], bytes);
+      return;
+    }
+
+  WriteVarint (start, nodeCosts.size ());
+  uint32_t previous = 0;
+  for (unsigned i = 0; i < nodeCosts.size (); i++)
+    {
+      NS_ASSERT_MSG (nodeCosts[i].first >= previous, "PackedNodeCosts must be sorted before Serialize");
+      WriteVarint (start, nodeCosts[i].first - previous);
+      WriteVarint (start, nodeCosts[i].second);
+      previous = nodeCosts[i].first;
+    }
+}
+
+uint32_t
+PackedNodeCosts::Deserialize (Buffer::Iterator &start)
+{
+  nodeCosts.clear ();
+  uint32_t size = sizeof (uint8_t);
+  uint8_t format = start.ReadU8 ();
+  if (format == UNIT_BITMAP)
+    {
+      uint32_t first = ReadVarint (start);
+      uint32_t bytes = ReadVarint (start);
+      size += GetVarintSize (first) + GetVarintSize (bytes) + bytes;
+      for (uint32_t i = 0; i < bytes; i++)
+        {
+          uint8_t byte = start.ReadU8 ();
+          for (uint32_t bit = 0; bit < 8; bit++)
+            {
+              if (byte & (1 << bit))
+                {
+                  nodeCosts.push_back (std::make_pair (first + 8 * i + bit, (uint32_t) 1));
+                }
+            }
+        }
+      return size;
+    }
+
+  uint32_t count = ReadVarint (start);
+  size += GetVarintSize (count);
+  uint32_t node = 0;
+  nodeCosts.reserve (count);
+  for (uint32_t i = 0; i < count; i++)
+    {
+      uint32_t gap = ReadVarint (start);
+      uint32_t cost = ReadVarint (start);
+      size += GetVarintSize (gap) + GetVarintSize (cost);
+      node += gap;
+      nodeCosts.push_back (std::make_pair (node, cost));
+    }
+  return size;
+}
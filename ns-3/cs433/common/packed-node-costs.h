@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKED_NODE_COSTS_H
+#define PACKED_NODE_COSTS_H
+
+#include "ns3/buffer.h"
+
+#include <vector>
+#include <ostream>
+
+using namespace ns3;
+
+/**
+ * \brief Compact wire encoding of a (node number, cost) list.
+ *
+ * Payload of the packed LS and DV table messages. Destinations are sent as
+ * node numbers of the shared topology instead of 4-byte addresses, sorted so
+ * that only the gap to the previous node is written. Numbers are base-128
+ * varints, least significant group first. Lists where every cost is 1 may go
+ * out as a bitmap over the node range instead; the smaller form is picked.
+ *
+ *   u8 format
+ *   DELTA:       varint count, then per entry varint node gap, varint cost
+ *   UNIT_BITMAP: varint first node, varint byte count, bitmap (bit i of byte
+ *                i / 8, LSB first, is node first + i)
+ */
+struct PackedNodeCosts
+  {
+    enum Format
+      {
+        DELTA = 0,
+        UNIT_BITMAP = 1,
+      };
+
+    void Print (std::ostream &os) const;
+    uint32_t GetSerializedSize (void) const;
+    void Serialize (Buffer::Iterator &start) const;
+    uint32_t Deserialize (Buffer::Iterator &start);
+    /**
+     * \brief Sort the entries by node number, as Serialize expects.
+     */
+    void Sort ();
+    /**
+     * \returns the format Serialize will use.
+     */
+    Format GetFormat (void) const;
+
+    static uint32_t GetVarintSize (uint32_t value);
+    static void WriteVarint (Buffer::Iterator &start, uint32_t value);
+    static uint32_t ReadVarint (Buffer::Iterator &start);
+
+    // Payload
+    std::vector<std::pair<uint32_t, uint32_t> > nodeCosts;
+
+  private:
+    uint32_t GetDeltaSize (void) const;
+    uint32_t GetBitmapSize (void) const;
+  };
+
+#endif
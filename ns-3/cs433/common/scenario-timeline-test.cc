@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/scenario-timeline.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * \brief Runs a scenario timeline and records when each entry ran and how
+ * many were still pending at that point.
+ */
+class ScenarioTimelineTestCase : public TestCase
+{
+public:
+  ScenarioTimelineTestCase ();
+  virtual ~ScenarioTimelineTestCase (void);
+
+protected:
+  virtual bool DoRun (void);
+
+private:
+  enum
+  {
+    OP_RECORD,
+    OP_ADD_LATER
+  };
+  struct Run
+  {
+    Time time;
+    uint32_t node;
+    uint32_t pending;
+  };
+  void Execute (uint8_t opcode, uint32_t node, uint32_t arg, uint32_t tokens);
+  void AddInteractive (uint32_t node);
+
+  ScenarioTimeline m_timeline;
+  std::vector<Run> m_runs;
+};
+
+ScenarioTimelineTestCase::ScenarioTimelineTestCase ()
+  : TestCase ("scenario timeline order, late entries and compaction")
+{
+}
+
+ScenarioTimelineTestCase::~ScenarioTimelineTestCase (void)
+{
+  return;
+}
+
+void
+ScenarioTimelineTestCase::Execute (uint8_t opcode, uint32_t node, uint32_t arg, uint32_t tokens)
+{
+  Run run;
+  run.time = Simulator::Now ();
+  run.node = node;
+  run.pending = m_timeline.GetEntryCount ();
+  m_runs.push_back (run);
+  if (opcode == OP_ADD_LATER)
+    {
+      m_timeline.Add (Simulator::Now () + MilliSeconds (arg), OP_RECORD, node + 1, 0,
+                      m_timeline.Intern (m_timeline.GetTokens (tokens)));
+    }
+}
+
+void
+ScenarioTimelineTestCase::AddInteractive (uint32_t node)
+{
+  // as simulator-main does for a command typed in with no delay
+  m_timeline.Add (Simulator::Now (), OP_RECORD, node, 0, ScenarioTimeline::NO_TOKENS);
+}
+
+bool
+ScenarioTimelineTestCase::DoRun (void)
+{
+  m_timeline.SetExecutor (MakeCallback (&ScenarioTimelineTestCase::Execute, this));
+
+  std::vector<std::string> tokens;
+  tokens.push_back ("PING");
+  tokens.push_back ("10.0.0.1");
+  uint32_t id = m_timeline.Intern (tokens);
+  NS_TEST_ASSERT_MSG_EQ (m_timeline.Intern (tokens), id, "token list interned twice");
+
+  // added out of order, the two at 10ms must keep their order
+  m_timeline.Add (MilliSeconds (30), OP_RECORD, 5, 0, ScenarioTimeline::NO_TOKENS);
+  m_timeline.Add (MilliSeconds (10), OP_RECORD, 1, 0, id);
+  m_timeline.Add (MilliSeconds (10), OP_RECORD, 2, 0, ScenarioTimeline::NO_TOKENS);
+  m_timeline.Add (MilliSeconds (20), OP_ADD_LATER, 3, 5, id);
+  m_timeline.Add (MilliSeconds (40), OP_RECORD, 7, 0, ScenarioTimeline::NO_TOKENS);
+  m_timeline.Start ();
+  // an interactive command at a fractional millisecond, then one in between
+  Simulator::Schedule (MicroSeconds (12300), &ScenarioTimelineTestCase::AddInteractive, this, 10);
+  Simulator::Schedule (MicroSeconds (34700), &ScenarioTimelineTestCase::AddInteractive, this, 6);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  uint32_t expectedNodes[] = { 1, 2, 10, 3, 4, 5, 6, 7 };
+  Time expectedTimes[] = { MilliSeconds (10), MilliSeconds (10), MicroSeconds (12300),
+                           MilliSeconds (20), MilliSeconds (25), MilliSeconds (30),
+                           MicroSeconds (34700), MilliSeconds (40) };
+  // the entries not run yet when each entry runs, the 25ms one is added at 20ms
+  uint32_t expectedPending[] = { 4, 3, 3, 2, 2, 1, 1, 0 };
+  NS_TEST_ASSERT_MSG_EQ (m_runs.size (), 8, "entries missing or run twice");
+  for (uint32_t k = 0; k < m_runs.size (); k++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_runs[k].node, expectedNodes[k], "entry " << k << " out of order");
+      NS_TEST_ASSERT_MSG_EQ (m_runs[k].time, expectedTimes[k], "entry " << k << " ran at the wrong time");
+      NS_TEST_ASSERT_MSG_EQ (m_runs[k].pending, expectedPending[k], "entry " << k << " pending count");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_timeline.GetEntryCount (), 0, "entries left after the run");
+  NS_TEST_ASSERT_MSG_EQ (m_timeline.GetTokenListCount (), 2, "token lists not shared");
+  return GetErrorStatus ();
+}
+
+class ScenarioTimelineTestSuite : public TestSuite
+{
+public:
+  ScenarioTimelineTestSuite ();
+};
+
+ScenarioTimelineTestSuite::ScenarioTimelineTestSuite ()
+  : TestSuite ("cs433-scenario-timeline", UNIT)
+{
+  AddTestCase (new ScenarioTimelineTestCase ());
+}
+
+static ScenarioTimelineTestSuite scenarioTimelineTestSuite;
+
+int
+main (int argc, char *argv[])
+{
+  scenarioTimelineTestSuite.SetVerbose (true);
+  bool failed = scenarioTimelineTestSuite.Run ();
+  std::cout << (failed ? "FAIL: " : "PASS: ") << scenarioTimelineTestSuite.GetName () << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/scenario-timeline.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+const uint32_t ScenarioTimeline::NO_TOKENS;
+
+ScenarioTimeline::ScenarioTimeline ()
+  : m_cursor (0),
+    m_started (false),
+    m_advancing (false)
+{
+  Intern (std::vector<std::string> ());
+}
+
+void
+ScenarioTimeline::SetExecutor (Executor executor)
+{
+  m_executor = executor;
+}
+
+uint32_t
+ScenarioTimeline::Intern (const std::vector<std::string> &tokens)
+{
+  std::map<std::vector<std::string>, uint32_t>::iterator it = m_tokenIds.find (tokens);
+  if (it != m_tokenIds.end ())
+    {
+      return it->second;
+    }
+  uint32_t id = m_tokenLists.size ();
+  m_tokenLists.push_back (tokens);
+  m_tokenIds.insert (std::make_pair (tokens, id));
+  return id;
+}
+
+const std::vector<std::string> &
+ScenarioTimeline::GetTokens (uint32_t tokens) const
+{
+  return m_tokenLists[tokens];
+}
+
+bool
+ScenarioTimeline::EntryTimeLess (const Entry &a, const Entry &b)
+{
+  return a.timeStep < b.timeStep;
+}
+
+void
+ScenarioTimeline::Add (Time at, uint8_t opcode, uint32_t node, uint32_t arg, uint32_t tokens)
+{
+  Entry entry;
+  entry.timeStep = at.GetTimeStep ();
+  entry.node = node;
+  entry.arg = arg;
+  entry.tokens = tokens;
+  entry.opcode = opcode;
+  if (!m_started)
+    {
+      m_entries.push_back (entry);
+      return;
+    }
+  // After everything due at the same time, and never before the cursor
+  std::vector<Entry>::iterator position =
+    std::upper_bound (m_entries.begin () + m_cursor, m_entries.end (), entry, &ScenarioTimeline::EntryTimeLess);
+  bool first = position == m_entries.begin () + m_cursor;
+  m_entries.insert (position, entry);
+  if (first && !m_advancing)
+    {
+      ScheduleCursor ();
+    }
+}
+
+void
+ScenarioTimeline::Start ()
+{
+  std::stable_sort (m_entries.begin (), m_entries.end (), &ScenarioTimeline::EntryTimeLess);
+  m_started = true;
+  m_cursor = 0;
+  ScheduleCursor ();
+}
+
+uint32_t
+ScenarioTimeline::GetEntryCount () const
+{
+  return m_entries.size () - m_cursor;
+}
+
+uint32_t
+ScenarioTimeline::GetTokenListCount () const
+{
+  return m_tokenLists.size ();
+}
+
+void
+ScenarioTimeline::ScheduleCursor ()
+{
+  Simulator::Cancel (m_cursorEvent);
+  if (m_cursor == m_entries.size ())
+    {
+      return;
+    }
+  Time delay = TimeStep (m_entries[m_cursor].timeStep) - Simulator::Now ();
+  if (delay < Seconds (0))
+    {
+      delay = Seconds (0);
+    }
+  m_cursorEvent = Simulator::Schedule (delay, &ScenarioTimeline::Advance, this);
+}
+
+void
+ScenarioTimeline::Advance ()
+{
+  Time now = Simulator::Now ();
+  m_advancing = true;
+  // The executor may add entries, so copy each one out before running it
+  while (m_cursor < m_entries.size () && TimeStep (m_entries[m_cursor].timeStep) <= now)
+    {
+      Entry entry = m_entries[m_cursor++];
+      m_executor (entry.opcode, entry.node, entry.arg, entry.tokens);
+    }
+  // Drop what has run once it is at least half of the array, so that an
+  // interactive session keeps only the pending entries and the erase cost
+  // stays proportional to the entries run
+  if (2 * m_cursor >= m_entries.size ())
+    {
+      m_entries.erase (m_entries.begin (), m_entries.begin () + m_cursor);
+      m_cursor = 0;
+    }
+  m_advancing = false;
+  ScheduleCursor ();
+}
@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef SCENARIO_TIMELINE_H
+#define SCENARIO_TIMELINE_H
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief Scenario commands compiled into one time sorted array of opcodes.
+ *
+ * Every command becomes a small fixed size entry: an opcode, a node, one
+ * numeric argument and the id of its interned token list, so commands that
+ * fan out to all nodes or repeat the same arguments share one copy of the
+ * strings. A single cursor event walks the array, it runs every entry that is
+ * due and then schedules itself for the next one, so the simulator never
+ * holds more than one event for the whole scenario.
+ *
+ * Entries at the same time run in the order they were added. What an opcode
+ * means is up to the executor set with SetExecutor ().
+ */
+class ScenarioTimeline
+{
+  public:
+    /**
+     * \brief Called for each entry: opcode, node, argument and token list id.
+     */
+    typedef Callback<void, uint8_t, uint32_t, uint32_t, uint32_t> Executor;
+
+    /// Token list id of the empty token list
+    static const uint32_t NO_TOKENS = 0;
+
+    ScenarioTimeline ();
+
+    void SetExecutor (Executor executor);
+
+    /**
+     * \brief Return the id of this token list, adding it if it was not seen yet.
+     */
+    uint32_t Intern (const std::vector<std::string> &tokens);
+    const std::vector<std::string> &GetTokens (uint32_t tokens) const;
+
+    /**
+     * \brief Add an entry at an absolute simulation time.
+     *
+     * Before Start () this only appends. Afterwards the entry is merged into
+     * the remaining ones and the cursor is moved if the entry comes first.
+     * Entries already due run at the next cursor event.
+     */
+    void Add (Time at, uint8_t opcode, uint32_t node, uint32_t arg, uint32_t tokens);
+
+    /**
+     * \brief Sort what was added so far and schedule the cursor.
+     */
+    void Start ();
+
+    /**
+     * \returns the number of entries that have not run yet.
+     */
+    uint32_t GetEntryCount () const;
+    uint32_t GetTokenListCount () const;
+
+  private:
+    struct Entry
+    {
+      // Absolute time in simulator time steps, kept exact so that commands
+      // added at a fractional millisecond do not shift later entries
+      int64_t timeStep;
+      uint32_t node;
+      uint32_t arg;
+      uint32_t tokens;
+      uint8_t opcode;
+    };
+    static bool EntryTimeLess (const Entry &a, const Entry &b);
+
+    void ScheduleCursor ();
+    void Advance ();
+
+    Executor m_executor;
+    std::vector<Entry> m_entries;
+    uint32_t m_cursor;
+    EventId m_cursorEvent;
+    bool m_started;
+    bool m_advancing;
+    std::vector<std::vector<std::string> > m_tokenLists;
+    std::map<std::vector<std::string>, uint32_t> m_tokenIds;
+};
+
+#endif /* SCENARIO_TIMELINE_H */
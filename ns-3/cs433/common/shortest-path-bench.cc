@@ -0,0 +1,193 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Micro-benchmark for the shortest path kernel in shortest-path.h.
+ *
+ * Runs single source shortest paths from several roots of a random graph
+ * with every frontier, next to the per-LSA vector and linear scan loop the
+ * LS routing protocol used before, and checks that they agree on the costs.
+ *
+ *   ./waf --run "shortest-path-bench --nodes=2000 --degree=4 --maxCost=1"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/shortest-path.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <utility>
+
+using namespace ns3;
+
+typedef std::vector<std::pair<uint32_t, uint32_t> > nodeCostsVec;
+
+// One vector per node, the way the LS database stores the LSAs
+static void
+BuildAdjacency (uint32_t nodes, uint32_t degree, uint32_t maxCost, std::vector<nodeCostsVec> &adjacency)
+{
+  UniformVariable random;
+  adjacency.assign (nodes, nodeCostsVec ());
+  // A ring keeps everything reachable, the rest are random chords
+  for (uint32_t node = 0; node < nodes; node++)
+    {
+      uint32_t next = (node + 1) % nodes;
+      uint32_t cost = random.GetInteger (1, maxCost);
+      adjacency[node].push_back (std::make_pair (next, cost));
+      adjacency[next].push_back (std::make_pair (node, cost));
+    }
+  uint32_t chords = nodes * (degree > 2 ? degree - 2 : 0) / 2;
+  for (uint32_t i = 0; i < chords; i++)
+    {
+      uint32_t a = random.GetInteger (0, nodes - 1);
+      uint32_t b = random.GetInteger (0, nodes - 1);
+      if (a == b)
+        {
+          continue;
+        }
+      uint32_t cost = random.GetInteger (1, maxCost);
+      adjacency[a].push_back (std::make_pair (b, cost));
+      adjacency[b].push_back (std::make_pair (a, cost));
+    }
+}
+
+// The SPF loop as it was: vector<bool> settled flags and a scan for the closest node
+static void
+LegacyShortestPaths (const std::vector<nodeCostsVec> &adjacency, uint32_t source, std::vector<uint32_t> &cost)
+{
+  cost.assign (adjacency.size (), ROUTE_UNREACHABLE);
+  std::vector<bool> leastCostFound (adjacency.size (), false);
+  cost[source] = 0;
+  while (true)
+    {
+      uint32_t min = ROUTE_UNREACHABLE;
+      uint32_t current = NODE_UNKNOWN;
+      for (uint32_t node = 0; node < cost.size (); node++)
+        {
+          if (!leastCostFound[node] && cost[node] < min)
+            {
+              min = cost[node];
+              current = node;
+            }
+        }
+      if (current == NODE_UNKNOWN)
+        {
+          break;
+        }
+      leastCostFound[current] = true;
+      const nodeCostsVec &neighbors = adjacency[current];
+      for (unsigned j = 0; j < neighbors.size (); j++)
+        {
+          uint32_t newCost = cost[current] + neighbors[j].second;
+          if (newCost < cost[neighbors[j].first])
+            {
+              cost[neighbors[j].first] = newCost;
+            }
+        }
+    }
+}
+
+static void
+Report (const char *name, uint32_t runs, double ms)
+{
+  std::cout << std::setw (12) << name << " runs=" << runs << ", time=" << ms / 1000 << "s"
+            << ", avg=" << ms / runs << "ms" << std::endl;
+}
+
+template <class Frontier>
+static bool
+BenchFrontier (const char *name, const CsrGraph &graph, const std::vector<std::vector<uint32_t> > &expected,
+               uint32_t runs)
+{
+  Frontier frontier;
+  std::vector<uint32_t> cost, parent, firstHop;
+  bool match = true;
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t run = 0; run < runs; run++)
+    {
+      ShortestPaths (graph, run % graph.GetNodeCount (), frontier, cost, parent, firstHop);
+      match = match && cost == expected[run];
+    }
+  Report (name, runs, time.End ());
+  if (!match)
+    {
+      std::cout << name << ": path costs differ from the linear scan" << std::endl;
+    }
+  return match;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 2000;
+  uint32_t degree = 4;
+  uint32_t maxCost = 1;
+  uint32_t runs = 50;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes in the random graph", nodes);
+  cmd.AddValue ("degree", "Average node degree", degree);
+  cmd.AddValue ("maxCost", "Link costs are drawn uniformly from 1 to maxCost", maxCost);
+  cmd.AddValue ("runs", "Number of SPF runs per frontier", runs);
+  cmd.Parse (argc, argv);
+  if (nodes < 2 || maxCost < 1)
+    {
+      std::cerr << "Need at least 2 nodes and a positive maxCost" << std::endl;
+      return 1;
+    }
+
+  SeedManager::SetSeed (1);
+  std::vector<nodeCostsVec> adjacency;
+  BuildAdjacency (nodes, degree, maxCost, adjacency);
+
+  SystemWallClockMs time;
+  time.Start ();
+  CsrGraph graph;
+  for (uint32_t node = 0; node < nodes; node++)
+    {
+      for (unsigned j = 0; j < adjacency[node].size (); j++)
+        {
+          graph.AddLink (adjacency[node][j].first, adjacency[node][j].second);
+        }
+      graph.EndNode ();
+    }
+  double snapshot = time.End ();
+  std::cout << "graph nodes=" << graph.GetNodeCount () << ", links=" << graph.GetLinkCount ()
+            << ", max cost=" << graph.GetMaxCost () << ", csr snapshot=" << snapshot << "ms" << std::endl;
+
+  std::vector<std::vector<uint32_t> > expected (runs);
+  time.Start ();
+  for (uint32_t run = 0; run < runs; run++)
+    {
+      LegacyShortestPaths (adjacency, run % nodes, expected[run]);
+    }
+  Report ("legacy", runs, time.End ());
+
+  bool match = BenchFrontier<LinearScanFrontier> ("linear-scan", graph, expected, runs);
+  match = BenchFrontier<IndexedBinaryHeap> ("binary-heap", graph, expected, runs) && match;
+  match = BenchFrontier<RadixHeap> ("radix-heap", graph, expected, runs) && match;
+  if (DialBuckets::IsUsable (graph.GetMaxCost ()))
+    {
+      match = BenchFrontier<DialBuckets> ("dial", graph, expected, runs) && match;
+    }
+  else
+    {
+      std::cout << std::setw (12) << "dial" << " skipped, max cost above " << DialBuckets::MAX_LINK_COST << std::endl;
+    }
+  return match ? 0 : 1;
+}
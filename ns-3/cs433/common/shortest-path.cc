@@ -0,0 +1,358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/shortest-path.h"
+#include "ns3/assert.h"
+
+using namespace ns3;
+
+CsrGraph::CsrGraph ()
+  : m_maxCost (0)
+{
+  m_offsets.push_back (0);
+}
+
+void
+CsrGraph::Clear ()
+{
+  m_offsets.clear ();
+  m_offsets.push_back (0);
+  m_targets.clear ();
+  m_costs.clear ();
+  m_maxCost = 0;
+}
+
+void
+CsrGraph::AddLink (uint32_t to, uint32_t cost)
+{
+  m_targets.push_back (to);
+  m_costs.push_back (cost);
+  if (cost > m_maxCost)
+    {
+      m_maxCost = cost;
+    }
+}
+
+void
+CsrGraph::EndNode ()
+{
+  m_offsets.push_back (m_targets.size ());
+}
+
+uint32_t
+CsrGraph::GetNodeCount () const
+{
+  return m_offsets.size () - 1;
+}
+
+uint32_t
+CsrGraph::GetLinkCount () const
+{
+  return m_targets.size ();
+}
+
+uint32_t
+CsrGraph::GetMaxCost () const
+{
+  return m_maxCost;
+}
+
+uint32_t
+CsrGraph::GetBegin (uint32_t node) const
+{
+  return m_offsets[node];
+}
+
+uint32_t
+CsrGraph::GetEnd (uint32_t node) const
+{
+  return m_offsets[node + 1];
+}
+
+uint32_t
+CsrGraph::GetTarget (uint32_t link) const
+{
+  return m_targets[link];
+}
+
+uint32_t
+CsrGraph::GetCost (uint32_t link) const
+{
+  return m_costs[link];
+}
+
+void
+LinearScanFrontier::Reset (uint32_t nodeCount, uint32_t maxLinkCost)
+{
+  m_keys.assign (nodeCount, ROUTE_UNREACHABLE);
+  m_size = 0;
+}
+
+bool
+LinearScanFrontier::IsEmpty () const
+{
+  return m_size == 0;
+}
+
+void
+LinearScanFrontier::Update (uint32_t node, uint32_t key)
+{
+  if (m_keys[node] == ROUTE_UNREACHABLE)
+    {
+      m_size++;
+    }
+  m_keys[node] = key;
+}
+
+uint32_t
+LinearScanFrontier::PopMin (uint32_t &key)
+{
+  uint32_t closest = NODE_UNKNOWN;
+  key = ROUTE_UNREACHABLE;
+  for (uint32_t node = 0; node < m_keys.size (); node++)
+    {
+      if (m_keys[node] < key)
+        {
+          key = m_keys[node];
+          closest = node;
+        }
+    }
+  NS_ASSERT (closest != NODE_UNKNOWN);
+  // Settled nodes are never updated again, so they can just leave the scan
+  m_keys[closest] = ROUTE_UNREACHABLE;
+  m_size--;
+  return closest;
+}
+
+void
+IndexedBinaryHeap::Reset (uint32_t nodeCount, uint32_t maxLinkCost)
+{
+  m_heap.clear ();
+  m_keys.assign (nodeCount, ROUTE_UNREACHABLE);
+  m_position.assign (nodeCount, NODE_UNKNOWN);
+}
+
+bool
+IndexedBinaryHeap::IsEmpty () const
+{
+  return m_heap.empty ();
+}
+
+bool
+IndexedBinaryHeap::Less (uint32_t a, uint32_t b) const
+{
+  return m_keys[a] < m_keys[b] || (m_keys[a] == m_keys[b] && a < b);
+}
+
+void
+IndexedBinaryHeap::Place (uint32_t slot, uint32_t node)
+{
+  m_heap[slot] = node;
+  m_position[node] = slot;
+}
+
+void
+IndexedBinaryHeap::SiftUp (uint32_t slot)
+{
+  uint32_t node = m_heap[slot];
+  while (slot > 0)
+    {
+      uint32_t up = (slot - 1) / 2;
+      if (!Less (node, m_heap[up]))
+        {
+          break;
+        }
+      Place (slot, m_heap[up]);
+      slot = up;
+    }
+  Place (slot, node);
+}
+
+void
+IndexedBinaryHeap::SiftDown (uint32_t slot)
+{
+  uint32_t node = m_heap[slot];
+  uint32_t size = m_heap.size ();
+  while (true)
+    {
+      uint32_t child = 2 * slot + 1;
+      if (child >= size)
+        {
+          break;
+        }
+      if (child + 1 < size && Less (m_heap[child + 1], m_heap[child]))
+        {
+          child++;
+        }
+      if (!Less (m_heap[child], node))
+        {
+          break;
+        }
+      Place (slot, m_heap[child]);
+      slot = child;
+    }
+  Place (slot, node);
+}
+
+void
+IndexedBinaryHeap::Update (uint32_t node, uint32_t key)
+{
+  m_keys[node] = key;
+  if (m_position[node] == NODE_UNKNOWN)
+    {
+      m_heap.push_back (node);
+      m_position[node] = m_heap.size () - 1;
+    }
+  SiftUp (m_position[node]);
+}
+
+uint32_t
+IndexedBinaryHeap::PopMin (uint32_t &key)
+{
+  uint32_t top = m_heap[0];
+  key = m_keys[top];
+  m_position[top] = NODE_UNKNOWN;
+  uint32_t last = m_heap.back ();
+  m_heap.pop_back ();
+  if (!m_heap.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
+  return top;
+}
+
+void
+RadixHeap::Reset (uint32_t nodeCount, uint32_t maxLinkCost)
+{
+  for (uint32_t i = 0; i < 33; i++)
+    {
+      m_buckets[i].clear ();
+    }
+  m_last = 0;
+  m_size = 0;
+}
+
+bool
+RadixHeap::IsEmpty () const
+{
+  return m_size == 0;
+}
+
+uint32_t
+RadixHeap::Bucket (uint32_t key) const
+{
+  if (key == m_last)
+    {
+      return 0;
+    }
+  return 32 - __builtin_clz (key ^ m_last);
+}
+
+void
+RadixHeap::Update (uint32_t node, uint32_t key)
+{
+  NS_ASSERT (key >= m_last);
+  m_buckets[Bucket (key)].push_back (Entry (key, node));
+  m_size++;
+}
+
+uint32_t
+RadixHeap::PopMin (uint32_t &key)
+{
+  if (m_buckets[0].empty ())
+    {
+      uint32_t i = 1;
+      while (m_buckets[i].empty ())
+        {
+          i++;
+        }
+      // Every key in the first non-empty bucket lands in a lower one
+      // once the smallest of them becomes the new reference
+      std::vector<Entry> &bucket = m_buckets[i];
+      uint32_t smallest = bucket[0].first;
+      for (uint32_t j = 1; j < bucket.size (); j++)
+        {
+          if (bucket[j].first < smallest)
+            {
+              smallest = bucket[j].first;
+            }
+        }
+      m_last = smallest;
+      for (uint32_t j = 0; j < bucket.size (); j++)
+        {
+          m_buckets[Bucket (bucket[j].first)].push_back (bucket[j]);
+        }
+      bucket.clear ();
+    }
+  Entry top = m_buckets[0].back ();
+  m_buckets[0].pop_back ();
+  m_size--;
+  key = top.first;
+  return top.second;
+}
+
+bool
+DialBuckets::IsUsable (uint32_t maxLinkCost)
+{
+  return maxLinkCost <= MAX_LINK_COST;
+}
+
+void
+DialBuckets::Reset (uint32_t nodeCount, uint32_t maxLinkCost)
+{
+  NS_ASSERT (IsUsable (maxLinkCost));
+  uint32_t bucketCount = maxLinkCost + 1;
+  if (m_buckets.size () < bucketCount)
+    {
+      m_buckets.resize (bucketCount);
+    }
+  for (uint32_t i = 0; i < m_buckets.size (); i++)
+    {
+      m_buckets[i].clear ();
+    }
+  m_current = 0;
+  m_size = 0;
+}
+
+bool
+DialBuckets::IsEmpty () const
+{
+  return m_size == 0;
+}
+
+void
+DialBuckets::Update (uint32_t node, uint32_t key)
+{
+  NS_ASSERT (key >= m_current);
+  m_buckets[key % m_buckets.size ()].push_back (Entry (key, node));
+  m_size++;
+}
+
+uint32_t
+DialBuckets::PopMin (uint32_t &key)
+{
+  while (m_buckets[m_current % m_buckets.size ()].empty ())
+    {
+      m_current++;
+    }
+  std::vector<Entry> &bucket = m_buckets[m_current % m_buckets.size ()];
+  Entry top = bucket.back ();
+  bucket.pop_back ();
+  m_size--;
+  key = top.first;
+  return top.second;
+}
@@ -0,0 +1,239 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SHORTEST_PATH_H
+#define SHORTEST_PATH_H
+
+#include "ns3/node-route-table.h"
+
+#include <vector>
+#include <utility>
+
+using namespace ns3;
+
+/**
+ * \brief Read-only adjacency snapshot in compressed sparse row form.
+ *
+ * The links of node n are [GetBegin (n), GetEnd (n)) in two flat arrays, so
+ * a shortest path run walks contiguous memory instead of one vector per LSA.
+ * Rows are appended in node number order with AddLink () and EndNode ().
+ */
+class CsrGraph
+{
+  public:
+    CsrGraph ();
+
+    /**
+     * \brief Drop all rows, keeping the allocated memory.
+     */
+    void Clear ();
+    /**
+     * \brief Append a link to the row that is currently being built.
+     */
+    void AddLink (uint32_t to, uint32_t cost);
+    /**
+     * \brief Close the current row, the next AddLink () starts the next node.
+     */
+    void EndNode ();
+
+    uint32_t GetNodeCount () const;
+    uint32_t GetLinkCount () const;
+    uint32_t GetMaxCost () const;
+    uint32_t GetBegin (uint32_t node) const;
+    uint32_t GetEnd (uint32_t node) const;
+    uint32_t GetTarget (uint32_t link) const;
+    uint32_t GetCost (uint32_t link) const;
+
+  private:
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_targets;
+    std::vector<uint32_t> m_costs;
+    uint32_t m_maxCost;
+};
+
+/*
+ * Frontiers for ShortestPaths (). All of them offer
+ *
+ *   void Reset (uint32_t nodeCount, uint32_t maxLinkCost);
+ *   bool IsEmpty () const;
+ *   void Update (uint32_t node, uint32_t key);   // insert or lower the key
+ *   uint32_t PopMin (uint32_t &key);
+ *
+ * Frontiers that can not lower a key in place insert a second entry instead,
+ * ShortestPaths () skips the stale one when it comes out.
+ */
+
+/**
+ * \brief Linear scan over a key array, the way SPF picked the next node so far.
+ *
+ * O(n) per pop. Ties go to the lowest node number.
+ */
+class LinearScanFrontier
+{
+  public:
+    void Reset (uint32_t nodeCount, uint32_t maxLinkCost);
+    bool IsEmpty () const;
+    void Update (uint32_t node, uint32_t key);
+    uint32_t PopMin (uint32_t &key);
+
+  private:
+    std::vector<uint32_t> m_keys;
+    uint32_t m_size;
+};
+
+/**
+ * \brief Binary heap with a position index, lowering a key is a sift up.
+ *
+ * O(log n) per operation. Ties go to the lowest node number, so it settles
+ * nodes in the same order as LinearScanFrontier.
+ */
+class IndexedBinaryHeap
+{
+  public:
+    void Reset (uint32_t nodeCount, uint32_t maxLinkCost);
+    bool IsEmpty () const;
+    void Update (uint32_t node, uint32_t key);
+    uint32_t PopMin (uint32_t &key);
+
+  private:
+    bool Less (uint32_t a, uint32_t b) const;
+    void Place (uint32_t slot, uint32_t node);
+    void SiftUp (uint32_t slot);
+    void SiftDown (uint32_t slot);
+
+    std::vector<uint32_t> m_heap;
+    std::vector<uint32_t> m_keys;
+    std::vector<uint32_t> m_position;
+};
+
+/**
+ * \brief Monotone radix heap on 32-bit keys.
+ *
+ * Bucket i holds keys whose highest bit differing from the last popped key
+ * is bit i - 1. Every entry moves down at most 32 times, and popping never
+ * compares more than one bucket. Only valid while popped keys never decrease,
+ * which holds for Dijkstra with non-negative costs.
+ */
+class RadixHeap
+{
+  public:
+    void Reset (uint32_t nodeCount, uint32_t maxLinkCost);
+    bool IsEmpty () const;
+    void Update (uint32_t node, uint32_t key);
+    uint32_t PopMin (uint32_t &key);
+
+  private:
+    typedef std::pair<uint32_t, uint32_t> Entry;
+
+    uint32_t Bucket (uint32_t key) const;
+
+    std::vector<Entry> m_buckets[33];
+    uint32_t m_last;
+    uint32_t m_size;
+};
+
+/**
+ * \brief Dial's circular bucket queue for small integer link costs.
+ *
+ * With link costs up to C every key in the frontier lies within C of the
+ * last popped one, so C + 1 buckets indexed by key modulo C + 1 suffice and
+ * both operations are O(1) amortized. Use IsUsable () to check the costs.
+ */
+class DialBuckets
+{
+  public:
+    static const uint32_t MAX_LINK_COST = 4096;
+    static bool IsUsable (uint32_t maxLinkCost);
+
+    void Reset (uint32_t nodeCount, uint32_t maxLinkCost);
+    bool IsEmpty () const;
+    void Update (uint32_t node, uint32_t key);
+    uint32_t PopMin (uint32_t &key);
+
+  private:
+    typedef std::pair<uint32_t, uint32_t> Entry;
+
+    std::vector<std::vector<Entry> > m_buckets;
+    uint32_t m_current;
+    uint32_t m_size;
+};
+
+/**
+ * \brief Single source shortest paths over a CSR snapshot.
+ *
+ * Ties between equal cost paths go to whichever node is settled first, the
+ * order of which depends on the frontier.
+ *
+ * \param graph the snapshot, targets must be valid node numbers.
+ * \param source the root of the tree.
+ * \param frontier priority queue to use, reset on every call.
+ * \param cost filled with the path cost of every node, ROUTE_UNREACHABLE if none.
+ * \param parent filled with the predecessor on the tree, the source is its own
+ *        parent, NODE_UNKNOWN for unreachable nodes.
+ * \param firstHop filled with the node after the source on the path.
+ */
+template <class Frontier>
+void
+ShortestPaths (const CsrGraph &graph, uint32_t source, Frontier &frontier,
+               std::vector<uint32_t> &cost, std::vector<uint32_t> &parent,
+               std::vector<uint32_t> &firstHop)
+{
+  uint32_t nodeCount = graph.GetNodeCount ();
+  cost.assign (nodeCount, ROUTE_UNREACHABLE);
+  parent.assign (nodeCount, NODE_UNKNOWN);
+  firstHop.assign (nodeCount, NODE_UNKNOWN);
+  if (source >= nodeCount)
+    {
+      return;
+    }
+
+  frontier.Reset (nodeCount, graph.GetMaxCost ());
+  cost[source] = 0;
+  parent[source] = source;
+  firstHop[source] = source;
+  frontier.Update (source, 0);
+
+  while (!frontier.IsEmpty ())
+    {
+      uint32_t key;
+      uint32_t node = frontier.PopMin (key);
+      if (key != cost[node])
+        {
+          // Stale entry, the node came out earlier with a lower key
+          continue;
+        }
+      uint32_t hop = (node == source) ? NODE_UNKNOWN : firstHop[node];
+      for (uint32_t link = graph.GetBegin (node); link < graph.GetEnd (node); link++)
+        {
+          uint32_t linkCost = graph.GetCost (link);
+          if (linkCost >= ROUTE_UNREACHABLE - key)
+            {
+              continue;
+            }
+          uint32_t to = graph.GetTarget (link);
+          uint32_t newCost = key + linkCost;
+          if (newCost < cost[to])
+            {
+              cost[to] = newCost;
+              parent[to] = node;
+              firstHop[to] = (hop == NODE_UNKNOWN) ? to : hop;
+              frontier.Update (to, newCost);
+            }
+        }
+    }
+}
+
+#endif
@@ -73,8 +73,13 @@ DVMessage::GetSerializedSize (void) const
         size += m_message.helloReq.GetSerializedSize ();
         break;
       case DV_TABLE_MSG:
+      case DV_UPDATE_MSG:
         size += m_message.dvTableMsg.GetSerializedSize ();
         break;
+      case DV_TABLE_PACKED_MSG:
+      case DV_UPDATE_PACKED_MSG:
+        size += m_message.dvTablePackedMsg.GetSerializedSize ();
+        break;
       default:
         NS_ASSERT (false);
     }
@@ -102,7 +107,12 @@ DVMessage::Print (std::ostream &os) const
       case HELLO_REQ:
         m_message.helloReq.Print (os);
         break;
+      case DV_TABLE_PACKED_MSG:
+      case DV_UPDATE_PACKED_MSG:
+        m_message.dvTablePackedMsg.Print (os);
+        break;
       case DV_TABLE_MSG:
+      case DV_UPDATE_MSG:
         m_message.dvTableMsg.Print (os);
       default:
         break;  
@@ -133,8 +143,13 @@ DVMessage::Serialize (Buffer::Iterator start) const
         m_message.helloReq.Serialize (i);
         break;
       case DV_TABLE_MSG:
+      case DV_UPDATE_MSG:
         m_message.dvTableMsg.Serialize (i);
         break;
+      case DV_TABLE_PACKED_MSG:
+      case DV_UPDATE_PACKED_MSG:
+        m_message.dvTablePackedMsg.Serialize (i);
+        break;
     }
 }
 
@@ -162,7 +177,12 @@ DVMessage::Deserialize (Buffer::Iterator start)
         size += m_message.helloReq.Deserialize (i);
         break;
       case DV_TABLE_MSG:
-        m_message.dvTableMsg.Deserialize (i);
+      case DV_UPDATE_MSG:
+        size += m_message.dvTableMsg.Deserialize (i);
+        break;
+      case DV_TABLE_PACKED_MSG:
+      case DV_UPDATE_PACKED_MSG:
+        size += m_message.dvTablePackedMsg.Deserialize (i);
         break;
       default:
         NS_ASSERT (false);
@@ -393,7 +413,7 @@ DVMessage::SetDVTableMsg (nbrCostsVec neighborCosts)
     }
   else
     {
-      NS_ASSERT (m_messageType == DV_TABLE_MSG);
+      NS_ASSERT (m_messageType == DV_TABLE_MSG || m_messageType == DV_UPDATE_MSG);
     }
   m_message.dvTableMsg.neighborCosts = neighborCosts;
 }
@@ -404,6 +424,29 @@ DVMessage::GetDVTableMsg ()
   return m_message.dvTableMsg;
 }
 
+/* DV_TABLE_PACKED_MSG */
+
+void
+DVMessage::SetDVTablePackedMsg (std::vector<std::pair<uint32_t, uint32_t> > nodeCosts)
+{
+  if (m_messageType == 0)
+    {
+      m_messageType = DV_TABLE_PACKED_MSG;
+    }
+  else
+    {
+      NS_ASSERT (m_messageType == DV_TABLE_PACKED_MSG || m_messageType == DV_UPDATE_PACKED_MSG);
+    }
+  m_message.dvTablePackedMsg.nodeCosts = nodeCosts;
+  m_message.dvTablePackedMsg.Sort ();
+}
+
+PackedNodeCosts
+DVMessage::GetDVTablePackedMsg ()
+{
+  return m_message.dvTablePackedMsg;
+}
+
 //
 //
 //
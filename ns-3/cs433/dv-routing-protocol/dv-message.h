@@ -22,6 +22,7 @@
 #include "ns3/packet.h"
 #include "ns3/object.h"
 #include <ns3/nstime.h>
+#include "ns3/packed-node-costs.h"
 #include <vector>
 
 using namespace ns3;
@@ -42,10 +43,21 @@ class DVMessage : public Header
         // Define extra message types when needed       
         HELLO_REQ = 3,
         DV_TABLE_MSG = 4,
+        // Triggered update, DVTableMsg payload with the changed destinations only
+        DV_UPDATE_MSG = 5,
+        // DV_TABLE_MSG and DV_UPDATE_MSG with node numbers, see PackedNodeCosts
+        DV_TABLE_PACKED_MSG = 6,
+        DV_UPDATE_PACKED_MSG = 7,
       };
 
     DVMessage (DVMessage::MessageType messageType, uint32_t sequenceNumber, uint8_t ttl, Ipv4Address originatorAddress);
 
+    /**
+     *  Offset of the sequence number in the serialized message, after the
+     *  message type.
+     */
+    static const uint32_t SEQUENCE_NUMBER_OFFSET = 1;
+
     /**
     *  \brief Sets message type
     *  \param messageType message type
@@ -163,6 +175,7 @@ class DVMessage : public Header
         PingRsp pingRsp;
         HelloReq helloReq;
         DVTableMsg dvTableMsg;
+        PackedNodeCosts dvTablePackedMsg;
       } m_message;
     
   public:
@@ -192,10 +205,18 @@ class DVMessage : public Header
     HelloReq GetHelloReq ();
     void SetHelloReq (Ipv4Address, std::string);
 
-    /* DV Table Msg */
+    /* DV Table Msg, also the payload of DV_UPDATE_MSG */
     DVTableMsg GetDVTableMsg ();
     void SetDVTableMsg (nbrCostsVec neighborCosts);
 
+    /* DV Table Packed Msg, also the payload of DV_UPDATE_PACKED_MSG */
+    PackedNodeCosts GetDVTablePackedMsg ();
+    /**
+     *  \brief Sets the destinations of a packed DV message
+     *  \param nodeCosts (node number, cost) pairs, in any order
+     */
+    void SetDVTablePackedMsg (std::vector<std::pair<uint32_t, uint32_t> > nodeCosts);
+
 }; // class DVMessage
 
 static inline std::ostream& operator<< (std::ostream& os, const DVMessage& message)
@@ -25,10 +25,12 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/test-result.h"
 #include <sys/time.h>
 #include <vector>
 #include <limits>
+#include <algorithm>
 
 using namespace ns3;
 
@@ -61,17 +63,35 @@ DVRoutingProtocol::GetTypeId (void)
                  UintegerValue (16),
                  MakeUintegerAccessor (&DVRoutingProtocol::m_maxTTL),
                  MakeUintegerChecker<uint8_t> ())
+  .AddAttribute ("TriggeredUpdates",
+                 "Advertise only the changed destinations when the distance vector changes",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&DVRoutingProtocol::m_triggeredUpdates),
+                 MakeBooleanChecker ())
+  .AddAttribute ("FullUpdateInterval",
+                 "Interval of the full table refresh in triggered mode, 0 disables it",
+                 TimeValue (MilliSeconds (30000)),
+                 MakeTimeAccessor (&DVRoutingProtocol::m_fullUpdateInterval),
+                 MakeTimeChecker ())
+  .AddAttribute ("PackedTableMessages",
+                 "Send distance vectors in the packed node number encoding",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&DVRoutingProtocol::m_packedTableMessages),
+                 MakeBooleanChecker ())
   ;
   return tid;
 }
 
 DVRoutingProtocol::DVRoutingProtocol ()
-  : m_auditPingsTimer (Timer::CANCEL_ON_DESTROY), m_auditHellosTimer (Timer::CANCEL_ON_DESTROY)
+  : m_auditPingsTimer (Timer::CANCEL_ON_DESTROY), m_auditHellosTimer (Timer::CANCEL_ON_DESTROY),
+    m_fullUpdateTimer (Timer::CANCEL_ON_DESTROY)
 {
   RandomVariable random;
   SeedManager::SetSeed (time (NULL));
   random = UniformVariable (0x00000000, 0xFFFFFFFF);
   m_currentSequenceNumber = random.GetInteger ();
+  m_forwardingTableDirty = true;
+  m_addressDirectory = Create<AddressDirectory> ();
   // Setup static routing 
   m_staticRouting = Create<Ipv4StaticRouting> ();
 }
@@ -97,6 +117,7 @@ DVRoutingProtocol::DoDispose ()
   // Cancel timers
   m_auditPingsTimer.Cancel ();
   m_auditHellosTimer.Cancel ();
+  m_fullUpdateTimer.Cancel ();
 
   m_pingTracker.clear (); 
 
@@ -107,45 +128,65 @@ void
 DVRoutingProtocol::SetMainInterface (uint32_t mainInterface)
 {
   m_mainAddress = m_ipv4->GetAddress (mainInterface, 0).GetLocal ();
+  m_helloTemplate = HeaderTemplate ();
 }
 
 void
 DVRoutingProtocol::SetNodeAddressMap (std::map<uint32_t, Ipv4Address> nodeAddressMap)
 {
   m_nodeAddressMap = nodeAddressMap;
+  SetAddressDirectory (Create<AddressDirectory> (m_nodeAddressMap, m_addressNodeMap));
 }
 
 void
 DVRoutingProtocol::SetAddressNodeMap (std::map<Ipv4Address, uint32_t> addressNodeMap)
 {
   m_addressNodeMap = addressNodeMap;
+  SetAddressDirectory (Create<AddressDirectory> (m_nodeAddressMap, m_addressNodeMap));
+}
+
+void
+DVRoutingProtocol::SetAddressDirectory (Ptr<AddressDirectory> addressDirectory)
+{
+  m_addressDirectory = addressDirectory;
+
+  // Node numbers index the distance vector and the routing table
+  uint32_t nodeCount = m_addressDirectory->GetNodeCount ();
+  m_dv.assign (nodeCount, DV_UNKNOWN);
+  m_routingTable.Resize (nodeCount);
+  m_forwardingTableDirty = true;
 }
 
 Ipv4Address
 DVRoutingProtocol::ResolveNodeIpAddress (uint32_t nodeNumber)
 {
-  std::map<uint32_t, Ipv4Address>::iterator iter = m_nodeAddressMap.find (nodeNumber);
-  if (iter != m_nodeAddressMap.end ())
-    { 
-      return iter->second;
-    }
-  return Ipv4Address::GetAny ();
+  return m_addressDirectory->GetMainAddress (nodeNumber);
 }
 
 std::string
 DVRoutingProtocol::ReverseLookup (Ipv4Address ipAddress)
 {
-  std::map<Ipv4Address, uint32_t>::iterator iter = m_addressNodeMap.find (ipAddress);
-  if (iter != m_addressNodeMap.end ())
+  uint32_t nodeNumber = m_addressDirectory->GetNodeNumber (ipAddress);
+  if (nodeNumber != NODE_UNKNOWN)
     { 
       std::ostringstream sin;
-      uint32_t nodeNumber = iter->second;
       sin << nodeNumber;    
       return sin.str();
     }
   return "Unknown";
 }
 
+uint32_t
+DVRoutingProtocol::LookupNodeNumber (Ipv4Address ipAddress)
+{
+  uint32_t nodeNumber = m_addressDirectory->GetNodeNumber (ipAddress);
+  if (nodeNumber < m_dv.size ())
+    {
+      return nodeNumber;
+    }
+  return NODE_UNKNOWN;
+}
+
 void
 DVRoutingProtocol::DoStart ()
 {
@@ -172,12 +213,19 @@ DVRoutingProtocol::DoStart ()
   // Configure timers
   m_auditPingsTimer.SetFunction (&DVRoutingProtocol::AuditPings, this);
   m_auditHellosTimer.SetFunction (&DVRoutingProtocol::AuditHellos, this);
+  m_fullUpdateTimer.SetFunction (&DVRoutingProtocol::SendFullUpdate, this);
 
   // Start timers
   m_auditPingsTimer.Schedule (m_pingTimeout);
   m_auditHellosTimer.Schedule (m_helloTimeout);
+  if (m_triggeredUpdates && !m_fullUpdateInterval.IsZero ())
+    m_fullUpdateTimer.Schedule (m_fullUpdateInterval);
 
-  m_dv.insert(std::make_pair(ReverseLookup(m_mainAddress), 0));
+  uint32_t thisNode = LookupNodeNumber(m_mainAddress);
+  if (thisNode != NODE_UNKNOWN) {
+    m_dv[thisNode] = 0;
+    m_routingTable.SetRoute(thisNode, 0, thisNode, m_mainAddress, Ipv4Address("127.0.0.1"));
+  }
 }
 
 Ptr<Ipv4Route>
@@ -186,7 +234,6 @@ DVRoutingProtocol::RouteOutput (Ptr<Packet> packet, const Ipv4Header &header, Pt
     DEBUG_LOG ("RouteOutput Called");
     // No clue what to do with outInterface or sockerr
     Ptr<Ipv4Route> ipv4Route = 0;
-    RoutingTableEntry entry;
 
     if (header.GetDestination () == m_mainAddress) {
          // DEBUG_LOG ("Found route in table");
@@ -201,20 +248,12 @@ DVRoutingProtocol::RouteOutput (Ptr<Packet> packet, const Ipv4Header &header, Pt
         ipv4Route->SetOutputDevice(m_ipv4->GetNetDevice (interface));
     }
 
-    else if (SearchTable (entry, header.GetDestination ())) {
-        // DEBUG_LOG ("Found route in table");
-        ipv4Route = Create<Ipv4Route> ();
-        ipv4Route->SetDestination (header.GetDestination ());
-        ipv4Route->SetSource (m_mainAddress);
-        ipv4Route->SetGateway (entry.nextHopAddr);
-        // Not 100% sure below is correct
-        // ipv4Route->SetOutputDevice (outInterface); // ????
-        int32_t interface = m_ipv4->GetInterfaceForAddress(entry.interfaceAddr);
-        ipv4Route->SetOutputDevice(m_ipv4->GetNetDevice (interface));
-    }
-
     else {
-        Ptr<Ipv4Route> ipv4Route = m_staticRouting->RouteOutput (packet, header, outInterface, sockerr);
+        // Compiled forwarding table first, static routes otherwise
+        ipv4Route = SearchTable (header.GetDestination ());
+        if (!ipv4Route) {
+            ipv4Route = m_staticRouting->RouteOutput (packet, header, outInterface, sockerr);
+        }
     }
 
     if (ipv4Route) {
@@ -254,17 +293,9 @@ DVRoutingProtocol::RouteInput  (Ptr<const Packet> packet,
     }
 
     // Forward using LS routing table
-    Ptr<Ipv4Route> ipv4Route;
-    RoutingTableEntry entry;
-    if (SearchTable (entry, destinationAddress)) {
-        DEBUG_LOG ("[RouteInput] Forwarding packet from " << m_mainAddress << " to " << entry.nextHopAddr);
-
-        ipv4Route = Create<Ipv4Route> ();
-        ipv4Route->SetDestination (destinationAddress);
-        ipv4Route->SetSource (m_mainAddress);
-        ipv4Route->SetGateway (entry.nextHopAddr);
-        int32_t interface = m_ipv4->GetInterfaceForAddress(entry.interfaceAddr);
-        ipv4Route->SetOutputDevice (m_ipv4->GetNetDevice (interface));
+    Ptr<Ipv4Route> ipv4Route = SearchTable (destinationAddress);
+    if (ipv4Route) {
+        DEBUG_LOG ("[RouteInput] Forwarding packet from " << m_mainAddress << " to " << ipv4Route->GetGateway ());
 
         // UnicastForwardCallback = void ucb(Ptr<Ipv4Route>, Ptr<const Packet>, const Ipv4Header &)
         ucb (ipv4Route, packet, header);
@@ -368,56 +399,91 @@ DVRoutingProtocol::ProcessCommand (std::vector<std::string> tokens)
 
 void
 DVRoutingProtocol::SendHello () {
-  Ipv4Address destAddress = ResolveNodeIpAddress (0); // TODO remove this and "hello"
   uint32_t sequenceNumber = GetNextSequenceNumber ();
   //TRAFFIC_LOG ("Broadcasting HELLO_REQ, SequenceNumber: " << sequenceNumber);
 //    //Ptr<HelloRequest> helloRequest = Create<HelloRequest> (sequenceNumber, Simulator::Now(), destAddress, "hello", m_helloTimeout);
+   if (m_helloTemplate.IsEmpty ())
+     {
+       Ipv4Address destAddress = ResolveNodeIpAddress (0); // TODO remove this and "hello"
+       DVMessage dvMessage = DVMessage (DVMessage::HELLO_REQ, sequenceNumber, 1, m_mainAddress);
+       dvMessage.SetHelloReq (destAddress, "hello");
+       m_helloTemplate = HeaderTemplate (dvMessage);
+     }
+   // Every hello is the same message but for its sequence number
+   m_helloTemplate.SetU32 (DVMessage::SEQUENCE_NUMBER_OFFSET, sequenceNumber);
    Ptr<Packet> packet = Create<Packet> ();
-   DVMessage dvMessage = DVMessage (DVMessage::HELLO_REQ, sequenceNumber, 1, m_mainAddress);
-   dvMessage.SetHelloReq (destAddress, "hello");
-   packet->AddHeader (dvMessage);
+   packet->AddHeader (m_helloTemplate);
    BroadcastPacket (packet);
 }
 
 void
 DVRoutingProtocol::SendDVTableMessage () {
-  uint32_t sequenceNumber = GetNextSequenceNumber ();
-  std::vector<std::pair<Ipv4Address, uint32_t> > neighborAddrs;
+  std::vector<uint32_t> knownDests;
+  for (uint32_t dest = 0; dest < m_dv.size(); dest++) {
+    if (m_dv[dest] != DV_UNKNOWN)
+      knownDests.push_back(dest);
+  }
+  SendDistanceVector(DVMessage::DV_TABLE_MSG, knownDests, NODE_UNKNOWN);
+}
+
+void
+DVRoutingProtocol::SendTriggeredUpdate (const std::vector<uint32_t> &changedDests) {
+  if (changedDests.empty())
+    return;
+  if (m_triggeredUpdates)
+    SendDistanceVector(DVMessage::DV_UPDATE_MSG, changedDests, NODE_UNKNOWN);
+  else
+    SendDVTableMessage();
+}
 
-  //for (ntEntry i = m_neighborTable.begin (); i != m_neighborTable.end (); i++) {
-  //  neighborAddrs.push_back( std::make_pair(i->second.neighborAddr, 1) ); // "1" should be cost
-  //}
+void
+DVRoutingProtocol::SendFullUpdate () {
+  SendDVTableMessage();
+  m_fullUpdateTimer.Schedule (m_fullUpdateInterval);
+}
 
-  for (distanceVector::iterator i = m_dv.begin(); i != m_dv.end(); i++) {
-    neighborAddrs.push_back( std::make_pair(ResolveNodeIpAddress(std::atoi(i->first.c_str())), i->second) );
-  }
+void
+DVRoutingProtocol::SendDistanceVector (DVMessage::MessageType type, const std::vector<uint32_t> &dests, uint32_t toNeighbor) {
+  uint32_t sequenceNumber = GetNextSequenceNumber ();
+  DVMessage::MessageType sendType = type;
+  if (m_packedTableMessages)
+    sendType = (type == DVMessage::DV_UPDATE_MSG) ? DVMessage::DV_UPDATE_PACKED_MSG : DVMessage::DV_TABLE_PACKED_MSG;
 
-  TRAFFIC_LOG("Sending DVTableMessage: sequence num: " << sequenceNumber << ", neighborAddrs.size: " << neighborAddrs.size());
+  TRAFFIC_LOG("Sending " << (type == DVMessage::DV_UPDATE_MSG ? "DVUpdateMessage" : "DVTableMessage")
+              << ": sequence num: " << sequenceNumber << ", neighborAddrs.size: " << dests.size());
 
   // for each neighbor:
-  for (distanceVector::iterator i = m_costs.begin(); i != m_costs.end(); i++) {
+  for (costEntry i = m_costs.begin(); i != m_costs.end(); i++) {
+    if (toNeighbor != NODE_UNKNOWN && i->first != toNeighbor)
+      continue;
     Ptr<Packet> packet = Create<Packet> ();
-    DVMessage dvMessage = DVMessage (DVMessage::DV_TABLE_MSG, sequenceNumber, 1, m_mainAddress);
-
-    // for each entry in my distance vector:
-    std::vector<std::pair<Ipv4Address, uint32_t> > newdv;
-    for (distanceVector::iterator j = m_dv.begin(); j != m_dv.end(); j++) {
-      std::string dest = j->first;
-      Ipv4Address destAddr = ResolveNodeIpAddress(std::atoi(dest.c_str()));
-      rtEntry rte = m_routingTable.find(dest);
-
-      if (destAddr == m_neighborTable.find(i->first)->second.neighborAddr &&
-          rte != m_routingTable.end() &&
-          rte->second.nextHopAddr == destAddr) {
+    DVMessage dvMessage = DVMessage (sendType, sequenceNumber, 1, m_mainAddress);
+
+    // for each advertised entry in my distance vector:
+    std::vector<std::pair<uint32_t, uint32_t> > newdv;
+    newdv.reserve(dests.size());
+    for (uint32_t k = 0; k < dests.size(); k++) {
+      uint32_t dest = dests[k];
+
+      if (dest == i->first &&
+          m_routingTable.HasRoute(dest) &&
+          m_routingTable.nextHop[dest] == dest) {
           // DEBUG_LOG("Poisoning " << dest);
-          newdv.push_back(std::make_pair(destAddr, M_INF));
+          newdv.push_back(std::make_pair(dest, (uint32_t) M_INF));
       } else {
-          newdv.push_back(std::make_pair(destAddr, m_dv[dest]));
+          newdv.push_back(std::make_pair(dest, m_dv[dest]));
       }
     }
 
-    // Ipv4Address neighAddr = ResolveNodeIpAddress(std::atoi(i->first.c_str()));
-    dvMessage.SetDVTableMsg(newdv);
+    if (m_packedTableMessages) {
+      dvMessage.SetDVTablePackedMsg(newdv);
+    } else {
+      std::vector<std::pair<Ipv4Address, uint32_t> > addrdv;
+      addrdv.reserve(newdv.size());
+      for (uint32_t k = 0; k < newdv.size(); k++)
+        addrdv.push_back(std::make_pair(ResolveNodeIpAddress(newdv[k].first), newdv[k].second));
+      dvMessage.SetDVTableMsg(addrdv);
+    }
     packet->AddHeader (dvMessage);
     SendPacket(packet, m_neighborTable.find(i->first)->second.interfaceAddr);
   }
@@ -427,8 +493,9 @@ void
 DVRoutingProtocol::DumpNeighborDV(NeighborTableEntry nte) {
     distanceVector dv = nte.dv;
     STATUS_LOG (std::endl << "**************** Neighbor DV: " << ReverseLookup(nte.neighborAddr) << " *******************" << std::endl);
-    for (distanceVector::iterator i = dv.begin(); i != dv.end(); i++) {
-       std::cout << '(' << i->first << ", " << i->second << ") ";
+    for (uint32_t i = 0; i < dv.size(); i++) {
+       if (dv[i] != DV_UNKNOWN)
+         std::cout << '(' << i << ", " << dv[i] << ") ";
     }
     std::cout << '\n';
 }
@@ -437,8 +504,9 @@ void
 DVRoutingProtocol::DumpDV() {
   STATUS_LOG (std::endl << "**************** Distance Vector ********************" << std::endl);
 
-  for (distanceVector::iterator i = m_dv.begin (); i != m_dv.end (); i++) {
-      std::cout << '(' << i->first << ", " << i->second << ") ";
+  for (uint32_t i = 0; i < m_dv.size (); i++) {
+      if (m_dv[i] != DV_UNKNOWN)
+        std::cout << '(' << i << ", " << m_dv[i] << ") ";
   }
   std::cout << '\n';
   PRINT_LOG ("");
@@ -471,16 +539,18 @@ DVRoutingProtocol::DumpRoutingTable ()
   STATUS_LOG (std::endl << "**************** Route Table ********************" << std::endl
               << "DestNumber\t\tDestAddr\t\tNextHopNumber\t\tNextHopAddr\t\tInterfaceAddr\t\tCost");
 
-      for (rtEntry i = m_routingTable.begin (); i != m_routingTable.end (); i++)
+      for (uint32_t node = 0; node < m_routingTable.GetNodeCount (); node++)
         {
-            RoutingTableEntry entry = i->second;
-            std::string fromNode = ReverseLookup (entry.destAddr);
+            if (!m_routingTable.HasRoute (node))
+                continue;
+            Ipv4Address destAddr = ResolveNodeIpAddress (node);
+            uint32_t nextHopNum = m_routingTable.nextHopAddr[node].Get ();
 
-            PRINT_LOG (fromNode << "\t\t" << entry.destAddr << "\t\t" << entry.nextHopNum << "\t\t"
-               << entry.nextHopAddr << "\t\t" << entry.interfaceAddr << "\t\t\t" << entry.cost << std::endl);
+            PRINT_LOG (node << "\t\t" << destAddr << "\t\t" << nextHopNum << "\t\t"
+               << m_routingTable.nextHopAddr[node] << "\t\t" << m_routingTable.interfaceAddr[node] << "\t\t\t" << m_routingTable.cost[node] << std::endl);
 
-            checkRouteTableEntry (fromNode, entry.destAddr, entry.nextHopNum, entry.nextHopAddr,
-                entry.interfaceAddr, entry.cost);
+            checkRouteTableEntry (node, destAddr, nextHopNum, m_routingTable.nextHopAddr[node],
+                m_routingTable.interfaceAddr[node], m_routingTable.cost[node]);
         }
 
   PRINT_LOG ("");
@@ -513,6 +583,9 @@ DVRoutingProtocol::RecvDVMessage (Ptr<Socket> socket)
         ProcessHelloReq (dvMessage, socket);
         break;
       case DVMessage::DV_TABLE_MSG:
+      case DVMessage::DV_UPDATE_MSG:
+      case DVMessage::DV_TABLE_PACKED_MSG:
+      case DVMessage::DV_UPDATE_PACKED_MSG:
         ProcessDVTableMessage(dvMessage, socket);
         break;
       default:
@@ -570,9 +643,15 @@ DVRoutingProtocol::ProcessHelloReq (DVMessage dvMessage, Ptr<Socket> socket)
   //TRAFFIC_LOG ("Received HELLO_REQ, From Node: " << fromNode);
 
   Ipv4Address neighAddr = dvMessage.GetOriginatorAddress();
-  std::string fromNode = ReverseLookup (dvMessage.GetOriginatorAddress());
+  uint32_t fromNode = LookupNodeNumber (neighAddr);
   Ipv4Address interfaceAddr;
 
+  if (fromNode == NODE_UNKNOWN)
+    {
+      ERROR_LOG ("HELLO_REQ from outside the topology: " << neighAddr);
+      return;
+    }
+
   std::map<Ptr<Socket> , Ipv4InterfaceAddress>::const_iterator i = m_socketAddresses.find(socket);
   if (i != m_socketAddresses.end())
     {
@@ -598,34 +677,55 @@ DVRoutingProtocol::ProcessHelloReq (DVMessage dvMessage, Ptr<Socket> socket)
     m_neighborTable.insert(std::make_pair(fromNode, entry));
 
     //add it to our neigbor and distance vectors
-    m_dv.insert( std::make_pair(fromNode, 1) );
+    if (m_dv[fromNode] == DV_UNKNOWN)
+      m_dv[fromNode] = 1;
     m_costs.insert( std::make_pair(fromNode, 1) );
 
     // DumpDV();
 
-    //TODO: run DV Algorithm
-    BellmanFord(emptydv);
+    // Only the new neighbor's own entry can change until it sends its DV
+    std::vector<uint32_t> changedDests;
+    BellmanFord(std::vector<uint32_t> (1, fromNode), changedDests);
+    SendTriggeredUpdate(changedDests);
     // DumpDV();
-    SendDVTableMessage();
+    // The new neighbor needs the whole table
+    if (m_triggeredUpdates) {
+      std::vector<uint32_t> knownDests;
+      for (uint32_t dest = 0; dest < m_dv.size(); dest++) {
+        if (m_dv[dest] != DV_UNKNOWN)
+          knownDests.push_back(dest);
+      }
+      SendDistanceVector(DVMessage::DV_TABLE_MSG, knownDests, fromNode);
+    } else {
+      SendDVTableMessage();
+    }
   }
 }
 
 void
 DVRoutingProtocol::ProcessDVTableMessage (DVMessage dvMessage, Ptr<Socket> socket) {
 
-    // extract info from dvMessage
-    std::vector<std::pair<Ipv4Address, uint32_t> > neighborAddrs = dvMessage.GetDVTableMsg().neighborCosts;
+    // extract info from dvMessage, destinations as node numbers
+    DVMessage::MessageType type = dvMessage.GetMessageType();
+    std::vector<std::pair<uint32_t, uint32_t> > neighborCosts;
+    if (type == DVMessage::DV_TABLE_PACKED_MSG || type == DVMessage::DV_UPDATE_PACKED_MSG) {
+        neighborCosts = dvMessage.GetDVTablePackedMsg().nodeCosts;
+    } else {
+        std::vector<std::pair<Ipv4Address, uint32_t> > neighborAddrs = dvMessage.GetDVTableMsg().neighborCosts;
+        neighborCosts.reserve(neighborAddrs.size());
+        for (unsigned i = 0; i < neighborAddrs.size(); i++)
+            neighborCosts.push_back(std::make_pair(LookupNodeNumber(neighborAddrs[i].first), neighborAddrs[i].second));
+    }
     uint32_t seqNum = dvMessage.GetSequenceNumber();
     Ipv4Address fromAddr = dvMessage.GetOriginatorAddress();
-    std::string fromNode = ReverseLookup(fromAddr);
+    uint32_t fromNode = LookupNodeNumber(fromAddr);
 
     TRAFFIC_LOG("Received DV Table Message from node " << fromNode);
 
-    // insert it into the neighbor table
-    distanceVector newdv;
-    for (int i = 0; i < neighborAddrs.size(); i++) {
-        newdv[ ReverseLookup(neighborAddrs[i].first) ] = neighborAddrs[i].second;
-    } 
+    if (fromNode == NODE_UNKNOWN) {
+        ERROR_LOG ("DV_TABLE_MSG from outside the topology: " << fromAddr);
+        return;
+    }
 
     // If the NeighborTableEntry does not exist, add it. (This will only happen
     // if the hello message is lost for some reason.)
@@ -640,21 +740,43 @@ DVRoutingProtocol::ProcessDVTableMessage (DVMessage dvMessage, Ptr<Socket> socke
             ERROR_LOG ("Didn't find socket in m_socketAddresses");
         }
 
-        NeighborTableEntry new_entry = { fromAddr, interfaceAddr , Simulator::Now(), newdv };
-        m_neighborTable[fromNode] = new_entry;
+        NeighborTableEntry new_entry = { fromAddr, interfaceAddr , Simulator::Now(), distanceVector() };
+        entry = m_neighborTable.insert(std::make_pair(fromNode, new_entry)).first;
+    }
+
+    // merge it into the neighbor's distance vector, remembering which entries moved
+    distanceVector &dv = entry->second.dv;
+    if (dv.empty())
+        dv.assign(m_dv.size(), DV_UNKNOWN);
+
+    std::vector<uint32_t> affectedDests;
+    if (type == DVMessage::DV_TABLE_MSG || type == DVMessage::DV_TABLE_PACKED_MSG) {
+        // A full table replaces the old one, destinations it leaves out become unknown
+        distanceVector newdv(m_dv.size(), DV_UNKNOWN);
+        for (unsigned i = 0; i < neighborCosts.size(); i++) {
+            uint32_t dest = neighborCosts[i].first;
+            if (dest < newdv.size())
+                newdv[dest] = neighborCosts[i].second;
+        }
+        for (uint32_t dest = 0; dest < newdv.size(); dest++) {
+            if (newdv[dest] != dv[dest])
+                affectedDests.push_back(dest);
+        }
+        dv.swap(newdv);
     } else {
-        // std::cout << "We are substituting our neighbor's distance vector!\n";
-        // DumpNeighborDV(entry->second);
-        entry->second.dv = newdv;
-        // DumpNeighborDV(entry->second);
+        for (unsigned i = 0; i < neighborCosts.size(); i++) {
+            uint32_t dest = neighborCosts[i].first;
+            if (dest < dv.size() && dv[dest] != neighborCosts[i].second) {
+                dv[dest] = neighborCosts[i].second;
+                affectedDests.push_back(dest);
+            }
+        }
     }
-    
-    // run DV algorithm
-    // DumpDV();
-    BellmanFord(newdv);
-    // DumpDV();
-    // Send new packet with neighbor info
-    //SendDVTableMessage();
+
+    // run DV algorithm on the entries that moved
+    std::vector<uint32_t> changedDests;
+    BellmanFord(affectedDests, changedDests);
+    SendTriggeredUpdate(changedDests);
 }
 
 bool
@@ -703,6 +825,8 @@ DVRoutingProtocol::AuditHellos()
   //Broadcast a fresh HELLO message to immediate neighbors
   SendHello ();
   bool sendMsg = false;
+  std::vector<uint32_t> affectedDests;
+  std::vector<uint32_t> lostNeighbors;
 
   // If "last updated" is more than helloTimeout seconds ago, remove it from the NeighborTable
   for (ntEntry i = m_neighborTable.begin (); i != m_neighborTable.end ();) {
@@ -710,15 +834,22 @@ DVRoutingProtocol::AuditHellos()
       TRAFFIC_LOG ("AUDIT HELLOS: entry.lastUpdated: " << entry.lastUpdated.GetMilliSeconds() << ", timeout: " << m_helloTimeout.GetMilliSeconds() << ", time is now: " << Simulator::Now().GetMilliSeconds());
 
       if ( entry.lastUpdated.GetMilliSeconds() + m_helloTimeout.GetMilliSeconds() <= Simulator::Now().GetMilliSeconds()) {
-          std::string nodeName = ReverseLookup(entry.neighborAddr);
-          m_dv[nodeName] = M_INF;
-          //m_costs[nodeName] = M_INF;
+          uint32_t nodeNumber = i->first;
+          // Everything the neighbor advertised may have been routed through it
+          const distanceVector &lostdv = entry.dv;
+          for (uint32_t dest = 0; dest < lostdv.size(); dest++) {
+              if (lostdv[dest] != DV_UNKNOWN)
+                  affectedDests.push_back(dest);
+          }
+          affectedDests.push_back(nodeNumber);
+          lostNeighbors.push_back(nodeNumber);
+          m_dv[nodeNumber] = M_INF;
+          //m_costs[nodeNumber] = M_INF;
           //m_dv.erase( nodeNumber );
-          distanceVector::iterator it = m_costs.find(nodeName);
-          m_costs.erase( it );
+          m_costs.erase( nodeNumber );
           m_neighborTable.erase( i++ );
           sendMsg = true;
-          // std::cout << "Didn't hear back from " << nodeName;
+          // std::cout << "Didn't hear back from " << nodeNumber;
           // DumpDV();
       } else {
          ++i;
@@ -728,7 +859,14 @@ DVRoutingProtocol::AuditHellos()
   if (sendMsg) {
       // std::cout << "AuditHellos is about to run BellmanFord!\n";
       // run DV Algorithm
-      BellmanFord(m_dv);
+      std::vector<uint32_t> changedDests;
+      BellmanFord(affectedDests, changedDests);
+      // Lost neighbors are advertised as unreachable straight away in triggered mode
+      if (m_triggeredUpdates)
+          changedDests.insert(changedDests.end(), lostNeighbors.begin(), lostNeighbors.end());
+      std::sort(changedDests.begin(), changedDests.end());
+      changedDests.erase(std::unique(changedDests.begin(), changedDests.end()), changedDests.end());
+      SendTriggeredUpdate(changedDests);
 
       //SendDVTableMessage();
   }
@@ -738,71 +876,45 @@ DVRoutingProtocol::AuditHellos()
 }
 
 void
-DVRoutingProtocol::BellmanFord(distanceVector &ndv) {
-    TRAFFIC_LOG("RUNNING BELLMAN FORD");
-    m_routingTable.clear();
-
-    for (distanceVector::iterator j = ndv.begin(); j != ndv.end(); j++) {
-        std::string name = j->first;
-        // std::cout << "Checking node " << name << "...";
-        if (m_dv.find(name) == m_dv.end()) {
-            m_dv[name] = M_INF;
-            // std::cout << "Inserted New Node " << name << '\n';
-        } else {
-          // std::cout << '\n';
-        }
-    }
+DVRoutingProtocol::BellmanFord(std::vector<uint32_t> dests, std::vector<uint32_t> &changedDests) {
+    TRAFFIC_LOG("RUNNING BELLMAN FORD on " << dests.size() << " destinations");
+    changedDests.clear();
+    if (dests.empty())
+        return;
+    m_forwardingTableDirty = true;
 
-    // std::cout << "before\n";
-    // DumpDV ();
- 
-    bool updated_value;
-    bool sendDV = false;
+    std::sort(dests.begin(), dests.end());
+    dests.erase(std::unique(dests.begin(), dests.end()), dests.end());
 
-    // Second, iterate through all known nodes and find the minimum distance
-    for (distanceVector::iterator i = m_dv.begin(); i != m_dv.end(); i++) {
-        uint32_t minCost = M_INF;
-        updated_value = false;
-        std::string dest = i->first;
-
-        std::string nextHop;
-
-        // create a new routing table entry
-        //check if it's ourselves
-        if (dest == ReverseLookup(m_mainAddress)) {
-            RoutingTableEntry nodeEntry;
-            nodeEntry.destAddr = m_mainAddress;
-            nodeEntry.nextHopNum = m_mainAddress.Get();
-            nodeEntry.nextHopAddr = m_mainAddress;
-            nodeEntry.interfaceAddr = Ipv4Address("127.0.0.1");;
-            nodeEntry.cost = 0;
-            m_routingTable.insert(std::make_pair(ReverseLookup(m_mainAddress), nodeEntry));
+    uint32_t thisNode = LookupNodeNumber(m_mainAddress);
+
+    for (uint32_t k = 0; k < dests.size(); k++) {
+        uint32_t dest = dests[k];
+        // our own route never changes
+        if (dest == thisNode)
             continue;
-        }
-        // std::cout << "Computing min dist to " << dest << std::endl;
-
-        //uint32_t current = M_INF;
-        for (distanceVector::iterator j = m_costs.begin(); j != m_costs.end(); j++) {
-            // std::cout << "  Going through " << j->first << "'s DV...\n";
-            // (Don't try to calculate a neighbor's distance to a neighbor, since all neighbors
-            // have cost = 1)
-            //if (dest != j->first) {
+        // first time we hear of this destination
+        if (m_dv[dest] == DV_UNKNOWN)
+            m_dv[dest] = M_INF;
+
+        uint32_t minCost = M_INF;
+        bool updated_value = false;
+        uint32_t nextHop = NODE_UNKNOWN;
+
+        for (costEntry j = m_costs.begin(); j != m_costs.end(); j++) {
             uint32_t cost_to_neighbor = j->second;
 
-            NeighborTableEntry entry = m_neighborTable.find(j->first)->second;
+            const NeighborTableEntry &entry = m_neighborTable.find(j->first)->second;
 
             if ( entry.dv.empty() )
                 continue;
             
-            distanceVector::iterator neighDest = entry.dv.find(dest);
-            // std::cout << "    trying to find "  << dest << " in " << j->first << " DV...\n";
-
             // If the neighbor can reach the destination, calculate the cost
-            if (neighDest == entry.dv.end() )
+            uint32_t neighbor_to_dest = entry.dv[dest];
+            if (neighbor_to_dest == DV_UNKNOWN)
                 continue;
 
             uint32_t current = 0;
-            uint32_t neighbor_to_dest = neighDest->second;
             if (neighbor_to_dest < M_INF - cost_to_neighbor) {
                 current = cost_to_neighbor + neighbor_to_dest;
             } else {
@@ -811,58 +923,58 @@ DVRoutingProtocol::BellmanFord(distanceVector &ndv) {
             }
             updated_value = true;
 
-            // std::cout << "  Found! Dist from " << j->first << " --> cost = " << current;
-            
             if (current < minCost) {
-                // std::cout << "(new min)";
                 minCost = current;
                 nextHop = j->first;
             }
-            // std::cout << std::endl;
         }
 
         if (updated_value) {
-            if (minCost != i->second && minCost <= 16) {
-                i->second = minCost;
-                sendDV = true; 
-                // std::cout << "Found a new minCost\n";
+            if (minCost != m_dv[dest] && minCost <= 16) {
+                m_dv[dest] = minCost;
+                changedDests.push_back(dest);
             }
         }
 
+        m_routingTable.RemoveRoute(dest);
         if (minCost < M_INF && minCost < 16) {
-            // std::cout << "Adding Entry for " << dest << " in routing table\n";
-            RoutingTableEntry nodeEntry;
-            Ipv4Address nha = ResolveNodeIpAddress(std::atoi(nextHop.c_str()));
-            nodeEntry.destAddr = ResolveNodeIpAddress(std::atoi(dest.c_str()));
-            nodeEntry.nextHopNum = nha.Get();
-            nodeEntry.nextHopAddr = nha;
-            nodeEntry.interfaceAddr = m_neighborTable.find(ReverseLookup(nha))->second.interfaceAddr;
-            nodeEntry.cost = minCost;
-            m_routingTable.insert(std::make_pair(dest, nodeEntry));
-            //DumpRoutingTable();
+            const NeighborTableEntry &hop = m_neighborTable.find(nextHop)->second;
+            m_routingTable.SetRoute(dest, minCost, nextHop, hop.neighborAddr, hop.interfaceAddr);
         }
-
     }
-    // std::cout << "after\n";
-    // DumpDV ();
-    if (sendDV) {
-        //TRAFFIC_LOG("Sending DV table");
-        SendDVTableMessage();
+}
+
+Ptr<Ipv4Route>
+DVRoutingProtocol::SearchTable (Ipv4Address dest)
+{
+    if (m_forwardingTableDirty) {
+        BuildForwardingTable();
     }
-    // DumpRoutingTable();
+    return m_forwardingTable.Lookup(dest);
 }
 
-bool
-DVRoutingProtocol::SearchTable (RoutingTableEntry& out_entry, Ipv4Address dest)
+void
+DVRoutingProtocol::BuildForwardingTable ()
 {
-    // Get the iterator at "dest" position
-    std::string node = ReverseLookup(dest);
-    std::map<std::string, RoutingTableEntry>::iterator it = m_routingTable.find(node);
-    if (it == m_routingTable.end()) {
-         return false;
+  // Every interface address of a node shares the route to its main address
+  m_forwardingTable.Reset (m_addressDirectory->GetNAddresses ());
+  for (uint32_t i = 0; i < m_addressDirectory->GetNAddresses (); i++)
+    {
+      uint32_t node = m_addressDirectory->GetAddressNode (i);
+      if (!m_routingTable.HasRoute (node))
+        {
+          continue;
+        }
+      Ipv4Address destination = m_addressDirectory->GetAddress (i);
+      Ptr<Ipv4Route> ipv4Route = Create<Ipv4Route> ();
+      ipv4Route->SetDestination (destination);
+      ipv4Route->SetSource (m_mainAddress);
+      ipv4Route->SetGateway (m_routingTable.nextHopAddr[node]);
+      int32_t interface = m_ipv4->GetInterfaceForAddress (m_routingTable.interfaceAddr[node]);
+      ipv4Route->SetOutputDevice (m_ipv4->GetNetDevice (interface));
+      m_forwardingTable.Insert (destination, ipv4Route);
     }
-    out_entry = it->second;
-    return true;
+  m_forwardingTableDirty = false;
 }
 
 uint32_t
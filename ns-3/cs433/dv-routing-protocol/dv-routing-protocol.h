@@ -31,11 +31,16 @@
 #include "ns3/dv-table-msg.h"
 #include "ns3/comm-routing-protocol.h"
 #include "ns3/dv-message.h"
+#include "ns3/header-template.h"
+#include "ns3/node-route-table.h"
+#include "ns3/forwarding-table.h"
 
 #include <vector>
 #include <map>
 
 #define M_INF std::numeric_limits<int>::max()
+// Destination missing from a distance vector
+#define DV_UNKNOWN std::numeric_limits<uint32_t>::max()
 
 using namespace ns3;
 
@@ -81,6 +86,15 @@ class DVRoutingProtocol : public CommRoutingProtocol
      */
 
     virtual void SetAddressNodeMap (std::map<Ipv4Address, uint32_t> addressNodeMap);
+    /**
+     * \brief Use the node number/address directory shared by all nodes.
+     *
+     * This method is called by the simulator-main when this node is created.
+     * SetNodeAddressMap and SetAddressNodeMap build a private directory instead.
+     *
+     * \param addressDirectory Directory.
+     */
+    virtual void SetAddressDirectory (Ptr<AddressDirectory> addressDirectory);
 
     // Message Handling
     /**
@@ -100,6 +114,19 @@ class DVRoutingProtocol : public CommRoutingProtocol
 
     void SendHello ();
     void SendDVTableMessage ();
+    /**
+     * \brief Advertise the destinations whose cost changed.
+     *
+     * Sends a DV_UPDATE_MSG carrying only those destinations when
+     * TriggeredUpdates is enabled, the whole table otherwise.
+     *
+     * \param changedDests Node numbers of the changed destinations.
+     */
+    void SendTriggeredUpdate (const std::vector<uint32_t> &changedDests);
+    /**
+     * \brief Periodic full table refresh for triggered mode.
+     */
+    void SendFullUpdate ();
 
     // Periodic Audit
     void AuditPings ();
@@ -220,6 +247,15 @@ class DVRoutingProtocol : public CommRoutingProtocol
      */
 
     virtual std::string ReverseLookup (Ipv4Address ipv4Address); 
+    /**
+     * \brief Returns the Inet topology node number which is using the specified IP.
+     *
+     * Used to index the routing table and distance vectors.
+     *
+     * \param ipv4Address IP address of node.
+     * \returns NODE_UNKNOWN if the address does not belong to any node.
+     */
+    uint32_t LookupNodeNumber (Ipv4Address ipv4Address);
     
     // Status 
     void DumpNeighbors ();
@@ -248,26 +284,28 @@ class DVRoutingProtocol : public CommRoutingProtocol
     uint32_t m_currentSequenceNumber;
     std::map<uint32_t, Ipv4Address> m_nodeAddressMap;
     std::map<Ipv4Address, uint32_t> m_addressNodeMap;
+    Ptr<AddressDirectory> m_addressDirectory;
     // Timers
     Timer m_auditPingsTimer;
     Timer m_auditHellosTimer;
+    Timer m_fullUpdateTimer;
+    // Triggered updates
+    bool m_triggeredUpdates;
+    Time m_fullUpdateInterval;
+    // Send the packed node number encoding of the table messages
+    bool m_packedTableMessages;
     // Ping tracker
     std::map<uint32_t, Ptr<PingRequest> > m_pingTracker;
+    // Serialized HELLO_REQ, only the sequence number changes
+    HeaderTemplate m_helloTemplate;
 
 
-    typedef std::map<std::string, uint32_t> distanceVector;
+    // Indexed by node number, DV_UNKNOWN for destinations not heard of
+    typedef std::vector<uint32_t> distanceVector;
 
     // Why do we need both of these?
     distanceVector m_dv;    // Cost to all destinations
-    distanceVector m_costs; // Cost to each neighbor
-
-    struct RoutingTableEntry {
-      Ipv4Address destAddr;
-      uint32_t nextHopNum;
-      Ipv4Address nextHopAddr;
-      Ipv4Address interfaceAddr;
-      uint32_t cost;
-    };
+    std::map<uint32_t, uint32_t> m_costs; // Cost to each neighbor
 
     struct NeighborTableEntry {
       Ipv4Address neighborAddr;
@@ -283,18 +321,46 @@ class DVRoutingProtocol : public CommRoutingProtocol
     //  uint32_t sequenceNumber; // I don't think we need this for the DV algorithm
     //};
 
-    std::map<std::string, NeighborTableEntry> m_neighborTable;
-    std::map<std::string, RoutingTableEntry> m_routingTable;
+    std::map<uint32_t, NeighborTableEntry> m_neighborTable;
+    NodeRouteTable m_routingTable;
     //std::map<std::string, DVTableEntry> m_dvTable;
 
-    typedef std::map<std::string, NeighborTableEntry>::iterator ntEntry;
-    typedef std::map<std::string, RoutingTableEntry>::iterator rtEntry;
+    typedef std::map<uint32_t, NeighborTableEntry>::iterator ntEntry;
+    typedef std::map<uint32_t, uint32_t>::iterator costEntry;
     //typedef std::map<std::string, DVTableEntry>::iterator dvtEntry;
 
     void DumpNeighborDV(NeighborTableEntry);
-    void BellmanFord (distanceVector&);
+    /**
+     * \brief Recompute the cost and route of the given destinations only.
+     *
+     * The cost of a destination depends only on the neighbors' entries for it,
+     * so destinations outside dests keep their routes.
+     *
+     * \param dests Node numbers whose inputs changed.
+     * \param changedDests Filled with the destinations whose cost changed.
+     */
+    void BellmanFord (std::vector<uint32_t> dests, std::vector<uint32_t> &changedDests);
+    /**
+     * \brief Send our distance vector entries for dests to one or all neighbors.
+     *
+     * Routes learnt directly from a neighbor are poisoned towards it.
+     *
+     * \param type DV_TABLE_MSG or DV_UPDATE_MSG.
+     * \param dests Node numbers to advertise.
+     * \param toNeighbor Only neighbor to send to, NODE_UNKNOWN for all of them.
+     */
+    void SendDistanceVector (DVMessage::MessageType type, const std::vector<uint32_t> &dests, uint32_t toNeighbor);
+
+    /**
+     * \brief Look up the compiled forwarding table, rebuilding it first if the routes changed.
+     *
+     * \returns the route to dest, or 0 if there is none.
+     */
+    Ptr<Ipv4Route> SearchTable (Ipv4Address dest);
+    void BuildForwardingTable ();
 
-    bool SearchTable (RoutingTableEntry& out_entry, Ipv4Address dest);
+    ForwardingTable m_forwardingTable;
+    bool m_forwardingTableDirty;
 };
 
 #endif
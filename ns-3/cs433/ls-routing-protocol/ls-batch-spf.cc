@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/ls-batch-spf.h"
+#include "ns3/system-thread.h"
+#include "ns3/log.h"
+
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LSBatchSpf");
+
+LSBatchSpf::LSBatchSpf ()
+  : m_next (0)
+{
+}
+
+void
+LSBatchSpf::AddLink (uint32_t nodeA, Ipv4Address addressA, uint32_t nodeB, Ipv4Address addressB)
+{
+  LSRoutingProtocol::TopologyLink link = { nodeA, addressA, nodeB, addressB };
+  m_links.push_back (link);
+}
+
+void
+LSBatchSpf::AddProtocol (Ptr<LSRoutingProtocol> protocol)
+{
+  m_protocols.push_back (protocol);
+}
+
+void
+LSBatchSpf::Run (uint32_t threads)
+{
+  // Priming reads the simulator clock, keep it on this thread
+  for (uint32_t i = 0; i < m_protocols.size (); i++)
+    {
+      m_protocols[i]->PrimeConvergedState (m_links);
+    }
+
+  if (threads == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      threads = cpus > 0 ? cpus : 1;
+    }
+  if (threads > m_protocols.size ())
+    {
+      threads = m_protocols.size ();
+    }
+  NS_LOG_INFO ("Batch SPF for " << m_protocols.size () << " nodes on " << threads << " threads");
+
+  m_next = 0;
+  std::vector<Ptr<SystemThread> > workers;
+  for (uint32_t i = 0; i < threads; i++)
+    {
+      Ptr<SystemThread> worker = Create<SystemThread> (MakeCallback (&LSBatchSpf::Worker, this));
+      worker->Start ();
+      workers.push_back (worker);
+    }
+  for (uint32_t i = 0; i < workers.size (); i++)
+    {
+      workers[i]->Join ();
+    }
+}
+
+void
+LSBatchSpf::Worker ()
+{
+  while (true)
+    {
+      uint32_t index;
+      {
+        CriticalSection cs (m_mutex);
+        if (m_next >= m_protocols.size ())
+          {
+            return;
+          }
+        index = m_next++;
+      }
+      m_protocols[index]->ComputeConvergedRoutes ();
+    }
+}
@@ -0,0 +1,61 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LS_BATCH_SPF_H
+#define LS_BATCH_SPF_H
+
+#include "ns3/ls-routing-protocol.h"
+#include "ns3/system-mutex.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief Computes the converged routing table of every LS node at startup.
+ *
+ * simulator-main hands over the topology and the LS instances before the
+ * simulation runs. Each instance is primed with the LSAs and neighbors the
+ * protocol would converge to, then the per-node SPF runs are spread over a
+ * pool of worker threads. The simulation then starts from the converged
+ * state instead of waiting for hellos and LSAs to propagate.
+ */
+class LSBatchSpf
+{
+  public:
+    LSBatchSpf ();
+
+    void AddLink (uint32_t nodeA, Ipv4Address addressA, uint32_t nodeB, Ipv4Address addressB);
+    void AddProtocol (Ptr<LSRoutingProtocol> protocol);
+
+    /**
+     * \brief Prime every protocol and compute all routing tables.
+     *
+     * \param threads Number of worker threads, 0 for one per online CPU.
+     */
+    void Run (uint32_t threads);
+
+  private:
+    void Worker ();
+
+    std::vector<LSRoutingProtocol::TopologyLink> m_links;
+    std::vector<Ptr<LSRoutingProtocol> > m_protocols;
+    // Next protocol to hand to a worker
+    uint32_t m_next;
+    SystemMutex m_mutex;
+};
+
+#endif
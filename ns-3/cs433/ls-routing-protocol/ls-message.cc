@@ -79,6 +79,9 @@ LSMessage::GetSerializedSize (void) const
       case LS_TABLE_MSG:
         size += m_message.lsTableMsg.GetSerializedSize ();
         break;
+      case LS_TABLE_PACKED_MSG:
+        size += m_message.lsTablePackedMsg.GetSerializedSize ();
+        break;
       default:
         NS_ASSERT (false);
     }
@@ -111,6 +114,9 @@ LSMessage::Print (std::ostream &os) const
         m_message.helloRsp.Print (os);
         break;
       */
+      case LS_TABLE_PACKED_MSG:
+        m_message.lsTablePackedMsg.Print (os);
+        break;
       case LS_TABLE_MSG:
         m_message.lsTableMsg.Print (os);
       default:
@@ -147,6 +153,9 @@ LSMessage::Serialize (Buffer::Iterator start) const
       case LS_TABLE_MSG:
         m_message.lsTableMsg.Serialize (i);
         break;
+      case LS_TABLE_PACKED_MSG:
+        m_message.lsTablePackedMsg.Serialize (i);
+        break;
       default:
         NS_ASSERT (false);   
     }
@@ -181,7 +190,10 @@ LSMessage::Deserialize (Buffer::Iterator start)
         break;
       */
       case LS_TABLE_MSG:
-        m_message.lsTableMsg.Deserialize (i);
+        size += m_message.lsTableMsg.Deserialize (i);
+        break;
+      case LS_TABLE_PACKED_MSG:
+        size += m_message.lsTablePackedMsg.Deserialize (i);
         break;
       default:
         NS_ASSERT (false);
@@ -485,6 +497,29 @@ LSMessage::GetLSTableMsg ()
   return m_message.lsTableMsg;
 }
 
+/* LS_TABLE_PACKED_MSG */
+
+void
+LSMessage::SetLSTablePackedMsg (std::vector<std::pair<uint32_t, uint32_t> > nodeCosts)
+{
+  if (m_messageType == 0)
+    {
+      m_messageType = LS_TABLE_PACKED_MSG;
+    }
+  else
+    {
+      NS_ASSERT (m_messageType == LS_TABLE_PACKED_MSG);
+    }
+  m_message.lsTablePackedMsg.nodeCosts = nodeCosts;
+  m_message.lsTablePackedMsg.Sort ();
+}
+
+PackedNodeCosts
+LSMessage::GetLSTablePackedMsg ()
+{
+  return m_message.lsTablePackedMsg;
+}
+
 //
 //
 //
@@ -537,3 +572,144 @@ LSMessage::GetOriginatorAddress (void) const
   return m_originatorAddress;
 }
 
+/* LSMessageView */
+
+LSMessageView::LSMessageView ()
+  : m_messageType (LSMessage::LS_TABLE_MSG),
+    m_sequenceNumber (0),
+    m_ttl (0),
+    m_nNeighbors (0)
+{
+}
+
+LSMessageView::~LSMessageView ()
+{
+}
+
+LSMessage::MessageType
+LSMessageView::GetMessageType () const
+{
+  return m_messageType;
+}
+
+uint32_t
+LSMessageView::GetSequenceNumber () const
+{
+  return m_sequenceNumber;
+}
+
+Ipv4Address
+LSMessageView::GetOriginatorAddress () const
+{
+  return m_originatorAddress;
+}
+
+uint8_t
+LSMessageView::GetTTL () const
+{
+  return m_ttl;
+}
+
+void
+LSMessageView::SetTTL (uint8_t ttl)
+{
+  m_ttl = ttl;
+}
+
+uint32_t
+LSMessageView::GetNNeighbors () const
+{
+  return m_nNeighbors;
+}
+
+Ipv4Address
+LSMessageView::GetNeighborAddress (uint32_t i) const
+{
+  NS_ASSERT (i < m_nNeighbors);
+  Buffer::Iterator neighbor = m_neighbors;
+  neighbor.Next (i * (IPV4_ADDRESS_SIZE + sizeof (uint32_t)));
+  return Ipv4Address (neighbor.ReadNtohU32 ());
+}
+
+uint32_t
+LSMessageView::GetNeighborCost (uint32_t i) const
+{
+  NS_ASSERT (i < m_nNeighbors);
+  Buffer::Iterator neighbor = m_neighbors;
+  neighbor.Next (i * (IPV4_ADDRESS_SIZE + sizeof (uint32_t)) + IPV4_ADDRESS_SIZE);
+  return neighbor.ReadNtohU32 ();
+}
+
+TypeId
+LSMessageView::GetInstanceTypeId (void) const
+{
+  return LSMessage::GetTypeId ();
+}
+
+void
+LSMessageView::Print (std::ostream &os) const
+{
+  os << "\n****LSMessage Dump****\n" ;
+  os << "messageType: " << m_messageType << "\n";
+  os << "sequenceNumber: " << m_sequenceNumber << "\n";
+  os << "ttl: " << unsigned(m_ttl) << "\n";
+  os << "originatorAddress: " << m_originatorAddress << "\n";
+  if (m_messageType == LSMessage::LS_TABLE_MSG)
+    {
+      os << "PAYLOAD:: \n";
+      os << "LSTableMsg:: Neighbors: ";
+      for (uint32_t i = 0; i < m_nNeighbors; i++)
+        {
+          os << GetNeighborAddress (i) << ":" << GetNeighborCost (i) << ", ";
+        }
+      os << "\b\b\n";
+    }
+  os << "\n****END OF MESSAGE****\n";
+}
+
+uint32_t
+LSMessageView::GetSerializedSize (void) const
+{
+  if (m_messageType != LSMessage::LS_TABLE_MSG)
+    {
+      return LSMessage::COMMON_HEADER_SIZE;
+    }
+  return LSMessage::COMMON_HEADER_SIZE + sizeof (uint16_t)
+    + (IPV4_ADDRESS_SIZE + sizeof (uint32_t)) * m_nNeighbors;
+}
+
+void
+LSMessageView::Serialize (Buffer::Iterator start) const
+{
+  NS_ASSERT (m_messageType == LSMessage::LS_TABLE_MSG);
+  Buffer::Iterator i = start;
+  i.WriteU8 (m_messageType);
+  i.WriteHtonU32 (m_sequenceNumber);
+  i.WriteU8 (m_ttl);
+  i.WriteHtonU32 (m_originatorAddress.Get ());
+  i.WriteU16 (m_nNeighbors);
+  Buffer::Iterator neighbors = m_neighbors;
+  for (uint32_t k = 0; k < m_nNeighbors; k++)
+    {
+      // address and cost, copied byte for byte
+      i.WriteU32 (neighbors.ReadU32 ());
+      i.WriteU32 (neighbors.ReadU32 ());
+    }
+}
+
+uint32_t
+LSMessageView::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_messageType = (LSMessage::MessageType) i.ReadU8 ();
+  m_sequenceNumber = i.ReadNtohU32 ();
+  m_ttl = i.ReadU8 ();
+  m_originatorAddress = Ipv4Address (i.ReadNtohU32 ());
+  m_nNeighbors = 0;
+  if (m_messageType == LSMessage::LS_TABLE_MSG)
+    {
+      m_nNeighbors = i.ReadU16 ();
+    }
+  m_neighbors = i;
+  return GetSerializedSize ();
+}
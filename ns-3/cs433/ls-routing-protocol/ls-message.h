@@ -22,6 +22,7 @@
 #include "ns3/packet.h"
 #include "ns3/object.h"
 #include "ns3/nstime.h"
+#include "ns3/packed-node-costs.h"
 #include <vector>
 
 using namespace ns3;
@@ -45,11 +46,21 @@ class LSMessage : public Header
         //HELLO_RSP = 4,
 
         LS_TABLE_MSG = 4,
+        // LS_TABLE_MSG with node numbers instead of addresses, see PackedNodeCosts
+        LS_TABLE_PACKED_MSG = 5,
 
       };
 
     LSMessage (LSMessage::MessageType messageType, uint32_t sequenceNumber, uint8_t ttl, Ipv4Address originatorAddress);
 
+    /**
+     *  Serialized layout of the fields every message starts with: message
+     *  type, sequence number, TTL and originator address.
+     */
+    static const uint32_t SEQUENCE_NUMBER_OFFSET = 1;
+    static const uint32_t TTL_OFFSET = 5;
+    static const uint32_t COMMON_HEADER_SIZE = 10;
+
     /**
     *  \brief Sets message type
     *  \param messageType message type
@@ -177,6 +188,7 @@ class LSMessage : public Header
         HelloReq helloReq;
         //HelloRsp helloRsp;
         LSTableMsg lsTableMsg;
+        PackedNodeCosts lsTablePackedMsg;
       } m_message;
     
   public:
@@ -219,10 +231,77 @@ class LSMessage : public Header
 
     void SetLSTableMsg (nbrCostsVec neighborCosts);
 
+    /* LS Table Packed Msg */
+    PackedNodeCosts GetLSTablePackedMsg ();
+
+    /**
+     *  \brief Sets the neighbors of an LS_TABLE_PACKED_MSG
+     *  \param nodeCosts (node number, cost) pairs, in any order
+     */
+    void SetLSTablePackedMsg (std::vector<std::pair<uint32_t, uint32_t> > nodeCosts);
+
 
 
 }; // class LSMessage
 
+/**
+ * \brief Reads an LSMessage in place, out of the packet which holds it.
+ *
+ * PeekHeader (view) only reads the fields every message starts with and,
+ * for an LS_TABLE_MSG, where its neighbors start; GetNeighborAddress and
+ * GetNeighborCost then read them one at a time out of the packet buffer,
+ * instead of copying the whole message into an LSMessage and its
+ * nbrCostsVec. The view is only valid while the packet it was peeked
+ * from is alive and unchanged.
+ *
+ * An LS_TABLE_MSG view can be added to another packet, with a new TTL
+ * for instance, which copies the neighbors as they are.
+ */
+class LSMessageView : public Header
+{
+  public:
+    LSMessageView ();
+    virtual ~LSMessageView ();
+
+    LSMessage::MessageType GetMessageType () const;
+    uint32_t GetSequenceNumber () const;
+    Ipv4Address GetOriginatorAddress () const;
+    uint8_t GetTTL () const;
+    void SetTTL (uint8_t ttl);
+
+    /**
+     *  \returns number of neighbors of an LS_TABLE_MSG
+     */
+    uint32_t GetNNeighbors () const;
+    /**
+     *  \param i index of the neighbor, less than GetNNeighbors ()
+     */
+    Ipv4Address GetNeighborAddress (uint32_t i) const;
+    uint32_t GetNeighborCost (uint32_t i) const;
+
+    /**
+     *  \returns the type of LSMessage, the view is an LSMessage on the wire
+     */
+    virtual TypeId GetInstanceTypeId (void) const;
+    virtual void Print (std::ostream &os) const;
+    /**
+     *  \returns size of an LS_TABLE_MSG, only the common fields of the other
+     *  messages are read
+     */
+    virtual uint32_t GetSerializedSize (void) const;
+    virtual void Serialize (Buffer::Iterator start) const;
+    virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  private:
+    LSMessage::MessageType m_messageType;
+    uint32_t m_sequenceNumber;
+    Ipv4Address m_originatorAddress;
+    uint8_t m_ttl;
+    uint16_t m_nNeighbors;
+    // first neighbor, in the buffer of the packet
+    Buffer::Iterator m_neighbors;
+};
+
 static inline std::ostream& operator<< (std::ostream& os, const LSMessage& message)
 {
   message.Print (os);
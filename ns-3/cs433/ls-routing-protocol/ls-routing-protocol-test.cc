@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/ls-routing-protocol.h"
+#include "ns3/address-directory.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \brief Gives the test access to the LS database of a protocol instance.
+ */
+class LSDatabaseProbe : public LSRoutingProtocol
+{
+public:
+  bool Offer (Ipv4Address fromAddr, uint32_t seqNum)
+  {
+    uint32_t fromNode = AcceptLSA (fromAddr, seqNum);
+    if (fromNode == NODE_UNKNOWN)
+      {
+        return false;
+      }
+    nodeCostsVec neighborCosts;
+    InstallLSA (fromNode, seqNum, false, neighborCosts);
+    return true;
+  }
+};
+
+/**
+ * \brief Which LSAs the LS database takes, including sequence numbers
+ * wrapping around from 0xffffffff to 0.
+ */
+class LSDatabaseSequenceTestCase : public TestCase
+{
+public:
+  LSDatabaseSequenceTestCase ();
+  virtual ~LSDatabaseSequenceTestCase (void);
+
+protected:
+  virtual bool DoRun (void);
+};
+
+LSDatabaseSequenceTestCase::LSDatabaseSequenceTestCase ()
+  : TestCase ("ls database accepts newer sequence numbers across the wrap")
+{
+}
+
+LSDatabaseSequenceTestCase::~LSDatabaseSequenceTestCase (void)
+{
+  return;
+}
+
+bool
+LSDatabaseSequenceTestCase::DoRun (void)
+{
+  std::map<uint32_t, Ipv4Address> nodeAddressMap;
+  std::map<Ipv4Address, uint32_t> addressNodeMap;
+  for (uint32_t node = 0; node < 4; node++)
+    {
+      std::ostringstream address;
+      address << "10.0." << node << ".1";
+      nodeAddressMap[node] = Ipv4Address (address.str ().c_str ());
+      addressNodeMap[nodeAddressMap[node]] = node;
+    }
+  Ptr<LSDatabaseProbe> probe = CreateObject<LSDatabaseProbe> ();
+  probe->SetAddressDirectory (Create<AddressDirectory> (nodeAddressMap, addressNodeMap));
+  Ipv4Address first = nodeAddressMap[1];
+  Ipv4Address second = nodeAddressMap[2];
+  // the rejected foreign LSA is logged as an error
+  probe->SetErrorVerbose (false);
+
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (Ipv4Address ("192.168.0.1"), 1), false, "LSA from outside the topology");
+
+  // any sequence number is newer than no LSA at all
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (first, 0xfffffff0), true, "first LSA");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (first, 0xfffffff0), false, "duplicate");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (first, 0xffffffe0), false, "older");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (first, 0xfffffffe), true, "newer");
+  // across the wrap
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (first, 0x00000003), true, "newer after the wrap");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (first, 0xffffffff), false, "older before the wrap");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (first, 0x00000003), false, "duplicate after the wrap");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (first, 0x00000004), true, "newer after the wrap");
+
+  // less than half the sequence space ahead is newer, exactly half is not
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (second, 0x7ffffff0), true, "first LSA");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (second, 0xfffffff0), false, "half the space ahead");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (second, 0xffffffef), true, "less than half the space ahead");
+  NS_TEST_ASSERT_MSG_EQ (probe->Offer (second, 0x7ffffff0), false, "older than the one installed");
+
+  probe->Dispose ();
+  Simulator::Destroy ();
+  return GetErrorStatus ();
+}
+
+class LSRoutingProtocolTestSuite : public TestSuite
+{
+public:
+  LSRoutingProtocolTestSuite ();
+};
+
+LSRoutingProtocolTestSuite::LSRoutingProtocolTestSuite ()
+  : TestSuite ("cs433-ls-routing-protocol", UNIT)
+{
+  AddTestCase (new LSDatabaseSequenceTestCase ());
+}
+
+static LSRoutingProtocolTestSuite lsRoutingProtocolTestSuite;
+
+int
+main (int argc, char *argv[])
+{
+  lsRoutingProtocolTestSuite.SetVerbose (true);
+  bool failed = lsRoutingProtocolTestSuite.Run ();
+  std::cout << (failed ? "FAIL: " : "PASS: ") << lsRoutingProtocolTestSuite.GetName () << std::endl;
+  return failed ? 1 : 0;
+}
@@ -25,9 +25,12 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
 #include "ns3/test-result.h"
 #include <sys/time.h>
 #include <vector>
+#include <algorithm>
 #include <limits>
 
 using namespace ns3;
@@ -61,17 +64,80 @@ LSRoutingProtocol::GetTypeId (void)
                  UintegerValue (16),
                  MakeUintegerAccessor (&LSRoutingProtocol::m_maxTTL),
                  MakeUintegerChecker<uint8_t> ())
+  .AddAttribute ("IncrementalSpf",
+                 "Repair the shortest path tree on remote LSA changes instead of running a full Dijkstra",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&LSRoutingProtocol::m_incrementalSpf),
+                 MakeBooleanChecker ())
+  .AddAttribute ("SpfInitialDelay",
+                 "Delay between the first topology change after a quiet period and the SPF run",
+                 TimeValue (MilliSeconds (0)),
+                 MakeTimeAccessor (&LSRoutingProtocol::m_spfInitialDelay),
+                 MakeTimeChecker ())
+  .AddAttribute ("SpfHoldTime",
+                 "Minimum time between two consecutive SPF runs, doubled while changes keep coming",
+                 TimeValue (MilliSeconds (0)),
+                 MakeTimeAccessor (&LSRoutingProtocol::m_spfHoldTime),
+                 MakeTimeChecker ())
+  .AddAttribute ("SpfMaxHoldTime",
+                 "Upper bound for the SPF hold time back-off",
+                 TimeValue (MilliSeconds (5000)),
+                 MakeTimeAccessor (&LSRoutingProtocol::m_spfMaxHoldTime),
+                 MakeTimeChecker ())
+  .AddAttribute ("LsaMinInterval",
+                 "Minimum time between two originations of our own LSA",
+                 TimeValue (MilliSeconds (0)),
+                 MakeTimeAccessor (&LSRoutingProtocol::m_lsaMinInterval),
+                 MakeTimeChecker ())
+  .AddAttribute ("PackedTableMessages",
+                 "Originate LSAs in the packed node number encoding",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&LSRoutingProtocol::m_packedTableMessages),
+                 MakeBooleanChecker ())
+  .AddAttribute ("LsaRefreshInterval",
+                 "Re-originate our LSA when it has not been sent for this long, 0 disables refresh (the default)",
+                 TimeValue (MilliSeconds (0)),
+                 MakeTimeAccessor (&LSRoutingProtocol::m_lsaRefreshInterval),
+                 MakeTimeChecker ())
+  .AddAttribute ("LsaMaxAge",
+                 "Purge LSAs of other nodes not refreshed for this long, 0 disables aging (the default); "
+                 "use a multiple of LsaRefreshInterval, e.g. 30s and 90s",
+                 TimeValue (MilliSeconds (0)),
+                 MakeTimeAccessor (&LSRoutingProtocol::m_lsaMaxAge),
+                 MakeTimeChecker ())
+  .AddAttribute ("SpfFrontier",
+                 "Priority queue used by full SPF runs",
+                 EnumValue (SPF_BINARY_HEAP),
+                 MakeEnumAccessor (&LSRoutingProtocol::m_spfFrontierType),
+                 MakeEnumChecker (SPF_LINEAR_SCAN, "LinearScan",
+                                  SPF_BINARY_HEAP, "BinaryHeap",
+                                  SPF_RADIX_HEAP, "RadixHeap",
+                                  SPF_DIAL_BUCKETS, "DialBuckets"))
   ;
   return tid;
 }
 
 LSRoutingProtocol::LSRoutingProtocol ()
-  : m_auditPingsTimer (Timer::CANCEL_ON_DESTROY), m_auditHellosTimer (Timer::CANCEL_ON_DESTROY)
+  : m_auditPingsTimer (Timer::CANCEL_ON_DESTROY), m_auditHellosTimer (Timer::CANCEL_ON_DESTROY),
+    m_spfTimer (Timer::CANCEL_ON_DESTROY), m_lsaTimer (Timer::CANCEL_ON_DESTROY),
+    m_lsaRefreshTimer (Timer::CANCEL_ON_DESTROY)
 {
   RandomVariable random;
   SeedManager::SetSeed (time (NULL));
   random = UniformVariable (0x00000000, 0xFFFFFFFF);
   m_currentSequenceNumber = random.GetInteger ();
+  m_forwardingTableDirty = true;
+  m_fullSpfCount = 0;
+  m_partialSpfCount = 0;
+  m_lsaOriginated = false;
+  m_pendingSpfNode = NODE_UNKNOWN;
+  m_coalescedSpfCount = 0;
+  m_coalescedLsaCount = 0;
+  m_duplicateLsaCount = 0;
+  m_purgedLsaCount = 0;
+  m_convergedStatePrimed = false;
+  m_spfFrontierType = SPF_BINARY_HEAP;
+  m_addressDirectory = Create<AddressDirectory> ();
   // Setup static routing 
   m_staticRouting = Create<Ipv4StaticRouting> ();
 }
@@ -97,6 +163,9 @@ LSRoutingProtocol::DoDispose ()
   // Cancel timers
   m_auditPingsTimer.Cancel ();
   m_auditHellosTimer.Cancel ();
+  m_spfTimer.Cancel ();
+  m_lsaTimer.Cancel ();
+  m_lsaRefreshTimer.Cancel ();
  
   m_pingTracker.clear (); 
 
@@ -107,45 +176,126 @@ void
 LSRoutingProtocol::SetMainInterface (uint32_t mainInterface)
 {
   m_mainAddress = m_ipv4->GetAddress (mainInterface, 0).GetLocal ();
+  m_helloTemplate = HeaderTemplate ();
 }
 
 void
 LSRoutingProtocol::SetNodeAddressMap (std::map<uint32_t, Ipv4Address> nodeAddressMap)
 {
   m_nodeAddressMap = nodeAddressMap;
+  SetAddressDirectory (Create<AddressDirectory> (m_nodeAddressMap, m_addressNodeMap));
 }
 
 void
 LSRoutingProtocol::SetAddressNodeMap (std::map<Ipv4Address, uint32_t> addressNodeMap)
 {
   m_addressNodeMap = addressNodeMap;
+  SetAddressDirectory (Create<AddressDirectory> (m_nodeAddressMap, m_addressNodeMap));
+}
+
+void
+LSRoutingProtocol::SetAddressDirectory (Ptr<AddressDirectory> addressDirectory)
+{
+  m_addressDirectory = addressDirectory;
+
+  // Node numbers index the LS and routing tables
+  uint32_t nodeCount = m_addressDirectory->GetNodeCount ();
+  LSTableEntry noLsa;
+  noLsa.sequenceNumber = 0;
+  noLsa.valid = false;
+  m_lsTable.assign (nodeCount, noLsa);
+  m_routingTable.Resize (nodeCount);
+  m_sptParent.assign (nodeCount, NODE_UNKNOWN);
+  m_forwardingTableDirty = true;
+}
+
+void
+LSRoutingProtocol::PrimeConvergedState (const std::vector<TopologyLink> &links)
+{
+  uint32_t thisNode = LookupNodeNumber (m_mainAddress);
+  if (thisNode == NODE_UNKNOWN)
+    {
+      return;
+    }
+
+  m_neighborTable.clear ();
+  for (uint32_t node = 0; node < m_lsTable.size (); node++)
+    {
+      m_lsTable[node].neighborCosts.clear ();
+      m_lsTable[node].valid = false;
+    }
+
+  // Every LSA as its originator would have sent it
+  for (unsigned i = 0; i < links.size (); i++)
+    {
+      const TopologyLink &link = links[i];
+      if (link.nodeA >= m_lsTable.size () || link.nodeB >= m_lsTable.size ())
+        {
+          continue;
+        }
+      m_lsTable[link.nodeA].neighborCosts.push_back (std::make_pair (link.nodeB, (uint32_t) 1));
+      m_lsTable[link.nodeB].neighborCosts.push_back (std::make_pair (link.nodeA, (uint32_t) 1));
+      if (link.nodeA == thisNode || link.nodeB == thisNode)
+        {
+          bool isA = link.nodeA == thisNode;
+          NeighborTableEntry entry = { isA ? link.addressB : link.addressA,
+                                       isA ? link.addressA : link.addressB,
+                                       Simulator::Now () };
+          m_neighborTable[isA ? link.nodeB : link.nodeA] = entry;
+        }
+    }
+  for (uint32_t node = 0; node < m_lsTable.size (); node++)
+    {
+      LSTableEntry &entry = m_lsTable[node];
+      std::sort (entry.neighborCosts.begin (), entry.neighborCosts.end ());
+      entry.neighborCosts.erase (std::unique (entry.neighborCosts.begin (), entry.neighborCosts.end ()),
+                                 entry.neighborCosts.end ());
+      entry.valid = !entry.neighborCosts.empty ();
+      entry.sequenceNumber = 0;
+      entry.installed = Simulator::Now ();
+    }
+
+  m_lastSpfTime = Simulator::Now ();
+  m_forwardingTableDirty = true;
+  m_convergedStatePrimed = true;
+}
+
+void
+LSRoutingProtocol::ComputeConvergedRoutes ()
+{
+  Dijkstra ();
 }
 
 Ipv4Address
 LSRoutingProtocol::ResolveNodeIpAddress (uint32_t nodeNumber)
 {
-  std::map<uint32_t, Ipv4Address>::iterator iter = m_nodeAddressMap.find (nodeNumber);
-  if (iter != m_nodeAddressMap.end ())
-    { 
-      return iter->second;
-    }
-  return Ipv4Address::GetAny ();
+  return m_addressDirectory->GetMainAddress (nodeNumber);
 }
 
 std::string
 LSRoutingProtocol::ReverseLookup (Ipv4Address ipAddress)
 {
-  std::map<Ipv4Address, uint32_t>::iterator iter = m_addressNodeMap.find (ipAddress);
-  if (iter != m_addressNodeMap.end ())
+  uint32_t nodeNumber = m_addressDirectory->GetNodeNumber (ipAddress);
+  if (nodeNumber != NODE_UNKNOWN)
     { 
       std::ostringstream sin;
-      uint32_t nodeNumber = iter->second;
       sin << nodeNumber;    
       return sin.str();
     }
   return "Unknown";
 }
 
+uint32_t
+LSRoutingProtocol::LookupNodeNumber (Ipv4Address ipAddress)
+{
+  uint32_t nodeNumber = m_addressDirectory->GetNodeNumber (ipAddress);
+  if (nodeNumber < m_lsTable.size ())
+    {
+      return nodeNumber;
+    }
+  return NODE_UNKNOWN;
+}
+
 void
 LSRoutingProtocol::DoStart ()
 {
@@ -182,10 +332,20 @@ LSRoutingProtocol::DoStart ()
   // Configure timers
   m_auditPingsTimer.SetFunction (&LSRoutingProtocol::AuditPings, this);
   m_auditHellosTimer.SetFunction (&LSRoutingProtocol::AuditHellos, this);
+  m_spfTimer.SetFunction (&LSRoutingProtocol::RunScheduledSpf, this);
+  m_lsaTimer.SetFunction (&LSRoutingProtocol::SendLSTableMessage, this);
+  m_lsaRefreshTimer.SetFunction (&LSRoutingProtocol::RefreshLSA, this);
+  m_spfCurrentHold = m_spfHoldTime;
 
   // Start timers
   m_auditPingsTimer.Schedule (m_pingTimeout);
   m_auditHellosTimer.Schedule (m_helloTimeout);
+  if (!m_lsaRefreshInterval.IsZero ())
+    m_lsaRefreshTimer.Schedule (m_lsaRefreshInterval);
+
+  // Primed neighbors expire at the first audit unless they hear from us now
+  if (m_convergedStatePrimed)
+    SendHello ();
 
 }
 
@@ -195,7 +355,6 @@ LSRoutingProtocol::RouteOutput (Ptr<Packet> packet, const Ipv4Header &header, Pt
     DEBUG_LOG ("RouteOutput Called");
     // No clue what to do with outInterface or sockerr
     Ptr<Ipv4Route> ipv4Route = 0;
-    RoutingTableEntry entry;
 
     if (header.GetDestination () == m_mainAddress) {
          // DEBUG_LOG ("Found route in table");
@@ -210,20 +369,12 @@ LSRoutingProtocol::RouteOutput (Ptr<Packet> packet, const Ipv4Header &header, Pt
         ipv4Route->SetOutputDevice(m_ipv4->GetNetDevice (interface));
     }
 
-    else if (SearchTable (entry, header.GetDestination ())) {
-        // DEBUG_LOG ("Found route in table");
-        ipv4Route = Create<Ipv4Route> ();
-        ipv4Route->SetDestination (header.GetDestination ());
-        ipv4Route->SetSource (m_mainAddress);
-        ipv4Route->SetGateway (entry.nextHopAddr);
-        // Not 100% sure below is correct
-        // ipv4Route->SetOutputDevice (outInterface); // ????
-        int32_t interface = m_ipv4->GetInterfaceForAddress(entry.interfaceAddr);
-        ipv4Route->SetOutputDevice(m_ipv4->GetNetDevice (interface));
-    }
-
     else {
-        Ptr<Ipv4Route> ipv4Route = m_staticRouting->RouteOutput (packet, header, outInterface, sockerr);
+        // Compiled forwarding table first, static routes otherwise
+        ipv4Route = SearchTable (header.GetDestination ());
+        if (!ipv4Route) {
+            ipv4Route = m_staticRouting->RouteOutput (packet, header, outInterface, sockerr);
+        }
     }
 
     if (ipv4Route) {
@@ -263,17 +414,9 @@ LSRoutingProtocol::RouteInput  (Ptr<const Packet> packet,
     }
 
     // Forward using LS routing table
-    Ptr<Ipv4Route> ipv4Route;
-    RoutingTableEntry entry;
-    if (SearchTable (entry, destinationAddress)) {
-        DEBUG_LOG ("[RouteInput] Forwarding packet from " << m_mainAddress << " to " << entry.nextHopAddr);
-
-        ipv4Route = Create<Ipv4Route> ();
-        ipv4Route->SetDestination (destinationAddress);
-        ipv4Route->SetSource (m_mainAddress);
-        ipv4Route->SetGateway (entry.nextHopAddr);
-        int32_t interface = m_ipv4->GetInterfaceForAddress(entry.interfaceAddr);
-        ipv4Route->SetOutputDevice (m_ipv4->GetNetDevice (interface));
+    Ptr<Ipv4Route> ipv4Route = SearchTable (destinationAddress);
+    if (ipv4Route) {
+        DEBUG_LOG ("[RouteInput] Forwarding packet from " << m_mainAddress << " to " << ipv4Route->GetGateway ());
 
         // UnicastForwardCallback = void ucb(Ptr<Ipv4Route>, Ptr<const Packet>, const Ipv4Header &)
         ucb (ipv4Route, packet, header);
@@ -301,6 +444,19 @@ LSRoutingProtocol::BroadcastPacket (Ptr<Packet> packet)
     }
 }
 
+void
+LSRoutingProtocol::FloodPacket (Ptr<Packet> packet, Ptr<Socket> except)
+{
+  for (std::map<Ptr<Socket> , Ipv4InterfaceAddress>::const_iterator i =
+      m_socketAddresses.begin (); i != m_socketAddresses.end (); i++)
+    {
+      if (i->first == except)
+        continue;
+      Ipv4Address broadcastAddr = i->second.GetLocal ().GetSubnetDirectedBroadcast (i->second.GetMask ());
+      i->first->SendTo (packet, 0, InetSocketAddress (broadcastAddr, m_lsPort));
+    }
+}
+
 void
 LSRoutingProtocol::ProcessCommand (std::vector<std::string> tokens)
 {
@@ -355,6 +511,10 @@ LSRoutingProtocol::ProcessCommand (std::vector<std::string> tokens)
         {
           DumpLSTable ();
         }
+      else if (table == "SPF")
+        {
+          DumpSpfStats ();
+        }
     }
   else if (command == "HELLO")
     {
@@ -369,26 +529,44 @@ LSRoutingProtocol::ProcessCommand (std::vector<std::string> tokens)
 
 void
 LSRoutingProtocol::SendHello () {
-  Ipv4Address destAddress = ResolveNodeIpAddress (0); // TODO remove this and "hello"
   uint32_t sequenceNumber = GetNextSequenceNumber ();
 //  TRAFFIC_LOG ("Broadcasting HELLO_REQ, SequenceNumber: " << sequenceNumber);
   //Ptr<HelloRequest> helloRequest = Create<HelloRequest> (sequenceNumber, Simulator::Now(), destAddress, "hello", m_helloTimeout);
   // Add to hello-tracker
 //  m_helloTracker.insert (std::make_pair (sequenceNumber, helloRequest));
+  if (m_helloTemplate.IsEmpty ()) {
+    Ipv4Address destAddress = ResolveNodeIpAddress (0); // TODO remove this and "hello"
+    //TTL for HELLO msgs is 1
+    LSMessage lsMessage = LSMessage (LSMessage::HELLO_REQ, sequenceNumber, 1, m_mainAddress);
+    lsMessage.SetHelloReq (destAddress, "hello");
+    m_helloTemplate = HeaderTemplate (lsMessage);
+  }
+  // Every hello is the same message but for its sequence number
+  m_helloTemplate.SetU32 (LSMessage::SEQUENCE_NUMBER_OFFSET, sequenceNumber);
   Ptr<Packet> packet = Create<Packet> ();
-  //TTL for HELLO msgs is 1
-  LSMessage lsMessage = LSMessage (LSMessage::HELLO_REQ, sequenceNumber, 1, m_mainAddress);
-
-  //TRAFFIC_LOG("MY TTL IS: " << (unsigned)lsMessage.GetTTL() << " and my seqNum is " << lsMessage.GetSequenceNumber());
-
-  lsMessage.SetHelloReq (destAddress, "hello");
-  packet->AddHeader (lsMessage);
+  packet->AddHeader (m_helloTemplate);
   BroadcastPacket (packet);
 }
 
 void
 LSRoutingProtocol::SendLSTableMessage () {
   uint32_t sequenceNumber = GetNextSequenceNumber ();
+  m_lastLsaTime = Simulator::Now ();
+  m_lsaOriginated = true;
+
+  if (m_packedTableMessages) {
+    nodeCostsVec nodeCosts;
+    for (ntEntry i = m_neighborTable.begin (); i != m_neighborTable.end (); i++) {
+      nodeCosts.push_back( std::make_pair(i->first, (uint32_t) 1 )); //TODO change cost here
+    }
+    Ptr<Packet> packet = Create<Packet> ();
+    LSMessage lsMessage = LSMessage (LSMessage::LS_TABLE_PACKED_MSG, sequenceNumber, m_maxTTL, m_mainAddress);
+    lsMessage.SetLSTablePackedMsg(nodeCosts);
+    TRAFFIC_LOG("Sending LSTableMessage: " << lsMessage);
+    packet->AddHeader (lsMessage);
+    BroadcastPacket (packet);
+    return;
+  }
 
   nbrCostsVec neighborAddrs;
   for (ntEntry i = m_neighborTable.begin (); i != m_neighborTable.end (); i++) {
@@ -407,6 +585,24 @@ LSRoutingProtocol::SendLSTableMessage () {
 
 }
 
+void
+LSRoutingProtocol::OriginateLSA ()
+{
+  if (m_lsaTimer.IsRunning ())
+    {
+      // The paced origination will pick up this change as well
+      m_coalescedLsaCount++;
+      return;
+    }
+  Time earliest = m_lastLsaTime + m_lsaMinInterval;
+  if (m_lsaOriginated && earliest > Simulator::Now ())
+    {
+      m_lsaTimer.Schedule (earliest - Simulator::Now ());
+      return;
+    }
+  SendLSTableMessage ();
+}
+
 
 
 void
@@ -444,16 +640,18 @@ LSRoutingProtocol::DumpRoutingTable ()
 	STATUS_LOG (std::endl << "**************** Route Table ********************" << std::endl
 			  << "DestNumber\tDestAddr\t\tNextHopNumber\t\tNextHopAddr\t\tInterfaceAddr\t\tCost");
 
-	for (rtEntry i = m_routingTable.begin (); i != m_routingTable.end (); i++)
+	for (uint32_t node = 0; node < m_routingTable.GetNodeCount (); node++)
 	{
-	    RoutingTableEntry entry = i->second;
-            std::string fromNode = ReverseLookup (entry.destAddr);
+	    if (!m_routingTable.HasRoute (node))
+	        continue;
+	    Ipv4Address destAddr = ResolveNodeIpAddress (node);
+	    uint32_t nextHopNum = m_routingTable.nextHopAddr[node].Get ();
 
-	    PRINT_LOG (fromNode << "\t\t" << entry.destAddr << "\t\t" << entry.nextHopNum << "\t\t"
-	       << entry.nextHopAddr << "\t\t" << entry.interfaceAddr << "\t\t\t" << entry.cost << std::endl);
+	    PRINT_LOG (node << "\t\t" << destAddr << "\t\t" << nextHopNum << "\t\t"
+	       << m_routingTable.nextHopAddr[node] << "\t\t" << m_routingTable.interfaceAddr[node] << "\t\t\t" << m_routingTable.cost[node] << std::endl);
 
-	    checkRouteTableEntry (fromNode, entry.destAddr, entry.nextHopNum, entry.nextHopAddr, 
-	        entry.interfaceAddr, entry.cost);
+	    checkRouteTableEntry (node, destAddr, nextHopNum, m_routingTable.nextHopAddr[node],
+	        m_routingTable.interfaceAddr[node], m_routingTable.cost[node]);
 	}
 	PRINT_LOG ("");
 
@@ -468,19 +666,33 @@ LSRoutingProtocol::DumpLSTable ()
 {
 	STATUS_LOG (std::endl << "**************** LS Table ********************" << std::endl)
 
-	for (lstEntry i = m_lsTable.begin (); i != m_lsTable.end (); i++)
+	for (uint32_t node = 0; node < m_lsTable.size (); node++)
 	{
-	    LSTableEntry entry = i->second;
-            std::cout << "\nNode " << i->first << '\n';
-            nbrCostsVec nc = entry.neighborCosts;
-            for (int i = 0; i < nc.size(); i++) {
-                std::cout << ReverseLookup(nc[i].first) << " " << nc[i].second << '\n';
+	    if (!m_lsTable[node].valid)
+	        continue;
+            std::cout << "\nNode " << node << " SequenceNumber " << m_lsTable[node].sequenceNumber
+                      << " Age " << (Simulator::Now () - m_lsTable[node].installed).GetMilliSeconds () << "ms\n";
+            const nodeCostsVec &nc = m_lsTable[node].neighborCosts;
+            for (unsigned i = 0; i < nc.size(); i++) {
+                std::cout << nc[i].first << " " << nc[i].second << '\n';
             }
 	}
 	PRINT_LOG ("");
 }
 
-
+void
+LSRoutingProtocol::DumpSpfStats ()
+{
+  STATUS_LOG (std::endl << "**************** SPF Statistics ********************" << std::endl
+              << "Mode: " << (m_incrementalSpf ? "incremental" : "full") << std::endl
+              << "Full recomputations: " << m_fullSpfCount << std::endl
+              << "Partial recomputations: " << m_partialSpfCount << std::endl
+              << "Coalesced SPF triggers: " << m_coalescedSpfCount << std::endl
+              << "Coalesced LSA originations: " << m_coalescedLsaCount << std::endl
+              << "Duplicate LSAs received: " << m_duplicateLsaCount << std::endl
+              << "LSAs purged after MaxAge: " << m_purgedLsaCount);
+  PRINT_LOG ("");
+}
 
 void
 LSRoutingProtocol::RecvLSMessage (Ptr<Socket> socket)
@@ -489,6 +701,16 @@ LSRoutingProtocol::RecvLSMessage (Ptr<Socket> socket)
   Ptr<Packet> packet = socket->RecvFrom (sourceAddr);
   InetSocketAddress inetSocketAddr = InetSocketAddress::ConvertFrom (sourceAddr);
   Ipv4Address sourceAddress = inetSocketAddr.GetIpv4 ();
+
+  // LSAs are read in place, the other messages are few
+  LSMessageView view;
+  packet->PeekHeader (view);
+  if (view.GetMessageType () == LSMessage::LS_TABLE_MSG)
+    {
+      ProcessLSTableView (view, socket);
+      return;
+    }
+
   LSMessage lsMessage;
   packet->RemoveHeader (lsMessage);
 
@@ -509,7 +731,8 @@ LSRoutingProtocol::RecvLSMessage (Ptr<Socket> socket)
       //  ProcessHelloRsp (lsMessage, socket);
       //  break;
       case LSMessage::LS_TABLE_MSG:
-        ProcessLSTableMessage(lsMessage);
+      case LSMessage::LS_TABLE_PACKED_MSG:
+        ProcessLSTableMessage(lsMessage, socket);
         //TRAFFIC_LOG( "SourceAddr: " << sourceAddress << '\n');
         break;
       default:
@@ -561,12 +784,10 @@ LSRoutingProtocol::ProcessPingRsp (LSMessage lsMessage)
 void
 LSRoutingProtocol::ProcessHelloReq (LSMessage lsMessage, Ptr<Socket> socket)
 {
-  // Use reverse lookup for ease of debug
   Ipv4Address neighAddr = lsMessage.GetOriginatorAddress();
-  std::string fromNode = ReverseLookup (lsMessage.GetOriginatorAddress());
   Ipv4Address interfaceAddr;
 
-  // TRAFFIC_LOG ("Received HELLO_REQ, From Node: " << fromNode << " with TTL " << (unsigned)lsMessage.GetTTL());
+  // TRAFFIC_LOG ("Received HELLO_REQ, From Node: " << ReverseLookup (neighAddr) << " with TTL " << (unsigned)lsMessage.GetTTL());
 
   std::map<Ptr<Socket> , Ipv4InterfaceAddress>::const_iterator i = m_socketAddresses.find(socket);
   if (i != m_socketAddresses.end())
@@ -580,7 +801,15 @@ LSRoutingProtocol::ProcessHelloReq (LSMessage lsMessage, Ptr<Socket> socket)
  
    //TRAFFIC_LOG( "Received HelloReq, From Neighbor: " << fromNode << ", with Addr: " << neighAddr << ", InterfaceAddr: " << interfaceAddr << '\n');
 
-  ntEntry e = m_neighborTable.find( fromNode );
+  uint32_t neighNode = LookupNodeNumber (neighAddr);
+  uint32_t thisNode = LookupNodeNumber (m_mainAddress);
+  if (neighNode == NODE_UNKNOWN || thisNode == NODE_UNKNOWN)
+    {
+      ERROR_LOG ("HELLO_REQ from outside the topology: " << neighAddr);
+      return;
+    }
+
+  ntEntry e = m_neighborTable.find( neighNode );
 
   if ( e != m_neighborTable.end() ) {//neighbor was already in our table
     e->second.lastUpdated = Simulator::Now();
@@ -589,30 +818,24 @@ LSRoutingProtocol::ProcessHelloReq (LSMessage lsMessage, Ptr<Socket> socket)
 
     //add it to our immediate neighbors table
     NeighborTableEntry entry = { neighAddr, interfaceAddr , Simulator::Now() };
-    m_neighborTable.insert(std::make_pair(fromNode, entry));
+    m_neighborTable.insert(std::make_pair(neighNode, entry));
 
     //also add it to the lsTable (with neighbor information for all nodes in network)
-    //see if this node is already in that table
-    lstEntry lste = m_lsTable.find( ReverseLookup(m_mainAddress) );
-    if ( lste != m_lsTable.end() ) {//if this node is already in there
-      //then just add this neighbor to the neighbors vector
-      lste->second.neighborCosts.push_back(std::make_pair(neighAddr, (uint32_t) 1));//TODO: change cost here
-
-    } else {
-      nbrCostsVec nbrCosts;
-      nbrCosts.push_back(std::make_pair(neighAddr, 1));  //TODO: change cost here
-      LSTableEntry lstEntry = { nbrCosts, lsMessage.GetSequenceNumber() };
-      m_lsTable.insert(std::make_pair(ReverseLookup(m_mainAddress), lstEntry));
-
+    LSTableEntry &lste = m_lsTable[thisNode];
+    if ( !lste.valid ) {//first neighbor of this node
+      lste.valid = true;
+      lste.installed = Simulator::Now();
+      lste.sequenceNumber = lsMessage.GetSequenceNumber();
     }
+    lste.neighborCosts.push_back(std::make_pair(neighNode, (uint32_t) 1));//TODO: change cost here
 
 
     //run Dijkstra to update costs
-    Dijkstra();
+    ScheduleSpf(thisNode, nodeCostsVec());
 
     //DumpRoutingTable();
 
-    SendLSTableMessage(); // neighbor table has changed, so resend neighbor info
+    OriginateLSA(); // neighbor table has changed, so resend neighbor info
   }
 
   // Send Hello Response
@@ -664,45 +887,168 @@ LSRoutingProtocol::ProcessHelloRsp (LSMessage lsMessage, Ptr<Socket> socket)
 }
 */
 
-void
-LSRoutingProtocol::ProcessLSTableMessage (LSMessage lsMessage) {
-    nbrCostsVec neighborAddrs = lsMessage.GetLSTableMsg().neighborCosts;
-    uint32_t seqNum = lsMessage.GetSequenceNumber();
-
-    // TRAFFIC_LOG("Received LSTableMessage. " << lsMessage);
+uint32_t
+LSRoutingProtocol::AcceptLSA (Ipv4Address fromAddr, uint32_t seqNum) {
+    // Our own LSA flooded back to us, our entry is kept up to date locally
+    if (IsOwnAddress(fromAddr))
+      return NODE_UNKNOWN;
+
+    uint32_t fromNode = LookupNodeNumber(fromAddr);
+    if (fromNode == NODE_UNKNOWN) {
+      ERROR_LOG ("LS_TABLE_MSG from outside the topology: " << fromAddr);
+      return NODE_UNKNOWN;
+    }
 
-    // if we have not seen the packet before, broadcast it
-    Ipv4Address fromAddr = lsMessage.GetOriginatorAddress();
-    std::string fromNode = ReverseLookup(fromAddr);
+    // Duplicate or older copy of what the LS database holds, drop it.
+    // Sequence numbers start at random and wrap, compare them as serial numbers
+    LSTableEntry &entry = m_lsTable[fromNode];
+    if (entry.valid && (int32_t) (seqNum - entry.sequenceNumber) <= 0) {
+      m_duplicateLsaCount++;
+      return NODE_UNKNOWN;
+    }
+    return fromNode;
+}
 
-    lstEntry entry = m_lsTable.find(fromNode);
+void
+LSRoutingProtocol::InstallLSA (uint32_t fromNode, uint32_t seqNum, bool changed, nodeCostsVec &neighborCosts) {
+    LSTableEntry &entry = m_lsTable[fromNode];
+    entry.sequenceNumber = seqNum;
+    entry.installed = Simulator::Now();
+    entry.valid = true;
+    if (changed) {
+      //keep the old adjacency around for the incremental SPF
+      nodeCostsVec oldNeighborCosts;
+      oldNeighborCosts.swap(entry.neighborCosts);
+      entry.neighborCosts.swap(neighborCosts);
+      ScheduleSpf(fromNode, oldNeighborCosts);
+    }
+}
 
-//    TRAFFIC_LOG("Sequence Number of this entry: " << entry->second.sequenceNumber << " SeqNum of new packet: " << seqNum);
-    if (entry == m_lsTable.end() || seqNum > entry->second.sequenceNumber) {
- //     std::cout << "Sequence Number is new.\n";
+void
+LSRoutingProtocol::ProcessLSTableMessage (LSMessage lsMessage, Ptr<Socket> socket) {
+    uint32_t seqNum = lsMessage.GetSequenceNumber();
 
-      //if it was already in the table, delete it first
-      if (entry != m_lsTable.end())
-        m_lsTable.erase(entry);
+    // TRAFFIC_LOG("Received LSTableMessage. " << lsMessage);
 
-      // Add to LSTable
-      nbrCostsVec neighborCosts;
-      for (int i = 0; i < neighborAddrs.size(); i++) {
-        neighborCosts.push_back(std::make_pair(neighborAddrs[i].first, neighborAddrs[i].second));
+    uint32_t fromNode = AcceptLSA(lsMessage.GetOriginatorAddress(), seqNum);
+    if (fromNode == NODE_UNKNOWN)
+      return;
+
+    // Addresses are only translated once here
+    nodeCostsVec neighborCosts;
+    if (lsMessage.GetMessageType() == LSMessage::LS_TABLE_PACKED_MSG) {
+      nodeCostsVec nodeCosts = lsMessage.GetLSTablePackedMsg().nodeCosts;
+      for (unsigned i = 0; i < nodeCosts.size(); i++) {
+        if (nodeCosts[i].first < m_lsTable.size()) {
+          neighborCosts.push_back(nodeCosts[i]);
+        }
+      }
+    } else {
+      nbrCostsVec neighborAddrs = lsMessage.GetLSTableMsg().neighborCosts;
+      for (unsigned i = 0; i < neighborAddrs.size(); i++) {
+        uint32_t nbr = LookupNodeNumber(neighborAddrs[i].first);
+        if (nbr != NODE_UNKNOWN) {
+          neighborCosts.push_back(std::make_pair(nbr, neighborAddrs[i].second));
+        }
       }
-      LSTableEntry newEntry = { neighborCosts, seqNum };
-      m_lsTable.insert(std::pair<std::string, LSTableEntry>(fromNode, newEntry));
+    }
 
-      //DumpLSTable();
-      // Run Dijkstra
-      Dijkstra();
-      //DumpLSTable();
+    // A refresh with the same adjacency only resets the age
+    const LSTableEntry &entry = m_lsTable[fromNode];
+    bool changed = !entry.valid || neighborCosts != entry.neighborCosts;
+    InstallLSA(fromNode, seqNum, changed, neighborCosts);
 
-      // Send Packet
+    // Flood on, except back where it came from
+    if (lsMessage.GetTTL() > 1) {
       Ptr<Packet> p = Create<Packet> ();
       lsMessage.SetTTL( lsMessage.GetTTL() - 1 ); // we need to decrement TTL ourselves
       p->AddHeader (lsMessage);
-      BroadcastPacket (p);
+      FloodPacket (p, socket);
+    }
+}
+
+void
+LSRoutingProtocol::ProcessLSTableView (const LSMessageView &view, Ptr<Socket> socket) {
+    uint32_t seqNum = view.GetSequenceNumber();
+    uint32_t fromNode = AcceptLSA(view.GetOriginatorAddress(), seqNum);
+    if (fromNode == NODE_UNKNOWN)
+      return;
+
+    // A refresh with the same adjacency only resets the age, so compare
+    // the translated neighbors with the LS database before copying them
+    const LSTableEntry &entry = m_lsTable[fromNode];
+    bool changed = !entry.valid;
+    uint32_t known = 0;
+    for (uint32_t i = 0; i < view.GetNNeighbors() && !changed; i++) {
+      uint32_t nbr = LookupNodeNumber(view.GetNeighborAddress(i));
+      if (nbr == NODE_UNKNOWN)
+        continue;
+      changed = known >= entry.neighborCosts.size()
+        || entry.neighborCosts[known] != std::make_pair(nbr, view.GetNeighborCost(i));
+      known++;
+    }
+    changed = changed || known != entry.neighborCosts.size();
+
+    nodeCostsVec neighborCosts;
+    if (changed) {
+      neighborCosts.reserve(view.GetNNeighbors());
+      for (uint32_t i = 0; i < view.GetNNeighbors(); i++) {
+        uint32_t nbr = LookupNodeNumber(view.GetNeighborAddress(i));
+        if (nbr != NODE_UNKNOWN) {
+          neighborCosts.push_back(std::make_pair(nbr, view.GetNeighborCost(i)));
+        }
+      }
+    }
+    InstallLSA(fromNode, seqNum, changed, neighborCosts);
+
+    // Flood on, except back where it came from, the neighbors are copied
+    // over from the packet we received
+    if (view.GetTTL() > 1) {
+      LSMessageView forward = view;
+      forward.SetTTL(view.GetTTL() - 1); // we need to decrement TTL ourselves
+      Ptr<Packet> p = Create<Packet> ();
+      p->AddHeader (forward);
+      FloodPacket (p, socket);
+    }
+}
+
+void
+LSRoutingProtocol::RefreshLSA ()
+{
+  Time sinceLast = Simulator::Now () - m_lastLsaTime;
+  if (!m_lsaOriginated || sinceLast >= m_lsaRefreshInterval)
+    {
+      OriginateLSA ();
+      m_lsaRefreshTimer.Schedule (m_lsaRefreshInterval);
+    }
+  else
+    {
+      // Recently sent for another reason, refresh a full interval after that
+      m_lsaRefreshTimer.Schedule (m_lsaRefreshInterval - sinceLast);
+    }
+}
+
+void
+LSRoutingProtocol::AgeLSTable ()
+{
+  if (m_lsaMaxAge.IsZero ())
+    return;
+
+  uint32_t thisNode = LookupNodeNumber (m_mainAddress);
+  for (uint32_t node = 0; node < m_lsTable.size (); node++)
+    {
+      LSTableEntry &entry = m_lsTable[node];
+      if (!entry.valid || node == thisNode)
+        continue;
+      if (Simulator::Now () - entry.installed < m_lsaMaxAge)
+        continue;
+
+      DEBUG_LOG ("Purging LSA of node " << node << " SequenceNumber: " << entry.sequenceNumber);
+      nodeCostsVec oldNeighborCosts;
+      oldNeighborCosts.swap (entry.neighborCosts);
+      entry.valid = false;
+      m_purgedLsaCount++;
+      ScheduleSpf (node, oldNeighborCosts);
     }
 }
 
@@ -752,6 +1098,7 @@ LSRoutingProtocol::AuditHellos()
   //Broadcast a fresh HELLO message to immediate neighbors
   SendHello ();
   bool sendMsg = false;
+  uint32_t thisNode = LookupNodeNumber(m_mainAddress);
 
   // If "last updated" is more than helloTimeout seconds ago, remove it from the NeighborTable
   for (ntEntry i = m_neighborTable.begin (); i != m_neighborTable.end ();) {
@@ -763,14 +1110,10 @@ LSRoutingProtocol::AuditHellos()
         // DumpLSTable();
 
         //remove missing neighbor from my my own entry in LSTable:
-        //1) get my entry
-        lstEntry entry1 = m_lsTable.find( ReverseLookup(m_mainAddress) );
-        //2) remove neighbor form the neighborCosts vector in my entry
-        removeLSTableLink( entry.neighborAddr, entry1->second.neighborCosts );
+        removeLSTableLink( i->first, m_lsTable[thisNode].neighborCosts );
 
         //now, remove myself from the neighbor's entry in LSTable:
-        lstEntry entry2 = m_lsTable.find( ReverseLookup(entry.neighborAddr) );
-        removeLSTableLink( m_mainAddress, entry2->second.neighborCosts );
+        removeLSTableLink( thisNode, m_lsTable[i->first].neighborCosts );
 
         //remove the neighbor from my Neighbors table
         m_neighborTable.erase(i++);
@@ -784,17 +1127,19 @@ LSRoutingProtocol::AuditHellos()
   }
 
   if (sendMsg) {
-      Dijkstra();
-      SendLSTableMessage(); // neighbor table info has changed, so resend neighbor info
+      ScheduleSpf(thisNode, nodeCostsVec());
+      OriginateLSA(); // neighbor table info has changed, so resend neighbor info
   }
 
+  AgeLSTable();
+
   // Reschedule timer
   m_auditHellosTimer.Schedule (m_helloTimeout);
 
 }
 
 void
-LSRoutingProtocol::removeLSTableLink(Ipv4Address nodeToRemove, nbrCostsVec& vectorToChange) {
+LSRoutingProtocol::removeLSTableLink(uint32_t nodeToRemove, nodeCostsVec& vectorToChange) {
   for (unsigned i = 0; i < vectorToChange.size(); i++) {
       if (vectorToChange[i].first == nodeToRemove) {
           vectorToChange.erase(vectorToChange.begin() + i);
@@ -804,209 +1149,351 @@ LSRoutingProtocol::removeLSTableLink(Ipv4Address nodeToRemove, nbrCostsVec& vect
 }
 
 void
-LSRoutingProtocol::removeLSTableLink_old(Ipv4Address node1, Ipv4Address node2) {
-    lstEntry entry1 = m_lsTable.find( ReverseLookup(node1) );
-    lstEntry entry2 = m_lsTable.find( ReverseLookup(node2) );
-
-    if (entry1 != m_lsTable.end()) {
-        nbrCostsVec pairs1 = entry1->second.neighborCosts;
-        for (unsigned i = 0; i < pairs1.size(); i++) {
-            if (pairs1[i].first == node2) {
-                pairs1.erase(pairs1.begin() + i);
-                break;
-            }
-        }
-    }
-
-    if (entry2 != m_lsTable.end()) {
-        nbrCostsVec pairs2 = entry2->second.neighborCosts;
-        for (unsigned i = 0; i < pairs2.size(); i++) {
-            if (pairs2[i].first == node1) {
-                pairs2.erase(pairs2.begin() + i);
-                break;
+LSRoutingProtocol::BuildSpfGraph (uint32_t thisNode)
+{
+  m_spfGraph.Clear ();
+  for (uint32_t node = 0; node < m_lsTable.size (); node++)
+    {
+      const nodeCostsVec &neighbors = m_lsTable[node].neighborCosts;
+      for (unsigned j = 0; j < neighbors.size (); j++)
+        {
+          if (node == thisNode && m_neighborTable.find (neighbors[j].first) == m_neighborTable.end ())
+            {
+              continue;
             }
+          m_spfGraph.AddLink (neighbors[j].first, neighbors[j].second);
         }
+      m_spfGraph.EndNode ();
     }
-
 }
 
 void
-LSRoutingProtocol::GetNeighbors(const std::string node, std::vector<Ipv4Address>& neighAddrs) {
-    neighAddrs.clear();
-    lstEntry entry = m_lsTable.find(node);
-    // check if does not exist, return NULL
-    if (entry == m_lsTable.end()) {
-        return;
+LSRoutingProtocol::Dijkstra() {
+  m_fullSpfCount++;
+
+  //we modify the routing table directly
+  //wipe it clean first
+  m_routingTable.Clear();
+  std::fill(m_sptParent.begin(), m_sptParent.end(), NODE_UNKNOWN);
+
+  uint32_t thisNode = LookupNodeNumber(m_mainAddress);
+  if (thisNode == NODE_UNKNOWN) {
+    return;
+  }
+
+  BuildSpfGraph (thisNode);
+  switch (m_spfFrontierType)
+    {
+      case SPF_LINEAR_SCAN:
+        ShortestPaths (m_spfGraph, thisNode, m_linearScan, m_spfCost, m_sptParent, m_spfFirstHop);
+        break;
+      case SPF_RADIX_HEAP:
+        ShortestPaths (m_spfGraph, thisNode, m_radixHeap, m_spfCost, m_sptParent, m_spfFirstHop);
+        break;
+      case SPF_DIAL_BUCKETS:
+        if (DialBuckets::IsUsable (m_spfGraph.GetMaxCost ()))
+          {
+            ShortestPaths (m_spfGraph, thisNode, m_dialBuckets, m_spfCost, m_sptParent, m_spfFirstHop);
+            break;
+          }
+        // Link costs too large for the buckets
+      case SPF_BINARY_HEAP:
+      default:
+        ShortestPaths (m_spfGraph, thisNode, m_binaryHeap, m_spfCost, m_sptParent, m_spfFirstHop);
+        break;
     }
 
-    nbrCostsVec pairs = entry->second.neighborCosts;
-        
-    for (unsigned i = 0; i < pairs.size(); i++) {
-        neighAddrs.push_back(pairs[i].first);
+  //the root routes to itself, everything else through the neighbor its path starts at
+  m_routingTable.SetRoute(thisNode, 0, thisNode, m_mainAddress, m_mainAddress);
+  for (uint32_t node = 0; node < m_spfCost.size(); node++) {
+    if (node == thisNode || m_spfCost[node] == ROUTE_UNREACHABLE) {
+      continue;
     }
-    
+    const NeighborTableEntry &neighbor = m_neighborTable[m_spfFirstHop[node]];
+    m_routingTable.SetRoute(node, m_spfCost[node], m_spfFirstHop[node],
+                            neighbor.neighborAddr, neighbor.interfaceAddr);
+  }
 }
 
-uint32_t
-LSRoutingProtocol::DistanceToNeighbor(const std::string node1, const std::string node2) {
-    if (node1 == node2) {
-        return 0;
+void
+LSRoutingProtocol::ScheduleSpf (uint32_t changedNode, const nodeCostsVec &oldNeighborCosts)
+{
+  if (m_spfInitialDelay.IsZero () && m_spfHoldTime.IsZero ())
+    {
+      UpdateRoutes (changedNode, oldNeighborCosts);
+      return;
     }
 
-    lstEntry entry = m_lsTable.find(node1);
-
-    nbrCostsVec pairs = entry->second.neighborCosts;
-    for (unsigned i = 0; i < pairs.size(); i++) {
-        if (ReverseLookup(pairs[i].first) == node2) {
-            return pairs[i].second;
+  if (m_spfTimer.IsRunning ())
+    {
+      // Changes to more than one LSA cannot be repaired incrementally
+      m_coalescedSpfCount++;
+      if (changedNode != m_pendingSpfNode)
+        {
+          m_pendingSpfNode = LookupNodeNumber (m_mainAddress);
+          m_pendingOldCosts.clear ();
         }
+      return;
     }
+  m_pendingSpfNode = changedNode;
+  m_pendingOldCosts = oldNeighborCosts;
 
-    return std::numeric_limits<int>::max();
-}
-
-std::string
-LSRoutingProtocol::GetMinCostNode( const std::map<std::string, bool>& leastCostFound ) {
-    uint32_t min = std::numeric_limits<int>::max();
-    uint32_t cost;
-    std::string closest;
-
-    for (rtEntry i = m_routingTable.begin(); i != m_routingTable.end(); i++) {
-        std::string node = i->first;
-//std::cout << "LOOP node: " << node << '\n';
-
-        if ( leastCostFound.find(node)->second == false ) {
-            cost = i->second.cost;
-//std::cout << "LOOP cost: " << cost << '\n';
-            if (cost < min) {
-                min = cost;
-                closest = node;
-            }
-        }
+  Time now = Simulator::Now ();
+  Time delay = m_spfInitialDelay;
+  if (m_fullSpfCount + m_partialSpfCount == 0 || now - m_lastSpfTime >= m_spfCurrentHold)
+    {
+      // Quiet for a whole hold time, start over with the short delay
+      m_spfCurrentHold = m_spfHoldTime;
+    }
+  else
+    {
+      delay = Max (m_lastSpfTime + m_spfCurrentHold - now, m_spfInitialDelay);
+      m_spfCurrentHold = Min (m_spfCurrentHold + m_spfCurrentHold, m_spfMaxHoldTime);
     }
-    //leastCostFound.find(closest)->second = true;
+  m_spfTimer.Schedule (delay);
+}
 
-    //std::cout << "CLOSEST: " << closest << '\n';
-    return closest;
+void
+LSRoutingProtocol::RunScheduledSpf ()
+{
+  nodeCostsVec oldNeighborCosts;
+  oldNeighborCosts.swap (m_pendingOldCosts);
+  UpdateRoutes (m_pendingSpfNode, oldNeighborCosts);
+  m_pendingSpfNode = NODE_UNKNOWN;
 }
 
 void
-LSRoutingProtocol::Dijkstra() {
-  //we modify the routing table directly
-  //wipe it clean first
-  m_routingTable.clear();
+LSRoutingProtocol::UpdateRoutes (uint32_t changedNode, const nodeCostsVec &oldNeighborCosts)
+{
+  m_lastSpfTime = Simulator::Now ();
+  m_forwardingTableDirty = true;
+  if (m_incrementalSpf)
+    {
+      IncrementalDijkstra (changedNode, oldNeighborCosts);
+    }
+  else
+    {
+      Dijkstra ();
+    }
+}
 
-  //create a map from each node to a bool: if true, means already found least cost to that node
-  std::map<std::string, bool> leastCostFound;
+void
+LSRoutingProtocol::IncrementalDijkstra (uint32_t changedNode, const nodeCostsVec &oldNeighborCosts)
+{
+  uint32_t thisNode = LookupNodeNumber (m_mainAddress);
 
-  //for each node in our m_lsTable keys, add it to leastCostFound
-  //TRAFFIC_LOG("DIJKSTRA: Iterating through LSTABLE");
-  for(lstEntry it = m_lsTable.begin(); it != m_lsTable.end(); it++) {
-    //std::cout << it->first << '\n';
-    leastCostFound.insert(std::make_pair(it->first, false));
-  }
+  // Our own links decide next hops for everybody, and without a tree there is nothing to repair
+  if (changedNode == thisNode || !m_routingTable.HasRoute (thisNode))
+    {
+      Dijkstra ();
+      return;
+    }
+  m_partialSpfCount++;
 
-  //INITIALIZATION
-  //name for this node
-  std::string thisNode = ReverseLookup(m_mainAddress);
-  //get neighbor for this node
-  std::vector<Ipv4Address> neighbors;
-  GetNeighbors(thisNode, neighbors);
-
-  //PRINT OUT
-  //std::cout << "My own neighbors: ";
-  //for (int i = 0; i < neighbors.size(); i++) {
-  //  std::cout << neighbors[i] << ", ";
- // }
-  //std::cout << "\b\b\n";
-
-  //insert this node into the routing table
-  RoutingTableEntry entry = { m_mainAddress, m_mainAddress.Get(), m_mainAddress,
-    m_mainAddress, 0}; 
-  m_routingTable.insert(std::make_pair(thisNode, entry));
-
-  for (int i = 0; i < neighbors.size(); i++) {
-    Ipv4Address nbr = neighbors[i];
-    RoutingTableEntry entry = { nbr, nbr.Get(), nbr,
-      m_neighborTable.find(ReverseLookup(nbr))->second.interfaceAddr,
-      DistanceToNeighbor(thisNode, ReverseLookup(nbr))};
-    //add the new entry to our routing table
-    m_routingTable.insert(std::make_pair(ReverseLookup(nbr), entry));
-  }
+  // Links of a node we cannot reach do not shorten or lengthen any path
+  if (!m_routingTable.HasRoute (changedNode))
+    {
+      return;
+    }
 
-  //set this node to true in leastCostFound
-  leastCostFound.find(thisNode)->second = true;
+  const nodeCostsVec &newNeighborCosts = m_lsTable[changedNode].neighborCosts;
+  uint32_t nodeCount = m_routingTable.GetNodeCount ();
 
-  //MAIN LOOP! woohooooooo
-  for (unsigned i = 0; i < m_lsTable.size()-1; i++) {
-    //pick node with least cost so far
-    std::string current = GetMinCostNode(leastCostFound);
-    leastCostFound.find(current)->second = true;
+  // 1) Every tree link of changedNode that vanished or got more expensive takes its subtree down
+  std::vector<bool> invalid (nodeCount, false);
+  std::vector<uint32_t> detached;
+  std::vector<std::vector<uint32_t> > children;
+  for (unsigned i = 0; i < oldNeighborCosts.size (); i++)
+    {
+      uint32_t nbr = oldNeighborCosts[i].first;
+      if (m_sptParent[nbr] != changedNode)
+        {
+          continue;
+        }
+      bool worse = true;
+      for (unsigned j = 0; j < newNeighborCosts.size (); j++)
+        {
+          if (newNeighborCosts[j].first == nbr)
+            {
+              worse = newNeighborCosts[j].second > oldNeighborCosts[i].second;
+              break;
+            }
+        }
+      if (!worse)
+        {
+          continue;
+        }
+      if (children.empty ())
+        {
+          children.resize (nodeCount);
+          for (uint32_t node = 0; node < nodeCount; node++)
+            {
+              uint32_t parent = m_sptParent[node];
+              if (parent != NODE_UNKNOWN && parent != node)
+                {
+                  children[parent].push_back (node);
+                }
+            }
+        }
+      std::vector<uint32_t> pending (1, nbr);
+      while (!pending.empty ())
+        {
+          uint32_t node = pending.back ();
+          pending.pop_back ();
+          if (!invalid[node])
+            {
+              invalid[node] = true;
+              detached.push_back (node);
+              pending.insert (pending.end (), children[node].begin (), children[node].end ());
+            }
+        }
+    }
 
-    //get its neighbors
-    GetNeighbors(current, neighbors);
+  for (unsigned i = 0; i < detached.size (); i++)
+    {
+      m_routingTable.RemoveRoute (detached[i]);
+      m_sptParent[detached[i]] = NODE_UNKNOWN;
+    }
 
-    //TRAFFIC_LOG("DIJKSTRA: Current node: " << current << " with neighbors:");
-    
+  // 2) Offer every detached node its cheapest link from a node that kept its route
+  spfFrontier frontier;
+  if (!detached.empty ())
+    {
+      for (uint32_t from = 0; from < nodeCount; from++)
+        {
+          if (!m_routingTable.HasRoute (from))
+            {
+              continue;
+            }
+          const nodeCostsVec &links = m_lsTable[from].neighborCosts;
+          for (unsigned i = 0; i < links.size (); i++)
+            {
+              if (invalid[links[i].first] && RelaxSpfLink (from, links[i].first, links[i].second))
+                {
+                  frontier.push (std::make_pair (m_routingTable.cost[links[i].first], links[i].first));
+                }
+            }
+        }
+    }
 
-    for (unsigned j = 0; j < neighbors.size(); j++) {
-      std::string nbrName = ReverseLookup(neighbors[j]);
+  // 3) New or cheaper links can only shorten paths that go through changedNode
+  for (unsigned i = 0; i < newNeighborCosts.size (); i++)
+    {
+      if (RelaxSpfLink (changedNode, newNeighborCosts[i].first, newNeighborCosts[i].second))
+        {
+          frontier.push (std::make_pair (m_routingTable.cost[newNeighborCosts[i].first], newNeighborCosts[i].first));
+        }
+    }
 
-      //std::cout << nbrName << " ";
+  // 4) Settle the frontier; stale heap entries are skipped instead of decreased in place
+  while (!frontier.empty ())
+    {
+      spfCandidate top = frontier.top ();
+      frontier.pop ();
+      if (m_routingTable.cost[top.second] != top.first)
+        {
+          continue;
+        }
+      const nodeCostsVec &links = m_lsTable[top.second].neighborCosts;
+      for (unsigned i = 0; i < links.size (); i++)
+        {
+          if (RelaxSpfLink (top.second, links[i].first, links[i].second))
+            {
+              frontier.push (std::make_pair (m_routingTable.cost[links[i].first], links[i].first));
+            }
+        }
+    }
+}
 
-      uint32_t old_cost;
+bool
+LSRoutingProtocol::RelaxSpfLink (uint32_t from, uint32_t to, uint32_t linkCost)
+{
+  uint32_t newCost = m_routingTable.cost[from] + linkCost;
+  if (newCost >= m_routingTable.cost[to])
+    {
+      return false;
+    }
 
-      if (m_routingTable.find(nbrName) != m_routingTable.end()) {
+  // Direct neighbors are their own next hop, everybody else inherits it from the parent
+  uint32_t nextHop = (m_sptParent[from] == from) ? to : m_routingTable.nextHop[from];
+  ntEntry neighbor = m_neighborTable.find (nextHop);
+  if (neighbor == m_neighborTable.end ())
+    {
+      return false;
+    }
 
-        old_cost = m_routingTable.find(nbrName)->second.cost;
+  m_routingTable.SetRoute (to, newCost, nextHop, neighbor->second.neighborAddr, neighbor->second.interfaceAddr);
+  m_sptParent[to] = from;
+  return true;
+}
 
-      } else {
-        old_cost = std::numeric_limits<int>::max();
-      }
+uint32_t
+LSRoutingProtocol::GetFullSpfCount () const
+{
+  return m_fullSpfCount;
+}
 
-      uint32_t new_cost = m_routingTable.find(current)->second.cost + 
-        DistanceToNeighbor(current, nbrName);
+uint32_t
+LSRoutingProtocol::GetPartialSpfCount () const
+{
+  return m_partialSpfCount;
+}
 
-      //std::cout << "old_cost: " << old_cost << " new_cost: " << new_cost << '\n';
+uint32_t
+LSRoutingProtocol::GetCoalescedSpfCount () const
+{
+  return m_coalescedSpfCount;
+}
 
-      if (new_cost < old_cost) {
-        Ipv4Address nextHopAddr = m_routingTable.find(current)->second.nextHopAddr;
+uint32_t
+LSRoutingProtocol::GetCoalescedLsaCount () const
+{
+  return m_coalescedLsaCount;
+}
 
-        rtEntry e = m_routingTable.find(nbrName);
-        if (e != m_routingTable.end()) {
-        //    std::cout << "Updating cost\n";
-            e->second.nextHopAddr = nextHopAddr;
-            e->second.nextHopNum = nextHopAddr.Get();
-            e->second.interfaceAddr = m_neighborTable.find(ReverseLookup(nextHopAddr))->second.interfaceAddr;
-            e->second.cost = new_cost;
-        } else {
-         //   std::cout << "new rt entry\n";
-            RoutingTableEntry rte = { neighbors[j], nextHopAddr.Get(), nextHopAddr,
-               m_neighborTable.find(ReverseLookup(nextHopAddr))->second.interfaceAddr, new_cost};
-               //add the new entry to our routing table
-            m_routingTable.insert(std::make_pair(ReverseLookup(neighbors[j]), rte));
-        }
+uint32_t
+LSRoutingProtocol::GetDuplicateLsaCount () const
+{
+  return m_duplicateLsaCount;
+}
 
-      }
+uint32_t
+LSRoutingProtocol::GetPurgedLsaCount () const
+{
+  return m_purgedLsaCount;
+}
 
+Ptr<Ipv4Route>
+LSRoutingProtocol::SearchTable (Ipv4Address dest)
+{
+    if (m_forwardingTableDirty) {
+        BuildForwardingTable();
     }
-
-  }
-  //DumpRoutingTable();
-
+    return m_forwardingTable.Lookup(dest);
 }
 
-bool
-LSRoutingProtocol::SearchTable (RoutingTableEntry& out_entry, Ipv4Address dest)
+void
+LSRoutingProtocol::BuildForwardingTable ()
 {
-    // Get the iterator at "dest" position
-    std::string node = ReverseLookup(dest);
-    std::map<std::string, RoutingTableEntry>::iterator it = m_routingTable.find(node);
-    if (it == m_routingTable.end()) {
-         return false;
-    }
-    out_entry = it->second;
-    return true;
+  // Every interface address of a node shares the route to its main address
+  m_forwardingTable.Reset (m_addressDirectory->GetNAddresses ());
+  for (uint32_t i = 0; i < m_addressDirectory->GetNAddresses (); i++)
+    {
+      uint32_t node = m_addressDirectory->GetAddressNode (i);
+      if (!m_routingTable.HasRoute (node))
+        {
+          continue;
+        }
+      Ipv4Address destination = m_addressDirectory->GetAddress (i);
+      Ptr<Ipv4Route> ipv4Route = Create<Ipv4Route> ();
+      ipv4Route->SetDestination (destination);
+      ipv4Route->SetSource (m_mainAddress);
+      ipv4Route->SetGateway (m_routingTable.nextHopAddr[node]);
+      int32_t interface = m_ipv4->GetInterfaceForAddress (m_routingTable.interfaceAddr[node]);
+      ipv4Route->SetOutputDevice (m_ipv4->GetNetDevice (interface));
+      m_forwardingTable.Insert (destination, ipv4Route);
+    }
+  m_forwardingTableDirty = false;
 }
 
 uint32_t
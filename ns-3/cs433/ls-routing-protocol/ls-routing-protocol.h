@@ -31,15 +31,31 @@
 #include "ns3/ls-table-msg.h"
 #include "ns3/comm-routing-protocol.h"
 #include "ns3/ls-message.h"
+#include "ns3/header-template.h"
+#include "ns3/node-route-table.h"
+#include "ns3/forwarding-table.h"
+#include "ns3/shortest-path.h"
 
 #include <vector>
 #include <map>
+#include <queue>
 
 using namespace ns3;
 
 class LSRoutingProtocol : public CommRoutingProtocol
 {
   public:
+    /**
+     * \brief Priority queue a full SPF run settles nodes from, see shortest-path.h.
+     */
+    enum SpfFrontierType
+    {
+      SPF_LINEAR_SCAN,
+      SPF_BINARY_HEAP,
+      SPF_RADIX_HEAP,
+      SPF_DIAL_BUCKETS
+    };
+
     static TypeId GetTypeId (void);
 
     LSRoutingProtocol ();
@@ -79,6 +95,44 @@ class LSRoutingProtocol : public CommRoutingProtocol
      */
 
     virtual void SetAddressNodeMap (std::map<Ipv4Address, uint32_t> addressNodeMap);
+    /**
+     * \brief Use the node number/address directory shared by all nodes.
+     *
+     * This method is called by the simulator-main when this node is created.
+     * SetNodeAddressMap and SetAddressNodeMap build a private directory instead.
+     *
+     * \param addressDirectory Directory.
+     */
+    virtual void SetAddressDirectory (Ptr<AddressDirectory> addressDirectory);
+
+    /**
+     * \brief Point-to-point link of the topology given to simulator-main.
+     */
+    struct TopologyLink
+      {
+        uint32_t nodeA;
+        Ipv4Address addressA;
+        uint32_t nodeB;
+        Ipv4Address addressB;
+      };
+
+    /**
+     * \brief Fill the neighbor and LS tables as if the protocol had converged on the topology.
+     *
+     * Used by the batch SPF mode at startup, before the simulation runs. A
+     * hello goes out at start so the primed neighbors are kept alive.
+     *
+     * \param links Every link of the topology, all with unit cost.
+     */
+    void PrimeConvergedState (const std::vector<TopologyLink> &links);
+
+    /**
+     * \brief Compute the routing table from the primed LS table.
+     *
+     * Touches only this protocol's tables and the read-only address directory,
+     * so different protocols can run it on different threads at once.
+     */
+    void ComputeConvergedRoutes ();
 
     // Message Handling
     /**
@@ -92,12 +146,69 @@ class LSRoutingProtocol : public CommRoutingProtocol
     void ProcessPingRsp (LSMessage lsMessage);
     void ProcessHelloReq (LSMessage lsMessage, Ptr<Socket> socket);
     void ProcessHelloRsp (LSMessage lsMessage, Ptr<Socket> socket);
-    void ProcessLSTableMessage (LSMessage lsMessage);
+    /**
+     * \brief Install a newer LSA into the LS database and flood it on.
+     *
+     * Duplicates and older copies are dropped, our own LSAs are ignored.
+     *
+     * \param socket Socket the LSA arrived on, it is not flooded back there.
+     */
+    void ProcessLSTableMessage (LSMessage lsMessage, Ptr<Socket> socket);
+    /**
+     * \brief ProcessLSTableMessage for an LS_TABLE_MSG, read in place.
+     *
+     * The neighbors are compared with the LS database straight from the
+     * packet, and only copied out when they changed.
+     */
+    void ProcessLSTableView (const LSMessageView &view, Ptr<Socket> socket);
 
+    /**
+     * \brief Rebuild the whole routing table from a CSR snapshot of the LS database.
+     *
+     * The SpfFrontier attribute picks the priority queue. Dial buckets fall
+     * back to the binary heap when a link cost is too large for them.
+     */
     void Dijkstra();
 
+    /**
+     * \returns Number of full shortest path recomputations run so far.
+     */
+    uint32_t GetFullSpfCount () const;
+    /**
+     * \returns Number of incremental shortest path updates run so far.
+     */
+    uint32_t GetPartialSpfCount () const;
+    /**
+     * \returns Number of SPF triggers folded into an already scheduled run.
+     */
+    uint32_t GetCoalescedSpfCount () const;
+    /**
+     * \returns Number of LSA originations folded into an already paced one.
+     */
+    uint32_t GetCoalescedLsaCount () const;
+    /**
+     * \returns Number of LSAs received that were already in the LS database.
+     */
+    uint32_t GetDuplicateLsaCount () const;
+    /**
+     * \returns Number of LSAs removed from the LS database after LsaMaxAge.
+     */
+    uint32_t GetPurgedLsaCount () const;
+
     void SendHello ();
     void SendLSTableMessage ();
+    /**
+     * \brief Originate our LSA, no more often than every LsaMinInterval.
+     */
+    void OriginateLSA ();
+    /**
+     * \brief Re-originate our LSA if it was not sent within LsaRefreshInterval.
+     */
+    void RefreshLSA ();
+    /**
+     * \brief Purge the LSAs not refreshed within LsaMaxAge.
+     */
+    void AgeLSTable ();
 
     // Periodic Audit
     void AuditPings ();
@@ -198,6 +309,13 @@ class LSRoutingProtocol : public CommRoutingProtocol
      * \param packet Packet to be sent.
      */
     void BroadcastPacket (Ptr<Packet> packet);
+    /**
+     * \brief Broadcast a packet on all interfaces but one.
+     *
+     * \param packet Packet to be sent.
+     * \param except Socket to skip.
+     */
+    void FloodPacket (Ptr<Packet> packet, Ptr<Socket> except);
 
     /**
      * \brief Returns the main IP address of a node in Inet topology.
@@ -216,17 +334,28 @@ class LSRoutingProtocol : public CommRoutingProtocol
      */
 
     virtual std::string ReverseLookup (Ipv4Address); 
+    /**
+     * \brief Returns the Inet topology node number which is using the specified IP.
+     *
+     * Used to index the routing and LS tables.
+     *
+     * \param ipv4Address IP address of node.
+     * \returns NODE_UNKNOWN if the address does not belong to any node.
+     */
+    uint32_t LookupNodeNumber (Ipv4Address ipv4Address);
     
     // Status 
     void DumpLSA ();
     void DumpNeighbors ();
     void DumpRoutingTable ();
     void DumpLSTable();
+    void DumpSpfStats ();
 
   protected:
     virtual void DoStart (void);
 
     typedef std::vector<std::pair<Ipv4Address, uint32_t> > nbrCostsVec;
+    typedef std::vector<std::pair<uint32_t, uint32_t> > nodeCostsVec;
     
     uint32_t GetNextSequenceNumber ();
     /**
@@ -236,11 +365,60 @@ class LSRoutingProtocol : public CommRoutingProtocol
      */
     bool IsOwnAddress (Ipv4Address originatorAddress);
 
-    void GetNeighbors(const std::string, std::vector<Ipv4Address>&);
-    uint32_t DistanceToNeighbor(const std::string, const std::string);
-    void removeLSTableLink(Ipv4Address, nbrCostsVec&);
-    void removeLSTableLink_old(Ipv4Address, Ipv4Address);
-    std::string GetMinCostNode( const std::map<std::string, bool>& );
+    void removeLSTableLink(uint32_t, nodeCostsVec&);
+    /**
+     * \returns the node which originated an LSA, or NODE_UNKNOWN when the
+     * LSA is ours, from outside the topology, or not newer than the one
+     * in the LS database.
+     */
+    uint32_t AcceptLSA (Ipv4Address fromAddr, uint32_t seqNum);
+    /**
+     * \brief Record a newer LSA of fromNode, and update the routes if its
+     * adjacency changed.
+     *
+     * \param neighborCosts New adjacency, swapped into the LS database.
+     */
+    void InstallLSA (uint32_t fromNode, uint32_t seqNum, bool changed, nodeCostsVec &neighborCosts);
+    /**
+     * \brief Snapshot the LS database into m_spfGraph.
+     *
+     * Links of this node only count towards neighbors in the neighbor table,
+     * nothing can be forwarded over the others.
+     */
+    void BuildSpfGraph (uint32_t thisNode);
+
+    /**
+     * \brief Bring the routing table up to date after the LSA of a node was replaced.
+     *
+     * Falls back to a full Dijkstra () unless the IncrementalSpf attribute is set
+     * and the change concerns a remote node.
+     *
+     * \param changedNode Node whose LSA changed.
+     * \param oldNeighborCosts Adjacency that node advertised before the change.
+     */
+    void UpdateRoutes (uint32_t changedNode, const nodeCostsVec &oldNeighborCosts);
+    /**
+     * \brief Repair the current shortest path tree instead of rebuilding it.
+     *
+     * Only the subtree hanging off links that disappeared or got more expensive
+     * is invalidated; it is reattached, together with whatever the new or cheaper
+     * links of changedNode improve, through a binary heap frontier.
+     */
+    void IncrementalDijkstra (uint32_t changedNode, const nodeCostsVec &oldNeighborCosts);
+    /**
+     * \brief Request a routing table update, throttled OSPF style.
+     *
+     * The first trigger after a quiet period runs SpfInitialDelay later. Triggers
+     * arriving inside the hold time of the previous run are deferred to its end,
+     * and the hold time doubles up to SpfMaxHoldTime while the churn goes on.
+     * Triggers arriving while a run is pending are folded into it. With both
+     * SpfInitialDelay and SpfHoldTime zero the update runs immediately.
+     *
+     * \param changedNode Node whose LSA changed.
+     * \param oldNeighborCosts Adjacency that node advertised before the change.
+     */
+    void ScheduleSpf (uint32_t changedNode, const nodeCostsVec &oldNeighborCosts);
+    void RunScheduledSpf ();
 
   private:
     std::map< Ptr<Socket>, Ipv4InterfaceAddress > m_socketAddresses;
@@ -252,23 +430,45 @@ class LSRoutingProtocol : public CommRoutingProtocol
     uint8_t m_maxTTL;
     uint16_t m_lsPort;
     uint32_t m_currentSequenceNumber;
+    bool m_incrementalSpf;
+    uint32_t m_fullSpfCount;
+    uint32_t m_partialSpfCount;
+    // SPF throttling and LSA pacing
+    Time m_spfInitialDelay;
+    Time m_spfHoldTime;
+    Time m_spfMaxHoldTime;
+    Time m_spfCurrentHold;
+    Time m_lastSpfTime;
+    Time m_lsaMinInterval;
+    Time m_lastLsaTime;
+    bool m_lsaOriginated;
+    uint32_t m_pendingSpfNode;
+    nodeCostsVec m_pendingOldCosts;
+    uint32_t m_coalescedSpfCount;
+    uint32_t m_coalescedLsaCount;
+    // Send LS_TABLE_PACKED_MSG instead of LS_TABLE_MSG
+    bool m_packedTableMessages;
+    // Tables were primed by the batch SPF mode
+    bool m_convergedStatePrimed;
+    // LS database aging
+    Time m_lsaRefreshInterval;
+    Time m_lsaMaxAge;
+    uint32_t m_duplicateLsaCount;
+    uint32_t m_purgedLsaCount;
     std::map<uint32_t, Ipv4Address> m_nodeAddressMap;
     std::map<Ipv4Address, uint32_t> m_addressNodeMap;
+    Ptr<AddressDirectory> m_addressDirectory;
     // Timers
     Timer m_auditPingsTimer;
     Timer m_auditHellosTimer;
+    Timer m_spfTimer;
+    Timer m_lsaTimer;
+    Timer m_lsaRefreshTimer;
     // Ping tracker
     std::map<uint32_t, Ptr<PingRequest> > m_pingTracker;
     std::map<uint32_t, Ptr<HelloRequest> > m_helloTracker;
-
-    struct RoutingTableEntry {
-      Ipv4Address destAddr;
-      uint32_t nextHopNum;
-      Ipv4Address nextHopAddr;
-      Ipv4Address interfaceAddr;
-      uint32_t cost;
-      // uint32_t sequenceNumber;
-    };
+    // Serialized HELLO_REQ, only the sequence number changes
+    HeaderTemplate m_helloTemplate;
 
     struct NeighborTableEntry {
       Ipv4Address neighborAddr;
@@ -277,22 +477,50 @@ class LSRoutingProtocol : public CommRoutingProtocol
     };
 
     struct LSTableEntry {
-      nbrCostsVec neighborCosts;
+      nodeCostsVec neighborCosts;
       uint32_t sequenceNumber;
-      // uint32_t ttl;
+      bool valid;
+      // When the current sequence number was installed, the LSA's age counts from here
+      Time installed;
     };
 
-    std::map<std::string, NeighborTableEntry> m_neighborTable;
-    std::map<std::string, RoutingTableEntry> m_routingTable;
-    std::map<std::string, LSTableEntry> m_lsTable;
+    // Neighbors are few, every other table is indexed by node number
+    std::map<uint32_t, NeighborTableEntry> m_neighborTable;
+    NodeRouteTable m_routingTable;
+    std::vector<LSTableEntry> m_lsTable;
+
+    // Predecessor of every reachable node in the last shortest path tree
+    std::vector<uint32_t> m_sptParent;
+
+    // Full SPF scratch space, kept between runs to reuse the memory
+    SpfFrontierType m_spfFrontierType;
+    CsrGraph m_spfGraph;
+    std::vector<uint32_t> m_spfCost;
+    std::vector<uint32_t> m_spfFirstHop;
+    LinearScanFrontier m_linearScan;
+    IndexedBinaryHeap m_binaryHeap;
+    RadixHeap m_radixHeap;
+    DialBuckets m_dialBuckets;
 
     //defining iterator types for our table maps
-    typedef std::map<std::string, NeighborTableEntry>::iterator ntEntry;
-    typedef std::map<std::string, RoutingTableEntry>::iterator rtEntry;
-    typedef std::map<std::string, LSTableEntry>::iterator lstEntry;
+    typedef std::map<uint32_t, NeighborTableEntry>::iterator ntEntry;
+
+    typedef std::pair<uint32_t, uint32_t> spfCandidate;
+    typedef std::priority_queue<spfCandidate, std::vector<spfCandidate>, std::greater<spfCandidate> > spfFrontier;
+
+    bool RelaxSpfLink (uint32_t from, uint32_t to, uint32_t linkCost);
     
 
-    bool SearchTable (RoutingTableEntry& out_entry, Ipv4Address dest);
+    /**
+     * \brief Look up the compiled forwarding table, rebuilding it first if the routes changed.
+     *
+     * \returns the route to dest, or 0 if there is none.
+     */
+    Ptr<Ipv4Route> SearchTable (Ipv4Address dest);
+    void BuildForwardingTable ();
+
+    ForwardingTable m_forwardingTable;
+    bool m_forwardingTableDirty;
 };
 
 #endif
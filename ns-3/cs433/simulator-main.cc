@@ -33,6 +33,7 @@
 #include <string.h>
 #include <vector>
 #include <map>
+#include <deque>
 #include "ns3/core-module.h"
 #include "ns3/common-module.h"
 #include "ns3/node-module.h"
@@ -42,11 +43,16 @@
 #include "ns3/nstime.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/test-result.h"
+#include "ns3/comm-log-sink.h"
+#include "ns3/scenario-timeline.h"
+#include "ns3/address-directory.h"
 #include "ns3/ls-routing-helper.h"
+#include "ns3/ls-batch-spf.h"
 #include "ns3/dv-routing-helper.h"
 #include "ns3/test-app-helper.h"
 #include "ns3/l4-platform-helper.h"
 #include "ns3/l4-device.h"
+#include "ns3/topology-partitioner.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -56,15 +62,14 @@
 #include <unistd.h>
 
 /* Defines */
-#define MAX_SCAN_DELAY 256
-#define MIN_SCAN_DELAY 1
-#define MAX_NOT_READY 3
-
 #define LS_MODULE_NAME "LS"
 #define DV_MODULE_NAME "DV"
 #define APP_MODULE_NAME "TESTAPP"
 #define SIM_MODULE_NAME "SIM"
 
+/* Node number of scenario entries that apply to every node */
+#define ALL_NODES 0xffffffff
+
 using namespace ns3;
 
 /* Log component for this file */
@@ -77,20 +82,68 @@ struct CommandHandlerArgument
   void *simulatorMain;
 };
 
+// Scenario timeline opcodes
+enum ScenarioOpcode
+{
+  OP_LINK_DOWN,           // node is the link number
+  OP_LINK_UP,
+  OP_P2P_DOWN,            // between node and arg
+  OP_P2P_UP,
+  OP_NODELINKS_DOWN,
+  OP_NODELINKS_UP,
+  OP_APP_VERBOSE,
+  OP_APP_COMMAND,
+  OP_APP_PING,            // command within a traffic trace
+  OP_END_TRAFFIC_TRACE,
+  OP_ROUTING_VERBOSE,     // arg is the ScenarioRouting module
+  OP_ROUTING_COMMAND,
+  OP_ROUTING_DUMP_NEIGHBORS,
+  OP_ROUTING_DUMP_ROUTES
+};
+
+enum ScenarioRouting
+{
+  ROUTING_LS,
+  ROUTING_DV
+};
+
 void Tokenize(const std::string& str, std::vector<std::string>& tokens, const std::string& delimiters);
 void UpperCase (std::string &str);
 
 class SimulatorMain
 {
   public:
-    void Start (std::string scriptFile, NodeContainer nodeContainer, NetDeviceContainer* ndc, uint32_t totalNodes, uint32_t totalLinks);
+    /**
+     * \brief Schedule the script file and, if interactive, start reading commands from stdin.
+     */
+    void Start (std::string scriptFile, NodeContainer nodeContainer, NetDeviceContainer* ndc, uint32_t totalNodes, uint32_t totalLinks, bool interactive);
     void Stop ();
 
     // Command Handler
     static void *CommandHandler (void *arg);
     void ProcessCommandTokens (std::vector<std::string> tokens, Time time);
     void ProcessNodeCommandTokens (uint32_t nodeNum, std::vector<std::string> tokens, Time time);
-    void ReadCommandTokens (void);
+    /**
+     * \brief Run one entry of the scenario timeline, for one node or for ALL_NODES.
+     */
+    void RunScenarioEntry (uint8_t opcode, uint32_t node, uint32_t arg, uint32_t tokens);
+    void RunNodeScenarioEntry (uint8_t opcode, uint32_t node, uint32_t arg, const std::vector<std::string> &tokens);
+    /**
+     * \brief Hand a command read by the command handler thread to the simulation.
+     *
+     * The first command queued while the simulation has none pending injects one
+     * event that runs all of them, at the current simulation time or, in real
+     * time mode, at the current wall clock time.
+     */
+    void QueueCommandTokens (std::vector<std::string> tokens);
+    void ProcessQueuedCommands (void);
+    /**
+     * \brief Block until a command is typed in after the simulation ran out of events.
+     *
+     * \returns true if the simulation has to be run again for the queued commands,
+     * false once the input is closed or QUIT was given.
+     */
+    bool WaitForCommands (void);
 
     void LinkOperation (uint32_t linkNumber, bool isUp);
     void P2POperation (uint32_t nodeANum, uint32_t nodeBNum, bool isUp);
@@ -101,17 +154,30 @@ class SimulatorMain
 
     std::map<uint32_t, Ipv4Address> g_nodeAddressMap;
     std::map<Ipv4Address, uint32_t> g_addressNodeMap;
+    // Read-only copy of both maps shared by all protocols and applications
+    Ptr<AddressDirectory> g_addressDirectory;
   
   private:
     std::string m_scriptFile;
     NodeContainer m_nodeContainer;
     NetDeviceContainer* m_ndc;
     std::vector<std::string> m_tokens;
-    bool m_readyToRead;
-    uint32_t m_scanDelay;
-    uint32_t m_notReadyCount;
     uint32_t m_totalNodes, m_totalLinks;
 
+    // Compiled script and runtime commands, with the per node targets they resolve to
+    ScenarioTimeline m_timeline;
+    std::vector<Ptr<TestApp> > m_applications;
+    std::vector<Ptr<LSRoutingProtocol> > m_lsRouting;
+    std::vector<Ptr<DVRoutingProtocol> > m_dvRouting;
+
+    // Commands typed in, shared between the command handler thread and the simulation
+    std::deque<std::vector<std::string> > m_commandQueue;
+    pthread_mutex_t m_commandQueueMutex;
+    pthread_cond_t m_commandQueueCond;
+    bool m_inputClosed;
+    RealtimeSimulatorImpl *m_realtimeImpl;
+    bool m_interactive;
+    bool m_quit;
     pthread_t m_commandHandlerThreadId;
     struct CommandHandlerArgument m_thArgument;
 
@@ -121,7 +187,7 @@ class SimulatorMain
 };
 
 void
-SimulatorMain::Start (std::string scriptFile, NodeContainer nodeContainer, NetDeviceContainer* ndc, uint32_t totalNodes, uint32_t totalLinks)
+SimulatorMain::Start (std::string scriptFile, NodeContainer nodeContainer, NetDeviceContainer* ndc, uint32_t totalNodes, uint32_t totalLinks, bool interactive)
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_thArgument.scriptFile = scriptFile;
@@ -133,9 +199,46 @@ SimulatorMain::Start (std::string scriptFile, NodeContainer nodeContainer, NetDe
   m_totalNodes = totalNodes;
   m_totalLinks = totalLinks;
   m_scriptFile = scriptFile;
-  m_readyToRead = false;
-  m_scanDelay = MIN_SCAN_DELAY;
-  m_notReadyCount = 0;
+  m_interactive = interactive;
+  m_inputClosed = false;
+  m_quit = false;
+  pthread_mutex_init (&m_commandQueueMutex, NULL);
+  pthread_cond_init (&m_commandQueueCond, NULL);
+  // Looked up here, the simulator implementation must not be created from the command handler thread
+  m_realtimeImpl = PeekPointer (DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ()));
+
+  // Resolve command targets once instead of per command
+  m_applications.assign (m_totalNodes, 0);
+  m_lsRouting.assign (m_totalNodes, 0);
+  m_dvRouting.assign (m_totalNodes, 0);
+  for (uint32_t i = 0; i < m_totalNodes; i++)
+    {
+      Ptr<Node> node = m_nodeContainer.Get (i);
+      if (node->GetNApplications () > 0)
+        {
+          m_applications[i] = node->GetApplication (0)->GetObject<TestApp> ();
+        }
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      if (!ipv4)
+        continue;
+      Ptr<Ipv4ListRouting> listRouting = DynamicCast<Ipv4ListRouting> (ipv4->GetRoutingProtocol ());
+      if (!listRouting)
+        continue;
+      for (uint32_t j = 0; j < listRouting->GetNRoutingProtocols (); j++)
+        {
+          int16_t priority;
+          Ptr<Ipv4RoutingProtocol> protocol = listRouting->GetRoutingProtocol (j, priority);
+          if (!m_lsRouting[i])
+            {
+              m_lsRouting[i] = DynamicCast<LSRoutingProtocol> (protocol);
+            }
+          if (!m_dvRouting[i])
+            {
+              m_dvRouting[i] = DynamicCast<DVRoutingProtocol> (protocol);
+            }
+        }
+    }
+  m_timeline.SetExecutor (MakeCallback (&SimulatorMain::RunScenarioEntry, this));
 
   // Process script file
   if (scriptFile != "")
@@ -185,8 +288,14 @@ SimulatorMain::Start (std::string scriptFile, NodeContainer nodeContainer, NetDe
             } while (!file.eof ());
         }
     }
-  // Schedule processing
-  Simulator::Schedule (MilliSeconds (m_scanDelay), &SimulatorMain::ReadCommandTokens, this);
+  NS_LOG_INFO ("Scenario compiled to " << m_timeline.GetEntryCount () << " entries, "
+               << m_timeline.GetTokenListCount () << " distinct argument lists");
+  m_timeline.Start ();
+  // Script only runs have no input to wait for
+  if (!m_interactive)
+    {
+      return;
+    }
   if (pthread_create (&m_commandHandlerThreadId, NULL, SimulatorMain::CommandHandler, &m_thArgument) != 0)
     {
       perror ("New thread creation failed, exiting...");
@@ -198,6 +307,10 @@ void
 SimulatorMain::Stop ()
 {
   NS_LOG_FUNCTION_NOARGS ();
+  if (!m_interactive)
+    {
+      return;
+    }
   pthread_cancel (m_commandHandlerThreadId);
   pthread_join (m_commandHandlerThreadId, NULL);
 }
@@ -214,53 +327,79 @@ SimulatorMain::CommandHandler (void* arg)
     {
       std::string commandLine;
       std::cout << "\nCommand > ";
-      std::getline (std::cin, commandLine, '\n');
-      if (commandLine == "")
-        continue;
-      if (simulatorMain->m_readyToRead == true)
+      if (!std::getline (std::cin, commandLine, '\n'))
         {
-          std::cout << "Simulator busy, please try again...\n";
-          continue;    
+          // End of input, the simulation goes on with what it has
+          pthread_mutex_lock (&simulatorMain->m_commandQueueMutex);
+          simulatorMain->m_inputClosed = true;
+          pthread_cond_signal (&simulatorMain->m_commandQueueCond);
+          pthread_mutex_unlock (&simulatorMain->m_commandQueueMutex);
+          break;
         }
-      Tokenize (commandLine, simulatorMain->m_tokens, " ");
-      std::vector<std::string>::iterator iterator = simulatorMain->m_tokens.begin ();
-      if (simulatorMain -> m_tokens.size() == 0)
+      if (commandLine == "")
+        continue;
+      std::vector<std::string> tokens;
+      Tokenize (commandLine, tokens, " ");
+      if (tokens.size() == 0)
         {
           continue;
         }
-      simulatorMain -> m_readyToRead = true;
+      simulatorMain->QueueCommandTokens (tokens);
     }
-  Simulator::Stop ();
   pthread_exit (NULL);
 }
 
 void
-SimulatorMain::ReadCommandTokens (void)
+SimulatorMain::QueueCommandTokens (std::vector<std::string> tokens)
 {
-  if (m_readyToRead == true)
+  pthread_mutex_lock (&m_commandQueueMutex);
+  bool wasEmpty = m_commandQueue.empty ();
+  m_commandQueue.push_back (tokens);
+  // Otherwise already injected, ProcessQueuedCommands will pick this one up too
+  if (wasEmpty)
     {
-      m_scanDelay = MIN_SCAN_DELAY;
-      if (m_tokens.size() > 0)
+      // No node context, commands are not executed on behalf of a node
+      if (m_realtimeImpl != 0)
         {
-          ProcessCommandTokens (m_tokens, MilliSeconds (0.0));
+          m_realtimeImpl->ScheduleRealtimeNowWithContext (0xffffffff, MakeEvent (&SimulatorMain::ProcessQueuedCommands, this));
         }
-      m_tokens.clear();
-      m_readyToRead = false;
-    }
-  else
-    {
-      m_notReadyCount++;
-      if (m_notReadyCount == MAX_NOT_READY)
+      else
         {
-          m_notReadyCount = 0;
-          m_scanDelay = m_scanDelay * 2;
-          if (m_scanDelay > MAX_SCAN_DELAY)
-            {
-              m_scanDelay = MAX_SCAN_DELAY;
-            }
+          Simulator::ScheduleWithContext (0xffffffff, Seconds (0), &SimulatorMain::ProcessQueuedCommands, this);
         }
+      pthread_cond_signal (&m_commandQueueCond);
+    }
+  pthread_mutex_unlock (&m_commandQueueMutex);
+}
+
+void
+SimulatorMain::ProcessQueuedCommands (void)
+{
+  std::deque<std::vector<std::string> > commands;
+  pthread_mutex_lock (&m_commandQueueMutex);
+  commands.swap (m_commandQueue);
+  pthread_mutex_unlock (&m_commandQueueMutex);
+  for (uint32_t i = 0; i < commands.size (); i++)
+    {
+      ProcessCommandTokens (commands[i], MilliSeconds (0.0));
+    }
+}
+
+bool
+SimulatorMain::WaitForCommands (void)
+{
+  if (!m_interactive || m_quit)
+    {
+      return false;
     }
-  Simulator::Schedule (MilliSeconds (m_scanDelay), &SimulatorMain::ReadCommandTokens, this);
+  pthread_mutex_lock (&m_commandQueueMutex);
+  while (m_commandQueue.empty () && !m_inputClosed)
+    {
+      pthread_cond_wait (&m_commandQueueCond, &m_commandQueueMutex);
+    }
+  bool pending = !m_commandQueue.empty ();
+  pthread_mutex_unlock (&m_commandQueueMutex);
+  return pending;
 }
 
 void
@@ -272,9 +411,12 @@ SimulatorMain::ProcessCommandTokens (std::vector<std::string> tokens, Time time)
     return;
   UpperCase (*iterator);
   std::string command = *iterator;
+  // Commands are relative to now, the timeline is in absolute time
+  Time at = Simulator::Now () + time;
   if (command == "QUIT")
     {
       NS_LOG_INFO ("Scheduling command: quit...");
+      m_quit = true;
       Simulator::Stop (MilliSeconds (time.GetMilliSeconds()));
       return;
     }
@@ -303,12 +445,12 @@ SimulatorMain::ProcessCommandTokens (std::vector<std::string> tokens, Time time)
           sin >> linkNumber;             
           if (operation == "DOWN")
             {
-              Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::LinkOperation, this, linkNumber, false);
+              m_timeline.Add (at, OP_LINK_DOWN, linkNumber, 0, ScenarioTimeline::NO_TOKENS);
               return;
             }
           else if (operation == "UP")
             {
-              Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::LinkOperation, this, linkNumber, true);
+              m_timeline.Add (at, OP_LINK_UP, linkNumber, 0, ScenarioTimeline::NO_TOKENS);
               return;
             }
         }
@@ -329,12 +471,12 @@ SimulatorMain::ProcessCommandTokens (std::vector<std::string> tokens, Time time)
           sinB >> nodeBNum;      
           if (operation == "DOWN")
             {
-              Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::P2POperation, this, nodeANum, nodeBNum, false);
+              m_timeline.Add (at, OP_P2P_DOWN, nodeANum, nodeBNum, ScenarioTimeline::NO_TOKENS);
               return;
             }
           else if (operation == "UP")
             {
-              Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::P2POperation, this, nodeANum, nodeBNum, true);
+              m_timeline.Add (at, OP_P2P_UP, nodeANum, nodeBNum, ScenarioTimeline::NO_TOKENS);
               return;
             }
 
@@ -356,23 +498,20 @@ SimulatorMain::ProcessCommandTokens (std::vector<std::string> tokens, Time time)
       sin >> nodeNumber;             
       if (operation == "DOWN")
         {
-          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::AllInterfacesOperation, this, nodeNumber, false);
+          m_timeline.Add (at, OP_NODELINKS_DOWN, nodeNumber, 0, ScenarioTimeline::NO_TOKENS);
           return;
         }
       else if (operation == "UP")
         {
-          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::AllInterfacesOperation, this, nodeNumber, true);
+          m_timeline.Add (at, OP_NODELINKS_UP, nodeNumber, 0, ScenarioTimeline::NO_TOKENS);
           return;
         }
     }
   else if (*iterator == "*")    
     {
-      // Send command to all nodes 
+      // Send command to all nodes, as one timeline entry
       tokens.erase (iterator);
-      for (uint32_t i = 0 ; i < m_totalNodes ; i++)
-        {
-          ProcessNodeCommandTokens (i, tokens, time);
-        }
+      ProcessNodeCommandTokens (ALL_NODES, tokens, time);
     }
   else
     {
@@ -393,7 +532,7 @@ SimulatorMain::ProcessCommandTokens (std::vector<std::string> tokens, Time time)
 void
 SimulatorMain::ProcessNodeCommandTokens (uint32_t nodeNumber, std::vector<std::string> tokens, Time time)
 {
-  if (nodeNumber >= m_totalNodes)
+  if (nodeNumber >= m_totalNodes && nodeNumber != ALL_NODES)
     { 
       NS_LOG_ERROR ("Invalid node number!");
       return;
@@ -408,136 +547,174 @@ SimulatorMain::ProcessNodeCommandTokens (uint32_t nodeNumber, std::vector<std::s
   if (tokens.size () == 0)
     return;
   iterator = tokens.begin();
+  Time at = Simulator::Now () + time;
+  std::string command = std::string ((*iterator).c_str(), (*iterator).length());
+  UpperCase (command);
   // module name
   if (module == APP_MODULE_NAME || module == "APP")
     {
-      // Get application pointer
-      Ptr<TestApp> application = m_nodeContainer.Get(nodeNumber)->GetApplication(0)->GetObject<TestApp> ();
-      std::string command = std::string ((*iterator).c_str(), (*iterator).length());
-      UpperCase (command);
       if (command == "VERBOSITY" || command == "VERBOSE")
         {
           tokens.erase (iterator);
           if (tokens.size () == 0)
             return;
-          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::SetApplicationVerbose, this, application, tokens);
+          m_timeline.Add (at, OP_APP_VERBOSE, nodeNumber, 0, m_timeline.Intern (tokens));
           return;
         }
       else
         {
-    	  if(tokens.size() == 3 && strcmp(tokens[0].c_str(), "PING") == 0)
-    	  {
-    		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &startDumpTrafficTrace);
-    		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &TestApp::ProcessCommand, application, tokens);
-    		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()+1000), &endDumpTrafficTrace);
-    	  }
-    	  else
-    	  {
-    		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &TestApp::ProcessCommand, application, tokens);
-    	  }
+          if (tokens.size() == 3 && strcmp(tokens[0].c_str(), "PING") == 0)
+            {
+              m_timeline.Add (at, OP_APP_PING, nodeNumber, 0, m_timeline.Intern (tokens));
+              m_timeline.Add (at + MilliSeconds (1000), OP_END_TRAFFIC_TRACE, nodeNumber, 0, ScenarioTimeline::NO_TOKENS);
+            }
+          else
+            {
+              m_timeline.Add (at, OP_APP_COMMAND, nodeNumber, 0, m_timeline.Intern (tokens));
+            }
           return;
         }
     }
   else if (module == LS_MODULE_NAME || module == DV_MODULE_NAME)
     {
-      Ptr<Ipv4> ipv4 = m_nodeContainer.Get(nodeNumber)->GetObject<Ipv4> ();
-      if (!ipv4)
-        return;
-      Ptr<Ipv4ListRouting> listRouting = DynamicCast<Ipv4ListRouting> (ipv4->GetRoutingProtocol ());
-      if (!listRouting)
+      uint32_t routing = module == LS_MODULE_NAME ? ROUTING_LS : ROUTING_DV;
+      if (nodeNumber != ALL_NODES
+          && (routing == ROUTING_LS ? m_lsRouting[nodeNumber] == 0 : m_dvRouting[nodeNumber] == 0))
         {
           return;
         }
-      uint32_t protocols = listRouting->GetNRoutingProtocols ();
-      for (uint32_t i = 0 ; i < protocols ; i++)
+      if (command == "VERBOSITY" || command == "VERBOSE")
         {
-          std::string command = std::string ((*iterator).c_str(), (*iterator).length());
-          UpperCase (command);
-          int16_t priority;
-          if (module == LS_MODULE_NAME)
-            {
-              Ptr<LSRoutingProtocol> lsRouting = DynamicCast<LSRoutingProtocol> (listRouting->GetRoutingProtocol (i, priority));
-              if (lsRouting)
-                {
-                  if (command == "VERBOSITY" || command == "VERBOSE")
-                    {
-                      tokens.erase (iterator);
-                      if (tokens.size () == 0)
-                        return;
-                      Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::SetRoutingVerbose, this, lsRouting, tokens);
-                      return;
-                    }
-                  else
-                    {
-                	  if(tokens.size() == 2 && strcmp(tokens[0].c_str(), "DUMP")==0 && strcmp(tokens[1].c_str(),"NEIGHBORS") == 0)
-                	  {
-                          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &startDumpNeighbor);
-                		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &LSRoutingProtocol::ProcessCommand, lsRouting, tokens);
-                          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &endDumpNeighbor);
-                	  }
-                	  else if(tokens.size() == 2 && strcmp(tokens[0].c_str(), "DUMP")==0 && strcmp(tokens[1].c_str(),"ROUTES") == 0)
-                	  {
-                          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &startDumpRoute);
-                		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &LSRoutingProtocol::ProcessCommand, lsRouting, tokens);
-                          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &endDumpRoute);
-                	  }
-                	  else
-                	  {
-                		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &LSRoutingProtocol::ProcessCommand, lsRouting, tokens);
-                	  }
-                      return;
-                    }
-                }
-            }
-          else if (module == DV_MODULE_NAME)
-            {
-              Ptr<DVRoutingProtocol> dvRouting = DynamicCast<DVRoutingProtocol> (listRouting->GetRoutingProtocol (i, priority));
-              if (dvRouting)
-                {
-                  if (command == "VERBOSITY" || command == "VERBOSE")
-                    {
-                      tokens.erase (iterator);
-                      if (tokens.size () == 0)
-                        return;
-                      Simulator::Schedule (MilliSeconds (time.GetMilliSeconds ()), &SimulatorMain::SetRoutingVerbose, this, dvRouting, tokens);
-                      return;
-                    }
-                  else
-                    {
-                	  if(tokens.size() == 2 && strcmp(tokens[0].c_str(), "DUMP")==0 && strcmp(tokens[1].c_str(),"NEIGHBORS") == 0)
-                	  {
-                          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &startDumpNeighbor);
-                		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &DVRoutingProtocol::ProcessCommand, dvRouting, tokens);
-                          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &endDumpNeighbor);
-                	  }
-                	  else if(tokens.size() == 2 && strcmp(tokens[0].c_str(), "DUMP")==0 && strcmp(tokens[1].c_str(),"ROUTES") == 0)
-                	  {
-                          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &startDumpRoute);
-                		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &DVRoutingProtocol::ProcessCommand, dvRouting, tokens);
-                          Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &endDumpRoute);
-                	  }
-                	  else
-                	  {
-                		  Simulator::Schedule (MilliSeconds (time.GetMilliSeconds()), &DVRoutingProtocol::ProcessCommand, dvRouting, tokens);
-                	  }
-                      return;
-                    }
-                }
-
-            }
+          tokens.erase (iterator);
+          if (tokens.size () == 0)
+            return;
+          m_timeline.Add (at, OP_ROUTING_VERBOSE, nodeNumber, routing, m_timeline.Intern (tokens));
+          return;
         }
+      if (tokens.size() == 2 && strcmp(tokens[0].c_str(), "DUMP")==0 && strcmp(tokens[1].c_str(),"NEIGHBORS") == 0)
+        {
+          m_timeline.Add (at, OP_ROUTING_DUMP_NEIGHBORS, nodeNumber, routing, m_timeline.Intern (tokens));
+        }
+      else if (tokens.size() == 2 && strcmp(tokens[0].c_str(), "DUMP")==0 && strcmp(tokens[1].c_str(),"ROUTES") == 0)
+        {
+          m_timeline.Add (at, OP_ROUTING_DUMP_ROUTES, nodeNumber, routing, m_timeline.Intern (tokens));
+        }
+      else
+        {
+          m_timeline.Add (at, OP_ROUTING_COMMAND, nodeNumber, routing, m_timeline.Intern (tokens));
+        }
+      return;
     }
   else if (module == SIM_MODULE_NAME)
     {
-      if (tokens.size () == 0)
+      return;
+    }
+
+}
+
+void
+SimulatorMain::RunScenarioEntry (uint8_t opcode, uint32_t node, uint32_t arg, uint32_t tokens)
+{
+  switch (opcode)
+    {
+      case OP_LINK_DOWN:
+        LinkOperation (node, false);
         return;
-      UpperCase (*iterator);
-      std::string command = *iterator;
-      tokens.erase (iterator);
-      iterator = tokens.begin ();
+      case OP_LINK_UP:
+        LinkOperation (node, true);
+        return;
+      case OP_P2P_DOWN:
+        P2POperation (node, arg, false);
+        return;
+      case OP_P2P_UP:
+        P2POperation (node, arg, true);
+        return;
+      case OP_NODELINKS_DOWN:
+        AllInterfacesOperation (node, false);
+        return;
+      case OP_NODELINKS_UP:
+        AllInterfacesOperation (node, true);
+        return;
+      default:
+        break;
+    }
+  // Copied, a command may add entries and intern new token lists
+  std::vector<std::string> args = m_timeline.GetTokens (tokens);
+  if (node != ALL_NODES)
+    {
+      RunNodeScenarioEntry (opcode, node, arg, args);
       return;
     }
+  for (uint32_t i = 0; i < m_totalNodes; i++)
+    {
+      RunNodeScenarioEntry (opcode, i, arg, args);
+    }
+}
 
+void
+SimulatorMain::RunNodeScenarioEntry (uint8_t opcode, uint32_t node, uint32_t arg, const std::vector<std::string> &tokens)
+{
+  Ptr<TestApp> application = m_applications[node];
+  Ptr<CommRoutingProtocol> routingProtocol;
+  if (arg == ROUTING_LS)
+    {
+      routingProtocol = m_lsRouting[node];
+    }
+  else
+    {
+      routingProtocol = m_dvRouting[node];
+    }
+  if (!application && (opcode == OP_APP_VERBOSE || opcode == OP_APP_COMMAND || opcode == OP_APP_PING))
+    {
+      return;
+    }
+  switch (opcode)
+    {
+      case OP_APP_VERBOSE:
+        SetApplicationVerbose (application, tokens);
+        break;
+      case OP_APP_COMMAND:
+        application->ProcessCommand (tokens);
+        break;
+      case OP_APP_PING:
+        startDumpTrafficTrace ();
+        application->ProcessCommand (tokens);
+        break;
+      case OP_END_TRAFFIC_TRACE:
+        endDumpTrafficTrace ();
+        break;
+      case OP_ROUTING_VERBOSE:
+        if (routingProtocol)
+          {
+            SetRoutingVerbose (routingProtocol, tokens);
+          }
+        break;
+      case OP_ROUTING_COMMAND:
+        if (routingProtocol)
+          {
+            routingProtocol->ProcessCommand (tokens);
+          }
+        break;
+      case OP_ROUTING_DUMP_NEIGHBORS:
+        if (routingProtocol)
+          {
+            startDumpNeighbor ();
+            routingProtocol->ProcessCommand (tokens);
+            endDumpNeighbor ();
+          }
+        break;
+      case OP_ROUTING_DUMP_ROUTES:
+        if (routingProtocol)
+          {
+            startDumpRoute ();
+            routingProtocol->ProcessCommand (tokens);
+            endDumpRoute ();
+          }
+        break;
+      default:
+        NS_LOG_ERROR ("Unknown scenario opcode " << (uint32_t) opcode);
+        break;
+    }
 }
 
 void
@@ -800,6 +977,14 @@ main (int argc, char *argv[])
   std::string realTime = "";
   std::string resultFile = "";
   std::string localAddress = "";
+  std::string batchSpf = "";
+  uint32_t batchSpfThreads = 0;
+  std::string binaryLog = "";
+  std::string asyncLog = "";
+  uint32_t asyncLogBuffer = CommLogSink::DEFAULT_BUFFER_SIZE;
+  std::string interactive = "";
+  uint32_t threads = 1;
+  std::string partitionReport = "";
 
   // Command Line parameters
   CommandLine cmd;
@@ -811,19 +996,65 @@ main (int argc, char *argv[])
   cmd.AddValue ("real-stack", "Use real IP stack/sockets: <yes/no>", realStack);
   cmd.AddValue ("real-time", "Run simulation in wall clock mode (real-time): <yes/no>", realTime);
   cmd.AddValue ("local-address", "Local Address if real stack is used (optional)", localAddress);
+  cmd.AddValue ("batch-spf", "Start LS from routing tables precomputed for the whole topology: <yes/no>", batchSpf);
+  cmd.AddValue ("batch-spf-threads", "Worker threads for batch-spf, 0 for one per CPU", batchSpfThreads);
+  cmd.AddValue ("binary-log", "Write the module logs to this file in binary, read it with comm-log-decode", binaryLog);
+  cmd.AddValue ("async-log", "Write NS_LOG and binary-log output from a background thread, when full: <block/drop>", asyncLog);
+  cmd.AddValue ("async-log-buffer", "Bytes queued for the async-log writer threads", asyncLogBuffer);
+  cmd.AddValue ("interactive", "Read commands from stdin while running: <yes/no>, default yes if stdin is a terminal", interactive);
+  cmd.AddValue ("threads", "Simulate the nodes on this many threads, 0 for one per CPU", threads);
+  cmd.AddValue ("partition-report", "Write the node partitions of threads to this file", partitionReport);
 
   cmd.Parse (argc, argv);
   
   UpperCase (realStack);
   UpperCase (realTime);
+  UpperCase (batchSpf);
+  UpperCase (asyncLog);
+  UpperCase (interactive);
 
   openResultFile(resultFile);
 
+  Ptr<AsyncLogWriter> nsLogWriter = 0;
+  AsyncLogWriter::FullPolicy asyncLogPolicy = AsyncLogWriter::BLOCK;
+  if (asyncLog == "DROP")
+    {
+      asyncLogPolicy = AsyncLogWriter::DROP;
+    }
+  else if (!asyncLog.empty () && asyncLog != "BLOCK")
+    {
+      NS_FATAL_ERROR ("async-log must be block or drop");
+    }
+  if (!asyncLog.empty ())
+    {
+      nsLogWriter = AsyncLogWriter::Redirect (std::clog, asyncLogBuffer, asyncLogPolicy);
+    }
+  if (!binaryLog.empty () && !CommLogSink::Open (binaryLog, asyncLogBuffer, !asyncLog.empty (), asyncLogPolicy))
+    {
+      NS_FATAL_ERROR ("Unable to create binary log " << binaryLog);
+    }
+
   if (realStack == "YES" || realTime == "YES")
     {
        GlobalValue::Bind ("SimulatorImplementationType",
                          StringValue ("ns3::RealtimeSimulatorImpl"));
     }
+  if (threads != 1)
+    {
+      // The log writers take a single producer, and the animation
+      // traces are written from the device callbacks
+      if (realStack == "YES" || realTime == "YES")
+        {
+          NS_FATAL_ERROR ("threads cannot be used with real-stack or real-time");
+        }
+      if (!asyncLog.empty () || !binaryLog.empty () || !animFile.empty ())
+        {
+          NS_FATAL_ERROR ("threads cannot be used with async-log, binary-log or anim-file");
+        }
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::MultithreadedSimulatorImpl"));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (threads));
+    }
 
   // Enable Logs
   LogComponentEnable ("SimulatorMain", LOG_LEVEL_ALL);
@@ -848,6 +1079,7 @@ main (int argc, char *argv[])
   if (realStack != "YES")
     {  
       std::map<uint32_t, Ptr<Node> > nodeMap;
+      std::string linkDelay = "2ms";
 
       topoHelper.SetFileName (topologyFile);
       topoHelper.SetFileType ("Inet");
@@ -862,6 +1094,24 @@ main (int argc, char *argv[])
           NS_FATAL_ERROR ("Unable to read/parse topology file");
           return -1;
         }
+      if (threads != 1)
+        {
+          uint32_t partitions = threads;
+          if (partitions == 0)
+            {
+              long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+              partitions = cpus > 0 ? cpus : 1;
+            }
+          TopologyPartitioner partitioner;
+          partitioner.SetDefaultDelay (Time (linkDelay));
+          partitioner.Partition (nodeContainer, topologyReader->LinksBegin (), topologyReader->LinksEnd (), partitions);
+          partitioner.Assign ();
+          if (!partitionReport.empty ())
+            {
+              std::ofstream report (partitionReport.c_str ());
+              partitioner.Print (report);
+            }
+        }
 
       // Create nodes
       NS_LOG_INFO ("Installing internet stack..");
@@ -915,6 +1165,7 @@ main (int argc, char *argv[])
 
       NS_LOG_INFO ("Creating node containers... Nodes : " << totalNodes);
       nc = new NodeContainer[totalLinks];
+      std::vector<std::pair<uint32_t, uint32_t> > linkNodes;
       TopologyReader::ConstLinksIterator iter;
       int num = 0;
       for (iter = topologyReader->LinksBegin (); iter != topologyReader->LinksEnd(); iter++, num++)
@@ -928,6 +1179,7 @@ main (int argc, char *argv[])
           nodeMap.insert (std::make_pair (from, iter->GetFromNode()));
           nodeMap.insert (std::make_pair (to, iter->GetToNode()));
           nc[num] = NodeContainer (iter->GetFromNode (), iter->GetToNode ());
+          linkNodes.push_back (std::make_pair (from, to));
         }
 
       // Create real node container
@@ -950,7 +1202,7 @@ main (int argc, char *argv[])
       PointToPointHelper p2p;
       for (uint32_t i = 0 ; i < totalLinks ; i++)
         {
-          p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+          p2p.SetChannelAttribute ("Delay", StringValue (linkDelay));
           p2p.SetDeviceAttribute ("DataRate", StringValue ("5Mbps"));
           ndc[i] = p2p.Install (nc[i]);
         }
@@ -1018,6 +1270,8 @@ main (int argc, char *argv[])
         }
 
       // Assign node-address map
+      simulatorMain.g_addressDirectory = Create<AddressDirectory> (simulatorMain.g_nodeAddressMap,
+                                                                   simulatorMain.g_addressNodeMap);
       for (uint32_t i = 0 ; i < totalNodes ; i++)
         {      
           Ptr<Ipv4> ipv4 = realNodeContainer.Get(i)->GetObject<Ipv4> ();
@@ -1034,18 +1288,47 @@ main (int argc, char *argv[])
               Ptr<LSRoutingProtocol> lsRouting = DynamicCast<LSRoutingProtocol> (listRouting->GetRoutingProtocol (k, priority));
               if (lsRouting)
                 {
-                  lsRouting->SetNodeAddressMap (simulatorMain.g_nodeAddressMap);
-                  lsRouting->SetAddressNodeMap (simulatorMain.g_addressNodeMap);
+                  lsRouting->SetAddressDirectory (simulatorMain.g_addressDirectory);
                   continue;
                 }
               Ptr<DVRoutingProtocol> dvRouting = DynamicCast<DVRoutingProtocol> (listRouting->GetRoutingProtocol (k, priority));
               if (dvRouting)
                 {
-                  dvRouting->SetNodeAddressMap (simulatorMain.g_nodeAddressMap);
-                  dvRouting->SetAddressNodeMap (simulatorMain.g_addressNodeMap);
+                  dvRouting->SetAddressDirectory (simulatorMain.g_addressDirectory);
+                  continue;
+                }
+            }
+        }
+
+      // Skip the LS warm-up, every node starts with its converged routing table
+      if (batchSpf == "YES")
+        {
+          NS_LOG_INFO ("Computing converged LS routing tables...");
+          LSBatchSpf batch;
+          for (uint32_t i = 0 ; i < totalLinks ; i++)
+            {
+              batch.AddLink (linkNodes[i].first, ipic[i].GetAddress (0),
+                             linkNodes[i].second, ipic[i].GetAddress (1));
+            }
+          for (uint32_t i = 0 ; i < totalNodes ; i++)
+            {
+              Ptr<Ipv4> ipv4 = realNodeContainer.Get(i)->GetObject<Ipv4> ();
+              Ptr<Ipv4ListRouting> listRouting = DynamicCast<Ipv4ListRouting> (ipv4->GetRoutingProtocol ());
+              if (!listRouting)
+                {
                   continue;
                 }
+              for (uint32_t k = 0 ; k < listRouting->GetNRoutingProtocols () ; k++)
+                {
+                  int16_t priority;
+                  Ptr<LSRoutingProtocol> lsRouting = DynamicCast<LSRoutingProtocol> (listRouting->GetRoutingProtocol (k, priority));
+                  if (lsRouting)
+                    {
+                      batch.AddProtocol (lsRouting);
+                    }
+                }
             }
+          batch.Run (batchSpfThreads);
         }
 
     }
@@ -1103,8 +1386,7 @@ main (int argc, char *argv[])
   for (uint32_t i = 0 ; i < totalNodes ; i++)
     {
       Ptr<TestApp> application = realNodeContainer.Get(i)->GetApplication(0)->GetObject<TestApp> ();
-      application->SetNodeAddressMap (simulatorMain.g_nodeAddressMap);
-      application->SetAddressNodeMap (simulatorMain.g_addressNodeMap);
+      application->SetAddressDirectory (simulatorMain.g_addressDirectory);
       std::ostringstream str;
       str << i;
       application->SetNodeId (str.str());
@@ -1114,7 +1396,8 @@ main (int argc, char *argv[])
 
   NS_LOG_INFO ("Creating script/command handler...");  
   // Start simulator main
-  simulatorMain.Start (scriptFile, realNodeContainer, ndc, totalNodes, totalLinks);
+  bool readCommands = interactive.empty () ? isatty (STDIN_FILENO) : interactive == "YES";
+  simulatorMain.Start (scriptFile, realNodeContainer, ndc, totalNodes, totalLinks, readCommands);
 
   // Create the animation object and configure for specified output
   AnimationInterface anim;
@@ -1127,7 +1410,22 @@ main (int argc, char *argv[])
   // Run the simulation
   NS_LOG_INFO ("Running Simulation...");
   Simulator::Run ();
+  // Out of events, keep going for as long as commands are typed in
+  while (simulatorMain.WaitForCommands ())
+    {
+      Simulator::Run ();
+    }
+  simulatorMain.Stop ();
   Simulator::Destroy ();
+  if (nsLogWriter != 0 && nsLogWriter->GetDroppedRecords () > 0)
+    {
+      std::cerr << "async-log dropped " << nsLogWriter->GetDroppedRecords () << " NS_LOG records" << std::endl;
+    }
+  if (CommLogSink::GetDroppedRecords () > 0)
+    {
+      std::cerr << "async-log dropped " << CommLogSink::GetDroppedRecords () << " binary-log records" << std::endl;
+    }
+  CommLogSink::Close ();
 
   if (ipic)
     delete[] ipic;
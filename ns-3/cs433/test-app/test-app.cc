@@ -59,6 +59,7 @@ TestApp::TestApp ()
   random = UniformVariable (0x00000000, 0xFFFFFFFF);
   m_currentTransactionId = random.GetInteger ();
   m_trafficRunning = false;
+  m_addressDirectory = Create<AddressDirectory> ();
 }
 
 TestApp::~TestApp ()
@@ -113,33 +114,35 @@ void
 TestApp::SetNodeAddressMap (std::map<uint32_t, Ipv4Address> nodeAddressMap)
 {
   m_nodeAddressMap = nodeAddressMap;
+  m_addressDirectory = Create<AddressDirectory> (m_nodeAddressMap, m_addressNodeMap);
 }
 
 void
 TestApp::SetAddressNodeMap (std::map<Ipv4Address, uint32_t> addressNodeMap)
 {
   m_addressNodeMap = addressNodeMap;
+  m_addressDirectory = Create<AddressDirectory> (m_nodeAddressMap, m_addressNodeMap);
+}
+
+void
+TestApp::SetAddressDirectory (Ptr<AddressDirectory> addressDirectory)
+{
+  m_addressDirectory = addressDirectory;
 }
 
 Ipv4Address
 TestApp::ResolveNodeIpAddress (uint32_t nodeNumber)
 {
-  std::map<uint32_t, Ipv4Address>::iterator iter = m_nodeAddressMap.find (nodeNumber);
-  if (iter != m_nodeAddressMap.end ())
-    { 
-      return iter->second;
-    }
-  return Ipv4Address::GetAny ();
+  return m_addressDirectory->GetMainAddress (nodeNumber);
 }
 
 std::string
 TestApp::ReverseLookup (Ipv4Address ipAddress)
 {
-  std::map<Ipv4Address, uint32_t>::iterator iter = m_addressNodeMap.find (ipAddress);
-  if (iter != m_addressNodeMap.end ())
+  uint32_t nodeNumber = m_addressDirectory->GetNodeNumber (ipAddress);
+  if (nodeNumber != NODE_UNKNOWN)
     { 
       std::ostringstream sin;
-      uint32_t nodeNumber = iter->second;
       sin << nodeNumber;    
       return sin.str();
     }
@@ -172,10 +175,10 @@ TestApp::ProcessCommand (std::vector<std::string> tokens)
         {
           iterator++;
           std::string pingMessage = *iterator;
-          std::map<uint32_t, Ipv4Address>::iterator iter;
-          for (iter = m_nodeAddressMap.begin () ; iter != m_nodeAddressMap.end (); iter++)  
+          for (uint32_t node = 0 ; node < m_addressDirectory->GetNodeCount (); node++)  
             {
-              SendPing (iter->first, pingMessage);
+              if (m_addressDirectory->GetMainAddress (node) != Ipv4Address::GetAny ())
+                SendPing (node, pingMessage);
             }
         }
     }
@@ -207,18 +210,19 @@ TestApp::ProcessCommand (std::vector<std::string> tokens)
         }
       else
         {
-          std::map<uint32_t, Ipv4Address>::iterator iter;
-          for (iter = m_nodeAddressMap.begin () ; iter != m_nodeAddressMap.end (); iter++)  
+          for (uint32_t node = 0 ; node < m_addressDirectory->GetNodeCount (); node++)  
             {
+              if (m_addressDirectory->GetMainAddress (node) == Ipv4Address::GetAny ())
+                continue;
               if (option == "START")
                 {
-                  DEBUG_LOG ("<*>Starting Traffic for node: " << iter->first);
-                  StartTraffic (iter->first);
+                  DEBUG_LOG ("<*>Starting Traffic for node: " << node);
+                  StartTraffic (node);
                 }
               else if (option == "STOP")
                 {
-                  DEBUG_LOG ("<*>Stop Traffic for node: " << iter->first);
-                  StopTraffic (iter->first);
+                  DEBUG_LOG ("<*>Stop Traffic for node: " << node);
+                  StopTraffic (node);
                 }
             }
         }
@@ -57,6 +57,7 @@ class TestApp : public CommApplication
     virtual void ProcessCommand (std::vector<std::string> tokens);
     virtual void SetNodeAddressMap (std::map<uint32_t, Ipv4Address> nodeAddressMap);
     virtual void SetAddressNodeMap (std::map<Ipv4Address, uint32_t> addressNodeMap);
+    virtual void SetAddressDirectory (Ptr<AddressDirectory> addressDirectory);
   private:
     virtual Ipv4Address ResolveNodeIpAddress (uint32_t nodeNumber);
     virtual std::string ReverseLookup (Ipv4Address ipv4Address); 
@@ -74,6 +75,7 @@ class TestApp : public CommApplication
     uint16_t m_appPort;
     std::map<uint32_t, Ipv4Address> m_nodeAddressMap;
     std::map<Ipv4Address, uint32_t> m_addressNodeMap;
+    Ptr<AddressDirectory> m_addressDirectory;
     // Timers
     Timer m_auditPingsTimer;
     // Ping tracker
@@ -25,8 +25,6 @@
 #include <ostream>
 #include "ns3/assert.h"
 
-#define noBUFFER_FREE_LIST 1
-
 namespace ns3 {
 
 /**
@@ -480,6 +478,11 @@ private:
   inline Buffer::Iterator End (void) const;
 
   Buffer CreateFullCopy (void) const;
+  /**
+   * \returns a copy of this buffer which does not share its data
+   *          with any other buffer.
+   */
+  Buffer CreateUnsharedCopy (void) const;
 
   /**
    * \return the number of bytes required for serialization 
@@ -610,17 +613,6 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize;
-  static FreeList *g_freeList;
-  static struct LocalStaticDestructor g_localStaticDestructor;
-#endif
 };
 
 } // namespace ns3
@@ -125,6 +125,12 @@ private:
    */
   void Add (const ByteTagList &o);
 
+  /**
+   * \returns a copy of this list which does not share its data
+   *          with any other list.
+   */
+  ByteTagList CreateUnsharedCopy (void) const;
+
   void RemoveAll (void);
 
   /**
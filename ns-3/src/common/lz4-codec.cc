@@ -0,0 +1,371 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "lz4-codec.h"
+#include <string.h>
+#include <vector>
+
+namespace ns3 {
+
+namespace {
+
+/**
+ * See https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+ * and lz4_Frame_format.md for the formats. A block is a sequence of
+ * literals and matches: a token with the two lengths, the literals, the
+ * two byte distance of the match and the rest of the lengths. The last
+ * five bytes are always literals, and the last match starts at least
+ * twelve bytes before the end.
+ */
+const uint32_t LZ4_MIN_MATCH = 4;
+const uint32_t LZ4_LAST_LITERALS = 5;
+const uint32_t LZ4_MF_LIMIT = 12;
+const uint32_t LZ4_MAX_DISTANCE = 65535;
+const uint32_t LZ4_HASH_LOG = 12;
+
+const uint32_t LZ4_FRAME_MAGIC = 0x184d2204;
+// version 1, independent blocks, no checksums and no content size
+const uint8_t LZ4_FRAME_FLG = 0x60;
+// blocks of at most 4MiB
+const uint8_t LZ4_FRAME_BD = 0x70;
+// second byte of the xxHash32 of the two bytes above
+const uint8_t LZ4_FRAME_HC = 0x73;
+const uint32_t LZ4_UNCOMPRESSED_BLOCK = 0x80000000;
+
+inline uint32_t
+Lz4Read32 (uint8_t const *p)
+{
+  uint32_t v;
+  memcpy (&v, p, 4);
+  return v;
+}
+
+inline uint32_t
+Lz4Hash (uint32_t sequence)
+{
+  return (sequence * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+inline void
+Lz4WriteLe32 (uint8_t *p, uint32_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+  p[2] = (v >> 16) & 0xff;
+  p[3] = (v >> 24) & 0xff;
+}
+
+inline uint32_t
+Lz4ReadLe32 (uint8_t const *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Writes the rest of a length which did not fit in its four bits.
+ */
+inline uint8_t *
+Lz4WriteLength (uint8_t *op, uint32_t length)
+{
+  for (length -= 15; length >= 255; length -= 255)
+    {
+      *op++ = 255;
+    }
+  *op++ = length;
+  return op;
+}
+
+/**
+ * Reads the rest of a length whose four bits are all set.
+ */
+inline bool
+Lz4ReadLength (uint8_t const *data, uint32_t size, uint32_t *ip, uint32_t *length)
+{
+  uint8_t b;
+  do
+    {
+      if (*ip >= size)
+        {
+          return false;
+        }
+      b = data[(*ip)++];
+      *length += b;
+    }
+  while (b == 255);
+  return true;
+}
+
+inline uint32_t
+Lz4MaxSequenceSize (uint32_t literals, uint32_t matchLength)
+{
+  return 1 + literals / 255 + 1 + literals + 2 + matchLength / 255 + 1;
+}
+
+} // anonymous namespace
+
+const uint32_t Lz4Codec::MAX_BLOCK_SIZE;
+const uint32_t Lz4Codec::FRAME_HEADER_SIZE;
+const uint32_t Lz4Codec::FRAME_END_SIZE;
+
+void
+Lz4Codec::WriteFrameHeader (uint8_t *buffer)
+{
+  Lz4WriteLe32 (buffer, LZ4_FRAME_MAGIC);
+  buffer[4] = LZ4_FRAME_FLG;
+  buffer[5] = LZ4_FRAME_BD;
+  buffer[6] = LZ4_FRAME_HC;
+}
+
+void
+Lz4Codec::WriteFrameEnd (uint8_t *buffer)
+{
+  Lz4WriteLe32 (buffer, 0);
+}
+
+uint32_t
+Lz4Codec::GetMaxCompressedBlockSize (uint32_t size)
+{
+  return 4 + size;
+}
+
+uint32_t
+Lz4Codec::CompressBlock (uint8_t const *data, uint32_t size, uint8_t *buffer)
+{
+  if (size == 0)
+    {
+      // an empty block would be read as the end of the frame
+      return 0;
+    }
+  uint32_t compressed = Compress (data, size, buffer + 4, size);
+  if (compressed == 0 || compressed >= size)
+    {
+      Lz4WriteLe32 (buffer, size | LZ4_UNCOMPRESSED_BLOCK);
+      memcpy (buffer + 4, data, size);
+      return 4 + size;
+    }
+  Lz4WriteLe32 (buffer, compressed);
+  return 4 + compressed;
+}
+
+uint32_t
+Lz4Codec::Compress (uint8_t const *data, uint32_t size, uint8_t *buffer, uint32_t capacity)
+{
+  uint8_t *op = buffer;
+  uint8_t *end = buffer + capacity;
+  uint32_t anchor = 0;
+  if (size > LZ4_MF_LIMIT)
+    {
+      // the last position at which each hash of four bytes was seen
+      uint32_t table[1 << LZ4_HASH_LOG];
+      memset (table, 0, sizeof (table));
+      uint32_t limit = size - LZ4_MF_LIMIT;
+      uint32_t matchLimit = size - LZ4_LAST_LITERALS;
+      uint32_t misses = 0;
+      uint32_t ip = 0;
+      while (ip < limit)
+        {
+          uint32_t sequence = Lz4Read32 (data + ip);
+          uint32_t h = Lz4Hash (sequence);
+          uint32_t ref = table[h];
+          table[h] = ip;
+          if (ref >= ip || ip - ref > LZ4_MAX_DISTANCE || Lz4Read32 (data + ref) != sequence)
+            {
+              // skip faster and faster through data which does not compress
+              ip += 1 + (misses++ >> 6);
+              continue;
+            }
+          misses = 0;
+          while (ip > anchor && ref > 0 && data[ip - 1] == data[ref - 1])
+            {
+              ip--;
+              ref--;
+            }
+          uint32_t length = LZ4_MIN_MATCH;
+          while (ip + length < matchLimit && data[ref + length] == data[ip + length])
+            {
+              length++;
+            }
+
+          uint32_t literals = ip - anchor;
+          uint32_t matchLength = length - LZ4_MIN_MATCH;
+          if (Lz4MaxSequenceSize (literals, matchLength) > (uint32_t)(end - op))
+            {
+              return 0;
+            }
+          uint8_t *token = op++;
+          *token = (literals >= 15 ? 15 : literals) << 4;
+          if (literals >= 15)
+            {
+              op = Lz4WriteLength (op, literals);
+            }
+          memcpy (op, data + anchor, literals);
+          op += literals;
+          uint32_t distance = ip - ref;
+          *op++ = distance & 0xff;
+          *op++ = distance >> 8;
+          *token |= matchLength >= 15 ? 15 : matchLength;
+          if (matchLength >= 15)
+            {
+              op = Lz4WriteLength (op, matchLength);
+            }
+          ip += length;
+          anchor = ip;
+        }
+    }
+
+  uint32_t literals = size - anchor;
+  if (Lz4MaxSequenceSize (literals, 0) > (uint32_t)(end - op))
+    {
+      return 0;
+    }
+  *op++ = (literals >= 15 ? 15 : literals) << 4;
+  if (literals >= 15)
+    {
+      op = Lz4WriteLength (op, literals);
+    }
+  memcpy (op, data + anchor, literals);
+  op += literals;
+  return op - buffer;
+}
+
+bool
+Lz4Codec::Decompress (uint8_t const *data, uint32_t size, uint8_t *buffer, uint32_t capacity,
+                      uint32_t *written)
+{
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  while (true)
+    {
+      if (ip >= size)
+        {
+          return false;
+        }
+      uint8_t token = data[ip++];
+      uint32_t literals = token >> 4;
+      if (literals == 15 && !Lz4ReadLength (data, size, &ip, &literals))
+        {
+          return false;
+        }
+      if (literals > size - ip || literals > capacity - op)
+        {
+          return false;
+        }
+      memcpy (buffer + op, data + ip, literals);
+      ip += literals;
+      op += literals;
+      if (ip == size)
+        {
+          // the last sequence has no match
+          break;
+        }
+
+      if (size - ip < 2)
+        {
+          return false;
+        }
+      uint32_t distance = data[ip] | (data[ip + 1] << 8);
+      ip += 2;
+      if (distance == 0 || distance > op)
+        {
+          return false;
+        }
+      uint32_t length = token & 15;
+      if (length == 15 && !Lz4ReadLength (data, size, &ip, &length))
+        {
+          return false;
+        }
+      length += LZ4_MIN_MATCH;
+      if (length > capacity - op)
+        {
+          return false;
+        }
+      // one byte at a time: a match may overlap the bytes it produces
+      for (uint32_t i = 0; i < length; i++, op++)
+        {
+          buffer[op] = buffer[op - distance];
+        }
+    }
+  *written = op;
+  return true;
+}
+
+bool
+Lz4Codec::DecompressFrame (std::istream &is, std::ostream &os)
+{
+  uint8_t header[6];
+  if (!is.read ((char *)header, 6) || Lz4ReadLe32 (header) != LZ4_FRAME_MAGIC)
+    {
+      return false;
+    }
+  uint8_t flg = header[4];
+  uint8_t bd = header[5];
+  uint32_t blockSizeId = (bd >> 4) & 7;
+  // only version 1 with independent blocks, of 64KiB to 4MiB
+  if ((flg >> 6) != 1 || (flg & 0x20) == 0 || blockSizeId < 4)
+    {
+      return false;
+    }
+  uint32_t maxBlockSize = 1 << (8 + 2 * blockSizeId);
+  bool blockChecksums = flg & 0x10;
+  bool contentSize = flg & 0x08;
+  bool contentChecksum = flg & 0x04;
+  bool dictionaryId = flg & 0x01;
+  // the optional fields and the header checksum are not checked
+  is.ignore ((contentSize ? 8 : 0) + (dictionaryId ? 4 : 0) + 1);
+
+  std::vector<uint8_t> block (maxBlockSize);
+  std::vector<uint8_t> decompressed (maxBlockSize);
+  while (true)
+    {
+      uint8_t sizeBytes[4];
+      if (!is.read ((char *)sizeBytes, 4))
+        {
+          return false;
+        }
+      uint32_t size = Lz4ReadLe32 (sizeBytes);
+      if (size == 0)
+        {
+          break;
+        }
+      bool uncompressed = size & LZ4_UNCOMPRESSED_BLOCK;
+      size &= ~LZ4_UNCOMPRESSED_BLOCK;
+      if (size > maxBlockSize || !is.read ((char *)&block[0], size))
+        {
+          return false;
+        }
+      if (blockChecksums)
+        {
+          is.ignore (4);
+        }
+      if (uncompressed)
+        {
+          os.write ((const char *)&block[0], size);
+          continue;
+        }
+      uint32_t written;
+      if (!Decompress (&block[0], size, &decompressed[0], maxBlockSize, &written))
+        {
+          return false;
+        }
+      os.write ((const char *)&decompressed[0], written);
+    }
+  if (contentChecksum)
+    {
+      is.ignore (4);
+    }
+  return !is.bad ();
+}
+
+} // namespace ns3
@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef LZ4_CODEC_H
+#define LZ4_CODEC_H
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief a fast compressor to the LZ4 frame format
+ *
+ * The output can be read by the lz4 command line tool (lz4 -d) and by
+ * the other LZ4 decoders. A frame is made of a header, of blocks of at
+ * most MAX_BLOCK_SIZE bytes compressed independently from each other,
+ * and of an end mark. The compressor looks for matches through a
+ * single hash table of four byte sequences, like the fast mode of the
+ * reference implementation: it is meant to keep up with the writing of
+ * traces, not to compress as much as possible.
+ */
+class Lz4Codec
+{
+public:
+  static const uint32_t MAX_BLOCK_SIZE = 4 * 1024 * 1024;
+  static const uint32_t FRAME_HEADER_SIZE = 7;
+  static const uint32_t FRAME_END_SIZE = 4;
+
+  /**
+   * \param buffer where to write the FRAME_HEADER_SIZE bytes of the
+   *        header of a frame
+   */
+  static void WriteFrameHeader (uint8_t *buffer);
+  /**
+   * \param buffer where to write the FRAME_END_SIZE bytes of the end
+   *        mark of a frame
+   */
+  static void WriteFrameEnd (uint8_t *buffer);
+  /**
+   * \param size the number of bytes of a block
+   * \returns the size of the buffer which CompressBlock needs for it
+   */
+  static uint32_t GetMaxCompressedBlockSize (uint32_t size);
+  /**
+   * \brief Writes a block of a frame, compressed unless compressing it
+   * would make it larger.
+   *
+   * \param data the bytes of the block
+   * \param size the number of bytes, at most MAX_BLOCK_SIZE
+   * \param buffer where to write the block, of at least
+   *        GetMaxCompressedBlockSize (size) bytes
+   * \returns the number of bytes written
+   */
+  static uint32_t CompressBlock (uint8_t const *data, uint32_t size, uint8_t *buffer);
+  /**
+   * \brief Decompresses a whole frame.
+   *
+   * \param is the frame
+   * \param os where to write the decompressed data
+   * \returns false if the frame is not a valid LZ4 frame
+   */
+  static bool DecompressFrame (std::istream &is, std::ostream &os);
+
+private:
+  static uint32_t Compress (uint8_t const *data, uint32_t size, uint8_t *buffer, uint32_t capacity);
+  static bool Decompress (uint8_t const *data, uint32_t size, uint8_t *buffer, uint32_t capacity,
+                          uint32_t *written);
+};
+
+} // namespace ns3
+
+#endif /* LZ4_CODEC_H */
@@ -0,0 +1,371 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "packet-arena.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#include <pthread.h>
+#endif
+#include <new>
+
+namespace ns3 {
+
+namespace {
+
+/**
+ * Size class c holds blocks of 32 bytes for c = 0, then alternately
+ * of 3 * 2^(n-2) and 2^n bytes, up to 64KiB. The classes up to 8KiB
+ * are carved out of 64KiB chunks which are never given back to the
+ * system; the larger blocks are allocated one by one and given back
+ * when the shared list of their class grows past ARENA_MAX_SHARED_BYTES.
+ */
+const uint32_t ARENA_MIN_SHIFT = 5;
+const uint32_t ARENA_MAX_SHIFT = 16;
+const uint32_t ARENA_CLASSES = 2 * (ARENA_MAX_SHIFT - ARENA_MIN_SHIFT) + 1;
+const uint32_t ARENA_CHUNK_SIZE = 1 << 16;
+const uint32_t ARENA_MAX_CARVED_SIZE = ARENA_CHUNK_SIZE / 8;
+// cached by each thread, per class
+const uint32_t ARENA_MAX_CACHED_BYTES = 256 * 1024;
+const uint32_t ARENA_MIN_CACHED = 8;
+// cached by all threads together, per class of separate blocks
+const uint32_t ARENA_MAX_SHARED_BYTES = 4 * 1024 * 1024;
+
+struct ArenaBlock
+{
+  ArenaBlock *next;
+};
+
+struct ArenaCache
+{
+  ArenaBlock *head[ARENA_CLASSES];
+  uint32_t count[ARENA_CLASSES];
+};
+
+enum ArenaState
+{
+  ARENA_UNKNOWN,
+  ARENA_ENABLED,
+  ARENA_DISABLED
+};
+
+enum ArenaState g_arenaState = ARENA_UNKNOWN;
+ArenaCache g_sharedCache;
+
+// blocks obtained from the system, per class, and bytes in total
+uint64_t g_reservedBlocks[ARENA_CLASSES];
+uint64_t g_peakReservedBlocks[ARENA_CLASSES];
+uint64_t g_reservedBytes = 0;
+uint64_t g_peakReservedBytes = 0;
+
+#ifdef HAVE_PTHREAD_H
+__thread ArenaCache *g_threadCache = 0;
+pthread_once_t g_arenaOnce = PTHREAD_ONCE_INIT;
+pthread_key_t g_arenaKey;
+SystemMutex *g_sharedMutex = 0;
+#else
+ArenaCache g_mainCache;
+ArenaCache *g_threadCache = &g_mainCache;
+#endif
+
+inline uint32_t
+ArenaClass (uint32_t size)
+{
+  if (size <= (1U << ARENA_MIN_SHIFT))
+    {
+      return 0;
+    }
+  // 2^(shift-1) < size <= 2^shift
+  uint32_t shift = 32 - __builtin_clz (size - 1);
+  uint32_t threeQuarters = size <= (3U << (shift - 2)) ? 1 : 0;
+  return 2 * (shift - ARENA_MIN_SHIFT) - threeQuarters;
+}
+
+inline uint32_t
+ArenaClassSize (uint32_t c)
+{
+  if (c % 2 == 1)
+    {
+      return 3U << ((c + 1) / 2 + ARENA_MIN_SHIFT - 2);
+    }
+  return 1U << (c / 2 + ARENA_MIN_SHIFT);
+}
+
+inline uint32_t
+ArenaMaxCached (uint32_t c)
+{
+  uint32_t n = ARENA_MAX_CACHED_BYTES / ArenaClassSize (c);
+  return n > ARENA_MIN_CACHED ? n : ARENA_MIN_CACHED;
+}
+
+void
+ArenaMax (uint64_t *peak, uint64_t value)
+{
+  uint64_t current = *peak;
+  while (value > current && !__sync_bool_compare_and_swap (peak, current, value))
+    {
+      current = *peak;
+    }
+}
+
+/**
+ * Accounts for n blocks of class c (or for bytes without a class when
+ * c is ARENA_CLASSES) obtained from, or given back to, the system.
+ */
+void
+ArenaReserve (uint32_t c, int64_t n, uint64_t bytes)
+{
+  if (c < ARENA_CLASSES)
+    {
+      ArenaMax (&g_peakReservedBlocks[c], __sync_add_and_fetch (&g_reservedBlocks[c], n));
+    }
+  if (n > 0)
+    {
+      ArenaMax (&g_peakReservedBytes, __sync_add_and_fetch (&g_reservedBytes, bytes));
+    }
+  else
+    {
+      __sync_sub_and_fetch (&g_reservedBytes, bytes);
+    }
+}
+
+/**
+ * Moves up to n blocks of size class c from one cache to the other.
+ */
+uint32_t
+ArenaMove (ArenaCache *from, ArenaCache *to, uint32_t c, uint32_t n)
+{
+  uint32_t moved = 0;
+  while (moved < n && from->head[c] != 0)
+    {
+      ArenaBlock *block = from->head[c];
+      from->head[c] = block->next;
+      block->next = to->head[c];
+      to->head[c] = block;
+      moved++;
+    }
+  from->count[c] -= moved;
+  to->count[c] += moved;
+  return moved;
+}
+
+#ifdef HAVE_PTHREAD_H
+void
+ArenaThreadExit (void *data)
+{
+  ArenaCache *cache = static_cast<ArenaCache *> (data);
+  {
+    CriticalSection cs (*g_sharedMutex);
+    for (uint32_t c = 0; c < ARENA_CLASSES; c++)
+      {
+        ArenaMove (cache, &g_sharedCache, c, cache->count[c]);
+      }
+  }
+  delete cache;
+  // the destructors of other thread-specific data may still free
+  // packets: they get a new cache, and come back here
+  g_threadCache = 0;
+}
+
+void
+ArenaInit (void)
+{
+  g_sharedMutex = new SystemMutex ();
+  pthread_key_create (&g_arenaKey, &ArenaThreadExit);
+}
+#endif
+
+ArenaCache *
+ArenaGetCache (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (g_threadCache == 0)
+    {
+      pthread_once (&g_arenaOnce, &ArenaInit);
+      g_threadCache = new ArenaCache ();
+      pthread_setspecific (g_arenaKey, g_threadCache);
+    }
+#endif
+  return g_threadCache;
+}
+
+void
+ArenaRefill (ArenaCache *cache, uint32_t c)
+{
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (*g_sharedMutex);
+#endif
+    if (ArenaMove (&g_sharedCache, cache, c, ArenaMaxCached (c) / 2) > 0)
+      {
+        return;
+      }
+  }
+  uint32_t blockSize = ArenaClassSize (c);
+  uint32_t n = blockSize <= ARENA_MAX_CARVED_SIZE ? ARENA_CHUNK_SIZE / blockSize : 1;
+  uint8_t *chunk = static_cast<uint8_t *> (::operator new (n * blockSize));
+  ArenaReserve (c, n, n * blockSize);
+  // link the blocks in address order
+  for (uint32_t i = n; i > 0; i--)
+    {
+      ArenaBlock *block = reinterpret_cast<ArenaBlock *> (chunk + (i - 1) * blockSize);
+      block->next = cache->head[c];
+      cache->head[c] = block;
+    }
+  cache->count[c] += n;
+}
+
+void
+ArenaRelease (ArenaCache *cache, uint32_t c)
+{
+  ArenaBlock *surplus = 0;
+  uint32_t blockSize = ArenaClassSize (c);
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (*g_sharedMutex);
+#endif
+    ArenaMove (cache, &g_sharedCache, c, ArenaMaxCached (c) / 2);
+    if (blockSize > ARENA_MAX_CARVED_SIZE)
+      {
+        ArenaCache surplusCache;
+        surplusCache.head[c] = 0;
+        surplusCache.count[c] = 0;
+        uint32_t maxShared = ARENA_MAX_SHARED_BYTES / blockSize;
+        if (g_sharedCache.count[c] > maxShared)
+          {
+            ArenaMove (&g_sharedCache, &surplusCache, c, g_sharedCache.count[c] - maxShared);
+          }
+        surplus = surplusCache.head[c];
+      }
+  }
+  while (surplus != 0)
+    {
+      ArenaBlock *next = surplus->next;
+      ::operator delete (surplus);
+      ArenaReserve (c, -1, blockSize);
+      surplus = next;
+    }
+}
+
+bool
+ArenaIsEnabled (void)
+{
+  if (g_arenaState == ARENA_UNKNOWN)
+    {
+      // the first packets are created by the static constructors of
+      // the test suites, maybe before those of this file
+      static GlobalValue packetArena = GlobalValue ("PacketArena",
+        "Allocate the packet buffers, metadata and tags from per-thread free lists "
+        "instead of the general purpose heap. Read once, when the first packet is "
+        "created, which is while the library loads: set it from NS_GLOBAL_VALUE.",
+        BooleanValue (true),
+        MakeBooleanChecker ());
+      BooleanValue enabled;
+      packetArena.GetValue (enabled);
+      g_arenaState = enabled.Get () ? ARENA_ENABLED : ARENA_DISABLED;
+    }
+  return g_arenaState == ARENA_ENABLED;
+}
+
+} // anonymous namespace
+
+bool
+PacketArena::IsEnabled (void)
+{
+  return ArenaIsEnabled ();
+}
+
+uint32_t
+PacketArena::GetBlockSize (uint32_t size)
+{
+  uint32_t c = ArenaClass (size);
+  if (c >= ARENA_CLASSES || !ArenaIsEnabled ())
+    {
+      return size;
+    }
+  return ArenaClassSize (c);
+}
+
+void *
+PacketArena::Allocate (uint32_t size)
+{
+  uint32_t c = ArenaClass (size);
+  if (c >= ARENA_CLASSES || !ArenaIsEnabled ())
+    {
+      ArenaReserve (ARENA_CLASSES, 1, size);
+      return ::operator new (size);
+    }
+  ArenaCache *cache = ArenaGetCache ();
+  if (cache->head[c] == 0)
+    {
+      ArenaRefill (cache, c);
+    }
+  ArenaBlock *block = cache->head[c];
+  cache->head[c] = block->next;
+  cache->count[c]--;
+  return block;
+}
+
+void
+PacketArena::Deallocate (void *block, uint32_t size)
+{
+  uint32_t c = ArenaClass (size);
+  if (c >= ARENA_CLASSES || g_arenaState != ARENA_ENABLED)
+    {
+      ArenaReserve (ARENA_CLASSES, -1, size);
+      ::operator delete (block);
+      return;
+    }
+  ArenaCache *cache = ArenaGetCache ();
+  ArenaBlock *b = static_cast<ArenaBlock *> (block);
+  b->next = cache->head[c];
+  cache->head[c] = b;
+  cache->count[c]++;
+  if (cache->count[c] > ArenaMaxCached (c))
+    {
+      ArenaRelease (cache, c);
+    }
+}
+
+uint64_t
+PacketArena::GetReservedBytes (void)
+{
+  return g_reservedBytes;
+}
+
+uint64_t
+PacketArena::GetPeakReservedBytes (void)
+{
+  return g_peakReservedBytes;
+}
+
+void
+PacketArena::PrintStats (std::ostream &os)
+{
+  os << "reserved " << g_reservedBytes << " bytes, peak " << g_peakReservedBytes << " bytes" << std::endl;
+  for (uint32_t c = 0; c < ARENA_CLASSES; c++)
+    {
+      if (g_peakReservedBlocks[c] == 0)
+        {
+          continue;
+        }
+      os << "  " << ArenaClassSize (c) << " bytes: " << g_reservedBlocks[c] << " blocks, peak "
+         << g_peakReservedBlocks[c] << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PACKET_ARENA_H
+#define PACKET_ARENA_H
+
+#include <stdint.h>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief memory of the Buffer, PacketMetadata, ByteTagList and
+ * PacketTagList data structures.
+ *
+ * Blocks are rounded up to a size class, two per power of two from 32
+ * bytes to 64KiB, and recycled through per-thread free lists so that
+ * packets are created and destroyed without taking a lock, from as many
+ * threads as the simulator uses. A thread which frees more blocks of a
+ * class than it allocates, such as the receiver of packets sent by
+ * another thread, hands the surplus over to a shared list from which
+ * the other threads refill, and so does a thread which exits. Larger
+ * blocks come straight from the system.
+ *
+ * The "PacketArena" global value turns the free lists off, for
+ * comparison and for memory checkers. It is read when the first block
+ * is allocated, by the static constructors of the test suites, so it
+ * can only be set from the NS_GLOBAL_VALUE environment variable:
+ * NS_GLOBAL_VALUE=PacketArena=false
+ */
+class PacketArena
+{
+public:
+  /**
+   * \returns whether the blocks are recycled by the free lists
+   */
+  static bool IsEnabled (void);
+  /**
+   * \param size the number of bytes needed
+   * \returns the number of bytes of the block which Allocate returns
+   *          for size, which callers may use in full.
+   */
+  static uint32_t GetBlockSize (uint32_t size);
+  /**
+   * \param size the number of bytes needed
+   * \returns a block of GetBlockSize (size) bytes, aligned for any type
+   */
+  static void *Allocate (uint32_t size);
+  /**
+   * \param block a block returned by Allocate
+   * \param size the size passed to Allocate, or any size between that
+   *        one and the block size
+   */
+  static void Deallocate (void *block, uint32_t size);
+
+  /**
+   * \returns the number of bytes currently obtained from the system,
+   *          whether in use or in a free list
+   */
+  static uint64_t GetReservedBytes (void);
+  /**
+   * \returns the high-water mark of GetReservedBytes
+   */
+  static uint64_t GetPeakReservedBytes (void);
+  /**
+   * \brief Writes the current and peak number of blocks obtained from
+   * the system for every size class which was used.
+   */
+  static void PrintStats (std::ostream &os);
+};
+
+} // namespace ns3
+
+#endif /* PACKET_ARENA_H */
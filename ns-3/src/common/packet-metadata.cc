@@ -19,10 +19,12 @@
  */
 #include <utility>
 #include <list>
+#include <algorithm>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include "packet-metadata.h"
+#include "packet-arena.h"
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -36,16 +38,6 @@ bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
 
 void 
 PacketMetadata::Enable (void)
@@ -525,19 +517,6 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
   NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
 }
@@ -545,22 +524,9 @@ PacketMetadata::Create (uint32_t size)
 void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
+  NS_LOG_LOGIC ("recycle size="<<data->m_size);
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
+  PacketMetadata::Deallocate (data);
 }
 
 struct PacketMetadata::Data *
@@ -571,9 +537,10 @@ PacketMetadata::Allocate (uint32_t n)
     {
       n = 10;
     }
-  size += n - 10;
-  uint8_t *buf = new uint8_t [size];
-  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
+  size = PacketArena::GetBlockSize (size + n - 10);
+  // the rest of the block is usable as well, as far as m_size can tell
+  n = std::min (size - sizeof (struct Data) + 10, (size_t)0xffff);
+  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)PacketArena::Allocate (size);
   data->m_size = n;
   data->m_count = 1;
   data->m_dirtyEnd = 0;
@@ -582,8 +549,7 @@ PacketMetadata::Allocate (uint32_t n)
 void 
 PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  PacketArena::Deallocate (data, sizeof (struct Data) + data->m_size - 10);
 }
 
 
@@ -596,6 +562,14 @@ PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
   return fragment;
 }
 
+PacketMetadata
+PacketMetadata::CreateUnsharedCopy (void) const
+{
+  PacketMetadata copy = *this;
+  copy.ReserveCopy (0);
+  return copy;
+}
+
 void 
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
@@ -146,6 +146,11 @@ private:
    * and then, RemoveAtEnd (end).
    */
   PacketMetadata CreateFragment (uint32_t start, uint32_t end) const;
+  /**
+   * \returns a copy of this metadata which does not share its data
+   *          with any other metadata.
+   */
+  PacketMetadata CreateUnsharedCopy (void) const;
   void AddAtEnd (PacketMetadata const&o);
   void AddPaddingAtEnd (uint32_t end);
   void RemoveAtStart (uint32_t start);
@@ -284,13 +289,6 @@ private:
     uint64_t packetUid;
   };
 
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
-  };
-
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -324,7 +322,6 @@ public:
   static struct PacketMetadata::Data *Allocate (uint32_t n);
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList;
   static bool m_enable;
   static bool m_enableChecking;
 
@@ -20,68 +20,31 @@
 #include "packet-tag-list.h"
 #include "tag-buffer.h"
 #include "tag.h"
+#include "packet-arena.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include <string.h>
+#include <new>
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
 namespace ns3 {
 
-#ifdef USE_FREE_LIST
-
-struct PacketTagList::TagData *PacketTagList::g_free = 0;
-uint32_t PacketTagList::g_nfree = 0;
-
-struct PacketTagList::TagData *
-PacketTagList::AllocData (void) const
-{
-  NS_LOG_FUNCTION (g_nfree);
-  struct PacketTagList::TagData *retval;
-  if (g_free != 0) 
-    {
-      retval = g_free;
-      g_free = g_free->m_next;
-      g_nfree--;
-    } 
-  else 
-    {
-      retval = new struct PacketTagList::TagData ();
-    }
-  return retval;
-}
-
-void
-PacketTagList::FreeData (struct TagData *data) const
-{
-  NS_LOG_FUNCTION (g_nfree << data);
-  if (g_nfree > 1000) 
-    {
-      delete data;
-      return;
-    }
-  g_nfree++;
-  data->next = g_free;
-  data->tid = TypeId ();
-  g_free = data;
-}
-#else
 struct PacketTagList::TagData *
 PacketTagList::AllocData (void) const
 {
   NS_LOG_FUNCTION_NOARGS ();
-  struct PacketTagList::TagData *retval;
-  retval = new struct PacketTagList::TagData ();
-  return retval;
+  void *block = PacketArena::Allocate (sizeof (struct PacketTagList::TagData));
+  return new (block) struct PacketTagList::TagData ();
 }
 
 void
 PacketTagList::FreeData (struct TagData *data) const
 {
   NS_LOG_FUNCTION (data);
-  delete data;
+  data->~TagData ();
+  PacketArena::Deallocate (data, sizeof (struct PacketTagList::TagData));
 }
-#endif
 
 bool
 PacketTagList::Remove (Tag &tag)
@@ -167,6 +130,25 @@ PacketTagList::Peek (Tag &tag) const
   return false;
 }
 
+PacketTagList
+PacketTagList::CreateUnsharedCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketTagList copy;
+  struct TagData **prevNext = &copy.m_next;
+  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData *data = AllocData ();
+      memcpy (data->data, cur->data, PACKET_TAG_MAX_SIZE);
+      data->tid = cur->tid;
+      data->count = 1;
+      data->next = 0;
+      *prevNext = data;
+      prevNext = &data->next;
+    }
+  return copy;
+}
+
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
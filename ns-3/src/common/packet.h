@@ -372,6 +372,15 @@ public:
    * same datasets internally.
    */
   Ptr<Packet> Copy (void) const;
+  /**
+   * \returns a copy of the packet which shares no dataset with it.
+   *
+   * Unlike the copies made by Copy, the returned packet and this
+   * packet can then be used concurrently from two threads, which is
+   * what the MultithreadedSimulatorImpl needs when a packet crosses
+   * from one partition to another.
+   */
+  Ptr<Packet> CreateUnsharedCopy (void) const;
 
   /**
    * A packet is allocated a new uid when it is created
@@ -566,6 +575,8 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector;
 
+  static uint32_t AllocateUid (void);
+
   static uint32_t m_globalUid;
 };
 
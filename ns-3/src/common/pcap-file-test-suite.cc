@@ -21,9 +21,14 @@
 #include <stdlib.h>
 #include <sstream>
 #include <cstring>
+#include <fstream>
+#include <algorithm>
 
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcap-writer.h"
+#include "ns3/lz4-codec.h"
+#include "ns3/packet.h"
 
 using namespace ns3;
 
@@ -1115,6 +1120,214 @@ DiffTestCase::DoRun (void)
   return GetErrorStatus();
 }
 
+// ===========================================================================
+// Test case to make sure that the LZ4 blocks decompress to what was
+// compressed, whether the data compresses well, badly or not at all.
+// ===========================================================================
+class Lz4CodecTestCase : public TestCase
+{
+public:
+  Lz4CodecTestCase ();
+  virtual ~Lz4CodecTestCase ();
+
+private:
+  virtual bool DoRun (void);
+  bool RoundTrip (std::string const &data);
+};
+
+Lz4CodecTestCase::Lz4CodecTestCase ()
+  : TestCase ("Check to see that Lz4Codec frames decompress to their data")
+{
+}
+
+Lz4CodecTestCase::~Lz4CodecTestCase ()
+{
+}
+
+bool
+Lz4CodecTestCase::RoundTrip (std::string const &data)
+{
+  std::string frame (Lz4Codec::FRAME_HEADER_SIZE, 0);
+  Lz4Codec::WriteFrameHeader ((uint8_t *)&frame[0]);
+  uint32_t offset = 0;
+  while (offset < data.size ())
+    {
+      uint32_t size = std::min<uint32_t> (data.size () - offset, Lz4Codec::MAX_BLOCK_SIZE);
+      std::string block (Lz4Codec::GetMaxCompressedBlockSize (size), 0);
+      uint32_t written = Lz4Codec::CompressBlock ((uint8_t const *)data.data () + offset, size,
+                                                  (uint8_t *)&block[0]);
+      frame.append (block, 0, written);
+      offset += size;
+    }
+  std::string end (Lz4Codec::FRAME_END_SIZE, 0);
+  Lz4Codec::WriteFrameEnd ((uint8_t *)&end[0]);
+  frame += end;
+
+  std::istringstream is (frame);
+  std::ostringstream os;
+  NS_TEST_ASSERT_MSG_EQ (Lz4Codec::DecompressFrame (is, os), true, "Cannot decompress a frame");
+  NS_TEST_ASSERT_MSG_EQ ((os.str () == data), true, "Frame of " << data.size () << " bytes decompresses to different data");
+  return false;
+}
+
+bool
+Lz4CodecTestCase::DoRun (void)
+{
+  RoundTrip ("");
+  RoundTrip ("a");
+  RoundTrip ("0123456789abcdef");
+  RoundTrip (std::string (100000, 0));
+
+  std::string text;
+  for (uint32_t i = 0; i < 5000; ++i)
+    {
+      std::ostringstream oss;
+      oss << "packet " << i << " from 10.1.1." << i % 7 << " to 10.1.2." << i % 13 << "; ";
+      text += oss.str ();
+    }
+  RoundTrip (text);
+
+  std::string random (300000, 0);
+  uint32_t seed = 12345;
+  for (uint32_t i = 0; i < random.size (); ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      random[i] = seed >> 24;
+    }
+  RoundTrip (random);
+
+  // more than a block, with a run which crosses the end of the first one
+  std::string large = random + std::string (Lz4Codec::MAX_BLOCK_SIZE, 'x') + text;
+  RoundTrip (large);
+
+  return GetErrorStatus ();
+}
+
+// ===========================================================================
+// Test case to make sure that a PcapWriter writes the same file as a
+// PcapFile, whether it writes from a background thread or not, and that
+// its compressed files decompress to that same file.
+// ===========================================================================
+class PcapWriterTestCase : public TestCase
+{
+public:
+  PcapWriterTestCase ();
+  virtual ~PcapWriterTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual bool DoRun (void);
+  virtual void DoTeardown (void);
+
+  void WriteRecords (PcapFile *file, PcapWriter *writer);
+  std::string ReadFile (std::string const &filename);
+
+  std::string m_testFilename;
+};
+
+PcapWriterTestCase::PcapWriterTestCase ()
+  : TestCase ("Check to see that PcapWriter writes the same records as PcapFile")
+{
+}
+
+PcapWriterTestCase::~PcapWriterTestCase ()
+{
+}
+
+void
+PcapWriterTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = GetTempDir () + filename.str () + ".pcap";
+}
+
+void
+PcapWriterTestCase::DoTeardown (void)
+{
+  remove (m_testFilename.c_str ());
+  remove ((m_testFilename + ".writer").c_str ());
+}
+
+void
+PcapWriterTestCase::WriteRecords (PcapFile *file, PcapWriter *writer)
+{
+  uint8_t data[2000];
+  for (uint32_t i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = i % 37;
+    }
+  for (uint32_t i = 0; i < 3000; ++i)
+    {
+      // some records are cut by the snap length of 1000 bytes
+      uint32_t size = (i * 97) % sizeof (data);
+      Ptr<Packet> p = Create<Packet> (data, size);
+      if (file != 0)
+        {
+          file->Write (i, i * 10, data, size);
+          file->Write (i, i * 10 + 1, p);
+        }
+      else
+        {
+          writer->Write (i, i * 10, data, size);
+          writer->Write (i, i * 10 + 1, p);
+        }
+    }
+}
+
+std::string
+PcapWriterTestCase::ReadFile (std::string const &filename)
+{
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream os;
+  os << is.rdbuf ();
+  return os.str ();
+}
+
+bool
+PcapWriterTestCase::DoRun (void)
+{
+  PcapFile f;
+  f.Open (m_testFilename, std::ios::out);
+  f.Init (1, 1000, 7);
+  WriteRecords (&f, 0);
+  f.Close ();
+  std::string expected = ReadFile (m_testFilename);
+
+  std::string writerFilename = m_testFilename + ".writer";
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      bool compress = i & 1;
+      bool background = i & 2;
+      PcapWriter writer;
+      // small buffers, so that records straddle them and some do not fit
+      writer.Open (writerFilename, 1500, compress, background);
+      NS_TEST_ASSERT_MSG_EQ (writer.Fail (), false, "Open (" << writerFilename << ") returns error");
+      writer.Init (1, 1000, 7);
+      NS_TEST_ASSERT_MSG_EQ (writer.GetSnapLen (), 1000, "Snap length not kept");
+      WriteRecords (0, &writer);
+      writer.Close ();
+      NS_TEST_ASSERT_MSG_EQ (writer.Fail (), false, "Write returns error");
+
+      std::string written = ReadFile (writerFilename);
+      if (compress)
+        {
+          std::istringstream is (written);
+          std::ostringstream os;
+          NS_TEST_ASSERT_MSG_EQ (Lz4Codec::DecompressFrame (is, os), true, "Cannot decompress " << writerFilename);
+          NS_TEST_ASSERT_MSG_EQ ((written.size () < expected.size ()), true, "Records do not compress");
+          written = os.str ();
+        }
+      NS_TEST_ASSERT_MSG_EQ (written.size (), expected.size (), "Different file size with compress=" << compress <<
+                             " background=" << background);
+      NS_TEST_ASSERT_MSG_EQ ((written == expected), true, "Different records with compress=" << compress <<
+                             " background=" << background);
+    }
+
+  return GetErrorStatus ();
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1131,6 +1344,8 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase);
   AddTestCase (new ReadFileTestCase);
   AddTestCase (new DiffTestCase);
+  AddTestCase (new Lz4CodecTestCase);
+  AddTestCase (new PcapWriterTestCase);
 }
 
 PcapFileTestSuite pcapFileTestSuite;
@@ -18,10 +18,12 @@
 
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 
 #include "buffer.h"
 #include "header.h"
 #include "pcap-file-wrapper.h"
+#include "lz4-codec.h"
 
 NS_LOG_COMPONENT_DEFINE ("PcapFileWrapper");
 
@@ -29,6 +31,9 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (PcapFileWrapper);
 
+// the buffer size of compressed files when WriteBufferSize is 0
+static const uint32_t COMPRESS_BUFFER_SIZE_DEFAULT = 1024 * 1024;
+
 TypeId 
 PcapFileWrapper::GetTypeId (void)
 {
@@ -40,12 +45,30 @@ PcapFileWrapper::GetTypeId (void)
                    UintegerValue (PcapFile::SNAPLEN_DEFAULT),
                    MakeUintegerAccessor (&PcapFileWrapper::m_snapLen),
                    MakeUintegerChecker<uint32_t> (0, PcapFile::SNAPLEN_DEFAULT))
+    .AddAttribute ("WriteBufferSize",
+                   "Number of bytes of records to collect before writing them to the file, "
+                   "0 to write each record as it comes",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_writeBufferSize),
+                   MakeUintegerChecker<uint32_t> (0, Lz4Codec::MAX_BLOCK_SIZE))
+    .AddAttribute ("Compress",
+                   "Write the records as an LZ4 frame, to a file whose name ends with .lz4 "
+                   "(by buffers of WriteBufferSize bytes, or 1MiB)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_compress),
+                   MakeBooleanChecker ())
+    .AddAttribute ("BackgroundFlush",
+                   "Write the buffered records from a background thread",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_backgroundFlush),
+                   MakeBooleanChecker ())
     ;
   return tid;
 }
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_writer (0)
 {
 }
 
@@ -58,11 +81,19 @@ PcapFileWrapper::~PcapFileWrapper ()
 bool 
 PcapFileWrapper::Fail (void) const
 {
+  if (m_writer != 0)
+    {
+      return m_writer->Fail ();
+    }
   return m_file.Fail ();
 }
 bool 
 PcapFileWrapper::Eof (void) const
 {
+  if (m_writer != 0)
+    {
+      return false;
+    }
   return m_file.Eof ();
 }
 void 
@@ -74,12 +105,26 @@ PcapFileWrapper::Clear (void)
 void
 PcapFileWrapper::Close (void)
 {
+  if (m_writer != 0)
+    {
+      m_writer->Close ();
+      delete m_writer;
+      m_writer = 0;
+    }
   m_file.Close ();
 }
 
 void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
+  if ((mode & std::ios::out) && !(mode & std::ios::in) && (m_writeBufferSize > 0 || m_compress))
+    {
+      NS_ASSERT (m_writer == 0);
+      uint32_t bufferSize = m_writeBufferSize > 0 ? m_writeBufferSize : COMPRESS_BUFFER_SIZE_DEFAULT;
+      m_writer = new PcapWriter ();
+      m_writer->Open (m_compress ? filename + ".lz4" : filename, bufferSize, m_compress, m_backgroundFlush);
+      return;
+    }
   m_file.Open (filename, mode);
 }
 
@@ -91,13 +136,17 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
   // this happens, we use the "CaptureSize" Attribute.  If the user does provide
   // a snaplen, we use the one provided.
   //
-  if (snapLen != std::numeric_limits<uint32_t>::max ())
+  if (snapLen == std::numeric_limits<uint32_t>::max ())
     {
-      m_file.Init (dataLinkType, snapLen, tzCorrection);
-    } 
+      snapLen = m_snapLen;
+    }
+  if (m_writer != 0)
+    {
+      m_writer->Init (dataLinkType, snapLen, tzCorrection);
+    }
   else
     {
-      m_file.Init (dataLinkType, m_snapLen, tzCorrection);
+      m_file.Init (dataLinkType, snapLen, tzCorrection);
     } 
 }
 
@@ -108,6 +157,11 @@ PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
+  if (m_writer != 0)
+    {
+      m_writer->Write (s, us, p);
+      return;
+    }
   m_file.Write (s, us, p);
 }
 
@@ -118,6 +172,11 @@ PcapFileWrapper::Write (Time t, Header &header, Ptr<const Packet> p)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
+  if (m_writer != 0)
+    {
+      m_writer->Write (s, us, header, p);
+      return;
+    }
   m_file.Write (s, us, header, p);
 }
 
@@ -128,48 +187,81 @@ PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
+  if (m_writer != 0)
+    {
+      m_writer->Write (s, us, buffer, length);
+      return;
+    }
   m_file.Write (s, us, buffer, length);
 }
 
 uint32_t
 PcapFileWrapper::GetMagic (void)
 {
+  if (m_writer != 0)
+    {
+      return m_writer->GetMagic ();
+    }
   return m_file.GetMagic ();
 }
 
 uint16_t
 PcapFileWrapper::GetVersionMajor (void)
 {
+  if (m_writer != 0)
+    {
+      return m_writer->GetVersionMajor ();
+    }
   return m_file.GetVersionMajor ();
 }
 
 uint16_t
 PcapFileWrapper::GetVersionMinor (void)
 {
+  if (m_writer != 0)
+    {
+      return m_writer->GetVersionMinor ();
+    }
   return m_file.GetVersionMinor ();
 }
 
 int32_t
 PcapFileWrapper::GetTimeZoneOffset (void)
 {
+  if (m_writer != 0)
+    {
+      return m_writer->GetTimeZoneOffset ();
+    }
   return m_file.GetTimeZoneOffset ();
 }
 
 uint32_t
 PcapFileWrapper::GetSigFigs (void)
 {
+  if (m_writer != 0)
+    {
+      return m_writer->GetSigFigs ();
+    }
   return m_file.GetSigFigs ();
 }
 
 uint32_t
 PcapFileWrapper::GetSnapLen (void)
 {
+  if (m_writer != 0)
+    {
+      return m_writer->GetSnapLen ();
+    }
   return m_file.GetSnapLen ();
 }
 
 uint32_t
 PcapFileWrapper::GetDataLinkType (void)
 {
+  if (m_writer != 0)
+    {
+      return m_writer->GetDataLinkType ();
+    }
   return m_file.GetDataLinkType ();
 }
 
@@ -27,6 +27,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "pcap-file.h"
+#include "pcap-writer.h"
 
 namespace ns3 {
 
@@ -35,6 +36,12 @@ namespace ns3 {
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * With the "WriteBufferSize" or "Compress" attributes, files opened for
+ * writing go through a PcapWriter instead, which collects the records
+ * in large buffers and writes them, possibly compressed, from a
+ * background thread.  The records only reach the file when the buffer
+ * is full or when the file is closed.
  */
 class PcapFileWrapper : public Object
 {
@@ -197,6 +204,11 @@ public:
 private:
   PcapFile m_file;
   uint32_t m_snapLen;
+  // the file opened for writing, when buffered
+  PcapWriter *m_writer;
+  uint32_t m_writeBufferSize;
+  bool m_compress;
+  bool m_backgroundFlush;
 };
 
 } //namespace ns3
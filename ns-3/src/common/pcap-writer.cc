@@ -0,0 +1,441 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "pcap-writer.h"
+#include "lz4-codec.h"
+#include "packet.h"
+#include "header.h"
+#include "buffer.h"
+#include "ns3/assert.h"
+#include "ns3/core-config.h"
+#include <string.h>
+#include <algorithm>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#include <deque>
+#endif
+
+namespace ns3 {
+
+namespace {
+
+const uint32_t PCAP_MAGIC = 0xa1b2c3d4;
+const uint16_t PCAP_VERSION_MAJOR = 2;
+const uint16_t PCAP_VERSION_MINOR = 4;
+const uint32_t PCAP_FILE_HEADER_SIZE = 24;
+const uint32_t PCAP_RECORD_HEADER_SIZE = 16;
+// the full buffers of all the writers waiting for the background thread
+const uint64_t PCAP_MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+inline uint8_t *
+PcapWriteLe16 (uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+inline uint8_t *
+PcapWriteLe32 (uint8_t *p, uint32_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+  p[2] = (v >> 16) & 0xff;
+  p[3] = (v >> 24) & 0xff;
+  return p + 4;
+}
+
+} // anonymous namespace
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * The thread which writes the full buffers of all the writers, in the
+ * order in which they are handed over. It is started by the first
+ * writer and waits for more buffers until the process exits.
+ */
+class PcapWriter::FlushThread
+{
+public:
+  static FlushThread *Get (void);
+  /**
+   * \brief Queues a buffer, after waiting for the queue to shrink if it
+   * is full.
+   */
+  void Submit (PcapWriter *writer, uint8_t *data, uint32_t size);
+  /**
+   * \brief Waits until all the buffers of the writer are written.
+   */
+  void Wait (PcapWriter *writer);
+
+private:
+  struct Job
+  {
+    PcapWriter *writer;
+    uint8_t *data;
+    uint32_t size;
+  };
+
+  FlushThread ();
+  static void Create (void);
+  static void *Run (void *thread);
+  void DoRun (void);
+
+  std::deque<Job> m_jobs;
+  uint64_t m_queuedBytes;
+  pthread_mutex_t m_mutex;
+  pthread_cond_t m_submitted;
+  pthread_cond_t m_written;
+
+  static FlushThread *g_thread;
+  static pthread_once_t g_once;
+};
+
+PcapWriter::FlushThread *PcapWriter::FlushThread::g_thread = 0;
+pthread_once_t PcapWriter::FlushThread::g_once = PTHREAD_ONCE_INIT;
+
+PcapWriter::FlushThread::FlushThread ()
+  : m_queuedBytes (0)
+{
+  pthread_mutex_init (&m_mutex, 0);
+  pthread_cond_init (&m_submitted, 0);
+  pthread_cond_init (&m_written, 0);
+}
+
+void
+PcapWriter::FlushThread::Create (void)
+{
+  g_thread = new FlushThread ();
+  pthread_t thread;
+  int error = pthread_create (&thread, 0, &FlushThread::Run, g_thread);
+  NS_ASSERT_MSG (error == 0, "Cannot create the pcap flush thread");
+  pthread_detach (thread);
+}
+
+PcapWriter::FlushThread *
+PcapWriter::FlushThread::Get (void)
+{
+  pthread_once (&g_once, &FlushThread::Create);
+  return g_thread;
+}
+
+void *
+PcapWriter::FlushThread::Run (void *thread)
+{
+  static_cast<FlushThread *> (thread)->DoRun ();
+  return 0;
+}
+
+void
+PcapWriter::FlushThread::DoRun (void)
+{
+  pthread_mutex_lock (&m_mutex);
+  while (true)
+    {
+      while (m_jobs.empty ())
+        {
+          pthread_cond_wait (&m_submitted, &m_mutex);
+        }
+      Job job = m_jobs.front ();
+      m_jobs.pop_front ();
+      pthread_mutex_unlock (&m_mutex);
+      job.writer->WriteOut (job.data, job.size);
+      pthread_mutex_lock (&m_mutex);
+      m_queuedBytes -= job.size;
+      job.writer->m_pending--;
+      pthread_cond_broadcast (&m_written);
+    }
+}
+
+void
+PcapWriter::FlushThread::Submit (PcapWriter *writer, uint8_t *data, uint32_t size)
+{
+  pthread_mutex_lock (&m_mutex);
+  while (m_queuedBytes > 0 && m_queuedBytes + size > PCAP_MAX_QUEUED_BYTES)
+    {
+      pthread_cond_wait (&m_written, &m_mutex);
+    }
+  Job job;
+  job.writer = writer;
+  job.data = data;
+  job.size = size;
+  m_jobs.push_back (job);
+  m_queuedBytes += size;
+  writer->m_pending++;
+  pthread_cond_signal (&m_submitted);
+  pthread_mutex_unlock (&m_mutex);
+}
+
+void
+PcapWriter::FlushThread::Wait (PcapWriter *writer)
+{
+  pthread_mutex_lock (&m_mutex);
+  while (writer->m_pending > 0)
+    {
+      pthread_cond_wait (&m_written, &m_mutex);
+    }
+  pthread_mutex_unlock (&m_mutex);
+}
+#endif /* HAVE_PTHREAD_H */
+
+PcapWriter::PcapWriter ()
+  : m_compress (false),
+    m_background (false),
+    m_fail (false),
+    m_bufferSize (0),
+    m_buffer (0),
+    m_capacity (0),
+    m_used (0),
+    m_pending (0),
+    m_zone (0),
+    m_snapLen (0),
+    m_dataLinkType (0)
+{
+}
+
+PcapWriter::~PcapWriter ()
+{
+  Close ();
+}
+
+void
+PcapWriter::Open (std::string const &filename, uint32_t bufferSize, bool compress, bool background)
+{
+  NS_ASSERT (!m_file.is_open ());
+  NS_ASSERT (bufferSize > 0 && bufferSize <= Lz4Codec::MAX_BLOCK_SIZE);
+  m_bufferSize = bufferSize;
+  m_capacity = bufferSize;
+  m_compress = compress;
+#ifdef HAVE_PTHREAD_H
+  m_background = background;
+#else
+  m_background = false;
+#endif
+  m_fail = false;
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open ())
+    {
+      m_fail = true;
+      return;
+    }
+  if (m_compress)
+    {
+      uint8_t header[Lz4Codec::FRAME_HEADER_SIZE];
+      Lz4Codec::WriteFrameHeader (header);
+      m_file.write ((const char *)header, sizeof (header));
+    }
+}
+
+bool
+PcapWriter::Fail (void) const
+{
+  return m_fail;
+}
+
+void
+PcapWriter::Close (void)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  Flush ();
+#ifdef HAVE_PTHREAD_H
+  if (m_background)
+    {
+      FlushThread::Get ()->Wait (this);
+    }
+#endif
+  if (m_compress)
+    {
+      uint8_t end[Lz4Codec::FRAME_END_SIZE];
+      Lz4Codec::WriteFrameEnd (end);
+      m_file.write ((const char *)end, sizeof (end));
+    }
+  m_file.close ();
+  delete [] m_buffer;
+  m_buffer = 0;
+  std::vector<uint8_t> ().swap (m_compressed);
+}
+
+uint8_t *
+PcapWriter::Reserve (uint32_t size)
+{
+  if (m_used + size > m_capacity)
+    {
+      Flush ();
+    }
+  if (size > m_capacity)
+    {
+      // a record larger than a buffer gets a buffer of its own
+      NS_ASSERT (!m_compress || size <= Lz4Codec::MAX_BLOCK_SIZE);
+      m_capacity = size;
+    }
+  if (m_buffer == 0)
+    {
+      m_buffer = new uint8_t [m_capacity];
+    }
+  uint8_t *start = m_buffer + m_used;
+  m_used += size;
+  return start;
+}
+
+void
+PcapWriter::Flush (void)
+{
+  if (m_used == 0)
+    {
+      return;
+    }
+  uint8_t *data = m_buffer;
+  uint32_t size = m_used;
+  m_buffer = 0;
+  m_used = 0;
+  m_capacity = m_bufferSize;
+#ifdef HAVE_PTHREAD_H
+  if (m_background)
+    {
+      FlushThread::Get ()->Submit (this, data, size);
+      return;
+    }
+#endif
+  WriteOut (data, size);
+}
+
+void
+PcapWriter::WriteOut (uint8_t *data, uint32_t size)
+{
+  if (m_compress)
+    {
+      m_compressed.resize (Lz4Codec::GetMaxCompressedBlockSize (size));
+      uint32_t compressed = Lz4Codec::CompressBlock (data, size, &m_compressed[0]);
+      m_file.write ((const char *)&m_compressed[0], compressed);
+    }
+  else
+    {
+      m_file.write ((const char *)data, size);
+    }
+  if (!m_file)
+    {
+      m_fail = true;
+    }
+  delete [] data;
+}
+
+void
+PcapWriter::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t timeZoneCorrection)
+{
+  m_dataLinkType = dataLinkType;
+  m_snapLen = snapLen;
+  m_zone = timeZoneCorrection;
+
+  uint8_t *p = Reserve (PCAP_FILE_HEADER_SIZE);
+  p = PcapWriteLe32 (p, PCAP_MAGIC);
+  p = PcapWriteLe16 (p, PCAP_VERSION_MAJOR);
+  p = PcapWriteLe16 (p, PCAP_VERSION_MINOR);
+  p = PcapWriteLe32 (p, m_zone);
+  p = PcapWriteLe32 (p, 0);
+  p = PcapWriteLe32 (p, m_snapLen);
+  p = PcapWriteLe32 (p, m_dataLinkType);
+}
+
+uint8_t *
+PcapWriter::WriteRecordHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t inclLen, uint32_t totalLen)
+{
+  uint8_t *p = Reserve (PCAP_RECORD_HEADER_SIZE + inclLen);
+  p = PcapWriteLe32 (p, tsSec);
+  p = PcapWriteLe32 (p, tsUsec);
+  p = PcapWriteLe32 (p, inclLen);
+  p = PcapWriteLe32 (p, totalLen);
+  return p;
+}
+
+void
+PcapWriter::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const *data, uint32_t totalLen)
+{
+  uint32_t inclLen = std::min (totalLen, m_snapLen);
+  uint8_t *p = WriteRecordHeader (tsSec, tsUsec, inclLen, totalLen);
+  memcpy (p, data, inclLen);
+}
+
+void
+PcapWriter::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
+{
+  uint32_t totalLen = p->GetSize ();
+  uint32_t inclLen = std::min (totalLen, m_snapLen);
+  uint8_t *data = WriteRecordHeader (tsSec, tsUsec, inclLen, totalLen);
+  // straight from the buffer of the packet, and no further than the
+  // snap length
+  p->CopyData (data, inclLen);
+}
+
+void
+PcapWriter::Write (uint32_t tsSec, uint32_t tsUsec, Header &header, Ptr<const Packet> p)
+{
+  uint32_t headerSize = header.GetSerializedSize ();
+  uint32_t totalLen = headerSize + p->GetSize ();
+  uint32_t inclLen = std::min (totalLen, m_snapLen);
+  uint8_t *data = WriteRecordHeader (tsSec, tsUsec, inclLen, totalLen);
+
+  Buffer headerBuffer;
+  headerBuffer.AddAtStart (headerSize);
+  header.Serialize (headerBuffer.Begin ());
+  uint32_t toCopy = std::min (headerSize, inclLen);
+  headerBuffer.CopyData (data, toCopy);
+  p->CopyData (data + toCopy, inclLen - toCopy);
+}
+
+uint32_t
+PcapWriter::GetMagic (void) const
+{
+  return PCAP_MAGIC;
+}
+
+uint16_t
+PcapWriter::GetVersionMajor (void) const
+{
+  return PCAP_VERSION_MAJOR;
+}
+
+uint16_t
+PcapWriter::GetVersionMinor (void) const
+{
+  return PCAP_VERSION_MINOR;
+}
+
+int32_t
+PcapWriter::GetTimeZoneOffset (void) const
+{
+  return m_zone;
+}
+
+uint32_t
+PcapWriter::GetSigFigs (void) const
+{
+  return 0;
+}
+
+uint32_t
+PcapWriter::GetSnapLen (void) const
+{
+  return m_snapLen;
+}
+
+uint32_t
+PcapWriter::GetDataLinkType (void) const
+{
+  return m_dataLinkType;
+}
+
+} // namespace ns3
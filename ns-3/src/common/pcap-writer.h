@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PCAP_WRITER_H
+#define PCAP_WRITER_H
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Packet;
+class Header;
+
+/**
+ * \ingroup packet
+ *
+ * \brief writes a pcap file through large buffers
+ *
+ * The records are serialized into a buffer of the given size, copying
+ * no more of each packet than the snap length, and the full buffers are
+ * written by a background thread, which serves all the PcapWriter
+ * objects of the process. With compression, the file is an LZ4 frame
+ * with a block per buffer, which lz4 -d turns back into the pcap file.
+ *
+ * The records are little endian, like the ones of PcapFile. The file is
+ * complete once Close returns; until then, the records of the current
+ * buffer are only in memory.
+ */
+class PcapWriter
+{
+public:
+  PcapWriter ();
+  ~PcapWriter ();
+
+  /**
+   * \param filename the name of the file to create
+   * \param bufferSize the number of bytes of records to collect before
+   *        writing them, at most Lz4Codec::MAX_BLOCK_SIZE
+   * \param compress whether to write an LZ4 frame
+   * \param background whether to write from the background thread or
+   *        from the caller of Write
+   */
+  void Open (std::string const &filename, uint32_t bufferSize, bool compress, bool background);
+  /**
+   * \return true if the file could not be created or written.
+   */
+  bool Fail (void) const;
+  /**
+   * \brief Writes the remaining records and closes the file.
+   */
+  void Close (void);
+  /**
+   * \brief Writes the pcap file header, see PcapFile::Init.
+   */
+  void Init (uint32_t dataLinkType, uint32_t snapLen, int32_t timeZoneCorrection);
+
+  void Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const *data, uint32_t totalLen);
+  void Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p);
+  void Write (uint32_t tsSec, uint32_t tsUsec, Header &header, Ptr<const Packet> p);
+  /**
+   * \brief Hands the records collected so far over to be written.
+   */
+  void Flush (void);
+
+  uint32_t GetMagic (void) const;
+  uint16_t GetVersionMajor (void) const;
+  uint16_t GetVersionMinor (void) const;
+  int32_t GetTimeZoneOffset (void) const;
+  uint32_t GetSigFigs (void) const;
+  uint32_t GetSnapLen (void) const;
+  uint32_t GetDataLinkType (void) const;
+
+private:
+  class FlushThread;
+
+  PcapWriter (PcapWriter const &);
+  PcapWriter &operator = (PcapWriter const &);
+
+  uint8_t *Reserve (uint32_t size);
+  uint8_t *WriteRecordHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t inclLen, uint32_t totalLen);
+  void WriteOut (uint8_t *data, uint32_t size);
+
+  std::ofstream m_file;
+  bool m_compress;
+  bool m_background;
+  // set by whichever thread writes the file
+  volatile bool m_fail;
+  uint32_t m_bufferSize;
+  uint8_t *m_buffer;
+  uint32_t m_capacity;
+  uint32_t m_used;
+  // buffers handed to the background thread and not written yet
+  uint32_t m_pending;
+  // written to by the thread which writes the file
+  std::vector<uint8_t> m_compressed;
+
+  int32_t m_zone;
+  uint32_t m_snapLen;
+  uint32_t m_dataLinkType;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_WRITER_H */
@@ -37,6 +37,11 @@ FlowClassifier::GetNewFlowId ()
   return ++m_lastNewFlowId;
 }
 
+void
+FlowClassifier::SerializeToBinaryStream (std::ostream &os) const
+{
+}
+
 
 } // namespace ns3
 
@@ -53,6 +53,9 @@ public:
   virtual ~FlowClassifier ();
 
   virtual void SerializeToXmlStream (std::ostream &os, int indent) const = 0;
+  /// Serializes the flows to an std::ostream in the binary format of
+  /// FlowMonitor::SerializeToBinaryStream; writes nothing by default.
+  virtual void SerializeToBinaryStream (std::ostream &os) const;
 
 protected:
   FlowId GetNewFlowId ();
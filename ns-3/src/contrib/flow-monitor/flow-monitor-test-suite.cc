@@ -0,0 +1,265 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "flow-monitor.h"
+#include "ipv4-flow-classifier.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/packet.h"
+#include "ns3/test.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+namespace ns3 {
+
+class FlowMonitorTestProbe : public FlowProbe
+{
+public:
+  FlowMonitorTestProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+class FlowMonitorTrackingTestCase : public TestCase
+{
+public:
+  FlowMonitorTrackingTestCase ();
+  virtual bool DoRun (void);
+};
+
+FlowMonitorTrackingTestCase::FlowMonitorTrackingTestCase ()
+  : TestCase ("Find the lost packets in flight, and bound their number")
+{
+}
+
+bool
+FlowMonitorTrackingTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<FlowProbe> probe = Create<FlowMonitorTestProbe> (monitor);
+  monitor->StartRightNow ();
+  monitor->ReportFirstTx (probe, 1, 1, 100);
+  monitor->ReportFirstTx (probe, 1, 2, 100);
+  monitor->ReportFirstTx (probe, 2, 1, 100);
+  Simulator::Schedule (Seconds (1), &FlowMonitor::ReportForwarding, monitor, probe, 1, 1, 100);
+  Simulator::Schedule (Seconds (2), &FlowMonitor::ReportLastRx, monitor, probe, 2, 1, 100);
+  Simulator::Stop (Seconds (3.5));
+  Simulator::Run ();
+
+  // packet 2 of flow 1 was last seen at 0s, packet 1 at 1s
+  monitor->CheckForLostPackets (Seconds (3));
+  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats[1].txPackets, 2, "Transmitted packets");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].lostPackets, 1, "Packet not seen for 3.5s");
+  NS_TEST_EXPECT_MSG_EQ (stats[2].rxPackets, 1, "Received packets");
+  NS_TEST_EXPECT_MSG_EQ (stats[2].lostPackets, 0, "Received packets are not lost");
+  monitor->CheckForLostPackets (Seconds (2.5));
+  stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats[1].lostPackets, 2, "Packet forwarded 2.5s ago");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].timesForwarded, 0, "Lost packets are not counted as forwarded");
+  Simulator::Destroy ();
+
+  monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("MaxTrackedPackets", UintegerValue (2));
+  probe = Create<FlowMonitorTestProbe> (monitor);
+  monitor->StartRightNow ();
+  monitor->ReportFirstTx (probe, 1, 1, 100);
+  monitor->ReportFirstTx (probe, 1, 2, 100);
+  monitor->ReportForwarding (probe, 1, 1, 100);
+  monitor->ReportFirstTx (probe, 1, 3, 100);
+  // packet 2 was seen least recently, and is given up
+  monitor->ReportLastRx (probe, 1, 2, 100);
+  monitor->ReportLastRx (probe, 1, 1, 100);
+  monitor->ReportLastRx (probe, 1, 3, 100);
+  stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats[1].lostPackets, 1, "Packet beyond MaxTrackedPackets");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].rxPackets, 2, "Packets still tracked");
+  Simulator::Destroy ();
+
+  return GetErrorStatus ();
+}
+
+class FlowMonitorBinaryTestCase : public TestCase
+{
+public:
+  FlowMonitorBinaryTestCase ();
+  virtual bool DoRun (void);
+
+private:
+  struct Table
+  {
+    std::string tag;
+    uint32_t version;
+    uint32_t nRows;
+    int64_t time;
+    // the values of each column, as unsigned integers
+    std::vector<std::vector<uint64_t> > columns;
+  };
+  static uint64_t ReadLsb (std::istream &is, uint32_t width);
+  static bool ReadTable (std::istream &is, const uint32_t *widths, uint32_t nColumns, Table &table);
+  static const uint32_t FLOW_COLUMNS[];
+  static const uint32_t IPV4_COLUMNS[];
+};
+
+const uint32_t FlowMonitorBinaryTestCase::FLOW_COLUMNS[] = { 4, 8, 8, 8, 8, 8, 8, 8, 8, 4, 4, 4, 4 };
+const uint32_t FlowMonitorBinaryTestCase::IPV4_COLUMNS[] = { 4, 4, 4, 1, 2, 2 };
+
+FlowMonitorBinaryTestCase::FlowMonitorBinaryTestCase ()
+  : TestCase ("Write the flows and the snapshots in the binary format")
+{
+}
+
+uint64_t
+FlowMonitorBinaryTestCase::ReadLsb (std::istream &is, uint32_t width)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < width; i++)
+    {
+      value |= (uint64_t)(uint8_t)is.get () << (8 * i);
+    }
+  return value;
+}
+
+bool
+FlowMonitorBinaryTestCase::ReadTable (std::istream &is, const uint32_t *widths, uint32_t nColumns,
+                                      Table &table)
+{
+  char tag[4];
+  if (!is.read (tag, 4))
+    {
+      return false;
+    }
+  table.tag = std::string (tag, 4);
+  table.version = ReadLsb (is, 4);
+  table.nRows = ReadLsb (is, 4);
+  table.time = ReadLsb (is, 8);
+  table.columns.assign (nColumns, std::vector<uint64_t> ());
+  for (uint32_t c = 0; c < nColumns; c++)
+    {
+      for (uint32_t r = 0; r < table.nRows; r++)
+        {
+          table.columns[c].push_back (ReadLsb (is, widths[c]));
+        }
+    }
+  return is.good ();
+}
+
+bool
+FlowMonitorBinaryTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<Ipv4FlowClassifier> classifier = Create<Ipv4FlowClassifier> ();
+  monitor->SetFlowClassifier (classifier);
+  std::string snapshotFileName = GetTempDir () + "/flow-monitor-snapshots.bin";
+  monitor->SetAttribute ("SnapshotInterval", TimeValue (Seconds (1)));
+  monitor->SetAttribute ("SnapshotFileName", StringValue (snapshotFileName));
+  Ptr<FlowProbe> probe = Create<FlowMonitorTestProbe> (monitor);
+  monitor->StartRightNow ();
+
+  FlowId flowIds[2];
+  FlowPacketId packetIds[2];
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      Ptr<Packet> packet = Create<Packet> (100);
+      UdpHeader udpHeader;
+      udpHeader.SetSourcePort (1000 + k);
+      udpHeader.SetDestinationPort (9);
+      packet->AddHeader (udpHeader);
+      Ipv4Header ipHeader;
+      ipHeader.SetSource (Ipv4Address ("10.0.0.1"));
+      ipHeader.SetDestination (Ipv4Address ("10.0.0.2"));
+      ipHeader.SetProtocol (17);
+      ipHeader.SetIdentification (7);
+      NS_TEST_ASSERT_MSG_EQ (classifier->Classify (ipHeader, packet, &flowIds[k], &packetIds[k]), true,
+                             "UDP packets are classified");
+    }
+  NS_TEST_ASSERT_MSG_EQ (flowIds[0], 1, "First flow id");
+  NS_TEST_ASSERT_MSG_EQ (flowIds[1], 2, "Second flow id");
+  NS_TEST_EXPECT_MSG_EQ (classifier->FindFlow (2).sourcePort, 1001, "Tuple of a flow id");
+
+  Simulator::Schedule (Seconds (0.5), &FlowMonitor::ReportFirstTx, monitor, probe, flowIds[0], packetIds[0], 108);
+  Simulator::Schedule (Seconds (1.5), &FlowMonitor::ReportFirstTx, monitor, probe, flowIds[1], packetIds[1], 108);
+  Simulator::Schedule (Seconds (1.5), &FlowMonitor::ReportLastRx, monitor, probe, flowIds[0], packetIds[0], 108);
+  Simulator::Stop (Seconds (3.25));
+  Simulator::Run ();
+  monitor->StopRightNow ();
+
+  std::ostringstream oss;
+  monitor->SerializeToBinaryStream (oss);
+  std::istringstream iss (oss.str ());
+  Table table;
+  NS_TEST_ASSERT_MSG_EQ (ReadTable (iss, FLOW_COLUMNS, 13, table), true, "Flow table");
+  NS_TEST_EXPECT_MSG_EQ (table.tag, "FLOW", "Flow table tag");
+  NS_TEST_EXPECT_MSG_EQ (table.version, 1, "Format version");
+  NS_TEST_EXPECT_MSG_EQ (table.time, Seconds (3.25).GetNanoSeconds (), "Time of the table");
+  NS_TEST_ASSERT_MSG_EQ (table.nRows, 2, "One row per flow");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[0][1], 2, "flowId");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[1][0], (uint64_t)Seconds (0.5).GetNanoSeconds (), "timeFirstTxPacket");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[5][0], (uint64_t)Seconds (1).GetNanoSeconds (), "delaySum");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[7][1], 108, "txBytes");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[10][0], 1, "rxPackets");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[10][1], 0, "rxPackets");
+  NS_TEST_ASSERT_MSG_EQ (ReadTable (iss, IPV4_COLUMNS, 6, table), true, "Classifier table");
+  NS_TEST_EXPECT_MSG_EQ (table.tag, "IPV4", "Classifier table tag");
+  NS_TEST_ASSERT_MSG_EQ (table.nRows, 2, "One row per flow");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[1][0], Ipv4Address ("10.0.0.1").Get (), "sourceAddress");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[3][1], 17, "protocol");
+  NS_TEST_EXPECT_MSG_EQ (table.columns[4][1], 1001, "sourcePort");
+  NS_TEST_EXPECT_MSG_EQ (iss.peek (), EOF, "Nothing after the classifier table");
+
+  // a snapshot at 1s, 2s and 3s, and one when the monitoring stops
+  std::ifstream ifs (snapshotFileName.c_str (), std::ios::in|std::ios::binary);
+  uint32_t expectedRows[] = { 1, 2, 0, 0 };
+  double expectedTimes[] = { 1, 2, 3, 3.25 };
+  for (uint32_t s = 0; s < 4; s++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (ReadTable (ifs, FLOW_COLUMNS, 13, table), true, "Snapshot table");
+      NS_TEST_EXPECT_MSG_EQ (table.tag, "SNAP", "Snapshot table tag");
+      NS_TEST_EXPECT_MSG_EQ (table.time, Seconds (expectedTimes[s]).GetNanoSeconds (), "Snapshot time");
+      NS_TEST_EXPECT_MSG_EQ (table.nRows, expectedRows[s], "Flows changed during the interval");
+      if (s == 1)
+        {
+          NS_TEST_EXPECT_MSG_EQ (table.columns[0][0], 1, "flowId");
+          NS_TEST_EXPECT_MSG_EQ (table.columns[10][0], 1, "rxPackets");
+          NS_TEST_EXPECT_MSG_EQ (table.columns[0][1], 2, "flowId");
+          NS_TEST_EXPECT_MSG_EQ (table.columns[9][1], 1, "txPackets");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (ifs.peek (), EOF, "Nothing after the last snapshot");
+  ifs.close ();
+  std::remove (snapshotFileName.c_str ());
+
+  Simulator::Destroy ();
+  return GetErrorStatus ();
+}
+
+static class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ()
+    : TestSuite ("flow-monitor", UNIT)
+  {
+    AddTestCase (new FlowMonitorTrackingTestCase ());
+    AddTestCase (new FlowMonitorBinaryTestCase ());
+  }
+} g_flowMonitorTestSuite;
+
+} // namespace ns3
@@ -21,9 +21,15 @@
 #include "flow-monitor.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/buffer.h"
+#include "ns3/sgi-hashmap.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #define INDENT(level) for (int __xpto = 0; __xpto < level; __xpto++) os << ' ';
 
@@ -47,6 +53,11 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (10.0)),
                    MakeTimeAccessor (&FlowMonitor::m_maxPerHopDelay),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTrackedPackets", ("The maximum number of packets in flight to keep track of, 0 for no limit.  "
+                                         "Beyond it, the packets not seen for the longest time are considered lost."),
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowMonitor::m_maxTrackedPackets),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("StartTime", ("The time when the monitoring starts."),
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&FlowMonitor::Start),
@@ -71,6 +82,16 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("SnapshotInterval", ("The interval between two snapshots of the flows which changed, "
+                                        "0 for no snapshots."),
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&FlowMonitor::m_snapshotInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("SnapshotFileName", ("The file to which the snapshots are written while monitoring, "
+                                        "in the binary format of SerializeToBinaryStream."),
+                   StringValue (""),
+                   MakeStringAccessor (&FlowMonitor::m_snapshotFileName),
+                   MakeStringChecker ())
     ;
   return tid;
 }
@@ -81,16 +102,53 @@ FlowMonitor::GetInstanceTypeId (void) const
   return GetTypeId ();
 }
 
+namespace {
+
+struct TrackedPacketHash
+{
+  size_t operator () (const std::pair<FlowId, FlowPacketId> &key) const
+  {
+    // the packet ids of a flow are consecutive, spread the flows apart
+    return key.first * 0x9e3779b1U + key.second;
+  }
+};
+
+} // anonymous namespace
+
+class FlowMonitor::TrackedPacketMap
+  : public sgi::hash_map<std::pair<FlowId, FlowPacketId>, TrackedPacketList::iterator, TrackedPacketHash>
+{
+};
+
 FlowMonitor::FlowMonitor ()
- : m_enabled (false)
+ : m_trackedPackets (new TrackedPacketMap ()),
+   m_enabled (false),
+   m_snapshot (1)
 {
  // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
 
+FlowMonitor::~FlowMonitor ()
+{
+  delete m_trackedPackets;
+}
+
 
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
+  if (m_snapshotStream.is_open ())
+    {
+      if (flowId >= m_flowSnapshot.size ())
+        {
+          m_flowSnapshot.resize (flowId + 1, 0);
+        }
+      if (m_flowSnapshot[flowId] != m_snapshot)
+        {
+          m_flowSnapshot[flowId] = m_snapshot;
+          m_snapshotFlows.push_back (flowId);
+        }
+    }
   std::map<FlowId, FlowStats>::iterator iter;
   iter = m_flowStats.find (flowId);
   if (iter == m_flowStats.end ())
@@ -126,12 +184,31 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
+  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
+  TrackedPacketMap::iterator iter = m_trackedPackets->find (key);
+  if (iter == m_trackedPackets->end ())
+    {
+      m_trackedList.push_back (TrackedPacket ());
+      iter = m_trackedPackets->insert (std::make_pair (key, --m_trackedList.end ())).first;
+    }
+  else
+    {
+      m_trackedList.splice (m_trackedList.end (), m_trackedList, iter->second);
+    }
+  TrackedPacket &tracked = *iter->second;
+  tracked.flowId = flowId;
+  tracked.packetId = packetId;
   tracked.firstSeenTime = now;
   tracked.lastSeenTime = tracked.firstSeenTime;
   tracked.timesForwarded = 0;
   NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
                 << ").");
+  if (m_maxTrackedPackets != 0 && m_trackedPackets->size () > m_maxTrackedPackets)
+    {
+      NS_LOG_DEBUG ("ReportFirstTx: too many tracked packets, losing (flowId="
+                    << m_trackedList.front ().flowId << ", packetId=" << m_trackedList.front ().packetId << ").");
+      LosePacket (m_trackedList.begin ());
+    }
 
   probe->AddPacketStats (flowId, packetSize, Seconds (0));
 
@@ -154,18 +231,19 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
       return;
     }
   std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  TrackedPacketMap::iterator tracked = m_trackedPackets->find (key);
+  if (tracked == m_trackedPackets->end ())
     {
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                    << ") but not known to be transmitted.");
       return;
     }
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  tracked->second->timesForwarded++;
+  tracked->second->lastSeenTime = Simulator::Now ();
+  m_trackedList.splice (m_trackedList.end (), m_trackedList, tracked->second);
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked->second->firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
@@ -177,8 +255,8 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  TrackedPacketMap::iterator tracked = m_trackedPackets->find (std::make_pair (flowId, packetId));
+  if (tracked == m_trackedPackets->end ())
     {
       NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
                    << ") but not known to be transmitted.");
@@ -186,7 +264,7 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     }
 
   Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - tracked->second->firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
@@ -225,12 +303,14 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += tracked->second->timesForwarded;
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  // we don't need to track this packet anymore
+  m_trackedList.erase (tracked->second);
+  m_trackedPackets->erase (tracked);
 }
 
 void
@@ -255,14 +335,15 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  TrackedPacketMap::iterator tracked = m_trackedPackets->find (std::make_pair (flowId, packetId));
+  if (tracked != m_trackedPackets->end ())
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      m_trackedList.erase (tracked->second);
+      m_trackedPackets->erase (tracked);
     }
 }
 
@@ -273,29 +354,28 @@ FlowMonitor::GetFlowStats () const
 }
 
 
+void
+FlowMonitor::LosePacket (TrackedPacketList::iterator tracked)
+{
+  // packet is considered lost, add it to the loss statistics
+  NS_ASSERT (m_flowStats.find (tracked->flowId) != m_flowStats.end ());
+  GetStatsForFlow (tracked->flowId).lostPackets++;
+
+  // we won't track it anymore
+  m_trackedPackets->erase (std::make_pair (tracked->flowId, tracked->packetId));
+  m_trackedList.erase (tracked);
+}
+
 void
 FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
-  
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+
+  // the packets are in the order in which they were last seen, stop at
+  // the first one seen recently enough
+  while (!m_trackedList.empty () && now - m_trackedList.front ().lastSeenTime >= maxDelay)
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
-        {
-          // packet is considered lost, add it to the loss statistics
-          std::map<FlowId, FlowStats>::iterator
-            flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
-
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
-        }
-      else
-        {
-          iter++;
-        }
+      LosePacket (m_trackedList.begin ());
     }
 }
 
@@ -312,6 +392,25 @@ FlowMonitor::PeriodicCheckForLostPackets ()
   Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
+void
+FlowMonitor::PeriodicSnapshot ()
+{
+  WriteSnapshot ();
+  m_snapshotEvent = Simulator::Schedule (m_snapshotInterval, &FlowMonitor::PeriodicSnapshot, this);
+}
+
+void
+FlowMonitor::WriteSnapshot ()
+{
+  // the lost packets belong to the window in which they are found lost
+  CheckForLostPackets ();
+  std::sort (m_snapshotFlows.begin (), m_snapshotFlows.end ());
+  SerializeFlowsToBinaryStream (m_snapshotStream, "SNAP", m_snapshotFlows);
+  m_snapshotStream.flush ();
+  m_snapshotFlows.clear ();
+  m_snapshot++;
+}
+
 void
 FlowMonitor::NotifyConstructionCompleted ()
 {
@@ -319,6 +418,19 @@ FlowMonitor::NotifyConstructionCompleted ()
   Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
+void
+FlowMonitor::DoDispose (void)
+{
+  Simulator::Cancel (m_snapshotEvent);
+  if (m_snapshotStream.is_open ())
+    {
+      m_snapshotStream.close ();
+    }
+  m_trackedPackets->clear ();
+  m_trackedList.clear ();
+  Object::DoDispose ();
+}
+
 void
 FlowMonitor::AddProbe (Ptr<FlowProbe> probe)
 {
@@ -363,6 +475,15 @@ FlowMonitor::StartRightNow ()
       return;
     }
   m_enabled = true;
+  if (m_snapshotInterval > Seconds (0) && !m_snapshotFileName.empty ())
+    {
+      if (!m_snapshotStream.is_open ())
+        {
+          m_snapshotStream.open (m_snapshotFileName.c_str (), std::ios::out|std::ios::binary);
+          NS_ABORT_MSG_UNLESS (m_snapshotStream.is_open (), "Could not open " << m_snapshotFileName);
+        }
+      m_snapshotEvent = Simulator::Schedule (m_snapshotInterval, &FlowMonitor::PeriodicSnapshot, this);
+    }
 }
 
 
@@ -375,6 +496,11 @@ FlowMonitor::StopRightNow ()
     }
   m_enabled = false;
   CheckForLostPackets ();
+  if (m_snapshotEvent.IsRunning ())
+    {
+      Simulator::Cancel (m_snapshotEvent);
+      WriteSnapshot ();
+    }
 }
 
 void
@@ -482,6 +608,79 @@ FlowMonitor::SerializeToXmlFile (std::string fileName, bool enableHistograms, bo
   os.close ();
 }
 
+void
+FlowMonitor::SerializeFlowsToBinaryStream (std::ostream &os, const char *tag,
+                                           const std::vector<FlowId> &flowIds) const
+{
+  uint32_t n = flowIds.size ();
+  std::vector<const FlowStats *> stats;
+  stats.reserve (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      std::map<FlowId, FlowStats>::const_iterator flow = m_flowStats.find (flowIds[i]);
+      NS_ASSERT (flow != m_flowStats.end ());
+      stats.push_back (&flow->second);
+    }
+
+  Buffer header;
+  header.AddAtStart (20);
+  Buffer::Iterator i = header.Begin ();
+  i.Write ((const uint8_t *)tag, 4);
+  i.WriteHtolsbU32 (1);
+  i.WriteHtolsbU32 (n);
+  i.WriteHtolsbU64 (Simulator::Now ().GetNanoSeconds ());
+  header.CopyData (&os, header.GetSize ());
+
+  // one column at a time, so that only one of them is in memory
+#define COLUMN(width, write, value)                    \
+  {                                                     \
+    Buffer column;                                      \
+    column.AddAtStart (width * n);                      \
+    Buffer::Iterator j = column.Begin ();               \
+    for (uint32_t k = 0; k < n; k++)                    \
+      {                                                 \
+        j.write (value);                                \
+      }                                                 \
+    column.CopyData (&os, column.GetSize ());           \
+  }
+  COLUMN (4, WriteHtolsbU32, flowIds[k]);
+  COLUMN (8, WriteHtolsbU64, stats[k]->timeFirstTxPacket.GetNanoSeconds ());
+  COLUMN (8, WriteHtolsbU64, stats[k]->timeFirstRxPacket.GetNanoSeconds ());
+  COLUMN (8, WriteHtolsbU64, stats[k]->timeLastTxPacket.GetNanoSeconds ());
+  COLUMN (8, WriteHtolsbU64, stats[k]->timeLastRxPacket.GetNanoSeconds ());
+  COLUMN (8, WriteHtolsbU64, stats[k]->delaySum.GetNanoSeconds ());
+  COLUMN (8, WriteHtolsbU64, stats[k]->jitterSum.GetNanoSeconds ());
+  COLUMN (8, WriteHtolsbU64, stats[k]->txBytes);
+  COLUMN (8, WriteHtolsbU64, stats[k]->rxBytes);
+  COLUMN (4, WriteHtolsbU32, stats[k]->txPackets);
+  COLUMN (4, WriteHtolsbU32, stats[k]->rxPackets);
+  COLUMN (4, WriteHtolsbU32, stats[k]->lostPackets);
+  COLUMN (4, WriteHtolsbU32, stats[k]->timesForwarded);
+#undef COLUMN
+}
+
+void
+FlowMonitor::SerializeToBinaryStream (std::ostream &os)
+{
+  CheckForLostPackets ();
 
-} // namespace ns3
+  std::vector<FlowId> flowIds;
+  flowIds.reserve (m_flowStats.size ());
+  for (std::map<FlowId, FlowStats>::const_iterator flowI = m_flowStats.begin ();
+       flowI != m_flowStats.end (); flowI++)
+    {
+      flowIds.push_back (flowI->first);
+    }
+  SerializeFlowsToBinaryStream (os, "FLOW", flowIds);
+  m_classifier->SerializeToBinaryStream (os);
+}
+
+void
+FlowMonitor::SerializeToBinaryFile (std::string fileName)
+{
+  std::ofstream os (fileName.c_str (), std::ios::out|std::ios::binary);
+  SerializeToBinaryStream (os);
+  os.close ();
+}
 
+} // namespace ns3
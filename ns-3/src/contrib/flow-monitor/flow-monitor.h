@@ -23,6 +23,8 @@
 
 #include <vector>
 #include <map>
+#include <list>
+#include <fstream>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
@@ -38,6 +40,16 @@ namespace ns3 {
 ///
 /// The FlowMonitor class is responsible forcoordinating efforts
 /// regarding probes, and collects end-to-end flowstatistics.
+///
+/// The packets in flight are kept in the order in which they were last
+/// seen, so that the ones missing for longer than MaxPerHopDelay are
+/// found without looking at the others; MaxTrackedPackets bounds their
+/// number for runs with very many flows.  When SnapshotInterval and
+/// SnapshotFileName are set, the statistics of the flows which changed
+/// during each interval are appended to that file as the simulation
+/// runs, in the binary format of SerializeToBinaryStream; the flows
+/// which changed since the last snapshot are written when the
+/// monitoring stops.
 class FlowMonitor : public Object
 {
 public:
@@ -130,6 +142,7 @@ public:
   static TypeId GetTypeId ();
   TypeId GetInstanceTypeId () const;
   FlowMonitor ();
+  virtual ~FlowMonitor ();
 
   /// Set the FlowClassifier to be used by the flow monitor.
   void SetFlowClassifier (Ptr<FlowClassifier> classifier);
@@ -201,15 +214,39 @@ public:
   /// \param enableProbes if true, include also the per-probe/flow pair statistics in the output
   void SerializeToXmlFile (std::string fileName, bool enableHistograms, bool enableProbes);
 
+  /// Serializes the flow statistics, followed by the flows of the
+  /// classifier, to an std::ostream in a binary columnar format.
+  ///
+  /// The output is a sequence of tables, each made of a header: a four
+  /// character tag, the uint32_t format version (1), the uint32_t
+  /// number of rows and the int64_t simulation time in nanoseconds; and
+  /// of a column per field, with a value per row.  All the numbers are
+  /// little endian and the times are int64_t nanoseconds.  The "FLOW"
+  /// tables have the columns flowId (uint32_t), timeFirstTxPacket,
+  /// timeFirstRxPacket, timeLastTxPacket, timeLastRxPacket, delaySum,
+  /// jitterSum (int64_t), txBytes, rxBytes (uint64_t), txPackets,
+  /// rxPackets, lostPackets and timesForwarded (uint32_t).  The
+  /// snapshots are "SNAP" tables with the same columns, and the
+  /// Ipv4FlowClassifier writes a "IPV4" table.  The histograms and the
+  /// drop reasons are only in the XML output.
+  /// \param os the output stream
+  void SerializeToBinaryStream (std::ostream &os);
+  /// Same as SerializeToBinaryStream, but writes to a file instead
+  /// \param fileName name or path of the output file that will be created
+  void SerializeToBinaryFile (std::string fileName);
+
 
 protected:
 
   virtual void NotifyConstructionCompleted ();
+  virtual void DoDispose (void);
 
 private:
 
   struct TrackedPacket
   {
+    FlowId flowId;
+    FlowPacketId packetId;
     Time firstSeenTime; // absolute time when the packet was first seen by a probe
     Time lastSeenTime; // absolute time when the packet was last seen by a probe
     uint32_t timesForwarded; // number of times the packet was reportedly forwarded
@@ -218,10 +255,15 @@ private:
   // FlowId --> FlowStats
   std::map<FlowId, FlowStats> m_flowStats;
 
-  // (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-  TrackedPacketMap m_trackedPackets;
+  // tracked packets, least recently seen first
+  typedef std::list<TrackedPacket> TrackedPacketList;
+  TrackedPacketList m_trackedList;
+  // (FlowId,PacketId) --> TrackedPacket, a hash map defined in
+  // flow-monitor.cc to keep <ext/hash_map> out of this header
+  class TrackedPacketMap;
+  TrackedPacketMap *m_trackedPackets;
   Time m_maxPerHopDelay;
+  uint32_t m_maxTrackedPackets;
   std::vector< Ptr<FlowProbe> > m_flowProbes;
 
   // note: this is needed only for serialization
@@ -236,8 +278,23 @@ private:
   double m_flowInterruptionsBinWidth;
   Time m_flowInterruptionsMinTime;
 
+  Time m_snapshotInterval;
+  std::string m_snapshotFileName;
+  std::ofstream m_snapshotStream;
+  EventId m_snapshotEvent;
+  // the flows whose statistics changed since the last snapshot, and
+  // the snapshot in which each flow id was last added to them
+  std::vector<FlowId> m_snapshotFlows;
+  std::vector<uint32_t> m_flowSnapshot;
+  uint32_t m_snapshot;
+
   FlowStats& GetStatsForFlow (FlowId flowId);
+  void LosePacket (TrackedPacketList::iterator tracked);
   void PeriodicCheckForLostPackets ();
+  void PeriodicSnapshot ();
+  void WriteSnapshot ();
+  void SerializeFlowsToBinaryStream (std::ostream &os, const char *tag,
+                                     const std::vector<FlowId> &flowIds) const;
 };
 
 
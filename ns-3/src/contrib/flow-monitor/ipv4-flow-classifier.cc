@@ -23,6 +23,9 @@
 #include "ipv4-flow-classifier.h"
 #include "ns3/udp-header.h"
 #include "ns3/tcp-header.h"
+#include "ns3/simulator.h"
+#include "ns3/buffer.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -95,10 +98,38 @@ bool operator == (const Ipv4FlowClassifier::FiveTuple &t1,
 
 
 
+namespace {
+
+struct FiveTupleHash
+{
+  size_t operator () (const Ipv4FlowClassifier::FiveTuple &tuple) const
+  {
+    size_t hash = tuple.sourceAddress.Get ();
+    hash = hash * 0x9e3779b1U + tuple.destinationAddress.Get ();
+    hash = hash * 0x9e3779b1U + tuple.protocol;
+    hash = hash * 0x9e3779b1U + ((tuple.sourcePort << 16) | tuple.destinationPort);
+    return hash;
+  }
+};
+
+} // anonymous namespace
+
+class Ipv4FlowClassifier::FlowMap
+  : public sgi::hash_map<FiveTuple, FlowId, FiveTupleHash>
+{
+};
+
+
 Ipv4FlowClassifier::Ipv4FlowClassifier ()
+  : m_flowMap (new FlowMap ())
 {
 }
 
+Ipv4FlowClassifier::~Ipv4FlowClassifier ()
+{
+  delete m_flowMap;
+}
+
 bool
 Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload,
                               uint32_t *out_flowId, uint32_t *out_packetId)
@@ -139,13 +170,15 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
     }
   
   // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
-    = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
+  std::pair<FlowMap::iterator, bool> insert
+    = m_flowMap->insert (std::pair<FiveTuple, FlowId> (tuple, 0));
   
   // if the insertion succeeded, we need to assign this tuple a new flow identifier
   if (insert.second)
     {
       insert.first->second = GetNewFlowId ();
+      m_flows.push_back (tuple);
+      NS_ASSERT (m_flows.size () == insert.first->second);
     }
 
   *out_flowId = insert.first->second;
@@ -158,13 +191,9 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
 Ipv4FlowClassifier::FiveTuple
 Ipv4FlowClassifier::FindFlow (FlowId flowId) const
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-         iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  if (flowId >= 1 && flowId <= m_flows.size ())
     {
-      if (iter->second == flowId)
-        {
-          return iter->first;
-        }
+      return m_flows[flowId - 1];
     }
   NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
   FiveTuple retval = { Ipv4Address::GetZero (), Ipv4Address::GetZero (), 0, 0, 0 };
@@ -179,16 +208,15 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
   INDENT(indent); os << "<Ipv4FlowClassifier>\n";
 
   indent += 2;
-  for (std::map<FiveTuple, FlowId>::const_iterator
-         iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  for (uint32_t i = 0; i < m_flows.size (); i++)
     {
       INDENT(indent);
-      os << "<Flow flowId=\"" << iter->second << "\""
-         << " sourceAddress=\"" << iter->first.sourceAddress << "\""
-         << " destinationAddress=\"" << iter->first.destinationAddress << "\""
-         << " protocol=\"" << int(iter->first.protocol) << "\""
-         << " sourcePort=\"" << iter->first.sourcePort << "\""
-         << " destinationPort=\"" << iter->first.destinationPort << "\""
+      os << "<Flow flowId=\"" << i + 1 << "\""
+         << " sourceAddress=\"" << m_flows[i].sourceAddress << "\""
+         << " destinationAddress=\"" << m_flows[i].destinationAddress << "\""
+         << " protocol=\"" << int(m_flows[i].protocol) << "\""
+         << " sourcePort=\"" << m_flows[i].sourcePort << "\""
+         << " destinationPort=\"" << m_flows[i].destinationPort << "\""
          << " />\n";
     }
 
@@ -198,6 +226,44 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
 #undef INDENT
 }
 
+void
+Ipv4FlowClassifier::SerializeToBinaryStream (std::ostream &os) const
+{
+  uint32_t n = m_flows.size ();
+  Buffer buffer;
+  buffer.AddAtStart (20 + n * (4 + 4 + 4 + 1 + 2 + 2));
+  Buffer::Iterator i = buffer.Begin ();
+  i.Write ((const uint8_t *)"IPV4", 4);
+  i.WriteHtolsbU32 (1);
+  i.WriteHtolsbU32 (n);
+  i.WriteHtolsbU64 (Simulator::Now ().GetNanoSeconds ());
+  for (uint32_t k = 0; k < n; k++)
+    {
+      i.WriteHtolsbU32 (k + 1);
+    }
+  for (uint32_t k = 0; k < n; k++)
+    {
+      i.WriteHtolsbU32 (m_flows[k].sourceAddress.Get ());
+    }
+  for (uint32_t k = 0; k < n; k++)
+    {
+      i.WriteHtolsbU32 (m_flows[k].destinationAddress.Get ());
+    }
+  for (uint32_t k = 0; k < n; k++)
+    {
+      i.WriteU8 (m_flows[k].protocol);
+    }
+  for (uint32_t k = 0; k < n; k++)
+    {
+      i.WriteHtolsbU16 (m_flows[k].sourcePort);
+    }
+  for (uint32_t k = 0; k < n; k++)
+    {
+      i.WriteHtolsbU16 (m_flows[k].destinationPort);
+    }
+  buffer.CopyData (&os, buffer.GetSize ());
+}
+
 
 } // namespace ns3
 
@@ -22,7 +22,7 @@
 #define __IPV4_FLOW_CLASSIFIER_H__
 
 #include <stdint.h>
-#include <map>
+#include <vector>
 
 #include "ns3/ipv4-header.h"
 #include "ns3/flow-classifier.h"
@@ -49,6 +49,7 @@ public:
   };
 
   Ipv4FlowClassifier ();
+  virtual ~Ipv4FlowClassifier ();
 
   /// \brief try to classify the packet into flow-id and packet-id
   /// \return true if the packet was classified, false if not (i.e. it
@@ -60,11 +61,23 @@ public:
   FiveTuple FindFlow (FlowId flowId) const;
 
   virtual void SerializeToXmlStream (std::ostream &os, int indent) const;
+  /// Writes a "IPV4" table with the columns flowId (uint32_t),
+  /// sourceAddress, destinationAddress (uint32_t), protocol (uint8_t),
+  /// sourcePort and destinationPort (uint16_t).
+  virtual void SerializeToBinaryStream (std::ostream &os) const;
 
 private:
 
-  std::map<FiveTuple, FlowId> m_flowMap;
-  
+  Ipv4FlowClassifier (Ipv4FlowClassifier const &);
+  Ipv4FlowClassifier &operator = (Ipv4FlowClassifier const &);
+
+  // FiveTuple --> FlowId, a hash map defined in ipv4-flow-classifier.cc
+  // to keep <ext/hash_map> out of this header
+  class FlowMap;
+  FlowMap *m_flowMap;
+  // the tuple of each flow, by flow id - 1
+  std::vector<FiveTuple> m_flows;
+
 };
 
 
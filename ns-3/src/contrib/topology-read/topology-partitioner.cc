@@ -0,0 +1,739 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <list>
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+#include "topology-partitioner.h"
+
+NS_LOG_COMPONENT_DEFINE ("TopologyPartitioner");
+
+namespace ns3 {
+
+namespace {
+
+const uint32_t NONE = 0xffffffff;
+const uint64_t NO_DELAY = 0xffffffffffffffffULL;
+// graphs this small are bisected directly
+const uint32_t COARSEST_SIZE = 20;
+// stop coarsening when a level shrinks the graph less than this
+const double MIN_SHRINK = 0.95;
+const uint32_t INITIAL_TRIES = 8;
+const uint32_t REFINE_PASSES = 8;
+
+// Compressed adjacency lists, each link in both directions
+struct Graph
+{
+  std::vector<uint32_t> xadj;
+  std::vector<uint32_t> adjncy;
+  // number of original links merged in the edge
+  std::vector<uint32_t> adjwgt;
+  // smallest delay of the original links merged in the edge
+  std::vector<uint64_t> adjdelay;
+  // number of original nodes merged in the vertex
+  std::vector<uint32_t> vwgt;
+
+  uint32_t GetN (void) const
+  {
+    return vwgt.size ();
+  }
+  uint64_t GetTotalWeight (void) const
+  {
+    uint64_t total = 0;
+    for (uint32_t v = 0; v < vwgt.size (); v++)
+      {
+        total += vwgt[v];
+      }
+    return total;
+  }
+  uint32_t GetMaxWeight (void) const
+  {
+    uint32_t max = 0;
+    for (uint32_t v = 0; v < vwgt.size (); v++)
+      {
+        max = std::max (max, vwgt[v]);
+      }
+    return max;
+  }
+};
+
+struct Balance
+{
+  uint64_t weight[2];
+  uint64_t target[2];
+  uint64_t max[2];
+
+  Balance (const Graph &g, double fraction, double imbalance, const std::vector<uint8_t> &side)
+  {
+    uint64_t total = g.GetTotalWeight ();
+    target[0] = static_cast<uint64_t> (total * fraction + 0.5);
+    target[1] = total - target[0];
+    for (uint32_t i = 0; i < 2; i++)
+      {
+        // a single vertex may not fit in the tolerance on coarse graphs
+        max[i] = std::max (static_cast<uint64_t> (target[i] * (1 + imbalance)),
+                           target[i] + g.GetMaxWeight () - 1);
+      }
+    weight[0] = weight[1] = 0;
+    for (uint32_t v = 0; v < g.GetN (); v++)
+      {
+        weight[side[v]] += g.vwgt[v];
+      }
+  }
+  uint64_t GetOverweight (void) const
+  {
+    return (weight[0] > max[0] ? weight[0] - max[0] : 0)
+           + (weight[1] > max[1] ? weight[1] - max[1] : 0);
+  }
+};
+
+// weight and smallest delay of the edges between the two sides
+void
+GetCut (const Graph &g, const std::vector<uint8_t> &side, uint64_t &weight, uint64_t &delay)
+{
+  weight = 0;
+  delay = NO_DELAY;
+  for (uint32_t v = 0; v < g.GetN (); v++)
+    {
+      for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1]; e++)
+        {
+          if (side[g.adjncy[e]] != side[v])
+            {
+              weight += g.adjwgt[e];
+              delay = std::min (delay, g.adjdelay[e]);
+            }
+        }
+    }
+  weight /= 2;
+}
+
+/*
+ * Heavy edge matching, preferring the shortest links so that they end
+ * up inside a vertex and never get cut. Returns false when the graph
+ * hardly shrinks.
+ */
+bool
+Coarsen (const Graph &g, Graph &coarse, std::vector<uint32_t> &cmap)
+{
+  uint32_t n = g.GetN ();
+  uint64_t maxVwgt = 3 * g.GetTotalWeight () / (2 * COARSEST_SIZE) + 1;
+
+  // low degree vertices first, they have the fewest choices
+  std::vector<std::pair<uint32_t, uint32_t> > order;
+  order.reserve (n);
+  for (uint32_t v = 0; v < n; v++)
+    {
+      order.push_back (std::make_pair (g.xadj[v + 1] - g.xadj[v], v));
+    }
+  std::sort (order.begin (), order.end ());
+
+  std::vector<uint32_t> match (n, NONE);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t v = order[i].second;
+      if (match[v] != NONE)
+        {
+          continue;
+        }
+      uint32_t best = NONE;
+      for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1]; e++)
+        {
+          uint32_t u = g.adjncy[e];
+          if (match[u] != NONE || g.vwgt[u] + g.vwgt[v] > maxVwgt)
+            {
+              continue;
+            }
+          if (best == NONE
+              || g.adjdelay[e] < g.adjdelay[best]
+              || (g.adjdelay[e] == g.adjdelay[best] && g.adjwgt[e] > g.adjwgt[best]))
+            {
+              best = e;
+            }
+        }
+      match[v] = best == NONE ? v : g.adjncy[best];
+      match[match[v]] = v;
+    }
+
+  cmap.assign (n, NONE);
+  std::vector<uint32_t> members;
+  for (uint32_t v = 0; v < n; v++)
+    {
+      if (cmap[v] == NONE)
+        {
+          cmap[v] = cmap[match[v]] = members.size ();
+          members.push_back (v);
+        }
+    }
+  uint32_t cn = members.size ();
+  if (cn > MIN_SHRINK * n)
+    {
+      return false;
+    }
+
+  coarse.xadj.assign (1, 0);
+  coarse.adjncy.clear ();
+  coarse.adjwgt.clear ();
+  coarse.adjdelay.clear ();
+  coarse.vwgt.assign (cn, 0);
+  std::vector<uint32_t> slot (cn, NONE);
+  for (uint32_t c = 0; c < cn; c++)
+    {
+      uint32_t start = coarse.adjncy.size ();
+      uint32_t pair[2] = { members[c], match[members[c]] };
+      for (uint32_t k = 0; k < (pair[0] == pair[1] ? 1U : 2U); k++)
+        {
+          uint32_t v = pair[k];
+          coarse.vwgt[c] += g.vwgt[v];
+          for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1]; e++)
+            {
+              uint32_t cu = cmap[g.adjncy[e]];
+              if (cu == c)
+                {
+                  continue;
+                }
+              if (slot[cu] == NONE)
+                {
+                  slot[cu] = coarse.adjncy.size ();
+                  coarse.adjncy.push_back (cu);
+                  coarse.adjwgt.push_back (g.adjwgt[e]);
+                  coarse.adjdelay.push_back (g.adjdelay[e]);
+                }
+              else
+                {
+                  coarse.adjwgt[slot[cu]] += g.adjwgt[e];
+                  coarse.adjdelay[slot[cu]] = std::min (coarse.adjdelay[slot[cu]], g.adjdelay[e]);
+                }
+            }
+        }
+      for (uint32_t e = start; e < coarse.adjncy.size (); e++)
+        {
+          slot[coarse.adjncy[e]] = NONE;
+        }
+      coarse.xadj.push_back (coarse.adjncy.size ());
+    }
+  return true;
+}
+
+/*
+ * Moves boundary vertices which reduce the cut, or restore the balance,
+ * without cutting an edge shorter than the current lookahead.
+ */
+void
+Refine (const Graph &g, double fraction, double imbalance, std::vector<uint8_t> &side)
+{
+  uint32_t n = g.GetN ();
+  Balance balance (g, fraction, imbalance, side);
+
+  // external minus internal edge weight
+  std::vector<int64_t> gain (n, 0);
+  for (uint32_t v = 0; v < n; v++)
+    {
+      for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1]; e++)
+        {
+          gain[v] += side[g.adjncy[e]] != side[v] ? g.adjwgt[e] : -static_cast<int64_t> (g.adjwgt[e]);
+        }
+    }
+
+  for (uint32_t pass = 0; pass < REFINE_PASSES; pass++)
+    {
+      uint64_t cutWeight, lookAhead;
+      GetCut (g, side, cutWeight, lookAhead);
+
+      std::vector<std::pair<int64_t, uint32_t> > candidates;
+      for (uint32_t v = 0; v < n; v++)
+        {
+          bool boundary = false;
+          for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1] && !boundary; e++)
+            {
+              boundary = side[g.adjncy[e]] != side[v];
+            }
+          if (boundary || balance.weight[side[v]] > balance.max[side[v]])
+            {
+              candidates.push_back (std::make_pair (-gain[v], v));
+            }
+        }
+      std::sort (candidates.begin (), candidates.end ());
+
+      bool moved = false;
+      for (uint32_t i = 0; i < candidates.size (); i++)
+        {
+          uint32_t v = candidates[i].second;
+          uint8_t from = side[v];
+          uint8_t to = 1 - from;
+          if (balance.weight[to] + g.vwgt[v] > balance.max[to])
+            {
+              continue;
+            }
+          if (balance.weight[from] <= balance.max[from])
+            {
+              // only a better cut, or the same cut with a better balance
+              if (gain[v] < 0
+                  || (gain[v] == 0 && balance.weight[from] < balance.target[from] + g.vwgt[v]))
+                {
+                  continue;
+                }
+              bool shorter = false;
+              for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1] && !shorter; e++)
+                {
+                  shorter = side[g.adjncy[e]] == from && g.adjdelay[e] < lookAhead;
+                }
+              if (shorter)
+                {
+                  continue;
+                }
+            }
+          side[v] = to;
+          balance.weight[from] -= g.vwgt[v];
+          balance.weight[to] += g.vwgt[v];
+          gain[v] = -gain[v];
+          for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1]; e++)
+            {
+              uint32_t u = g.adjncy[e];
+              gain[u] += side[u] == to ? -2 * static_cast<int64_t> (g.adjwgt[e]) : 2 * static_cast<int64_t> (g.adjwgt[e]);
+            }
+          moved = true;
+        }
+      if (!moved)
+        {
+          break;
+        }
+    }
+}
+
+/*
+ * Grows side 0 from a few seeds in breadth first order and keeps the
+ * best refined result.
+ */
+void
+InitialBisection (const Graph &g, double fraction, double imbalance, std::vector<uint8_t> &side)
+{
+  uint32_t n = g.GetN ();
+  uint64_t target = static_cast<uint64_t> (g.GetTotalWeight () * fraction + 0.5);
+  uint32_t tries = std::min (n, INITIAL_TRIES);
+  uint64_t bestOverweight = NO_DELAY, bestWeight = NO_DELAY, bestDelay = 0;
+
+  side.assign (n, 1);
+  for (uint32_t t = 0; t < tries; t++)
+    {
+      std::vector<uint8_t> candidate (n, 1);
+      std::vector<bool> queued (n, false);
+      std::list<uint32_t> queue;
+      uint64_t weight = 0;
+      uint32_t next = t * n / tries;
+      while (weight < target)
+        {
+          if (queue.empty ())
+            {
+              // another component
+              while (queued[next])
+                {
+                  next = (next + 1) % n;
+                }
+              queue.push_back (next);
+              queued[next] = true;
+            }
+          uint32_t v = queue.front ();
+          queue.pop_front ();
+          candidate[v] = 0;
+          weight += g.vwgt[v];
+          for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1]; e++)
+            {
+              if (!queued[g.adjncy[e]])
+                {
+                  queued[g.adjncy[e]] = true;
+                  queue.push_back (g.adjncy[e]);
+                }
+            }
+        }
+      Refine (g, fraction, imbalance, candidate);
+
+      uint64_t overweight = Balance (g, fraction, imbalance, candidate).GetOverweight ();
+      uint64_t cutWeight, cutDelay;
+      GetCut (g, candidate, cutWeight, cutDelay);
+      if (overweight < bestOverweight
+          || (overweight == bestOverweight && cutWeight < bestWeight)
+          || (overweight == bestOverweight && cutWeight == bestWeight && cutDelay > bestDelay))
+        {
+          bestOverweight = overweight;
+          bestWeight = cutWeight;
+          bestDelay = cutDelay;
+          side = candidate;
+        }
+    }
+}
+
+/*
+ * Splits g in two, side 0 getting fraction of the weight.
+ */
+void
+Bisect (const Graph &g, double fraction, double imbalance, std::vector<uint8_t> &side)
+{
+  Graph coarse;
+  std::vector<uint32_t> cmap;
+  if (g.GetN () > COARSEST_SIZE && Coarsen (g, coarse, cmap))
+    {
+      std::vector<uint8_t> coarseSide;
+      Bisect (coarse, fraction, imbalance, coarseSide);
+      side.resize (g.GetN ());
+      for (uint32_t v = 0; v < g.GetN (); v++)
+        {
+          side[v] = coarseSide[cmap[v]];
+        }
+      Refine (g, fraction, imbalance, side);
+    }
+  else
+    {
+      InitialBisection (g, fraction, imbalance, side);
+    }
+}
+
+/*
+ * Recursive bisection of g into nParts partitions numbered from first;
+ * vertices maps the vertices of g to the ones of the original graph.
+ */
+void
+PartitionGraph (const Graph &g, const std::vector<uint32_t> &vertices, uint32_t nParts, uint32_t first,
+                double imbalance, std::vector<uint32_t> &parts)
+{
+  uint32_t n = g.GetN ();
+  if (nParts == 1 || n == 0)
+    {
+      for (uint32_t v = 0; v < n; v++)
+        {
+          parts[vertices[v]] = first;
+        }
+      return;
+    }
+  uint32_t nParts0 = nParts / 2;
+  std::vector<uint8_t> side;
+  Bisect (g, static_cast<double> (nParts0) / nParts, imbalance, side);
+
+  std::vector<uint32_t> local (n);
+  for (uint8_t s = 0; s < 2; s++)
+    {
+      Graph sub;
+      std::vector<uint32_t> subVertices;
+      for (uint32_t v = 0; v < n; v++)
+        {
+          if (side[v] == s)
+            {
+              local[v] = subVertices.size ();
+              subVertices.push_back (vertices[v]);
+              sub.vwgt.push_back (g.vwgt[v]);
+            }
+        }
+      sub.xadj.push_back (0);
+      for (uint32_t v = 0; v < n; v++)
+        {
+          if (side[v] != s)
+            {
+              continue;
+            }
+          for (uint32_t e = g.xadj[v]; e < g.xadj[v + 1]; e++)
+            {
+              if (side[g.adjncy[e]] == s)
+                {
+                  sub.adjncy.push_back (local[g.adjncy[e]]);
+                  sub.adjwgt.push_back (g.adjwgt[e]);
+                  sub.adjdelay.push_back (g.adjdelay[e]);
+                }
+            }
+          sub.xadj.push_back (sub.adjncy.size ());
+        }
+      PartitionGraph (sub, subVertices, s == 0 ? nParts0 : nParts - nParts0,
+                      s == 0 ? first : first + nParts0, imbalance, parts);
+    }
+}
+
+} // anonymous namespace
+
+TopologyPartitioner::TopologyPartitioner ()
+  : m_imbalance (0.03),
+    m_defaultDelay (Seconds (0)),
+    m_nLinks (0),
+    m_nCutLinks (0),
+    m_lookAhead (Seconds (0))
+{
+}
+
+void
+TopologyPartitioner::SetImbalance (double imbalance)
+{
+  m_imbalance = imbalance;
+}
+
+void
+TopologyPartitioner::SetDefaultDelay (Time delay)
+{
+  m_defaultDelay = delay;
+}
+
+void
+TopologyPartitioner::Partition (NodeContainer nodes, TopologyReader::ConstLinksIterator begin,
+                                TopologyReader::ConstLinksIterator end, uint32_t nPartitions)
+{
+  NS_ASSERT (nPartitions > 0);
+  m_nodes = nodes;
+  std::map<uint32_t, uint32_t> index;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      index.insert (std::make_pair (m_nodes.Get (i)->GetId (), i));
+    }
+
+  // one edge per pair of nodes, in both directions
+  std::vector<std::map<uint32_t, std::pair<uint32_t, uint64_t> > > edges (m_nodes.GetN ());
+  std::vector<std::pair<std::pair<uint32_t, uint32_t>, uint64_t> > links;
+  for (TopologyReader::ConstLinksIterator i = begin; i != end; i++)
+    {
+      TopologyReader::Link link = *i;
+      Ptr<Node> ends[2] = { link.GetFromNode (), link.GetToNode () };
+      uint32_t v[2];
+      for (uint32_t k = 0; k < 2; k++)
+        {
+          std::map<uint32_t, uint32_t>::iterator found = index.find (ends[k]->GetId ());
+          if (found == index.end ())
+            {
+              found = index.insert (std::make_pair (ends[k]->GetId (), m_nodes.GetN ())).first;
+              m_nodes.Add (ends[k]);
+              edges.resize (m_nodes.GetN ());
+            }
+          v[k] = found->second;
+        }
+      std::string value;
+      uint64_t delay = m_defaultDelay.GetTimeStep ();
+      if (link.GetAttributeFailSafe ("Delay", value))
+        {
+          delay = Time (value).GetTimeStep ();
+        }
+      links.push_back (std::make_pair (std::make_pair (v[0], v[1]), delay));
+      if (v[0] == v[1])
+        {
+          continue;
+        }
+      for (uint32_t k = 0; k < 2; k++)
+        {
+          std::map<uint32_t, std::pair<uint32_t, uint64_t> >::iterator edge = edges[v[k]].find (v[1 - k]);
+          if (edge == edges[v[k]].end ())
+            {
+              edges[v[k]][v[1 - k]] = std::make_pair (1U, delay);
+            }
+          else
+            {
+              edge->second.first++;
+              edge->second.second = std::min (edge->second.second, delay);
+            }
+        }
+    }
+
+  Graph g;
+  std::vector<uint32_t> vertices;
+  g.xadj.push_back (0);
+  for (uint32_t v = 0; v < m_nodes.GetN (); v++)
+    {
+      for (std::map<uint32_t, std::pair<uint32_t, uint64_t> >::const_iterator e = edges[v].begin ();
+           e != edges[v].end (); e++)
+        {
+          g.adjncy.push_back (e->first);
+          g.adjwgt.push_back (e->second.first);
+          g.adjdelay.push_back (e->second.second);
+        }
+      g.xadj.push_back (g.adjncy.size ());
+      g.vwgt.push_back (1);
+      vertices.push_back (v);
+    }
+
+  std::vector<uint32_t> parts (m_nodes.GetN (), 0);
+  PartitionGraph (g, vertices, nPartitions, 0, m_imbalance, parts);
+
+  m_partitions.clear ();
+  m_partitionNodes.assign (nPartitions, 0);
+  m_partitionCutLinks.assign (nPartitions, 0);
+  for (uint32_t v = 0; v < m_nodes.GetN (); v++)
+    {
+      m_partitions[m_nodes.Get (v)->GetId ()] = parts[v];
+      m_partitionNodes[parts[v]]++;
+    }
+  m_nLinks = links.size ();
+  m_nCutLinks = 0;
+  uint64_t lookAhead = NO_DELAY;
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      uint32_t from = parts[links[i].first.first];
+      uint32_t to = parts[links[i].first.second];
+      if (from != to)
+        {
+          m_nCutLinks++;
+          m_partitionCutLinks[from]++;
+          m_partitionCutLinks[to]++;
+          lookAhead = std::min (lookAhead, links[i].second);
+        }
+    }
+  m_lookAhead = TimeStep (lookAhead == NO_DELAY ? 0 : lookAhead);
+  NS_LOG_INFO (nPartitions << " partitions, " << m_nCutLinks << " cut links out of " << m_nLinks <<
+               ", lookahead " << m_lookAhead);
+}
+
+void
+TopologyPartitioner::Assign (void) const
+{
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      m_nodes.Get (i)->SetSystemId (GetPartition (m_nodes.Get (i)));
+    }
+}
+
+uint32_t
+TopologyPartitioner::GetPartition (Ptr<Node> node) const
+{
+  std::map<uint32_t, uint32_t>::const_iterator i = m_partitions.find (node->GetId ());
+  NS_ASSERT_MSG (i != m_partitions.end (), "Node " << node->GetId () << " was not partitioned");
+  return i->second;
+}
+
+uint32_t
+TopologyPartitioner::GetNPartitions (void) const
+{
+  return m_partitionNodes.size ();
+}
+
+uint32_t
+TopologyPartitioner::GetNCutLinks (void) const
+{
+  return m_nCutLinks;
+}
+
+Time
+TopologyPartitioner::GetLookAhead (void) const
+{
+  return m_lookAhead;
+}
+
+void
+TopologyPartitioner::Print (std::ostream &os) const
+{
+  os << GetNPartitions () << " partitions, " << m_nodes.GetN () << " nodes, " << m_nLinks << " links, "
+     << m_nCutLinks << " cut links, lookahead " << m_lookAhead.GetSeconds () << "s" << std::endl;
+  for (uint32_t i = 0; i < GetNPartitions (); i++)
+    {
+      os << "partition " << i << ": " << m_partitionNodes[i] << " nodes, "
+         << m_partitionCutLinks[i] << " cut links" << std::endl;
+    }
+  for (std::map<uint32_t, uint32_t>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      os << "node " << i->first << ": partition " << i->second << std::endl;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit tests
+//-----------------------------------------------------------------------------
+
+class TopologyPartitionerTestCase : public TestCase
+{
+public:
+  TopologyPartitionerTestCase ();
+  virtual bool DoRun (void);
+};
+
+TopologyPartitionerTestCase::TopologyPartitionerTestCase ()
+  : TestCase ("Split two clusters and a ring")
+{
+}
+
+bool
+TopologyPartitionerTestCase::DoRun (void)
+{
+  // two cliques of 8 nodes with 1ms links, joined by two 10ms links
+  NodeContainer nodes;
+  nodes.Create (16);
+  std::list<TopologyReader::Link> links;
+  std::string shortDelay = "1ms";
+  std::string longDelay = "10ms";
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      for (uint32_t i = 0; i < 8; i++)
+        {
+          for (uint32_t j = i + 1; j < 8; j++)
+            {
+              TopologyReader::Link link (nodes.Get (8 * c + i), "", nodes.Get (8 * c + j), "");
+              link.SetAttribute ("Delay", shortDelay);
+              links.push_back (link);
+            }
+        }
+    }
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      TopologyReader::Link link (nodes.Get (i), "", nodes.Get (8 + i), "");
+      link.SetAttribute ("Delay", longDelay);
+      links.push_back (link);
+    }
+
+  TopologyPartitioner partitioner;
+  partitioner.Partition (nodes, links.begin (), links.end (), 2);
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetNCutLinks (), 2, "Only the links between the cliques are cut");
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetLookAhead (), MilliSeconds (10), "The long links give the lookahead");
+  for (uint32_t i = 1; i < 8; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (partitioner.GetPartition (nodes.Get (i)), partitioner.GetPartition (nodes.Get (0)),
+                             "A clique is in a single partition");
+    }
+
+  // a ring of 64 nodes in 4 partitions: 16 consecutive nodes each
+  NodeContainer ring;
+  ring.Create (64);
+  links.clear ();
+  for (uint32_t i = 0; i < 64; i++)
+    {
+      links.push_back (TopologyReader::Link (ring.Get (i), "", ring.Get ((i + 1) % 64), ""));
+    }
+  partitioner.SetDefaultDelay (MilliSeconds (2));
+  partitioner.Partition (ring, links.begin (), links.end (), 4);
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetNPartitions (), 4, "Partition count");
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetNCutLinks (), 4, "Each partition is an arc of the ring");
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetLookAhead (), MilliSeconds (2), "Default delay");
+  std::vector<uint32_t> sizes (4, 0);
+  for (uint32_t i = 0; i < 64; i++)
+    {
+      sizes[partitioner.GetPartition (ring.Get (i))]++;
+    }
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (sizes[i], 16, "Balanced partitions");
+    }
+
+  partitioner.Assign ();
+  NS_TEST_EXPECT_MSG_EQ (ring.Get (0)->GetSystemId (), partitioner.GetPartition (ring.Get (0)), "System id");
+
+  Simulator::Destroy ();
+  return GetErrorStatus ();
+}
+
+static class TopologyPartitionerTestSuite : public TestSuite
+{
+public:
+  TopologyPartitionerTestSuite ()
+    : TestSuite ("topology-partitioner", UNIT)
+  {
+    AddTestCase (new TopologyPartitionerTestCase ());
+  }
+} g_topologyPartitionerTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TOPOLOGY_PARTITIONER_H
+#define TOPOLOGY_PARTITIONER_H
+
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "topology-reader.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup topology
+ * \brief Splits the nodes of a topology into partitions for a parallel run.
+ *
+ * The partitions balance the number of nodes and cut as few links as
+ * possible, by multilevel recursive bisection: the graph is coarsened by
+ * merging the two ends of links, the coarsest one is bisected by growing
+ * a region from several seeds, and the bisection is refined with
+ * Fiduccia-Mattheyses moves while it is projected back to the original
+ * graph. The links with the smallest delay are merged first and the
+ * refinement never cuts a link shorter than the ones already cut, so
+ * the lookahead, the smallest delay of the cut links, stays as long as
+ * possible.
+ *
+ * The delay of a link is its "Delay" attribute, such as "2ms", or the
+ * default delay when it has none. Assign makes the partition of each
+ * node its system id, which is the rank of DistributedSimulatorImpl and
+ * the partition of MultithreadedSimulatorImpl.
+ */
+class TopologyPartitioner
+{
+public:
+  TopologyPartitioner ();
+
+  /**
+   * \param imbalance how much heavier than its share a partition may be,
+   * 0.03 by default.
+   */
+  void SetImbalance (double imbalance);
+  /**
+   * \param delay the delay of the links without a "Delay" attribute.
+   */
+  void SetDefaultDelay (Time delay);
+
+  /**
+   * \brief Splits the nodes.
+   *
+   * \param nodes the nodes to split, the ends of the links are added if
+   * they are missing.
+   * \param begin the first link between the nodes
+   * \param end past the last link between the nodes
+   * \param nPartitions the number of partitions
+   */
+  void Partition (NodeContainer nodes, TopologyReader::ConstLinksIterator begin,
+                  TopologyReader::ConstLinksIterator end, uint32_t nPartitions);
+  /**
+   * \brief Sets the system id of every node to its partition.
+   */
+  void Assign (void) const;
+
+  /**
+   * \param node a node which was split
+   * \returns the partition of the node
+   */
+  uint32_t GetPartition (Ptr<Node> node) const;
+  uint32_t GetNPartitions (void) const;
+  /**
+   * \returns the number of links between two partitions
+   */
+  uint32_t GetNCutLinks (void) const;
+  /**
+   * \returns the smallest delay of the links between two partitions,
+   * zero when there are none.
+   */
+  Time GetLookAhead (void) const;
+  /**
+   * \brief Writes the size, the cut links and the lookahead of the
+   * partitions, followed by the partition of each node.
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  double m_imbalance;
+  Time m_defaultDelay;
+  NodeContainer m_nodes;
+  // partition of each node id
+  std::map<uint32_t, uint32_t> m_partitions;
+  std::vector<uint32_t> m_partitionNodes;
+  std::vector<uint32_t> m_partitionCutLinks;
+  uint32_t m_nLinks;
+  uint32_t m_nCutLinks;
+  Time m_lookAhead;
+};
+
+} // namespace ns3
+
+#endif /* TOPOLOGY_PARTITIONER_H */
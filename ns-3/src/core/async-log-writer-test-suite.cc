@@ -0,0 +1,394 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "test.h"
+#include "async-log-writer.h"
+#include "system-thread.h"
+
+#include <unistd.h>
+#include <sstream>
+#include <string>
+
+namespace ns3 {
+
+// Collects what the writer thread writes, which waits while the gate is
+// closed so that the tests can fill the ring
+class GatedStreamBuf : public std::streambuf
+{
+public:
+  GatedStreamBuf ()
+    : m_open (true)
+  {
+  }
+  void Close (void)
+  {
+    m_open = false;
+  }
+  void Open (void)
+  {
+    m_open = true;
+  }
+  std::string GetData (void) const
+  {
+    return m_data;
+  }
+
+protected:
+  virtual std::streamsize xsputn (const char *data, std::streamsize size)
+  {
+    while (!m_open)
+      {
+        usleep (100);
+      }
+    m_data.append (data, size);
+    return size;
+  }
+  virtual int overflow (int c)
+  {
+    if (!traits_type::eq_int_type (c, traits_type::eof ()))
+      {
+        char ch = traits_type::to_char_type (c);
+        xsputn (&ch, 1);
+      }
+    return traits_type::not_eof (c);
+  }
+
+private:
+  volatile bool m_open;
+  std::string m_data;
+};
+
+// A record of this size whose bytes tell which record it is
+static std::string
+MakeRecord (uint32_t index, uint32_t size)
+{
+  std::string record;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      record += static_cast<char> ('a' + (index + i) % 26);
+    }
+  return record;
+}
+
+/**
+ * \brief Pushes many more records than the ring holds through a small ring,
+ * so that it wraps around, and checks the output byte for byte.
+ */
+class AsyncLogWriterWrapTestCase : public TestCase
+{
+public:
+  AsyncLogWriterWrapTestCase ();
+  virtual ~AsyncLogWriterWrapTestCase ();
+
+private:
+  virtual bool DoRun (void);
+};
+
+AsyncLogWriterWrapTestCase::AsyncLogWriterWrapTestCase ()
+  : TestCase ("Records wrap around the ring and come out unchanged")
+{
+}
+
+AsyncLogWriterWrapTestCase::~AsyncLogWriterWrapTestCase ()
+{
+}
+
+bool
+AsyncLogWriterWrapTestCase::DoRun (void)
+{
+  // with BLOCK the producer outruns the writer thread and waits for it
+  GatedStreamBuf blockTarget;
+  Ptr<AsyncLogWriter> writer = Create<AsyncLogWriter> (&blockTarget, 64, AsyncLogWriter::BLOCK);
+  std::string expected;
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      std::string record = MakeRecord (i, 1 + (i * 7) % 23);
+      expected += record;
+      NS_TEST_ASSERT_MSG_EQ (writer->Write (record.data (), record.size ()), true, "BLOCK record " << i << " dropped");
+    }
+  // too large for the ring, written out after what is queued
+  std::string large = MakeRecord (2000, 100);
+  expected += large;
+  NS_TEST_ASSERT_MSG_EQ (writer->Write (large.data (), large.size ()), true, "Large BLOCK record dropped");
+  writer->Flush ();
+  NS_TEST_ASSERT_MSG_EQ (blockTarget.GetData (), expected, "BLOCK output differs");
+  NS_TEST_ASSERT_MSG_EQ (writer->GetDroppedRecords (), 0, "BLOCK dropped records");
+  writer->Stop ();
+
+  // with DROP, flushing between records never lets the ring fill up
+  GatedStreamBuf dropTarget;
+  writer = Create<AsyncLogWriter> (&dropTarget, 16, AsyncLogWriter::DROP);
+  expected.clear ();
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      std::string record = MakeRecord (i, 1 + (i * 5) % 16);
+      expected += record;
+      NS_TEST_ASSERT_MSG_EQ (writer->Write (record.data (), record.size ()), true, "DROP record " << i << " dropped");
+      writer->Flush ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (dropTarget.GetData (), expected, "DROP output differs");
+  NS_TEST_ASSERT_MSG_EQ (writer->GetDroppedRecords (), 0, "DROP dropped records");
+  writer->Stop ();
+  return GetErrorStatus ();
+}
+
+/**
+ * \brief Fills the ring while the writer thread is stuck in the target and
+ * checks which records the DROP policy keeps and counts.
+ */
+class AsyncLogWriterDropTestCase : public TestCase
+{
+public:
+  AsyncLogWriterDropTestCase ();
+  virtual ~AsyncLogWriterDropTestCase ();
+
+private:
+  virtual bool DoRun (void);
+};
+
+AsyncLogWriterDropTestCase::AsyncLogWriterDropTestCase ()
+  : TestCase ("DROP keeps what fits into the ring and counts the rest")
+{
+}
+
+AsyncLogWriterDropTestCase::~AsyncLogWriterDropTestCase ()
+{
+}
+
+bool
+AsyncLogWriterDropTestCase::DoRun (void)
+{
+  GatedStreamBuf target;
+  Ptr<AsyncLogWriter> writer = Create<AsyncLogWriter> (&target, 32, AsyncLogWriter::DROP);
+  std::string expected;
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      // the space only comes back once the writer thread got through the
+      // gate, so what fits does not depend on the thread timing
+      target.Close ();
+      uint32_t sizes[] = { 10, 10, 10, 10, 2, 1, 40 };
+      bool kept[] = { true, true, true, false, true, false, false };
+      for (uint32_t i = 0; i < 7; i++)
+        {
+          std::string record = MakeRecord (round * 7 + i, sizes[i]);
+          NS_TEST_ASSERT_MSG_EQ (writer->Write (record.data (), record.size ()), kept[i],
+                                 "Record " << i << " of round " << round);
+          if (kept[i])
+            {
+              expected += record;
+            }
+        }
+      target.Open ();
+      writer->Flush ();
+      NS_TEST_ASSERT_MSG_EQ (target.GetData (), expected, "Output after round " << round);
+      NS_TEST_ASSERT_MSG_EQ (writer->GetDroppedRecords (), 3 * (round + 1), "Dropped records after round " << round);
+      NS_TEST_ASSERT_MSG_EQ (writer->GetDroppedBytes (), 51 * (round + 1), "Dropped bytes after round " << round);
+    }
+  writer->Stop ();
+  return GetErrorStatus ();
+}
+
+/**
+ * \brief Fills the ring while the writer thread is stuck in the target and
+ * checks a BLOCK producer waits until the target moves again.
+ */
+class AsyncLogWriterBlockTestCase : public TestCase
+{
+public:
+  AsyncLogWriterBlockTestCase ();
+  virtual ~AsyncLogWriterBlockTestCase ();
+
+private:
+  virtual bool DoRun (void);
+  void OpenLater (void);
+
+  GatedStreamBuf m_target;
+  volatile bool m_opened;
+};
+
+AsyncLogWriterBlockTestCase::AsyncLogWriterBlockTestCase ()
+  : TestCase ("BLOCK waits for room in the ring")
+{
+}
+
+AsyncLogWriterBlockTestCase::~AsyncLogWriterBlockTestCase ()
+{
+}
+
+void
+AsyncLogWriterBlockTestCase::OpenLater (void)
+{
+  usleep (50000);
+  m_opened = true;
+  m_target.Open ();
+}
+
+bool
+AsyncLogWriterBlockTestCase::DoRun (void)
+{
+  m_opened = false;
+  m_target.Close ();
+  Ptr<AsyncLogWriter> writer = Create<AsyncLogWriter> (&m_target, 32, AsyncLogWriter::BLOCK);
+  Ptr<SystemThread> opener = Create<SystemThread> (MakeCallback (&AsyncLogWriterBlockTestCase::OpenLater, this));
+  opener->Start ();
+  std::string expected;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      std::string record = MakeRecord (i, 10);
+      expected += record;
+      writer->Write (record.data (), record.size ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_opened, false, "Records which fit waited");
+  std::string record = MakeRecord (3, 10);
+  expected += record;
+  NS_TEST_ASSERT_MSG_EQ (writer->Write (record.data (), record.size ()), true, "BLOCK record dropped");
+  NS_TEST_ASSERT_MSG_EQ (m_opened, true, "Record beyond the ring did not wait");
+  opener->Join ();
+  writer->Flush ();
+  NS_TEST_ASSERT_MSG_EQ (m_target.GetData (), expected, "BLOCK output differs");
+  NS_TEST_ASSERT_MSG_EQ (writer->GetDroppedRecords (), 0, "BLOCK dropped records");
+  writer->Stop ();
+  return GetErrorStatus ();
+}
+
+/**
+ * \brief Checks Flush and FlushAll return only once everything written
+ * before is in the targets, and that writes after Stop go straight through.
+ */
+class AsyncLogWriterFlushTestCase : public TestCase
+{
+public:
+  AsyncLogWriterFlushTestCase ();
+  virtual ~AsyncLogWriterFlushTestCase ();
+
+private:
+  virtual bool DoRun (void);
+};
+
+AsyncLogWriterFlushTestCase::AsyncLogWriterFlushTestCase ()
+  : TestCase ("Flush and FlushAll wait for the queued records")
+{
+}
+
+AsyncLogWriterFlushTestCase::~AsyncLogWriterFlushTestCase ()
+{
+}
+
+bool
+AsyncLogWriterFlushTestCase::DoRun (void)
+{
+  GatedStreamBuf targets[2];
+  Ptr<AsyncLogWriter> writers[2];
+  std::string expected[2];
+  for (uint32_t w = 0; w < 2; w++)
+    {
+      writers[w] = Create<AsyncLogWriter> (&targets[w], 4096, AsyncLogWriter::DROP);
+    }
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      uint32_t w = i % 2;
+      std::string record = MakeRecord (i, 20 + i);
+      expected[w] += record;
+      writers[w]->Write (record.data (), record.size ());
+      if (i == 20)
+        {
+          writers[0]->Flush ();
+          NS_TEST_ASSERT_MSG_EQ (targets[0].GetData (), expected[0], "Flush returned early");
+        }
+    }
+  AsyncLogWriter::FlushAll ();
+  for (uint32_t w = 0; w < 2; w++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (targets[w].GetData (), expected[w], "FlushAll returned early for writer " << w);
+      writers[w]->Stop ();
+    }
+
+  std::string late = MakeRecord (40, 8);
+  expected[0] += late;
+  NS_TEST_ASSERT_MSG_EQ (writers[0]->Write (late.data (), late.size ()), true, "Write after Stop dropped");
+  NS_TEST_ASSERT_MSG_EQ (targets[0].GetData (), expected[0], "Write after Stop not written through");
+  return GetErrorStatus ();
+}
+
+/**
+ * \brief Redirects std::clog through a writer and checks Restore puts its
+ * original stream buffer back with everything written in between.
+ */
+class AsyncLogWriterRedirectTestCase : public TestCase
+{
+public:
+  AsyncLogWriterRedirectTestCase ();
+  virtual ~AsyncLogWriterRedirectTestCase ();
+
+private:
+  virtual bool DoRun (void);
+};
+
+AsyncLogWriterRedirectTestCase::AsyncLogWriterRedirectTestCase ()
+  : TestCase ("Redirect and Restore std::clog")
+{
+}
+
+AsyncLogWriterRedirectTestCase::~AsyncLogWriterRedirectTestCase ()
+{
+}
+
+bool
+AsyncLogWriterRedirectTestCase::DoRun (void)
+{
+  std::streambuf *console = std::clog.rdbuf ();
+  std::stringbuf captured;
+  std::clog.rdbuf (&captured);
+
+  Ptr<AsyncLogWriter> writer = AsyncLogWriter::Redirect (std::clog, 64, AsyncLogWriter::BLOCK);
+  bool redirected = std::clog.rdbuf () != &captured;
+  std::ostringstream expected;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      std::clog << "line " << i << " " << MakeRecord (i, i % 30) << std::endl;
+      expected << "line " << i << " " << MakeRecord (i, i % 30) << std::endl;
+    }
+  // no std::endl, the record is cut by Restore
+  std::clog << "tail";
+  expected << "tail";
+  AsyncLogWriter::Restore (std::clog);
+  std::streambuf *restored = std::clog.rdbuf ();
+  // a second Restore finds nothing to undo
+  AsyncLogWriter::Restore (std::clog);
+  std::clog.rdbuf (console);
+
+  NS_TEST_ASSERT_MSG_EQ (redirected, true, "Redirect did not replace the stream buffer");
+  NS_TEST_ASSERT_MSG_EQ ((restored == &captured), true, "Restore did not put the stream buffer back");
+  NS_TEST_ASSERT_MSG_EQ (captured.str (), expected.str (), "Redirected output differs");
+  NS_TEST_ASSERT_MSG_EQ (writer->GetDroppedRecords (), 0, "Redirected records dropped");
+  return GetErrorStatus ();
+}
+
+static class AsyncLogWriterTestSuite : public TestSuite
+{
+public:
+  AsyncLogWriterTestSuite ()
+    : TestSuite ("async-log-writer", UNIT)
+  {
+    AddTestCase (new AsyncLogWriterWrapTestCase ());
+    AddTestCase (new AsyncLogWriterDropTestCase ());
+    AddTestCase (new AsyncLogWriterBlockTestCase ());
+    AddTestCase (new AsyncLogWriterFlushTestCase ());
+    AddTestCase (new AsyncLogWriterRedirectTestCase ());
+  }
+} g_asyncLogWriterTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,319 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "async-log-writer.h"
+#include "system-mutex.h"
+#include "assert.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <list>
+
+namespace ns3 {
+
+// How long the writer thread sleeps when there is nothing to write, and
+// how long a blocked producer waits before it looks for room again
+static const uint32_t IDLE_SLEEP_US = 1000;
+static const uint32_t FULL_SLEEP_US = 50;
+
+namespace {
+
+// Cuts what is written to a stream into records for an AsyncLogWriter
+class AsyncStreamBuf : public std::streambuf
+{
+public:
+  AsyncStreamBuf (Ptr<AsyncLogWriter> writer)
+    : m_writer (writer)
+  {
+    setp (m_buffer, m_buffer + sizeof (m_buffer));
+  }
+  Ptr<AsyncLogWriter> GetWriter (void) const
+  {
+    return m_writer;
+  }
+
+protected:
+  virtual int overflow (int c)
+  {
+    Commit ();
+    if (!traits_type::eq_int_type (c, traits_type::eof ()))
+      {
+        *pptr () = traits_type::to_char_type (c);
+        pbump (1);
+      }
+    return traits_type::not_eof (c);
+  }
+  virtual int sync (void)
+  {
+    Commit ();
+    return 0;
+  }
+
+private:
+  void Commit (void)
+  {
+    if (pptr () > pbase ())
+      {
+        m_writer->Write (pbase (), pptr () - pbase ());
+      }
+    setp (m_buffer, m_buffer + sizeof (m_buffer));
+  }
+
+  Ptr<AsyncLogWriter> m_writer;
+  char m_buffer[1024];
+};
+
+struct Redirection
+{
+  std::ostream *stream;
+  std::streambuf *original;
+  AsyncStreamBuf *buffer;
+};
+
+// Never destroyed, writers may still be stopped by exit handlers
+// that run after the static destructors
+
+SystemMutex &
+GetRegistryMutex (void)
+{
+  static SystemMutex *mutex = new SystemMutex ();
+  return *mutex;
+}
+
+std::list<AsyncLogWriter *> &
+GetWriters (void)
+{
+  static std::list<AsyncLogWriter *> *writers = new std::list<AsyncLogWriter *> ();
+  return *writers;
+}
+
+std::list<Redirection> &
+GetRedirections (void)
+{
+  static std::list<Redirection> *redirections = new std::list<Redirection> ();
+  return *redirections;
+}
+
+void
+RestoreAll (void)
+{
+  while (!GetRedirections ().empty ())
+    {
+      AsyncLogWriter::Restore (*GetRedirections ().front ().stream);
+    }
+}
+
+} // anonymous namespace
+
+AsyncLogWriter::AsyncLogWriter (std::streambuf *target, uint32_t capacity, FullPolicy policy)
+  : m_target (target),
+    m_ring (std::max<uint32_t> (capacity, 1)),
+    m_capacity (m_ring.size ()),
+    m_head (0),
+    m_tail (0),
+    m_stopping (false),
+    m_running (true),
+    m_policy (policy),
+    m_droppedRecords (0),
+    m_droppedBytes (0)
+{
+  {
+    CriticalSection lock (GetRegistryMutex ());
+    GetWriters ().push_back (this);
+  }
+  m_thread = Create<SystemThread> (MakeCallback (&AsyncLogWriter::Run, this));
+  m_thread->Start ();
+}
+
+AsyncLogWriter::~AsyncLogWriter ()
+{
+  Stop ();
+  CriticalSection lock (GetRegistryMutex ());
+  GetWriters ().remove (this);
+}
+
+bool
+AsyncLogWriter::Write (const char *data, uint32_t size)
+{
+  if (!m_running)
+    {
+      m_target->sputn (data, size);
+      return true;
+    }
+  if (size > m_capacity)
+    {
+      if (m_policy == DROP)
+        {
+          m_droppedRecords++;
+          m_droppedBytes += size;
+          return false;
+        }
+      // Too large to ever fit, write it ourselves once the thread is idle
+      Flush ();
+      m_target->sputn (data, size);
+      m_target->pubsync ();
+      return true;
+    }
+
+  uint64_t head = m_head;
+  while (m_capacity - (head - m_tail) < size)
+    {
+      if (m_policy == DROP)
+        {
+          m_droppedRecords++;
+          m_droppedBytes += size;
+          return false;
+        }
+      usleep (FULL_SLEEP_US);
+    }
+  // The writer thread is done with the bytes behind the tail we just read
+  __sync_synchronize ();
+  uint64_t start = head % m_capacity;
+  uint64_t first = std::min<uint64_t> (size, m_capacity - start);
+  memcpy (&m_ring[start], data, first);
+  memcpy (&m_ring[0], data + first, size - first);
+  // Publish the data before the new head
+  __sync_synchronize ();
+  m_head = head + size;
+  return true;
+}
+
+void
+AsyncLogWriter::Flush (void)
+{
+  while (m_running && m_tail != m_head)
+    {
+      usleep (FULL_SLEEP_US);
+    }
+}
+
+void
+AsyncLogWriter::Stop (void)
+{
+  if (!m_running)
+    {
+      return;
+    }
+  Flush ();
+  m_stopping = true;
+  m_thread->Join ();
+  m_running = false;
+}
+
+uint64_t
+AsyncLogWriter::GetDroppedRecords (void) const
+{
+  return m_droppedRecords;
+}
+
+uint64_t
+AsyncLogWriter::GetDroppedBytes (void) const
+{
+  return m_droppedBytes;
+}
+
+void
+AsyncLogWriter::Run (void)
+{
+  while (true)
+    {
+      bool stopping = m_stopping;
+      __sync_synchronize ();
+      uint64_t head = m_head;
+      // Read the head before the data it covers
+      __sync_synchronize ();
+      if (head != m_tail)
+        {
+          Drain (head);
+        }
+      else if (stopping)
+        {
+          return;
+        }
+      else
+        {
+          usleep (IDLE_SLEEP_US);
+        }
+    }
+}
+
+void
+AsyncLogWriter::Drain (uint64_t head)
+{
+  uint64_t tail = m_tail;
+  uint64_t start = tail % m_capacity;
+  uint64_t size = head - tail;
+  uint64_t first = std::min<uint64_t> (size, m_capacity - start);
+  m_target->sputn (&m_ring[start], first);
+  m_target->sputn (&m_ring[0], size - first);
+  m_target->pubsync ();
+  // Finish reading the data before handing the space back
+  __sync_synchronize ();
+  m_tail = head;
+}
+
+void
+AsyncLogWriter::FlushAll (void)
+{
+  CriticalSection lock (GetRegistryMutex ());
+  for (std::list<AsyncLogWriter *>::iterator i = GetWriters ().begin (); i != GetWriters ().end (); i++)
+    {
+      (*i)->Flush ();
+    }
+}
+
+Ptr<AsyncLogWriter>
+AsyncLogWriter::Redirect (std::ostream &stream, uint32_t capacity, FullPolicy policy)
+{
+  static bool restoreAtExit = false;
+  if (!restoreAtExit)
+    {
+      // Static destructors would otherwise run with the writer threads alive
+      atexit (&RestoreAll);
+      restoreAtExit = true;
+    }
+  Restore (stream);
+
+  stream.flush ();
+  Redirection redirection;
+  redirection.stream = &stream;
+  redirection.original = stream.rdbuf ();
+  redirection.buffer = new AsyncStreamBuf (Create<AsyncLogWriter> (redirection.original, capacity, policy));
+  stream.rdbuf (redirection.buffer);
+  GetRedirections ().push_back (redirection);
+  return redirection.buffer->GetWriter ();
+}
+
+void
+AsyncLogWriter::Restore (std::ostream &stream)
+{
+  for (std::list<Redirection>::iterator i = GetRedirections ().begin (); i != GetRedirections ().end (); i++)
+    {
+      if (i->stream == &stream)
+        {
+          stream.flush ();
+          stream.rdbuf (i->original);
+          i->buffer->GetWriter ()->Stop ();
+          delete i->buffer;
+          GetRedirections ().erase (i);
+          return;
+        }
+    }
+}
+
+} // namespace ns3
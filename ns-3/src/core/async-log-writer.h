@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ASYNC_LOG_WRITER_H
+#define ASYNC_LOG_WRITER_H
+
+#include "ptr.h"
+#include "simple-ref-count.h"
+#include "system-thread.h"
+
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Hands log output to a background thread that writes it out.
+ *
+ * The producer, normally the thread running the simulation, copies every
+ * record into a bounded lock-free single producer, single consumer ring
+ * buffer and goes on. A writer thread drains the ring into the target
+ * stream buffer, so slow terminals and disks no longer stall the event loop.
+ *
+ * Only one thread may call Write () and Flush () on a writer. When the ring
+ * is full the record is either dropped and counted, or the producer waits
+ * for the writer thread to make room, see FullPolicy.
+ *
+ * Simulator::Destroy () calls FlushAll (), so nothing logged during the
+ * simulation is still in flight when it returns.
+ */
+class AsyncLogWriter : public SimpleRefCount<AsyncLogWriter>
+{
+public:
+  enum FullPolicy
+  {
+    /** Drop records that do not fit into the ring. */
+    DROP,
+    /** Wait until the writer thread made room. */
+    BLOCK
+  };
+
+  /**
+   * \param target where the writer thread writes the records to; it must
+   *        outlive the writer and nobody else may write to it meanwhile.
+   * \param capacity size of the ring buffer in bytes.
+   * \param policy what to do with records that do not fit.
+   */
+  AsyncLogWriter (std::streambuf *target, uint32_t capacity, FullPolicy policy);
+  ~AsyncLogWriter ();
+
+  /**
+   * \brief Queue one record, it is written out in one piece or not at all.
+   *
+   * \returns false if the record was dropped.
+   */
+  bool Write (const char *data, uint32_t size);
+  /**
+   * \brief Wait until everything queued so far has been written to the target.
+   */
+  void Flush (void);
+  /**
+   * \brief Flush and stop the writer thread, later writes go straight to the target.
+   */
+  void Stop (void);
+
+  uint64_t GetDroppedRecords (void) const;
+  uint64_t GetDroppedBytes (void) const;
+
+  /**
+   * \brief Flush every writer that is currently running.
+   */
+  static void FlushAll (void);
+
+  /**
+   * \brief Send everything written to the stream through a writer thread.
+   *
+   * Records are cut at every flush of the stream, std::endl in particular.
+   * Use it for std::clog to take NS_LOG output off the simulation thread.
+   *
+   * \returns the writer, for its drop counters.
+   */
+  static Ptr<AsyncLogWriter> Redirect (std::ostream &stream, uint32_t capacity, FullPolicy policy);
+  /**
+   * \brief Flush and undo Redirect ().
+   */
+  static void Restore (std::ostream &stream);
+
+private:
+  void Run (void);
+  void Drain (uint64_t head);
+
+  std::streambuf *m_target;
+  std::vector<char> m_ring;
+  uint64_t m_capacity;
+  // Bytes ever queued and bytes ever written, only the producer moves the
+  // head and only the writer thread moves the tail
+  volatile uint64_t m_head;
+  volatile uint64_t m_tail;
+  volatile bool m_stopping;
+  bool m_running;
+  FullPolicy m_policy;
+  uint64_t m_droppedRecords;
+  uint64_t m_droppedBytes;
+  Ptr<SystemThread> m_thread;
+};
+
+} // namespace ns3
+
+#endif /* ASYNC_LOG_WRITER_H */
@@ -21,7 +21,11 @@
 #ifndef SYSTEM_THREAD_H
 #define SYSTEM_THREAD_H
 
+#include "ns3/core-config.h"
 #include "callback.h"
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 namespace ns3 { 
 
@@ -45,6 +49,11 @@ class SystemThreadImpl;
 class SystemThread : public SimpleRefCount<SystemThread>
 {
 public:
+  /**
+   * @brief Identifies a thread of execution, see Self ().
+   */
+  typedef pthread_t ThreadId;
+
   /**
    * @brief Create a SystemThread object.
    *
@@ -163,6 +172,19 @@ public:
    */
   bool Break (void);
 
+  /**
+   * @returns the id of the calling thread.
+   */
+  static ThreadId Self (void);
+
+  /**
+   * @brief Check whether the calling thread is the given one.
+   *
+   * @param id a thread id returned by Self ().
+   * @returns true if Self () would return id.
+   */
+  static bool Equals (ThreadId id);
+
 private:
   SystemThreadImpl * m_impl;
   bool m_break;
@@ -180,4 +180,18 @@ SystemThread::Break (void)
   return m_impl->Break ();
 }  
 
+SystemThread::ThreadId
+SystemThread::Self (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return pthread_self ();
+}
+
+bool
+SystemThread::Equals (SystemThread::ThreadId id)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return pthread_equal (pthread_self (), id) != 0;
+}
+
 } // namespace ns3
@@ -20,8 +20,13 @@
 #include "point-to-point-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
+#include "ns3/node.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/multithreaded-simulator-impl.h"
+#endif
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointChannel");
 
@@ -76,6 +81,8 @@ PointToPointChannel::Attach(Ptr<PointToPointNetDevice> device)
       m_link[1].m_dst = m_link[0].m_src;
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
+      m_link[0].m_dstNode = PeekPointer (m_link[0].m_dst->GetNode ());
+      m_link[1].m_dstNode = PeekPointer (m_link[1].m_dst->GetNode ());
     }
 }
 
@@ -93,9 +100,33 @@ PointToPointChannel::TransmitStart(
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
-                                  txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+  if (m_link[0].m_dstNode == 0 || m_link[1].m_dstNode == 0)
+    {
+      // devices attached before they were added to their node
+      m_link[0].m_dstNode = PeekPointer (m_link[0].m_dst->GetNode ());
+      m_link[1].m_dstNode = PeekPointer (m_link[1].m_dst->GetNode ());
+    }
+  Node *dstNode = m_link[wire].m_dstNode;
+  Node *srcNode = m_link[1 - wire].m_dstNode;
+  bool parallel = false;
+#ifdef HAVE_PTHREAD_H
+  parallel = MultithreadedSimulatorImpl::IsParallel ();
+#endif
+  if (parallel && dstNode->GetSystemId () != srcNode->GetSystemId ())
+    {
+      // The receiver may run on another thread, see MultithreadedSimulatorImpl:
+      // hand it a packet which shares nothing with ours, and do not touch
+      // the reference count of its device from this thread.
+      Simulator::ScheduleWithContext (dstNode->GetId (),
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      PeekPointer (m_link[wire].m_dst), p->CreateUnsharedCopy ());
+    }
+  else
+    {
+      Simulator::ScheduleWithContext (dstNode->GetId (),
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      m_link[wire].m_dst, p);
+    }
 
   // Call the tx anim callback on the net device
   m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
@@ -30,6 +30,7 @@ namespace ns3 {
 
 class PointToPointNetDevice;
 class Packet;
+class Node;
 
 /**
  * \brief Simple Point To Point Channel.
@@ -154,10 +155,13 @@ private:
   class Link
   {
   public:
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0), m_dstNode (0) {}
     WireState                  m_state;
     Ptr<PointToPointNetDevice> m_src;
     Ptr<PointToPointNetDevice> m_dst;
+    // the node of m_dst, held without a reference so that the sender can
+    // read it while another thread runs that node
+    Node                      *m_dstNode;
   };
     
   Link    m_link[N_DEVICES];
@@ -34,6 +34,7 @@
 #include "qos-utils.h"
 
 #include <map>
+#include <list>
 
 namespace ns3 {
 
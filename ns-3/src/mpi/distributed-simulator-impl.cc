@@ -278,7 +278,9 @@ DistributedSimulatorImpl::Run (void)
       Time nextTime = Next ();
       if (nextTime > m_grantedTime)
         { // Can't process, calculate a new LBTS
-          // First receive any pending messages
+          // First send the packets of the window, batched by system
+          MpiInterface::SendMessages ();
+          // Then receive any pending messages
           MpiInterface::ReceiveMessages ();
           // reset next time
           nextTime = Next ();
@@ -316,6 +318,8 @@ DistributedSimulatorImpl::Run (void)
           ProcessOneEvent ();
         }
     }
+  // Do not keep the packets of the last window from the other systems
+  MpiInterface::SendMessages ();
 
   // If the simulator stopped naturally by lack of events, make a
   // consistency test to check that we didn't lose any events along the way.
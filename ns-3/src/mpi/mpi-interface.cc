@@ -40,25 +40,36 @@ namespace ns3 {
 
 SentBuffer::SentBuffer ()
 {
-  m_buffer = 0;
   m_request = 0;
 }
 
 SentBuffer::~SentBuffer ()
 {
-  delete [] m_buffer;
 }
 
 uint8_t*
 SentBuffer::GetBuffer ()
 {
-  return m_buffer;
+  return &m_buffer[0];
+}
+
+uint32_t
+SentBuffer::GetSize ()
+{
+  return m_buffer.size ();
+}
+
+void
+SentBuffer::SetBuffer (std::vector<uint8_t> &buffer)
+{
+  m_buffer.swap (buffer);
 }
 
 void
-SentBuffer::SetBuffer (uint8_t* buffer)
+SentBuffer::ReleaseBuffer (std::vector<uint8_t> &buffer)
 {
-  m_buffer = buffer;
+  m_buffer.swap (buffer);
+  buffer.clear ();
 }
 
 #ifdef NS3_MPI
@@ -76,23 +87,47 @@ bool                  MpiInterface::m_enabled = false;
 uint32_t              MpiInterface::m_rxCount = 0;
 uint32_t              MpiInterface::m_txCount = 0;
 std::list<SentBuffer> MpiInterface::m_pendingTx;
+std::vector<std::vector<uint8_t> > MpiInterface::m_pendingPackets;
+std::vector<uint32_t> MpiInterface::m_pendingCount;
+std::list<std::vector<uint8_t> > MpiInterface::m_freeBuffers;
+std::vector<uint8_t> MpiInterface::m_rxBuffer;
 
 #ifdef NS3_MPI
-MPI_Request* MpiInterface::m_requests;
-char**       MpiInterface::m_pRxBuffers;
+namespace {
+
+/*
+ * A message holds the packets for one system, each one as a record
+ * header followed by the serialized packet, padded to keep the next
+ * record aligned.
+ */
+struct PacketRecord
+{
+  uint64_t rxTime;
+  uint32_t node;
+  uint32_t dev;
+  uint32_t size;
+  uint32_t reserved;
+};
+
+const uint32_t RECORD_ALIGNMENT = 8;
+
+uint32_t
+GetPaddedSize (uint32_t size)
+{
+  return (size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+}
+
+} // anonymous namespace
 #endif
 
 void
 MpiInterface::Destroy ()
 {
 #ifdef NS3_MPI
-  for (uint32_t i = 0; i < GetSize (); ++i)
-    {
-      delete [] m_pRxBuffers[i];
-    }
-  delete [] m_pRxBuffers;
-  delete [] m_requests;
-
+  m_rxBuffer.clear ();
+  m_pendingPackets.clear ();
+  m_pendingCount.clear ();
+  m_freeBuffers.clear ();
   m_pendingTx.clear ();
 #endif
 }
@@ -153,15 +188,9 @@ MpiInterface::Enable (int* pargc, char*** pargv)
   MPI_Comm_size (MPI_COMM_WORLD, reinterpret_cast <int *> (&m_size));
   m_enabled = true;
   m_initialized = true;
-  // Post a non-blocking receive for all peers
-  m_pRxBuffers = new char*[m_size];
-  m_requests = new MPI_Request[m_size];
-  for (uint32_t i = 0; i < GetSize (); ++i)
-    {
-      m_pRxBuffers[i] = new char[MAX_MPI_MSG_SIZE];
-      MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[i]);
-    }
+  m_rxBuffer.resize (MAX_MPI_MSG_SIZE);
+  m_pendingPackets.resize (m_size);
+  m_pendingCount.resize (m_size, 0);
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -171,30 +200,56 @@ void
 MpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev)
 {
 #ifdef NS3_MPI
-  SentBuffer sendBuf;
-  m_pendingTx.push_back (sendBuf);
-  std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
-
-  uint32_t serializedSize = p->GetSerializedSize ();
-  uint8_t* buffer =  new uint8_t[serializedSize + 16];
-  i->SetBuffer (buffer);
-  // Add the time, dest node and dest device
-  uint64_t t = rxTime.GetNanoSeconds ();
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = t;
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = node;
-  *pData++ = dev;
-  // Serialize the packet
-  p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
-
   // Find the system id for the destination node
   Ptr<Node> destNode = NodeList::GetNode (node);
   uint32_t nodeSysId = destNode->GetSystemId ();
 
-  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (i->GetRequest ()));
-  m_txCount++;
+  // Serialize the packet right after the ones already pending for the
+  // same system, in storage reused from the previous messages
+  std::vector<uint8_t> &message = m_pendingPackets[nodeSysId];
+  if (message.empty () && !m_freeBuffers.empty ())
+    {
+      message.swap (m_freeBuffers.front ());
+      m_freeBuffers.pop_front ();
+    }
+  uint32_t serializedSize = p->GetSerializedSize ();
+  uint32_t offset = message.size ();
+  message.resize (offset + sizeof (PacketRecord) + GetPaddedSize (serializedSize));
+
+  // Add the time, dest node and dest device
+  PacketRecord *record = reinterpret_cast<PacketRecord *> (&message[offset]);
+  record->rxTime = rxTime.GetNanoSeconds ();
+  record->node = node;
+  record->dev = dev;
+  record->size = serializedSize;
+  record->reserved = 0;
+  p->Serialize (&message[offset + sizeof (PacketRecord)], serializedSize);
+  m_pendingCount[nodeSysId]++;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+MpiInterface::SendMessages ()
+{
+#ifdef NS3_MPI
+  for (uint32_t i = 0; i < m_pendingPackets.size (); ++i)
+    {
+      if (m_pendingPackets[i].empty ())
+        {
+          continue;
+        }
+      SentBuffer sendBuf;
+      m_pendingTx.push_back (sendBuf);
+      std::list<SentBuffer>::reverse_iterator j = m_pendingTx.rbegin (); // Points to the last element
+      j->SetBuffer (m_pendingPackets[i]);
+
+      MPI_Isend (reinterpret_cast<void *> (j->GetBuffer ()), j->GetSize (), MPI_CHAR, i,
+                 0, MPI_COMM_WORLD, (j->GetRequest ()));
+      m_txCount += m_pendingCount[i];
+      m_pendingCount[i] = 0;
+    }
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -202,60 +257,60 @@ MpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint
 
 void
 MpiInterface::ReceiveMessages ()
-{ // Poll the non-block reads to see if data arrived
+{ // Poll for the messages which arrived
 #ifdef NS3_MPI
   while (true)
     {
       int flag = 0;
-      int index = 0;
       MPI_Status status;
 
-      MPI_Testany (GetSize (), m_requests, &index, &flag, &status);
+      MPI_Iprobe (MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &flag, &status);
       if (!flag)
         {
           break;        // No more messages
         }
       int count;
       MPI_Get_count (&status, MPI_CHAR, &count);
-      m_rxCount++; // Count this receive
-
-      // Get the meta data first
-      uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
-      uint64_t nanoSeconds = *pTime++;
-      uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-      uint32_t node = *pData++;
-      uint32_t dev  = *pData++;
-
-      Time rxTime = NanoSeconds (nanoSeconds);
-
-      count -= sizeof (nanoSeconds) + sizeof (node) + sizeof (dev);
-
-      Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
+      if (static_cast<uint32_t> (count) > m_rxBuffer.size ())
+        {
+          m_rxBuffer.resize (count);
+        }
+      MPI_Recv (&m_rxBuffer[0], count, MPI_CHAR, status.MPI_SOURCE, 0,
+                MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
-      // Find the correct node/device to schedule receive event
-      Ptr<Node> pNode = NodeList::GetNode (node);
-      uint32_t nDevices = pNode->GetNDevices ();
-      Ptr<PointToPointNetDevice> pDev = 0;
-      for (uint32_t i = 0; i < nDevices; ++i)
+      uint32_t offset = 0;
+      while (offset < static_cast<uint32_t> (count))
         {
-          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-          if (pThisDev->GetIfIndex () == dev)
+          m_rxCount++; // Count this receive
+
+          // Get the meta data first
+          const PacketRecord *record = reinterpret_cast<const PacketRecord *> (&m_rxBuffer[offset]);
+          Time rxTime = NanoSeconds (record->rxTime);
+          uint8_t *data = &m_rxBuffer[offset + sizeof (PacketRecord)];
+          Ptr<Packet> p = Create<Packet> (data, record->size, true);
+          offset += sizeof (PacketRecord) + GetPaddedSize (record->size);
+
+          // Find the correct node/device to schedule receive event
+          Ptr<Node> pNode = NodeList::GetNode (record->node);
+          uint32_t nDevices = pNode->GetNDevices ();
+          Ptr<PointToPointNetDevice> pDev = 0;
+          for (uint32_t i = 0; i < nDevices; ++i)
             {
-              pDev = DynamicCast<PointToPointNetDevice> (pThisDev);
-              break;
+              Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+              if (pThisDev->GetIfIndex () == record->dev)
+                {
+                  pDev = DynamicCast<PointToPointNetDevice> (pThisDev);
+                  break;
+                }
             }
-        }
-
-      NS_ASSERT (pNode && pDev);
 
-      // Schedule the rx event
-      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                      &PointToPointNetDevice::Receive,
-                                      pDev, p);
+          NS_ASSERT (pNode && pDev);
 
-      // Re-queue the next read
-      MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[index]);
+          // Schedule the rx event
+          Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                          &PointToPointNetDevice::Receive,
+                                          pDev, p);
+        }
     }
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
@@ -275,7 +330,9 @@ MpiInterface::TestSendComplete ()
       std::list<SentBuffer>::iterator current = i; // Save current for erasing
       i++;                                    // Advance to next
       if (flag)
-        { // This message is complete
+        { // This message is complete, keep its storage for the next ones
+          m_freeBuffers.push_back (std::vector<uint8_t> ());
+          current->ReleaseBuffer (m_freeBuffers.back ());
           m_pendingTx.erase (current);
         }
     }
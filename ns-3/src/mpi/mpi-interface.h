@@ -24,6 +24,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 
 #include "ns3/nstime.h"
 #include "ns3/buffer.h"
@@ -34,8 +35,8 @@ typedef struct ompi_request_t* MPI_Request;
 namespace ns3 {
 
 /**
- * maximum MPI message size for easy
- * buffer creation
+ * initial size of the MPI receive buffer, which grows to the largest
+ * message received
  */
 const uint32_t MAX_MPI_MSG_SIZE = 2000;
 
@@ -53,16 +54,26 @@ public:
    */
   uint8_t* GetBuffer ();
   /**
-   * \param buffer pointer to sent buffer
+   * \return size of the sent buffer
    */
-  void SetBuffer (uint8_t* buffer);
+  uint32_t GetSize ();
+  /**
+   * \param buffer the bytes to send, swapped with the (empty) storage
+   * of this object
+   */
+  void SetBuffer (std::vector<uint8_t> &buffer);
+  /**
+   * \param buffer an empty vector which receives the storage of this
+   * object, for reuse once the send completed
+   */
+  void ReleaseBuffer (std::vector<uint8_t> &buffer);
   /**
    * \return MPI request
    */
   MPI_Request* GetRequest ();
 
 private:
-  uint8_t* m_buffer;
+  std::vector<uint8_t> m_buffer;
   MPI_Request m_request;
 };
 
@@ -104,9 +115,16 @@ public:
    * \param node destination node
    * \param dev destination device
    *
-   * Serialize and send a packet to the specified node and net device
+   * Serialize a packet for the specified node and net device. The
+   * packets for a given system are sent together, in a single message,
+   * by the next call to SendMessages.
    */
   static void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+  /**
+   * Send the packets serialized since the last call, one message per
+   * destination system
+   */
+  static void SendMessages ();
   /**
    * Check for received messages complete
    */
@@ -133,14 +151,18 @@ private:
 
   // Total packets sent
   static uint32_t m_txCount;
+
+  // Packets serialized for each system, not sent yet
+  static std::vector<std::vector<uint8_t> > m_pendingPackets;
+  static std::vector<uint32_t> m_pendingCount;
+
+  // Storage of completed sends, for reuse
+  static std::list<std::vector<uint8_t> > m_freeBuffers;
   static bool     m_initialized;
   static bool     m_enabled;
 
-  // Pending non-blocking receives
-  static MPI_Request* m_requests;
-
-  // Data buffers for non-blocking reads
-  static char**   m_pRxBuffers;
+  // Data buffer for the reads, as large as the largest message
+  static std::vector<uint8_t> m_rxBuffer;
 
   // List of pending non-blocking sends
   static std::list<SentBuffer> m_pendingTx;
@@ -0,0 +1,858 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <sched.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+// The partition whose events the calling thread is running, zero
+// outside of the windows and between them.
+static __thread void *g_currentPartition = 0;
+
+// Whether the nodes are split into several partitions, set before the
+// worker threads start and cleared once they have stopped
+static volatile bool g_parallel = false;
+
+// Rounds of busy waiting in Synchronize before yielding the processor,
+// and before sleeping, as when the main thread waits for commands
+static const uint32_t SPIN_ROUNDS = 1000;
+static const uint32_t YIELD_ROUNDS = 100000;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "The number of threads, and of partitions when all the nodes "
+                   "have the same system id. Zero means one per processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+bool
+MultithreadedSimulatorImpl::IsParallel (void)
+{
+  return g_parallel;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  m_stop = false;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_serial = CreatePartition (0, 4);
+  m_partitions.push_back (m_serial);
+  m_nPartitions = 0;
+  m_maxThreads = 0;
+  m_lookAhead = 0;
+  m_windowEnd = 0;
+  m_windows = 0;
+  m_workersStarted = 0;
+  m_done = false;
+  m_exit = false;
+  m_barrierWaiting = 0;
+  m_barrierGeneration = 0;
+  m_main = SystemThread::Self ();
+  m_eventsWithContextEmpty = true;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  StopWorkers ();
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      while (partition->events != 0 && !partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      for (uint32_t j = 0; j < partition->outboxes.size (); j++)
+        {
+          for (uint32_t k = 0; k < partition->outboxes[j].size (); k++)
+            {
+              partition->outboxes[j][k].impl->Unref ();
+            }
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  m_serial = 0;
+  for (std::list<EventWithContext>::iterator i = m_eventsWithContext.begin (); i != m_eventsWithContext.end (); i++)
+    {
+      i->event->Unref ();
+    }
+  m_eventsWithContext.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  StopWorkers ();
+  g_parallel = false;
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::CreatePartition (uint32_t index, uint32_t uid)
+{
+  Partition *partition = new Partition ();
+  partition->index = index;
+  if (m_schedulerFactory.GetTypeId ().GetUid () != 0)
+    {
+      partition->events = m_schedulerFactory.Create<Scheduler> ();
+    }
+  partition->currentTs = 0;
+  // before ::Run is entered, the currentUid will be zero
+  partition->currentUid = 0;
+  partition->currentContext = 0xffffffff;
+  partition->uid = uid;
+  partition->unscheduledEvents = 0;
+  partition->processedEvents = 0;
+  return partition;
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  uint32_t nNodes = NodeList::GetNNodes ();
+  uint32_t threads = m_maxThreads;
+  if (threads == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      threads = cpus > 0 ? cpus : 1;
+    }
+  threads = std::max (1U, std::min (threads, nNodes));
+
+  bool sameSystemId = true;
+  uint32_t maxSystemId = 0;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      uint32_t systemId = NodeList::GetNode (i)->GetSystemId ();
+      sameSystemId = sameSystemId && systemId == NodeList::GetNode (0)->GetSystemId ();
+      maxSystemId = std::max (maxSystemId, systemId);
+    }
+  if (sameSystemId && threads > 1)
+    {
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          NodeList::GetNode (i)->SetSystemId (static_cast<uint64_t> (i) * threads / nNodes);
+        }
+      maxSystemId = threads - 1;
+    }
+  m_nPartitions = std::min (threads, maxSystemId + 1);
+
+  m_contextPartitions.resize (nNodes);
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      m_contextPartitions[i] = NodeList::GetNode (i)->GetSystemId () % m_nPartitions;
+    }
+
+  // uids above the ones handed out so far, so that the events moved
+  // below never share a key with the ones of their new partition
+  m_partitions.clear ();
+  for (uint32_t i = 0; i < m_nPartitions; i++)
+    {
+      m_partitions.push_back (CreatePartition (i, m_serial->uid));
+    }
+  m_serial->index = m_nPartitions;
+  m_partitions.push_back (m_serial);
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      m_partitions[i]->outboxes.resize (m_partitions.size ());
+    }
+
+  // Move the events scheduled so far to the partition of their node
+  Ptr<Scheduler> events = m_serial->events;
+  m_serial->events = m_schedulerFactory.Create<Scheduler> ();
+  while (!events->IsEmpty ())
+    {
+      Scheduler::Event next = events->RemoveNext ();
+      Partition *partition = GetPartition (next.key.m_context);
+      partition->events->Insert (next);
+      m_serial->unscheduledEvents--;
+      partition->unscheduledEvents++;
+    }
+
+  for (uint32_t i = 0; i < m_nPartitions; i++)
+    {
+      NS_LOG_INFO ("partition " << i << ": " <<
+                   std::count (m_contextPartitions.begin (), m_contextPartitions.end (), i) << " nodes");
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  m_lookAhead = GetMaximumSimulationTime ().GetTimeStep ();
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); i++)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      Partition *local = GetPartition (node->GetId ());
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          Ptr<NetDevice> localNetDevice = node->GetDevice (j);
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); k++)
+            {
+              Ptr<Node> remoteNode = channel->GetDevice (k)->GetNode ();
+              if (GetPartition (remoteNode->GetId ()) == local)
+                {
+                  continue;
+                }
+              if (!localNetDevice->IsPointToPoint ())
+                {
+                  NS_FATAL_ERROR ("Channel " << channel->GetId () << " between nodes " << node->GetId () <<
+                                  " and " << remoteNode->GetId () << " crosses partitions but is not point-to-point");
+                }
+              TimeValue delay;
+              channel->GetAttribute ("Delay", delay);
+              if (!delay.Get ().IsStrictlyPositive ())
+                {
+                  NS_FATAL_ERROR ("Channel " << channel->GetId () << " between nodes " << node->GetId () <<
+                                  " and " << remoteNode->GetId () << " crosses partitions without delay");
+                }
+              m_lookAhead = std::min (m_lookAhead, static_cast<uint64_t> (delay.Get ().GetTimeStep ()));
+            }
+        }
+    }
+  NS_LOG_INFO ("lookahead " << TimeStep (m_lookAhead) << " for " << m_nPartitions << " partitions");
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  Partition *partition = static_cast<Partition *> (g_currentPartition);
+  if (partition == 0 && SystemThread::Equals (m_main))
+    {
+      // setting up or between two runs, nobody else is simulating
+      return m_serial;
+    }
+  return partition;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (context < m_contextPartitions.size ())
+    {
+      return m_partitions[m_contextPartitions[context]];
+    }
+  // no context, or a node created after the simulation started
+  return m_serial;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetOwner (const EventId &id) const
+{
+  return GetPartition (id.GetContext ());
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  m_schedulerFactory = schedulerFactory;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if (partition->events != 0)
+        {
+          while (!partition->events->IsEmpty ())
+            {
+              Scheduler::Event next = partition->events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      partition->events = scheduler;
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->uid;
+  partition->uid++;
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  partition->unscheduledEvents--;
+  partition->processedEvents++;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (Partition *partition)
+{
+  g_currentPartition = partition;
+  while (!partition->events->IsEmpty ()
+         && partition->events->PeekNext ().key.m_ts < m_windowEnd)
+    {
+      ProcessOneEvent (partition);
+    }
+  g_currentPartition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::CollectOutboxes (uint32_t index)
+{
+  Partition *partition = m_partitions[index];
+  // by order of sender, then of sending, whatever the thread timing was
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      std::vector<Scheduler::Event> &outbox = m_partitions[i]->outboxes[index];
+      for (std::vector<Scheduler::Event>::iterator j = outbox.begin (); j != outbox.end (); j++)
+        {
+          j->key.m_uid = partition->uid;
+          partition->uid++;
+          partition->unscheduledEvents++;
+          partition->events->Insert (*j);
+        }
+      outbox.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContextEmpty)
+    {
+      return;
+    }
+
+  std::list<EventWithContext> eventsWithContext;
+  {
+    CriticalSection cs (m_eventsWithContextMutex);
+    eventsWithContext.swap (m_eventsWithContext);
+    m_eventsWithContextEmpty = true;
+  }
+  for (std::list<EventWithContext>::iterator i = eventsWithContext.begin (); i != eventsWithContext.end (); i++)
+    {
+      Insert (GetPartition (i->context), m_serial->currentTs + i->delay, i->context, i->event);
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetNextPartition (void) const
+{
+  // the serial partition comes last and wins ties
+  Partition *next = 0;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      if (partition->events->IsEmpty ())
+        {
+          continue;
+        }
+      if (next == 0
+          || partition->events->PeekNext ().key.m_ts <= next->events->PeekNext ().key.m_ts)
+        {
+          next = partition;
+        }
+    }
+  return next;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessSerialEvents (void)
+{
+  g_currentPartition = m_serial;
+  // nothing which happens from now on can be earlier than what the
+  // partitions already did
+  for (uint32_t i = 0; i < m_nPartitions; i++)
+    {
+      m_serial->currentTs = std::max (m_serial->currentTs, m_partitions[i]->currentTs);
+    }
+  ProcessEventsWithContext ();
+
+  m_done = true;
+  while (!m_stop)
+    {
+      Partition *next = GetNextPartition ();
+      if (next == 0)
+        {
+          break;
+        }
+      if (next == m_serial)
+        {
+          ProcessOneEvent (m_serial);
+          continue;
+        }
+      uint64_t start = next->events->PeekNext ().key.m_ts;
+      m_windowEnd = start + std::min (m_lookAhead, GetMaximumSimulationTime ().GetTimeStep () - start);
+      if (!m_serial->events->IsEmpty ())
+        {
+          m_windowEnd = std::min (m_windowEnd, m_serial->events->PeekNext ().key.m_ts);
+        }
+      m_windows++;
+      m_done = false;
+      break;
+    }
+  g_currentPartition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::Synchronize (void)
+{
+  uint32_t generation = m_barrierGeneration;
+  if (__sync_add_and_fetch (&m_barrierWaiting, 1) == m_nPartitions)
+    {
+      m_barrierWaiting = 0;
+      __sync_synchronize ();
+      m_barrierGeneration = generation + 1;
+    }
+  else
+    {
+      uint32_t rounds = 0;
+      while (m_barrierGeneration == generation)
+        {
+          rounds++;
+          if (rounds > YIELD_ROUNDS)
+            {
+              usleep (1000);
+            }
+          else if (rounds > SPIN_ROUNDS)
+            {
+              sched_yield ();
+            }
+        }
+    }
+  __sync_synchronize ();
+}
+
+bool
+MultithreadedSimulatorImpl::RunWindows (uint32_t index)
+{
+  while (true)
+    {
+      // partition 0 has decided what comes next
+      Synchronize ();
+      if (m_exit)
+        {
+          return false;
+        }
+      if (m_done)
+        {
+          // nobody looks at m_done anymore once everybody is past this one
+          Synchronize ();
+          return true;
+        }
+      ProcessWindow (m_partitions[index]);
+      Synchronize ();
+      CollectOutboxes (index);
+      if (index == 0)
+        {
+          CollectOutboxes (m_nPartitions);
+        }
+      Synchronize ();
+      if (index == 0)
+        {
+          ProcessSerialEvents ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Worker (void)
+{
+  uint32_t index = __sync_add_and_fetch (&m_workersStarted, 1);
+  while (RunWindows (index))
+    {
+    }
+}
+
+void
+MultithreadedSimulatorImpl::StopWorkers (void)
+{
+  if (m_workers.empty ())
+    {
+      return;
+    }
+  m_exit = true;
+  Synchronize ();
+  for (uint32_t i = 0; i < m_workers.size (); i++)
+    {
+      m_workers[i]->Join ();
+    }
+  m_workers.clear ();
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  return GetNextPartition () == 0 || m_stop;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::NextTs (void) const
+{
+  Partition *next = GetNextPartition ();
+  NS_ASSERT (next != 0);
+  return next->events->PeekNext ().key.m_ts;
+}
+
+Time
+MultithreadedSimulatorImpl::Next (void) const
+{
+  return TimeStep (NextTs ());
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_ASSERT_MSG (!m_exit, "Run after Destroy");
+  m_stop = false;
+  m_main = SystemThread::Self ();
+  if (m_nPartitions == 0)
+    {
+      CreatePartitions ();
+    }
+  CalculateLookAhead ();
+  g_parallel = m_nPartitions > 1;
+  while (m_workers.size () + 1 < m_nPartitions)
+    {
+      Ptr<SystemThread> worker = Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::Worker, this));
+      worker->Start ();
+      m_workers.push_back (worker);
+    }
+
+  ProcessSerialEvents ();
+  RunWindows (0);
+
+  NS_LOG_INFO (m_windows << " windows so far");
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      NS_LOG_INFO ("partition " << i << ": " << m_partitions[i]->processedEvents << " events");
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  int unscheduledEvents = 0;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      unscheduledEvents += m_partitions[i]->unscheduledEvents;
+    }
+  NS_ASSERT (!IsFinished () || m_stop || unscheduledEvents == 0);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId () const
+{
+  return 0;
+}
+
+void
+MultithreadedSimulatorImpl::RunOneEvent (void)
+{
+  Partition *next = GetNextPartition ();
+  if (next == 0)
+    {
+      return;
+    }
+  g_currentPartition = next;
+  ProcessOneEvent (next);
+  g_currentPartition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  Partition *current = GetCurrentPartition ();
+  if (current != 0 && current != m_serial
+      && current->currentTs + time.GetTimeStep () < m_windowEnd)
+    {
+      // too close for the serial partition, the other partitions finish
+      // the window
+      Simulator::Schedule (time, &Simulator::Stop);
+      return;
+    }
+  Simulator::ScheduleWithContext (0xffffffff, time, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  Partition *current = GetCurrentPartition ();
+  NS_ASSERT_MSG (current != 0, "Schedule from a thread which is not simulating, use ScheduleWithContext");
+  NS_ASSERT (time.IsPositive ());
+  uint64_t ts = current->currentTs + time.GetTimeStep ();
+  if (current == m_serial)
+    {
+      return Insert (GetPartition (current->currentContext), ts, current->currentContext, event);
+    }
+  return Insert (current, ts, current->currentContext, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+
+  Partition *current = GetCurrentPartition ();
+  if (current == 0)
+    {
+      EventWithContext ev;
+      ev.context = context;
+      ev.delay = time.GetTimeStep ();
+      ev.event = event;
+      CriticalSection cs (m_eventsWithContextMutex);
+      m_eventsWithContext.push_back (ev);
+      m_eventsWithContextEmpty = false;
+      return;
+    }
+
+  uint64_t ts = current->currentTs + time.GetTimeStep ();
+  Partition *destination = GetPartition (context);
+  if (current == m_serial || destination == current)
+    {
+      Insert (destination, ts, context, event);
+      return;
+    }
+  // the destination is running on another thread
+  if (ts < m_windowEnd)
+    {
+      NS_FATAL_ERROR ("Event for node " << context << " at " << TimeStep (ts) << " from node " <<
+                      current->currentContext << " is within the lookahead of " << TimeStep (m_lookAhead));
+    }
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = 0;
+  current->outboxes[destination->index].push_back (ev);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), 0xffffffff, 2);
+  CriticalSection cs (m_destroyMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  Partition *current = GetCurrentPartition ();
+  if (current == 0)
+    {
+      return TimeStep (m_serial->currentTs);
+    }
+  return TimeStep (current->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs ()) - Now ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *owner = GetOwner (id);
+  Partition *current = GetCurrentPartition ();
+  if (current != m_serial && current != owner)
+    {
+      // the event list of the owner may be in use by another thread,
+      // leave the event there
+      id.PeekEventImpl ()->Cancel ();
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  owner->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  owner->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  if (ev.GetUid () == 2)
+    {
+      if (ev.PeekEventImpl () == 0
+          || ev.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (m_destroyMutex);
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == ev)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  Partition *owner = GetOwner (ev);
+  if (ev.PeekEventImpl () == 0
+      || ev.GetTs () < owner->currentTs
+      || (ev.GetTs () == owner->currentTs
+          && ev.GetUid () <= owner->currentUid)
+      || ev.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  // XXX: I am fairly certain other compilers use other non-standard
+  // post-fixes to indicate 64 bit constants.
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  Partition *current = GetCurrentPartition ();
+  if (current == 0)
+    {
+      return 0xffffffff;
+    }
+  return current->currentContext;
+}
+
+} // namespace ns3
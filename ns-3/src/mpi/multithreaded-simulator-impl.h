@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/ptr.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-thread.h"
+
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief shared memory parallel simulator implementation using lookahead
+ *
+ * The nodes are split into partitions, each with its own event list, by
+ * their system id. Every partition runs on its own thread, the first one
+ * on the thread which called Run. If all nodes have the same system id,
+ * they are split into MaxThreads blocks of consecutive node ids first.
+ *
+ * The partitions advance in lock step through windows of simulation time
+ * as wide as the lookahead, the smallest delay of the point-to-point
+ * channels between two partitions. No event can then cross from one
+ * partition to another within a window: each partition writes the events
+ * it schedules for another one to its own outbox for that partition, and
+ * the outboxes are emptied into the event lists between two windows.
+ * Neither needs a lock, and the order in which a partition receives the
+ * events of the others does not depend on the scheduling of the threads,
+ * so runs are repeatable.
+ *
+ * Events without a node context (0xffffffff), such as the ones scheduled
+ * before the simulation starts, run between two windows while all the
+ * partition threads wait, so they may touch any node.
+ *
+ * The models must only reach the nodes of another partition through
+ * ScheduleWithContext with at least the lookahead as delay. The
+ * PointToPointChannel does so and hands over an unshared copy of the
+ * packet; any other channel between two partitions is a fatal error.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /**
+   * \returns true while a MultithreadedSimulatorImpl runs its partitions
+   *          on more than one thread, so that the models know whether the
+   *          events they schedule for other nodes may run concurrently.
+   */
+  static bool IsParallel (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual Time Next (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual void RunOneEvent (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+private:
+  struct Partition
+  {
+    uint32_t index;
+    Ptr<Scheduler> events;
+    uint64_t currentTs;
+    uint32_t currentUid;
+    uint32_t currentContext;
+    uint32_t uid;
+    // number of events that have been inserted but not yet scheduled,
+    // not counting the "destroy" events; this is used for validation
+    int unscheduledEvents;
+    // events for the other partitions, indexed by destination partition
+    std::vector<std::vector<Scheduler::Event> > outboxes;
+    uint64_t processedEvents;
+  };
+  struct EventWithContext
+  {
+    uint32_t context;
+    uint64_t delay;
+    EventImpl *event;
+  };
+
+  virtual void DoDispose (void);
+
+  Partition *CreatePartition (uint32_t index, uint32_t uid);
+  void CreatePartitions (void);
+  void CalculateLookAhead (void);
+  Partition *GetCurrentPartition (void) const;
+  Partition *GetPartition (uint32_t context) const;
+  Partition *GetOwner (const EventId &id) const;
+  EventId Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  void ProcessOneEvent (Partition *partition);
+  void ProcessWindow (Partition *partition);
+  void CollectOutboxes (uint32_t index);
+  void ProcessSerialEvents (void);
+  void ProcessEventsWithContext (void);
+  bool RunWindows (uint32_t index);
+  void Worker (void);
+  void StopWorkers (void);
+  void Synchronize (void);
+  Partition *GetNextPartition (void) const;
+  uint64_t NextTs (void) const;
+
+  typedef std::list<EventId> DestroyEvents;
+
+  DestroyEvents m_destroyEvents;
+  mutable SystemMutex m_destroyMutex;
+  volatile bool m_stop;
+  ObjectFactory m_schedulerFactory;
+  // the node partitions, followed by the partition of the events
+  // without a node context which run between the windows
+  std::vector<Partition *> m_partitions;
+  Partition *m_serial;
+  uint32_t m_nPartitions;
+  // partition of each node id
+  std::vector<uint32_t> m_contextPartitions;
+  uint32_t m_maxThreads;
+  uint64_t m_lookAhead;
+  // end of the current window, excluded
+  uint64_t m_windowEnd;
+  uint64_t m_windows;
+
+  std::vector<Ptr<SystemThread> > m_workers;
+  volatile uint32_t m_workersStarted;
+  // set between two windows, when the current Run is over
+  volatile bool m_done;
+  volatile bool m_exit;
+  volatile uint32_t m_barrierWaiting;
+  volatile uint32_t m_barrierGeneration;
+
+  SystemThread::ThreadId m_main;
+  // events scheduled by threads which are not simulating
+  SystemMutex m_eventsWithContextMutex;
+  std::list<EventWithContext> m_eventsWithContext;
+  volatile bool m_eventsWithContextEmpty;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
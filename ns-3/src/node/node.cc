@@ -101,6 +101,12 @@ Node::GetSystemId (void) const
   return m_sid;
 }
 
+void
+Node::SetSystemId (uint32_t systemId)
+{
+  m_sid = systemId;
+}
+
 uint32_t 
 Node::AddDevice (Ptr<NetDevice> device)
 {
@@ -83,6 +83,14 @@ public:
    *          to this node.
    */
   uint32_t GetSystemId (void) const;
+  /**
+   * \param systemId the system id for parallel simulations
+   *
+   * Moves the node to another partition of a parallel simulation.
+   * It must be called before the simulation starts and, with MPI,
+   * before the node is connected to any other node.
+   */
+  void SetSystemId (uint32_t systemId);
 
   /**
    * \param device NetDevice to associate to this node.
@@ -0,0 +1,234 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<DaryHeapScheduler> ()
+    .AddAttribute ("Arity",
+                   "Number of children of every heap node, a power of two.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&DaryHeapScheduler::SetArity,
+                                         &DaryHeapScheduler::GetArity),
+                   MakeUintegerChecker<uint32_t> (2, 64))
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+  : m_shift (2)
+{
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+}
+
+void
+DaryHeapScheduler::SetArity (uint32_t arity)
+{
+  if (arity == 0 || (arity & (arity - 1)) != 0)
+    {
+      NS_FATAL_ERROR ("DaryHeapScheduler arity must be a power of two, not " << arity);
+    }
+  NS_ASSERT_MSG (m_keys.empty (), "Can not change the arity of a non-empty heap");
+  m_shift = 0;
+  while ((1U << m_shift) < arity)
+    {
+      m_shift++;
+    }
+}
+
+uint32_t
+DaryHeapScheduler::GetArity (void) const
+{
+  return 1U << m_shift;
+}
+
+void
+DaryHeapScheduler::Place (uint32_t index, const EventKey &key, EventImpl *impl)
+{
+  m_keys[index] = key;
+  m_impls[index] = impl;
+  impl->SetSchedulerIndex (index);
+}
+
+void
+DaryHeapScheduler::SiftUp (uint32_t index, EventKey key, EventImpl *impl)
+{
+  // move parents down into the hole instead of swapping
+  while (index > 0)
+    {
+      uint32_t parent = (index - 1) >> m_shift;
+      if (!(key < m_keys[parent]))
+        {
+          break;
+        }
+      Place (index, m_keys[parent], m_impls[parent]);
+      index = parent;
+    }
+  Place (index, key, impl);
+}
+
+void
+DaryHeapScheduler::SiftDown (uint32_t index, EventKey key, EventImpl *impl)
+{
+  uint32_t size = m_keys.size ();
+  while (true)
+    {
+      uint32_t first = (index << m_shift) + 1;
+      if (first >= size)
+        {
+          break;
+        }
+      uint32_t end = std::min (first + (1U << m_shift), size);
+      uint32_t smallest = first;
+      for (uint32_t child = first + 1; child < end; child++)
+        {
+          if (m_keys[child] < m_keys[smallest])
+            {
+              smallest = child;
+            }
+        }
+      if (!(m_keys[smallest] < key))
+        {
+          break;
+        }
+      Place (index, m_keys[smallest], m_impls[smallest]);
+      index = smallest;
+    }
+  Place (index, key, impl);
+}
+
+void
+DaryHeapScheduler::RemoveAt (uint32_t index)
+{
+  EventKey key = m_keys.back ();
+  EventImpl *impl = m_impls.back ();
+  m_keys.pop_back ();
+  m_impls.pop_back ();
+  if (index == m_keys.size ())
+    {
+      return;
+    }
+  if (index > 0 && key < m_keys[(index - 1) >> m_shift])
+    {
+      SiftUp (index, key, impl);
+    }
+  else
+    {
+      SiftDown (index, key, impl);
+    }
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  m_keys.push_back (ev.key);
+  m_impls.push_back (ev.impl);
+  SiftUp (m_keys.size () - 1, ev.key, ev.impl);
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  return m_keys.empty ();
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_ASSERT (!IsEmpty ());
+  Event next;
+  next.impl = m_impls[0];
+  next.key = m_keys[0];
+  return next;
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  Event next = PeekNext ();
+  RemoveAt (0);
+  return next;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  uint32_t index = ev.impl->GetSchedulerIndex ();
+  NS_ASSERT (index < m_impls.size () && m_impls[index] == ev.impl);
+  RemoveAt (index);
+}
+
+void
+DaryHeapScheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+  uint32_t last = 0;
+  for (uint32_t i = 0; i < m_impls.size (); i++)
+    {
+      if (m_impls[i]->IsCancelled ())
+        {
+          Event ev;
+          ev.impl = m_impls[i];
+          ev.key = m_keys[i];
+          removed.push_back (ev);
+        }
+      else
+        {
+          m_keys[last] = m_keys[i];
+          m_impls[last] = m_impls[i];
+          last++;
+        }
+    }
+  if (last == m_keys.size ())
+    {
+      return;
+    }
+  m_keys.resize (last);
+  m_impls.resize (last);
+  for (uint32_t i = 0; i < last; i++)
+    {
+      m_impls[i]->SetSchedulerIndex (i);
+    }
+  if (last < 2)
+    {
+      return;
+    }
+  for (uint32_t i = ((last - 2) >> m_shift) + 1; i > 0; i--)
+    {
+      SiftDown (i - 1, m_keys[i - 1], m_impls[i - 1]);
+    }
+}
+
+} // namespace ns3
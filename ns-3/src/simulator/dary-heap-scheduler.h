@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief an implicit d-ary heap event scheduler
+ *
+ * Compared to the HeapScheduler, this heap is shallower (every node has
+ * Arity children, 4 by default, so log4 (n) levels instead of log2 (n)) and
+ * its array is split in two: the event keys, which are all that sifting
+ * compares, and the EventImpl pointers, which are only moved along. Four
+ * 16-byte sibling keys fit in one cache line, so at millions of pending
+ * events a sift down costs about one cache miss per level.
+ *
+ * Like the HeapScheduler, every event knows its position through
+ * EventImpl::SetSchedulerIndex, so Remove is O(log n) and RemoveCancelled
+ * rebuilds the heap in O(n).
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DaryHeapScheduler ();
+  virtual ~DaryHeapScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+  virtual void RemoveCancelled (std::vector<Event> &removed);
+
+private:
+  void SetArity (uint32_t arity);
+  uint32_t GetArity (void) const;
+
+  inline void Place (uint32_t index, const EventKey &key, EventImpl *impl);
+  void SiftUp (uint32_t index, EventKey key, EventImpl *impl);
+  void SiftDown (uint32_t index, EventKey key, EventImpl *impl);
+  /* Take the event at index out, filling the hole with the last one. */
+  void RemoveAt (uint32_t index);
+
+  // The children of i are at (i << m_shift) + 1 ... (i << m_shift) + Arity
+  uint32_t m_shift;
+  std::vector<EventKey> m_keys;
+  std::vector<EventImpl *> m_impls;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
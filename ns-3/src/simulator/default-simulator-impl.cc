@@ -59,6 +59,11 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
+#ifdef HAVE_PTHREAD_H
+  m_eventsWithContextEmpty = true;
+  m_main = SystemThread::Self ();
+#endif
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
@@ -72,6 +77,13 @@ DefaultSimulatorImpl::DoDispose (void)
       Scheduler::Event next = m_events->RemoveNext ();
       next.impl->Unref ();
     }
+#ifdef HAVE_PTHREAD_H
+  for (std::list<EventWithContext>::iterator i = m_eventsWithContext.begin (); i != m_eventsWithContext.end (); i++)
+    {
+      i->event->Unref ();
+    }
+  m_eventsWithContext.clear ();
+#endif
   m_events = 0;
   SimulatorImpl::DoDispose ();
 }
@@ -125,8 +137,59 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+  if (next.impl->IsCancelled () && m_cancelledEvents > 0)
+    {
+      m_cancelledEvents--;
+    }
   next.impl->Invoke ();
   next.impl->Unref ();
+
+  ProcessEventsWithContext ();
+}
+
+void
+DefaultSimulatorImpl::RemoveCancelledEvents (void)
+{
+  std::vector<Scheduler::Event> removed;
+  m_events->RemoveCancelled (removed);
+  NS_LOG_LOGIC ("removed " << removed.size () << " of " << m_cancelledEvents << " canceled events");
+  for (std::vector<Scheduler::Event>::iterator i = removed.begin (); i != removed.end (); i++)
+    {
+      i->impl->Unref ();
+    }
+  m_unscheduledEvents -= removed.size ();
+  // schedulers which keep canceled events are asked again only after as
+  // many new cancellations
+  m_cancelledEvents = 0;
+}
+
+void
+DefaultSimulatorImpl::ProcessEventsWithContext (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (m_eventsWithContextEmpty)
+    {
+      return;
+    }
+
+  std::list<EventWithContext> eventsWithContext;
+  {
+    CriticalSection cs (m_eventsWithContextMutex);
+    eventsWithContext.swap (m_eventsWithContext);
+    m_eventsWithContextEmpty = true;
+  }
+  for (std::list<EventWithContext>::iterator i = eventsWithContext.begin (); i != eventsWithContext.end (); i++)
+    {
+      Scheduler::Event ev;
+      ev.impl = i->event;
+      ev.key.m_ts = m_currentTs + i->delay;
+      ev.key.m_context = i->context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+    }
+#endif
 }
 
 bool 
@@ -153,6 +216,11 @@ void
 DefaultSimulatorImpl::Run (void)
 {
   m_stop = false;
+#ifdef HAVE_PTHREAD_H
+  // Events from other threads are kept off the main loop's thread
+  m_main = SystemThread::Self ();
+#endif
+  ProcessEventsWithContext ();
   while (!m_events->IsEmpty () && !m_stop) 
     {
       ProcessOneEvent ();
@@ -207,6 +275,20 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, E
 {
   NS_LOG_FUNCTION (this << context << time.GetTimeStep () << m_currentTs << event);
 
+#ifdef HAVE_PTHREAD_H
+  if (!SystemThread::Equals (m_main))
+    {
+      EventWithContext ev;
+      ev.context = context;
+      ev.delay = time.GetTimeStep ();
+      ev.event = event;
+      CriticalSection cs (m_eventsWithContextMutex);
+      m_eventsWithContext.push_back (ev);
+      m_eventsWithContextEmpty = false;
+      return;
+    }
+#endif
+
   Scheduler::Event ev;
   ev.impl = event;
   ev.key.m_ts = m_currentTs + time.GetTimeStep ();
@@ -298,6 +380,15 @@ DefaultSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () == 2)
+        {
+          return;
+        }
+      m_cancelledEvents++;
+      if (m_cancelledEvents >= 1024 && 2 * m_cancelledEvents >= m_unscheduledEvents)
+        {
+          RemoveCancelledEvents ();
+        }
     }
 }
 
@@ -26,11 +26,24 @@
 #include "event-impl.h"
 
 #include "ns3/ptr.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#include "ns3/system-thread.h"
+#endif
 
 #include <list>
 
 namespace ns3 {
 
+/**
+ * \brief Sequential simulator implementation.
+ *
+ * Only ScheduleWithContext may be called from threads other than the one
+ * running the simulation: such events are queued under a lock and moved
+ * into the scheduler between two events of the main loop, with their delay
+ * counted from the simulation time they are moved at.
+ */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
 public:
@@ -63,6 +76,8 @@ public:
 private:
   virtual void DoDispose (void);
   void ProcessOneEvent (void);
+  void ProcessEventsWithContext (void);
+  void RemoveCancelledEvents (void);
   uint64_t NextTs (void) const;
   typedef std::list<EventId> DestroyEvents;
 
@@ -76,6 +91,23 @@ private:
   // number of events that have been inserted but not yet scheduled,
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
+  // canceled events still in m_events, as far as we know; once they make up
+  // half of it, they are removed in one go instead of expiring one by one
+  int m_cancelledEvents;
+
+#ifdef HAVE_PTHREAD_H
+  struct EventWithContext
+  {
+    uint32_t context;
+    uint64_t delay;
+    EventImpl *event;
+  };
+  // Events scheduled from other threads, waiting to be moved into m_events
+  std::list<EventWithContext> m_eventsWithContext;
+  volatile bool m_eventsWithContextEmpty;
+  SystemMutex m_eventsWithContextMutex;
+  SystemThread::ThreadId m_main;
+#endif
 };
 
 } // namespace ns3
@@ -19,14 +19,199 @@
  */
 
 #include "event-impl.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#include <pthread.h>
+#endif
+#include <new>
 
 namespace ns3 {
 
+static GlobalValue g_eventImplPool = GlobalValue ("EventImplPool",
+  "Allocate events from per-thread free lists instead of the general purpose heap. "
+  "Read once, when the first event is created.",
+  BooleanValue (true),
+  MakeBooleanChecker ());
+
+namespace {
+
+/**
+ * Events are recycled through one singly-linked free list per 16-byte
+ * size class. Each thread owns a cache of such lists so that the common
+ * case takes no lock. A cache which grows past POOL_MAX_CACHED blocks,
+ * as happens to the simulation thread when another thread schedules
+ * events with ScheduleWithContext, hands half of them over to a shared,
+ * locked, cache from which other threads refill before carving a new
+ * chunk. Chunks are never given back to the system.
+ */
+const size_t POOL_GRANULARITY = 16;
+const uint32_t POOL_CLASSES = 16;
+const size_t POOL_CHUNK_SIZE = 16384;
+const uint32_t POOL_MAX_CACHED = 1024;
+
+struct PoolBlock
+{
+  PoolBlock *next;
+};
+
+struct PoolCache
+{
+  PoolBlock *head[POOL_CLASSES];
+  uint32_t count[POOL_CLASSES];
+};
+
+enum PoolState
+{
+  POOL_UNKNOWN,
+  POOL_ENABLED,
+  POOL_DISABLED
+};
+
+enum PoolState g_poolState = POOL_UNKNOWN;
+PoolCache g_sharedCache;
+
+#ifdef HAVE_PTHREAD_H
+__thread PoolCache *g_threadCache = 0;
+pthread_once_t g_poolOnce = PTHREAD_ONCE_INIT;
+pthread_key_t g_poolKey;
+SystemMutex *g_sharedMutex = 0;
+#else
+PoolCache g_mainCache;
+PoolCache *g_threadCache = &g_mainCache;
+#endif
+
+inline uint32_t
+PoolClass (size_t size)
+{
+  return (size + POOL_GRANULARITY - 1) / POOL_GRANULARITY - 1;
+}
+
+/**
+ * Moves up to n blocks of size class c from one cache to the other.
+ */
+uint32_t
+PoolMove (PoolCache *from, PoolCache *to, uint32_t c, uint32_t n)
+{
+  uint32_t moved = 0;
+  while (moved < n && from->head[c] != 0)
+    {
+      PoolBlock *block = from->head[c];
+      from->head[c] = block->next;
+      block->next = to->head[c];
+      to->head[c] = block;
+      moved++;
+    }
+  from->count[c] -= moved;
+  to->count[c] += moved;
+  return moved;
+}
+
+void
+PoolReadState (void)
+{
+  BooleanValue enabled;
+  g_eventImplPool.GetValue (enabled);
+  g_poolState = enabled.Get () ? POOL_ENABLED : POOL_DISABLED;
+}
+
+#ifdef HAVE_PTHREAD_H
+void
+PoolThreadExit (void *data)
+{
+  PoolCache *cache = static_cast<PoolCache *> (data);
+  CriticalSection cs (*g_sharedMutex);
+  for (uint32_t c = 0; c < POOL_CLASSES; c++)
+    {
+      PoolMove (cache, &g_sharedCache, c, cache->count[c]);
+    }
+  delete cache;
+}
+
+void
+PoolInit (void)
+{
+  PoolReadState ();
+  g_sharedMutex = new SystemMutex ();
+  pthread_key_create (&g_poolKey, &PoolThreadExit);
+}
+#endif
+
+PoolCache *
+PoolGetCache (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (g_threadCache == 0)
+    {
+      pthread_once (&g_poolOnce, &PoolInit);
+      g_threadCache = new PoolCache ();
+      // the blocks of a thread which exits go to the shared cache
+      pthread_setspecific (g_poolKey, g_threadCache);
+    }
+#endif
+  return g_threadCache;
+}
+
+void
+PoolRefill (PoolCache *cache, uint32_t c)
+{
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (*g_sharedMutex);
+#endif
+    if (PoolMove (&g_sharedCache, cache, c, POOL_MAX_CACHED / 2) > 0)
+      {
+        return;
+      }
+  }
+  size_t blockSize = (c + 1) * POOL_GRANULARITY;
+  uint32_t n = POOL_CHUNK_SIZE / blockSize;
+  uint8_t *chunk = static_cast<uint8_t *> (::operator new (n * blockSize));
+  // link the blocks in address order
+  for (uint32_t i = n; i > 0; i--)
+    {
+      PoolBlock *block = reinterpret_cast<PoolBlock *> (chunk + (i - 1) * blockSize);
+      block->next = cache->head[c];
+      cache->head[c] = block;
+    }
+  cache->count[c] += n;
+}
+
+void
+PoolRelease (PoolCache *cache, uint32_t c)
+{
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (*g_sharedMutex);
+#endif
+  PoolMove (cache, &g_sharedCache, c, POOL_MAX_CACHED / 2);
+}
+
+bool
+PoolIsEnabled (void)
+{
+#ifdef HAVE_PTHREAD_H
+  // threads of the multithreaded simulator may create their first events
+  // at the same time
+  pthread_once (&g_poolOnce, &PoolInit);
+#else
+  if (g_poolState == POOL_UNKNOWN)
+    {
+      PoolReadState ();
+    }
+#endif
+  return g_poolState == POOL_ENABLED;
+}
+
+} // anonymous namespace
+
 EventImpl::~EventImpl ()
 {}
 
 EventImpl::EventImpl ()
-  : m_cancel (false)
+  : m_cancel (false),
+    m_schedulerIndex (0)
 {}
 
 void 
@@ -50,4 +235,43 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+void *
+EventImpl::operator new (size_t size)
+{
+  uint32_t c = PoolClass (size);
+  if (c >= POOL_CLASSES || !PoolIsEnabled ())
+    {
+      return ::operator new (size);
+    }
+  PoolCache *cache = PoolGetCache ();
+  if (cache->head[c] == 0)
+    {
+      PoolRefill (cache, c);
+    }
+  PoolBlock *block = cache->head[c];
+  cache->head[c] = block->next;
+  cache->count[c]--;
+  return block;
+}
+
+void
+EventImpl::operator delete (void *buffer, size_t size)
+{
+  uint32_t c = PoolClass (size);
+  if (c >= POOL_CLASSES || g_poolState != POOL_ENABLED)
+    {
+      ::operator delete (buffer);
+      return;
+    }
+  PoolCache *cache = PoolGetCache ();
+  PoolBlock *block = static_cast<PoolBlock *> (buffer);
+  block->next = cache->head[c];
+  cache->head[c] = block;
+  cache->count[c]++;
+  if (cache->count[c] > POOL_MAX_CACHED)
+    {
+      PoolRelease (cache, c);
+    }
+}
+
 } // namespace ns3
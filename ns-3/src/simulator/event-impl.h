@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "ns3/simple-ref-count.h"
 
 namespace ns3 {
@@ -35,6 +36,12 @@ namespace ns3 {
  * obviously (there are Ref and Unref methods) reference-counted and
  * most subclasses are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are created and destroyed at a very high rate so their memory
+ * comes from per-thread free lists, one per 16-byte size class, which
+ * are refilled from large chunks rather than from the general purpose
+ * heap. Events bigger than 256 bytes and all events when the
+ * "EventImplPool" global value is false go to the heap instead.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -57,14 +64,53 @@ public:
    * Invoked by the simulation engine before calling Invoke.
    */
   bool IsCancelled (void);
+  /**
+   * \param index the position of this event in the event list
+   *
+   * Schedulers which can find an event by its position, such as the
+   * HeapScheduler, keep it up to date here while the event is in their
+   * event list. Nothing else should use it.
+   */
+  void SetSchedulerIndex (uint32_t index);
+  /**
+   * \returns the last position stored by SetSchedulerIndex.
+   */
+  uint32_t GetSchedulerIndex (void) const;
+
+  /**
+   * \param size the size of the event subclass to allocate
+   * \returns memory from the calling thread's free list for size
+   */
+  static void *operator new (size_t size);
+  /**
+   * \param buffer memory returned by EventImpl::operator new
+   * \param size the size of the event subclass being destroyed
+   *
+   * The memory is kept in the calling thread's free list, which need
+   * not be the thread which allocated it.
+   */
+  static void operator delete (void *buffer, size_t size);
 
 protected:
   virtual void Notify (void) = 0;
 
 private:
   bool m_cancel;
+  uint32_t m_schedulerIndex;
 };
 
+inline void
+EventImpl::SetSchedulerIndex (uint32_t index)
+{
+  m_schedulerIndex = index;
+}
+
+inline uint32_t
+EventImpl::GetSchedulerIndex (void) const
+{
+  return m_schedulerIndex;
+}
+
 } // namespace ns3
 
 #endif /* EVENT_IMPL_H */
@@ -108,6 +108,8 @@ HeapScheduler::Exch (uint32_t a, uint32_t b)
   Event tmp (m_heap[a]);
   m_heap[a] = m_heap[b];
   m_heap[b] = tmp;
+  m_heap[a].impl->SetSchedulerIndex (a);
+  m_heap[b].impl->SetSchedulerIndex (b);
 }
 
 bool
@@ -129,9 +131,9 @@ HeapScheduler::IsEmpty (void) const
 }
 
 void
-HeapScheduler::BottomUp (void)
+HeapScheduler::BottomUp (uint32_t start)
 {
-  uint32_t index = Last ();
+  uint32_t index = start;
   while (!IsRoot (index)
          && IsLessStrictly (index, Parent (index)))
     {
@@ -179,7 +181,8 @@ void
 HeapScheduler::Insert (const Event &ev)
 {
   m_heap.push_back (ev);
-  BottomUp ();
+  ev.impl->SetSchedulerIndex (Last ());
+  BottomUp (Last ());
 }
 
 Scheduler::Event
@@ -201,19 +204,52 @@ HeapScheduler::RemoveNext (void)
 void
 HeapScheduler::Remove (const Event &ev)
 {
-  uint32_t uid = ev.key.m_uid;
-  for (uint32_t i = 1; i < m_heap.size (); i++)
+  uint32_t i = ev.impl->GetSchedulerIndex ();
+  NS_ASSERT (i < m_heap.size () && m_heap[i].impl == ev.impl);
+  if (i == Last ())
+    {
+      m_heap.pop_back ();
+      return;
+    }
+  Exch (i, Last ());
+  m_heap.pop_back ();
+  // the event moved into the hole may have to go either way
+  if (!IsRoot (i) && IsLessStrictly (i, Parent (i)))
     {
-      if (uid == m_heap[i].key.m_uid)
+      BottomUp (i);
+    }
+  else
+    {
+      TopDown (i);
+    }
+}
+
+void
+HeapScheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+  uint32_t last = Root ();
+  for (uint32_t i = Root (); i < m_heap.size (); i++)
+    {
+      if (m_heap[i].impl->IsCancelled ())
         {
-          NS_ASSERT (m_heap[i].impl == ev.impl);
-          Exch (i, Last ());
-          m_heap.pop_back ();
-          TopDown (i);
-          return;
+          removed.push_back (m_heap[i]);
+        }
+      else
+        {
+          m_heap[last] = m_heap[i];
+          m_heap[last].impl->SetSchedulerIndex (last);
+          last++;
         }
     }
-  NS_ASSERT (false);
+  if (last == m_heap.size ())
+    {
+      return;
+    }
+  m_heap.resize (last);
+  for (uint32_t i = Parent (Last ()); i >= Root (); i--)
+    {
+      TopDown (i);
+    }
 }
 
 } // namespace ns3
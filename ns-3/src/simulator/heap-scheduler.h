@@ -43,6 +43,11 @@ namespace ns3 {
  *    the index of the root is 1.
  *  - It uses a slightly non-standard while loop for top-down heapify
  *    to move one if statement out of the loop.
+ *  - Every event knows its position in the array through
+ *    EventImpl::SetSchedulerIndex, so Remove does not have to search for
+ *    it and costs O(log n) like the other operations.
+ *  - RemoveCancelled filters the array in one pass and rebuilds the heap
+ *    bottom-up in O(n).
  */
 class HeapScheduler : public Scheduler
 {
@@ -57,6 +62,7 @@ public:
   virtual Event PeekNext (void) const;
   virtual Event RemoveNext (void);
   virtual void Remove (const Event &ev);
+  virtual void RemoveCancelled (std::vector<Event> &removed);
 
 private:
   typedef std::vector<Event> BinaryHeap;
@@ -74,7 +80,7 @@ private:
   inline uint32_t Smallest (uint32_t a, uint32_t b) const;
 
   inline void Exch (uint32_t a, uint32_t b);
-  void BottomUp (void);
+  void BottomUp (uint32_t start);
   void TopDown (uint32_t start);
 
   BinaryHeap m_heap;
@@ -0,0 +1,280 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-queue-scheduler.h"
+#include "event-impl.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("LadderQueueScheduler");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (LadderQueueScheduler);
+
+// A bucket with more events than this is split into a new rung rather
+// than sorted into Bottom, unless the ladder is already this deep.
+static const uint32_t LADDER_BUCKET_THRESHOLD = 50;
+static const uint32_t LADDER_MAX_RUNGS = 8;
+
+TypeId
+LadderQueueScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderQueueScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderQueueScheduler> ()
+  ;
+  return tid;
+}
+
+LadderQueueScheduler::LadderQueueScheduler ()
+  : m_topMin (0),
+    m_topMax (0),
+    m_topStart (0),
+    m_nRungs (0),
+    m_size (0)
+{
+  // all rungs up front, so that references to them stay valid
+  m_rungs.resize (LADDER_MAX_RUNGS);
+}
+
+LadderQueueScheduler::~LadderQueueScheduler ()
+{
+}
+
+bool
+LadderQueueScheduler::IsLater (const Event &a, const Event &b)
+{
+  return b.key < a.key;
+}
+
+void
+LadderQueueScheduler::Append (Bucket &bucket, const Event &ev)
+{
+  ev.impl->SetSchedulerIndex (bucket.size ());
+  bucket.push_back (ev);
+}
+
+void
+LadderQueueScheduler::Erase (Bucket &bucket, uint32_t index)
+{
+  NS_ASSERT (index < bucket.size ());
+  bucket[index] = bucket.back ();
+  bucket[index].impl->SetSchedulerIndex (index);
+  bucket.pop_back ();
+}
+
+uint32_t
+LadderQueueScheduler::FindRung (uint64_t ts) const
+{
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      const Rung &rung = m_rungs[i];
+      if (ts >= rung.start + rung.current * rung.width)
+        {
+          return i;
+        }
+    }
+  return m_nRungs;
+}
+
+void
+LadderQueueScheduler::SpawnRung (uint64_t start, uint64_t width, uint32_t nBuckets, Bucket &events)
+{
+  NS_LOG_LOGIC ("rung " << m_nRungs << " start=" << start << " width=" << width <<
+                " buckets=" << nBuckets << " events=" << events.size ());
+  Rung &rung = m_rungs[m_nRungs++];
+  rung.start = start;
+  rung.width = width;
+  rung.current = 0;
+  rung.nBuckets = nBuckets;
+  if (rung.buckets.size () < nBuckets)
+    {
+      rung.buckets.resize (nBuckets);
+    }
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); i++)
+    {
+      uint64_t index = (i->key.m_ts - start) / width;
+      NS_ASSERT (index < nBuckets);
+      Append (rung.buckets[index], *i);
+    }
+  events.clear ();
+}
+
+void
+LadderQueueScheduler::SortIntoBottom (Bucket &events)
+{
+  NS_ASSERT (m_bottom.empty ());
+  m_bottom.swap (events);
+  std::sort (m_bottom.begin (), m_bottom.end (), &LadderQueueScheduler::IsLater);
+}
+
+void
+LadderQueueScheduler::Refill (void)
+{
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          if (m_top.empty ())
+            {
+              return;
+            }
+          // spread all of Top over one bucket per event
+          uint64_t n = m_top.size ();
+          uint64_t width = (m_topMax - m_topMin) / n + 1;
+          uint32_t nBuckets = (m_topMax - m_topMin) / width + 1;
+          m_topStart = m_topMin + nBuckets * width;
+          SpawnRung (m_topMin, width, nBuckets, m_top);
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      while (rung.current < rung.nBuckets && rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      if (rung.current == rung.nBuckets)
+        {
+          m_nRungs--;
+          continue;
+        }
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t start = rung.start + rung.current * rung.width;
+      rung.current++;
+      if (bucket.size () > LADDER_BUCKET_THRESHOLD && rung.width > 1 && m_nRungs < LADDER_MAX_RUNGS)
+        {
+          uint64_t width = std::max<uint64_t> (rung.width / bucket.size (), 1);
+          uint32_t nBuckets = (rung.width + width - 1) / width;
+          SpawnRung (start, width, nBuckets, bucket);
+        }
+      else
+        {
+          SortIntoBottom (bucket);
+        }
+    }
+}
+
+void
+LadderQueueScheduler::Insert (const Event &ev)
+{
+  m_size++;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ts);
+          m_topMax = std::max (m_topMax, ts);
+        }
+      Append (m_top, ev);
+    }
+  else
+    {
+      uint32_t r = FindRung (ts);
+      if (r < m_nRungs)
+        {
+          Rung &rung = m_rungs[r];
+          Append (rung.buckets[(ts - rung.start) / rung.width], ev);
+        }
+      else
+        {
+          m_bottom.insert (std::lower_bound (m_bottom.begin (), m_bottom.end (), ev,
+                                             &LadderQueueScheduler::IsLater), ev);
+          uint64_t min = m_bottom.back ().key.m_ts;
+          uint64_t max = m_bottom.front ().key.m_ts;
+          if (m_bottom.size () > LADDER_BUCKET_THRESHOLD && m_nRungs < LADDER_MAX_RUNGS && max > min)
+            {
+              // keep sorted inserts cheap, Bottom becomes the lowest rung;
+              // it has to reach up to where the rung above it takes over
+              uint64_t end = m_topStart;
+              if (m_nRungs > 0)
+                {
+                  const Rung &above = m_rungs[m_nRungs - 1];
+                  end = above.start + above.current * above.width;
+                }
+              uint64_t width = (end - min) / m_bottom.size () + 1;
+              uint32_t nBuckets = (end - min + width - 1) / width;
+              SpawnRung (min, width, nBuckets, m_bottom);
+            }
+        }
+    }
+}
+
+bool
+LadderQueueScheduler::IsEmpty (void) const
+{
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderQueueScheduler::PeekNext (void) const
+{
+  NS_ASSERT (!IsEmpty ());
+  // Bottom is only refilled on demand, so that events inserted before the
+  // first dequeue all end up in Top and the first rung spans all of them
+  const_cast<LadderQueueScheduler *> (this)->Refill ();
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderQueueScheduler::RemoveNext (void)
+{
+  NS_ASSERT (!IsEmpty ());
+  Refill ();
+  Event next = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_size--;
+  return next;
+}
+
+void
+LadderQueueScheduler::Remove (const Event &ev)
+{
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      NS_ASSERT (m_top[ev.impl->GetSchedulerIndex ()].impl == ev.impl);
+      Erase (m_top, ev.impl->GetSchedulerIndex ());
+    }
+  else
+    {
+      uint32_t r = FindRung (ts);
+      if (r < m_nRungs)
+        {
+          Rung &rung = m_rungs[r];
+          Bucket &bucket = rung.buckets[(ts - rung.start) / rung.width];
+          NS_ASSERT (bucket[ev.impl->GetSchedulerIndex ()].impl == ev.impl);
+          Erase (bucket, ev.impl->GetSchedulerIndex ());
+        }
+      else
+        {
+          Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev,
+                                                 &LadderQueueScheduler::IsLater);
+          NS_ASSERT (i != m_bottom.end () && i->impl == ev.impl);
+          m_bottom.erase (i);
+        }
+    }
+  m_size--;
+}
+
+} // namespace ns3
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_QUEUE_SCHEDULER_H
+#define LADDER_QUEUE_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue from "Ladder Queue: An
+ * O(1) Priority Queue Structure for Large-Scale Discrete Event Simulation"
+ * by Wee Tang, Rick Goh and Ian Thng (2005). Events go into one of three
+ * tiers:
+ *  - Top: an unsorted array of the events beyond the range of the ladder.
+ *  - Ladder: rungs of buckets. The first rung splits the whole of Top
+ *    into buckets; a bucket that holds too many events when its turn
+ *    comes is split again into a finer rung below.
+ *  - Bottom: the events of the current bucket, sorted. RemoveNext takes
+ *    them from here.
+ * Inserts append to Top or to a bucket, so they are O(1). Each event is
+ * sorted only once, in a small batch, when its bucket moves to Bottom.
+ * Unlike the CalendarScheduler, nothing has to be resized by hand, because
+ * bucket widths follow the events that are actually pending.
+ *
+ * Events in Top and in buckets know their position through
+ * EventImpl::SetSchedulerIndex, so Remove does not search those either.
+ */
+class LadderQueueScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderQueueScheduler ();
+  virtual ~LadderQueueScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  typedef std::vector<Event> Bucket;
+  struct Rung
+  {
+    uint64_t start;
+    uint64_t width;
+    // buckets before this one have been handed down already
+    uint32_t current;
+    // buckets in use, there may be more from an earlier, wider rung
+    uint32_t nBuckets;
+    std::vector<Bucket> buckets;
+  };
+
+  static bool IsLater (const Event &a, const Event &b);
+  /* Append to an unsorted bucket or Top, recording the position. */
+  inline void Append (Bucket &bucket, const Event &ev);
+  /* Swap the last event of an unsorted bucket or Top into slot index. */
+  inline void Erase (Bucket &bucket, uint32_t index);
+  /* Return the rung whose current range holds ts, or m_nRungs if none. */
+  uint32_t FindRung (uint64_t ts) const;
+  void SpawnRung (uint64_t start, uint64_t width, uint32_t nBuckets, Bucket &events);
+  void SortIntoBottom (Bucket &events);
+  /* Refill Bottom if it is empty and events are left elsewhere. */
+  void Refill (void);
+
+  Bucket m_top;
+  uint64_t m_topMin;
+  uint64_t m_topMax;
+  // events at or after m_topStart go to Top
+  uint64_t m_topStart;
+  // m_rungs[0 .. m_nRungs) are in use, the rest keep their memory
+  std::vector<Rung> m_rungs;
+  uint32_t m_nRungs;
+  // sorted latest first, so the next event is at the back
+  Bucket m_bottom;
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_QUEUE_SCHEDULER_H */
@@ -38,4 +38,9 @@ Scheduler::GetTypeId (void)
   return tid;
 }
 
+void
+Scheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+}
+
 } // namespace ns3
@@ -22,6 +22,7 @@
 #define SCHEDULER_H
 
 #include <stdint.h>
+#include <vector>
 #include "ns3/object.h"
 
 namespace ns3 {
@@ -95,6 +96,15 @@ public:
    * This methods cannot be invoked if the list is empty.
    */
   virtual void Remove (const Event &ev) = 0;
+  /**
+   * \param removed the events taken out of the event list
+   *
+   * Remove all events whose EventImpl has been canceled and append them to
+   * removed. The caller has to Unref them as for the other Remove methods.
+   * Schedulers which can not do this in a single pass over their event
+   * list keep the canceled events, which are then skipped when they expire.
+   */
+  virtual void RemoveCancelled (std::vector<Event> &removed);
 };
 
 /* Note the invariants which this function must provide:
@@ -30,6 +30,9 @@
 #include "ns3/global-value.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/async-log-writer.h"
+#endif
 
 #include <math.h>
 #include <fstream>
@@ -143,6 +146,10 @@ Simulator::Destroy (void)
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
+#ifdef HAVE_PTHREAD_H
+  // Whatever was logged during the simulation is out when Destroy returns
+  AsyncLogWriter::FlushAll ();
+#endif
 }
 
 void
@@ -383,6 +390,8 @@ Simulator::GetImplementation (void)
 #include "ns3/test.h"
 #include "list-scheduler.h"
 #include "heap-scheduler.h"
+#include "dary-heap-scheduler.h"
+#include "ladder-queue-scheduler.h"
 #include "map-scheduler.h"
 #include "calendar-scheduler.h"
 #include "ns2-calendar-scheduler.h"
@@ -532,6 +541,75 @@ SimulatorEventsTestCase::DoRun (void)
   return false;
 }
 
+class SimulatorRemoveTestCase : public TestCase
+{
+public:
+  SimulatorRemoveTestCase (ObjectFactory schedulerFactory);
+  virtual bool DoRun (void);
+  void Ran (uint32_t i);
+  std::vector<EventId> m_ids;
+  std::vector<uint32_t> m_ran;
+  uint64_t m_lastNs;
+  bool m_inOrder;
+  ObjectFactory m_schedulerFactory;
+};
+
+SimulatorRemoveTestCase::SimulatorRemoveTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that removed and canceled events are gone with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{}
+
+void
+SimulatorRemoveTestCase::Ran (uint32_t i)
+{
+  uint64_t ns = Now ().GetNanoSeconds ();
+  if (ns < m_lastNs)
+    {
+      m_inOrder = false;
+    }
+  m_lastNs = ns;
+  m_ran.push_back (i);
+}
+
+bool
+SimulatorRemoveTestCase::DoRun (void)
+{
+  // enough canceled events for the simulator to drop them from the event list
+  const uint32_t n = 6000;
+  m_lastNs = 0;
+  m_inOrder = true;
+  Simulator::SetScheduler (m_schedulerFactory);
+
+  uint32_t random = 1;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      random = random * 1103515245 + 12345;
+      m_ids.push_back (Simulator::Schedule (MicroSeconds (1 + (random >> 16) % 1000),
+                                            &SimulatorRemoveTestCase::Ran, this, i));
+    }
+  // remove every third event, cancel the one after it
+  for (uint32_t i = 0; i + 1 < n; i += 3)
+    {
+      Simulator::Remove (m_ids[i]);
+      Simulator::Cancel (m_ids[i + 1]);
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_ids[i].IsExpired (), (i % 3 != 2), "Event " << i);
+    }
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_inOrder, true, "Events did not run in time order");
+  NS_TEST_EXPECT_MSG_EQ (m_ran.size (), n / 3, "Wrong number of events ran");
+  for (uint32_t i = 0; i < m_ran.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_ran[i] % 3, 2, "Removed or canceled event " << m_ran[i] << " ran");
+    }
+  Simulator::Destroy ();
+  return false;
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -838,10 +916,28 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory));
     factory.SetTypeId (HeapScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory));
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory));
+    factory.SetTypeId (LadderQueueScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory));
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory));
     factory.SetTypeId (Ns2CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory));
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (LadderQueueScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
+    factory.SetTypeId (Ns2CalendarScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory));
   }
 } g_simulatorTestSuite;
 
@@ -0,0 +1,447 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+
+using namespace ns3;
+
+// Returns the DefaultSimulatorImpl for zero threads
+static Ptr<SimulatorImpl>
+CreateSimulatorImpl (uint32_t maxThreads)
+{
+  if (maxThreads == 0)
+    {
+      return CreateObject<DefaultSimulatorImpl> ();
+    }
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  impl->SetAttribute ("MaxThreads", UintegerValue (maxThreads));
+  return impl;
+}
+
+struct Reception
+{
+  int64_t ts;
+  uint32_t ifIndex;
+  uint32_t size;
+};
+
+// What one node sends and receives. Only the thread of the partition of
+// the node touches it while the simulation runs.
+struct NodeTraffic
+{
+  // indexed by interface, in the order the links were installed
+  std::vector<Ptr<NetDevice> > devices;
+  std::vector<Reception> receptions;
+};
+
+// Packets lose a byte at every hop and are dropped at this size
+static const uint32_t RING_MIN_SIZE = 40;
+
+static void
+RingSend (NodeTraffic *traffic, uint32_t ifIndex, uint32_t size)
+{
+  Ptr<NetDevice> device = traffic->devices[ifIndex];
+  device->Send (Create<Packet> (size), device->GetBroadcast (), 0x0800);
+}
+
+// Forwards what a node receives on one device out of its other one
+static bool
+RingReceive (NodeTraffic *traffic, Ptr<NetDevice> device, Ptr<const Packet> packet,
+             uint16_t protocol, const Address &from)
+{
+  Reception reception;
+  reception.ts = Simulator::Now ().GetTimeStep ();
+  reception.ifIndex = device->GetIfIndex ();
+  reception.size = packet->GetSize ();
+  traffic->receptions.push_back (reception);
+  if (reception.size > RING_MIN_SIZE)
+    {
+      RingSend (traffic, 1 - reception.ifIndex, reception.size - 1);
+    }
+  return true;
+}
+
+// Injects more packets from an event without node context, between windows
+static void
+RingInject (NodeTraffic *traffic, uint32_t node)
+{
+  Simulator::ScheduleWithContext (node, Seconds (0), &RingSend, traffic, 0, 50);
+  Simulator::ScheduleWithContext (node, MilliSeconds (1), &RingSend, traffic, 1, 51);
+}
+
+/**
+ * \brief Runs the same traffic over a ring of point-to-point links with
+ * the DefaultSimulatorImpl and with the MultithreadedSimulatorImpl on 1, 2
+ * and 4 threads, and checks every node receives the same packets at the
+ * same times.
+ */
+class MultithreadedSimulatorRingTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorRingTestCase ();
+  virtual ~MultithreadedSimulatorRingTestCase ();
+
+private:
+  virtual bool DoRun (void);
+  void RunRing (uint32_t maxThreads, std::vector<NodeTraffic> &traffic, std::vector<uint32_t> &systemIds);
+};
+
+MultithreadedSimulatorRingTestCase::MultithreadedSimulatorRingTestCase ()
+  : TestCase ("Same receptions on 1, 2 and 4 threads as with the default simulator")
+{
+}
+
+MultithreadedSimulatorRingTestCase::~MultithreadedSimulatorRingTestCase ()
+{
+}
+
+void
+MultithreadedSimulatorRingTestCase::RunRing (uint32_t maxThreads, std::vector<NodeTraffic> &traffic,
+                                             std::vector<uint32_t> &systemIds)
+{
+  Simulator::SetImplementation (CreateSimulatorImpl (maxThreads));
+
+  // links of different delays, the lookahead is the smallest one which
+  // crosses two partitions
+  uint32_t delaysUs[] = { 2000, 3000, 5000, 2000, 7000, 3000, 2500, 4000 };
+  uint32_t nNodes = sizeof (delaysUs) / sizeof (delaysUs[0]);
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+  traffic.assign (nNodes, NodeTraffic ());
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("5Mbps"));
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      uint32_t next = (i + 1) % nNodes;
+      p2p.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (delaysUs[i])));
+      NetDeviceContainer devices = p2p.Install (nodes.Get (i), nodes.Get (next));
+      traffic[i].devices.push_back (devices.Get (0));
+      traffic[next].devices.push_back (devices.Get (1));
+    }
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Ptr<NetDevice> device = traffic[i].devices[j];
+          device->SetReceiveCallback (MakeBoundCallback (&RingReceive, &traffic[i]));
+          Simulator::ScheduleWithContext (i, MicroSeconds (137 * i + 53 * j + 11), &RingSend,
+                                          &traffic[i], j, 60 + i + j);
+        }
+    }
+  Simulator::Schedule (MicroSeconds (10310), &RingInject, &traffic[3], 3);
+  Simulator::Run ();
+
+  systemIds.clear ();
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      systemIds.push_back (nodes.Get (i)->GetSystemId ());
+    }
+  Simulator::Destroy ();
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      traffic[i].devices.clear ();
+    }
+}
+
+bool
+MultithreadedSimulatorRingTestCase::DoRun (void)
+{
+  std::vector<NodeTraffic> expected;
+  std::vector<uint32_t> systemIds;
+  RunRing (0, expected, systemIds);
+  uint32_t nReceptions = 0;
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      nReceptions += expected[i].receptions.size ();
+    }
+  NS_TEST_ASSERT_MSG_GT (nReceptions, 200, "Too little traffic in the ring");
+
+  uint32_t threads[] = { 1, 2, 4 };
+  for (uint32_t t = 0; t < 3; t++)
+    {
+      std::vector<NodeTraffic> traffic;
+      RunRing (threads[t], traffic, systemIds);
+      for (uint32_t i = 0; i < expected.size (); i++)
+        {
+          // the nodes are split into blocks of consecutive ids
+          uint32_t expectedSystemId = threads[t] > 1 ? i * threads[t] / expected.size () : 0;
+          NS_TEST_ASSERT_MSG_EQ (systemIds[i], expectedSystemId, "System id of node " << i);
+          NS_TEST_ASSERT_MSG_EQ (traffic[i].receptions.size (), expected[i].receptions.size (),
+                                 "Receptions of node " << i << " on " << threads[t] << " threads");
+          for (uint32_t k = 0; k < expected[i].receptions.size (); k++)
+            {
+              const Reception &got = traffic[i].receptions[k];
+              const Reception &want = expected[i].receptions[k];
+              NS_TEST_ASSERT_MSG_EQ (got.ts, want.ts, "Time of reception " << k << " of node " << i <<
+                                     " on " << threads[t] << " threads");
+              NS_TEST_ASSERT_MSG_EQ (got.ifIndex, want.ifIndex, "Device of reception " << k << " of node " << i <<
+                                     " on " << threads[t] << " threads");
+              NS_TEST_ASSERT_MSG_EQ (got.size, want.size, "Size of reception " << k << " of node " << i <<
+                                     " on " << threads[t] << " threads");
+            }
+        }
+    }
+  return GetErrorStatus ();
+}
+
+/**
+ * \brief Base of the tests on two nodes, one per partition, joined by a
+ * point-to-point link, which record the labels of the events they run.
+ */
+class MultithreadedSimulatorPairTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorPairTestCase (std::string name);
+  virtual ~MultithreadedSimulatorPairTestCase ();
+
+protected:
+  struct Record
+  {
+    int64_t ts;
+    uint32_t label;
+  };
+
+  // Sets the implementation and creates the nodes, linked by a channel
+  // with this delay, which is the lookahead
+  void Setup (uint32_t maxThreads, Time delay);
+  void Teardown (void);
+  void Fire (uint32_t node, uint32_t label);
+
+  NodeContainer m_nodes;
+  // what each node ran, only touched from the partition of that node
+  std::vector<Record> m_records[2];
+};
+
+MultithreadedSimulatorPairTestCase::MultithreadedSimulatorPairTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+MultithreadedSimulatorPairTestCase::~MultithreadedSimulatorPairTestCase ()
+{
+}
+
+void
+MultithreadedSimulatorPairTestCase::Setup (uint32_t maxThreads, Time delay)
+{
+  Simulator::SetImplementation (CreateSimulatorImpl (maxThreads));
+  m_nodes = NodeContainer ();
+  m_nodes.Create (2);
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", TimeValue (delay));
+  p2p.Install (m_nodes);
+  m_records[0].clear ();
+  m_records[1].clear ();
+}
+
+void
+MultithreadedSimulatorPairTestCase::Teardown (void)
+{
+  Simulator::Destroy ();
+  m_nodes = NodeContainer ();
+}
+
+void
+MultithreadedSimulatorPairTestCase::Fire (uint32_t node, uint32_t label)
+{
+  Record record;
+  record.ts = Simulator::Now ().GetTimeStep ();
+  record.label = label;
+  m_records[node].push_back (record);
+}
+
+/**
+ * \brief Schedules, cancels and removes events of the other partition, from
+ * a node and from an event without context.
+ */
+class MultithreadedSimulatorCancelTestCase : public MultithreadedSimulatorPairTestCase
+{
+public:
+  MultithreadedSimulatorCancelTestCase ();
+
+private:
+  virtual bool DoRun (void);
+  void ScheduleOnNode1 (void);
+  void CancelFromNode0 (void);
+  void RemoveFromSerial (void);
+
+  EventId m_cancelled;
+  EventId m_removedByNode0;
+  EventId m_removedBySerial;
+  EventId m_kept;
+  bool m_expiredAfterRemove;
+  bool m_keptPending;
+};
+
+MultithreadedSimulatorCancelTestCase::MultithreadedSimulatorCancelTestCase ()
+  : MultithreadedSimulatorPairTestCase ("Schedule, Cancel and Remove events of another partition")
+{
+}
+
+void
+MultithreadedSimulatorCancelTestCase::ScheduleOnNode1 (void)
+{
+  m_cancelled = Simulator::Schedule (MilliSeconds (39), &MultithreadedSimulatorCancelTestCase::Fire, this, 1, 1);
+  m_removedByNode0 = Simulator::Schedule (MilliSeconds (39), &MultithreadedSimulatorCancelTestCase::Fire, this, 1, 2);
+  m_removedBySerial = Simulator::Schedule (MilliSeconds (39), &MultithreadedSimulatorCancelTestCase::Fire, this, 1, 3);
+  m_kept = Simulator::Schedule (MilliSeconds (44), &MultithreadedSimulatorCancelTestCase::Fire, this, 1, 4);
+  // removed by its own partition
+  EventId local = Simulator::Schedule (MilliSeconds (5), &MultithreadedSimulatorCancelTestCase::Fire, this, 1, 5);
+  Simulator::Remove (local);
+}
+
+void
+MultithreadedSimulatorCancelTestCase::CancelFromNode0 (void)
+{
+  Simulator::Cancel (m_cancelled);
+  Simulator::Remove (m_removedByNode0);
+  // an event of node 1 sent from node 0, at least the lookahead later
+  Simulator::ScheduleWithContext (1, MilliSeconds (10), &MultithreadedSimulatorCancelTestCase::Fire, this, 1, 6);
+  Fire (0, 7);
+}
+
+void
+MultithreadedSimulatorCancelTestCase::RemoveFromSerial (void)
+{
+  Simulator::Remove (m_removedBySerial);
+  m_expiredAfterRemove = Simulator::IsExpired (m_removedBySerial);
+  m_keptPending = !Simulator::IsExpired (m_kept);
+  Simulator::ScheduleWithContext (0, MilliSeconds (1), &MultithreadedSimulatorCancelTestCase::Fire, this, 0, 8);
+}
+
+bool
+MultithreadedSimulatorCancelTestCase::DoRun (void)
+{
+  uint32_t threads[] = { 0, 2 };
+  for (uint32_t t = 0; t < 2; t++)
+    {
+      Setup (threads[t], MilliSeconds (10));
+      m_expiredAfterRemove = false;
+      m_keptPending = false;
+      Simulator::ScheduleWithContext (1, MilliSeconds (1), &MultithreadedSimulatorCancelTestCase::ScheduleOnNode1, this);
+      Simulator::ScheduleWithContext (0, MilliSeconds (20), &MultithreadedSimulatorCancelTestCase::CancelFromNode0, this);
+      Simulator::Schedule (MilliSeconds (25), &MultithreadedSimulatorCancelTestCase::RemoveFromSerial, this);
+      Simulator::Run ();
+      Teardown ();
+
+      NS_TEST_ASSERT_MSG_EQ (m_expiredAfterRemove, true, "Removed event not expired on " << threads[t] << " threads");
+      NS_TEST_ASSERT_MSG_EQ (m_keptPending, true, "Pending event expired on " << threads[t] << " threads");
+      NS_TEST_ASSERT_MSG_EQ (m_records[0].size (), 2, "Events of node 0 on " << threads[t] << " threads");
+      NS_TEST_ASSERT_MSG_EQ (m_records[0][0].label, 7, "First event of node 0");
+      NS_TEST_ASSERT_MSG_EQ (m_records[0][0].ts, MilliSeconds (20).GetTimeStep (), "Time of the first event of node 0");
+      NS_TEST_ASSERT_MSG_EQ (m_records[0][1].label, 8, "Event of node 0 from the serial event");
+      NS_TEST_ASSERT_MSG_EQ (m_records[0][1].ts, MilliSeconds (26).GetTimeStep (), "Time of the serial event");
+      NS_TEST_ASSERT_MSG_EQ (m_records[1].size (), 2, "Events of node 1 on " << threads[t] << " threads");
+      NS_TEST_ASSERT_MSG_EQ (m_records[1][0].label, 6, "Event of node 1 from node 0");
+      NS_TEST_ASSERT_MSG_EQ (m_records[1][0].ts, MilliSeconds (30).GetTimeStep (), "Time of the event from node 0");
+      NS_TEST_ASSERT_MSG_EQ (m_records[1][1].label, 4, "Event of node 1 which was kept");
+      NS_TEST_ASSERT_MSG_EQ (m_records[1][1].ts, MilliSeconds (45).GetTimeStep (), "Time of the kept event");
+    }
+  return GetErrorStatus ();
+}
+
+/**
+ * \brief Sends an event to the other partition with a delay shorter than the
+ * lookahead, which is allowed as long as it lands after the current window,
+ * and checks it runs at its time and after what that node had scheduled
+ * for the same time.
+ */
+class MultithreadedSimulatorShortDelayTestCase : public MultithreadedSimulatorPairTestCase
+{
+public:
+  MultithreadedSimulatorShortDelayTestCase ();
+
+private:
+  virtual bool DoRun (void);
+  void SendLate (void);
+  void ScheduleOnNode1 (void);
+};
+
+MultithreadedSimulatorShortDelayTestCase::MultithreadedSimulatorShortDelayTestCase ()
+  : MultithreadedSimulatorPairTestCase ("Delay shorter than the lookahead to another partition")
+{
+}
+
+void
+MultithreadedSimulatorShortDelayTestCase::SendLate (void)
+{
+  Fire (0, 1);
+  // 3ms of a 10ms lookahead, 8ms into the window which started at 0
+  Simulator::ScheduleWithContext (1, MilliSeconds (3), &MultithreadedSimulatorShortDelayTestCase::Fire, this, 1, 2);
+}
+
+void
+MultithreadedSimulatorShortDelayTestCase::ScheduleOnNode1 (void)
+{
+  Simulator::Schedule (MilliSeconds (11), &MultithreadedSimulatorShortDelayTestCase::Fire, this, 1, 3);
+  Simulator::Schedule (MicroSeconds (10500), &MultithreadedSimulatorShortDelayTestCase::Fire, this, 1, 4);
+}
+
+bool
+MultithreadedSimulatorShortDelayTestCase::DoRun (void)
+{
+  std::vector<Record> expected;
+  uint32_t threads[] = { 0, 2 };
+  for (uint32_t t = 0; t < 2; t++)
+    {
+      Setup (threads[t], MilliSeconds (10));
+      Simulator::ScheduleWithContext (1, Seconds (0), &MultithreadedSimulatorShortDelayTestCase::ScheduleOnNode1, this);
+      Simulator::ScheduleWithContext (0, MilliSeconds (8), &MultithreadedSimulatorShortDelayTestCase::SendLate, this);
+      Simulator::Run ();
+      Teardown ();
+
+      NS_TEST_ASSERT_MSG_EQ (m_records[0].size (), 1, "Events of node 0 on " << threads[t] << " threads");
+      NS_TEST_ASSERT_MSG_EQ (m_records[1].size (), 3, "Events of node 1 on " << threads[t] << " threads");
+      uint32_t labels[] = { 4, 3, 2 };
+      int64_t times[] = { MicroSeconds (10500).GetTimeStep (), MilliSeconds (11).GetTimeStep (),
+                          MilliSeconds (11).GetTimeStep () };
+      for (uint32_t k = 0; k < 3; k++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (m_records[1][k].label, labels[k], "Event " << k << " of node 1 on " <<
+                                 threads[t] << " threads");
+          NS_TEST_ASSERT_MSG_EQ (m_records[1][k].ts, times[k], "Time of event " << k << " of node 1 on " <<
+                                 threads[t] << " threads");
+        }
+    }
+  return GetErrorStatus ();
+}
+
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ();
+};
+
+MultithreadedSimulatorTestSuite::MultithreadedSimulatorTestSuite ()
+  : TestSuite ("multithreaded-simulator", SYSTEM)
+{
+  AddTestCase (new MultithreadedSimulatorRingTestCase);
+  AddTestCase (new MultithreadedSimulatorCancelTestCase);
+  AddTestCase (new MultithreadedSimulatorShortDelayTestCase);
+}
+
+MultithreadedSimulatorTestSuite multithreadedSimulatorTestSuite;
@@ -20,6 +20,13 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/packet-arena.h"
+#include "ns3/traced-callback.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
+#include <vector>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -181,6 +188,42 @@ benchD (uint32_t n)
 }
 
 
+static void
+CountTrace (uint32_t *count, Ptr<const Packet> p)
+{
+  (*count)++;
+}
+
+// the trace sources a packet fires through a point to point hop and the
+// ipv4 layers on each side, as seen when only a packet counter is connected
+static void
+benchE (uint32_t n)
+{
+  TracedCallback<Ptr<const Packet> > macTx;
+  TracedCallback<Ptr<const Packet> > phyTxBegin;
+  TracedCallback<Ptr<const Packet> > phyTxEnd;
+  TracedCallback<Ptr<const Packet> > phyRxEnd;
+  TracedCallback<Ptr<const Packet> > macRx;
+  TracedCallback<Ptr<const Packet>, Ptr<const Packet>, uint32_t> ipv4Tx;
+  TracedCallback<Ptr<const Packet>, Ptr<const Packet>, uint32_t> ipv4Rx;
+  uint32_t count = 0;
+  macRx.ConnectWithoutContext (MakeBoundCallback (&CountTrace, &count));
+
+  Ptr<const Packet> p = Create<Packet> (2000);
+  for (uint32_t i = 0; i < n; i++) {
+    // a few hops per packet, to weigh the traces against the packet work
+    for (uint32_t hop = 0; hop < 16; hop++) {
+      ipv4Tx (p, p, 1);
+      macTx (p);
+      phyTxBegin (p);
+      phyTxEnd (p);
+      phyRxEnd (p);
+      macRx (p);
+      ipv4Rx (p, p, 1);
+    }
+  }
+  NS_ASSERT (count == n * 16);
+}
 
 static void 
 benchA (uint32_t n)
@@ -243,13 +286,33 @@ benchC (uint32_t n)
 
 
 static void
-runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t nThreads, char const *name)
 {
   SystemWallClockMs time;
   time.Start ();
-  (*bench) (n);
+#ifdef HAVE_PTHREAD_H
+  if (nThreads > 1)
+    {
+      // every thread creates and destroys its own n packets
+      std::vector<Ptr<SystemThread> > threads;
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          threads.push_back (Create<SystemThread> (MakeBoundCallback (bench, n)));
+          threads.back ()->Start ();
+        }
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          threads[i]->Join ();
+        }
+    }
+  else
+#endif
+    {
+      (*bench) (n);
+    }
   uint64_t deltaMs = time.End ();
   double ps = n;
+  ps *= nThreads;
   ps *= 1000;
   ps /= deltaMs;
   std::cout << name<<"=" << ps << " packets/s" << std::endl;
@@ -258,6 +321,7 @@ runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
 int main (int argc, char *argv[])
 {
   uint32_t n = 0;
+  uint32_t nThreads = 1;
   while (argc > 0) {
       if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0) 
         {
@@ -270,6 +334,10 @@ int main (int argc, char *argv[])
         {
           Packet::EnablePrinting ();
         }
+      if (strncmp ("--threads=", argv[0], strlen ("--threads=")) == 0)
+        {
+          nThreads = atoi (argv[0] + strlen ("--threads="));
+        }
       argc--;
       argv++;
   }
@@ -279,12 +347,24 @@ int main (int argc, char *argv[])
         "by command-line argument --n=(number of packets)" << std::endl;
       exit (1);
     }
-  std::cout << "Running bench-packets with n=" << n << std::endl;
+#ifndef HAVE_PTHREAD_H
+  nThreads = 1;
+#endif
+  if (nThreads == 0)
+    {
+      nThreads = 1;
+    }
+  // NS_GLOBAL_VALUE=PacketArena=false for the general purpose heap
+  std::cout << "Running bench-packets with n=" << n << ", threads=" << nThreads
+            << ", packet arena " << (PacketArena::IsEnabled () ? "on" : "off") << std::endl;
+
+  runBench (&benchA, n, nThreads, "a");
+  runBench (&benchB, n, nThreads, "b");
+  runBench (&benchC, n, nThreads, "c");
+  runBench (&benchD, n, nThreads, "d");
+  runBench (&benchE, n, nThreads, "e");
 
-  runBench (&benchA, n, "a");
-  runBench (&benchB, n, "b");
-  runBench (&benchC, n, "c");
-  runBench (&benchD, n, "d");
+  PacketArena::PrintStats (std::cout);
 
   return 0;
 }
@@ -30,26 +30,48 @@ using namespace ns3;
 
 bool g_debug = false;
 
+enum Reschedule
+{
+  RESCHEDULE_NONE,
+  RESCHEDULE_CANCEL,
+  RESCHEDULE_REMOVE
+};
+
 class Bench 
 {
 public:
   Bench ();
   void ReadDistribution (std::istream &istream);
   void SetTotal (uint32_t total);
+  void SetReschedule (enum Reschedule reschedule);
   void RunBench (void);
 private:
   void Cb (void);
+  void Timeout (void);
   std::vector<uint64_t> m_distribution;
   std::vector<uint64_t>::const_iterator m_current;
   uint32_t m_n;
   uint32_t m_total;
+  enum Reschedule m_reschedule;
+  std::vector<EventId> m_timers;
+  uint32_t m_nextTimer;
+  uint32_t m_timeouts;
 };
 
 Bench::Bench ()
   : m_n (0),
-    m_total (0)
+    m_total (0),
+    m_reschedule (RESCHEDULE_NONE),
+    m_nextTimer (0),
+    m_timeouts (0)
 {}
 
+void
+Bench::SetReschedule (enum Reschedule reschedule)
+{
+  m_reschedule = reschedule;
+}
+
 void 
 Bench::SetTotal (uint32_t total)
 {
@@ -91,6 +113,11 @@ Bench::RunBench (void)
   init /= 1000;
 
   m_current = m_distribution.begin ();
+  if (m_reschedule != RESCHEDULE_NONE)
+    {
+      // one pending timer per scheduled event, like protocol timeouts
+      m_timers.assign (m_distribution.size (), EventId ());
+    }
 
   time.Start ();
   Simulator::Run ();
@@ -105,6 +132,10 @@ Bench::RunBench (void)
       "simu " << ((double)m_n) / simu<< " hold/s, avg hold=" << 
       simu / ((double)m_n) << "s" << std::endl
       ;
+  if (m_reschedule != RESCHEDULE_NONE)
+    {
+      std::cout << "timers rescheduled=" << m_n << ", expired=" << m_timeouts << std::endl;
+    }
 }
 
 void
@@ -123,10 +154,31 @@ Bench::Cb (void)
       std::cerr << "event at " << Simulator::Now ().GetSeconds () << "s" << std::endl;
     }
   Simulator::Schedule (NanoSeconds (*m_current), &Bench::Cb, this);
+  if (m_reschedule != RESCHEDULE_NONE)
+    {
+      // push a timer further out, the way Timer::Schedule does
+      EventId &timer = m_timers[m_nextTimer];
+      m_nextTimer = (m_nextTimer + 1) % m_timers.size ();
+      if (m_reschedule == RESCHEDULE_CANCEL)
+        {
+          Simulator::Cancel (timer);
+        }
+      else
+        {
+          Simulator::Remove (timer);
+        }
+      timer = Simulator::Schedule (NanoSeconds (*m_current * 10), &Bench::Timeout, this);
+    }
   m_current++;
   m_n++;
 }
 
+void
+Bench::Timeout (void)
+{
+  m_timeouts++;
+}
+
 void
 PrintHelp (void)
 {
@@ -136,6 +188,12 @@ PrintHelp (void)
   std::cout << "      --list: use std::list scheduler"<<std::endl;
   std::cout << "      --map: use std::map cheduler"<<std::endl;
   std::cout << "      --heap: use Binary Heap scheduler"<<std::endl;
+  std::cout << "      --calendar: use Calendar scheduler"<<std::endl;
+  std::cout << "      --dary: use 4-ary Heap scheduler"<<std::endl;
+  std::cout << "      --ladder: use Ladder Queue scheduler"<<std::endl;
+  std::cout << "      --reschedule=cancel: each event also cancels and reschedules a timer"<<std::endl;
+  std::cout << "      --reschedule=remove: same, with Simulator::Remove instead of Cancel"<<std::endl;
+  std::cout << "      --no-event-pool: allocate events from the heap instead of the event pool"<<std::endl;
   std::cout << "      --debug: enable some debugging"<<std::endl;
 }
 
@@ -145,6 +203,7 @@ int main (int argc, char *argv[])
   std::istream *input;
   uint32_t n = 1;
   uint32_t total = 20000;
+  enum Reschedule reschedule = RESCHEDULE_NONE;
   if (argc == 1)
     {
       PrintHelp ();
@@ -175,7 +234,7 @@ int main (int argc, char *argv[])
         } 
       else if (strcmp ("--map", argv[0]) == 0) 
         {
-          factory.SetTypeId ("ns3::HeapScheduler");
+          factory.SetTypeId ("ns3::MapScheduler");
           Simulator::SetScheduler (factory);
         } 
       else if (strcmp ("--calendar", argv[0]) == 0)
@@ -183,6 +242,29 @@ int main (int argc, char *argv[])
           factory.SetTypeId ("ns3::CalendarScheduler");
           Simulator::SetScheduler (factory);
         }
+      else if (strcmp ("--dary", argv[0]) == 0)
+        {
+          factory.SetTypeId ("ns3::DaryHeapScheduler");
+          Simulator::SetScheduler (factory);
+        }
+      else if (strcmp ("--ladder", argv[0]) == 0)
+        {
+          factory.SetTypeId ("ns3::LadderQueueScheduler");
+          Simulator::SetScheduler (factory);
+        }
+      else if (strcmp ("--reschedule=cancel", argv[0]) == 0)
+        {
+          reschedule = RESCHEDULE_CANCEL;
+        }
+      else if (strcmp ("--reschedule=remove", argv[0]) == 0)
+        {
+          reschedule = RESCHEDULE_REMOVE;
+        }
+      else if (strcmp ("--no-event-pool", argv[0]) == 0)
+        {
+          // must be set before the first event is created
+          GlobalValue::Bind ("EventImplPool", BooleanValue (false));
+        }
       else if (strcmp ("--debug", argv[0]) == 0) 
         {
           g_debug = true;
@@ -202,6 +284,7 @@ int main (int argc, char *argv[])
   Bench *bench = new Bench ();
   bench->ReadDistribution (*input);
   bench->SetTotal (total);
+  bench->SetReschedule (reschedule);
   for (uint32_t i = 0; i < n; i++)
     {
       bench->RunBench ();